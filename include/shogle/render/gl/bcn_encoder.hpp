@@ -0,0 +1,35 @@
+#pragma once
+
+#include <shogle/render/gl/texture.hpp>
+
+namespace shogle {
+
+// CPU encoder for the BCn block compressed formats, for load time conversion or bake steps.
+// Input is always RGBA8, BC4 takes the red channel and BC5 the red and green ones. BC7 only
+// emits mode 6 blocks (single subset RGBA), which is fast and good enough for most content.
+// Doesn't touch the context, rows of blocks get split between worker threads.
+class gl_bcn_encoder {
+public:
+  static constexpr u32 BLOCK_TEXELS = gl_texture::COMPRESSED_BLOCK_EXTENT *
+                                      gl_texture::COMPRESSED_BLOCK_EXTENT;
+
+  struct encode_args {
+    gl_texture::texture_format format;
+    u32 threads; // Zero uses every hardware thread
+  };
+
+public:
+  static bool is_supported(gl_texture::texture_format format) noexcept;
+
+  // Fails with GL_INVALID_ENUM on unsupported formats or non RGBA8 images,
+  // and with GL_INVALID_VALUE if the output span is smaller than compressed_image_size()
+  static gl_expect<size_t> encode(const gl_texture::image_data& image, span<u8> output,
+                                  const encode_args& args);
+  static gl_expect<std::vector<u8>> encode(const gl_texture::image_data& image,
+                                           const encode_args& args);
+
+  // Encodes a single block from 16 RGBA8 texels in row order
+  static void encode_block(gl_texture::texture_format format, const u8* texels, u8* output);
+};
+
+} // namespace shogle
@@ -18,6 +18,10 @@ public:
     TYPE_UNIFORM = 0x8A11, // GL_UNIFORM_BUFFER,
     TYPE_SHADER = 0x90D2,  // GL_SHADER_STORAGE_BUFFER,
     TYPE_TEXTURE = 0x8C2A, // GL_TEXTURE_BUFFER
+
+    TYPE_PIXEL_PACK = 0x88EB,   // GL_PIXEL_PACK_BUFFER
+    TYPE_PIXEL_UNPACK = 0x88EC, // GL_PIXEL_UNPACK_BUFFER
+    TYPE_INDIRECT = 0x8F3F,     // GL_DRAW_INDIRECT_BUFFER
   };
 
   enum buffer_bits : gldefs::GLbitfield {
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <shogle/render/gl/buffer.hpp>
+
+#include <shogle/util/tlsf.hpp>
+
+namespace shogle {
+
+// Sub-allocates ranges from a few big buffers, so that many small meshes can share the same
+// buffer objects. Blocks get allocated on demand, each one managed by its own TLSF allocator.
+class gl_buffer_pool {
+public:
+  using context_type = gl_context;
+  using deleter_type = gl_deleter<gl_buffer_pool>;
+
+public:
+  struct allocation {
+    u32 block;
+    mem::tlsf_allocator::handle node;
+  };
+
+  struct buffer_range {
+    gldefs::GLhandle buffer;
+    size_t offset;
+    size_t size;
+  };
+
+private:
+  struct create_t {};
+
+  struct pool_block {
+    gl_buffer buffer;
+    mem::tlsf_allocator allocator;
+  };
+
+public:
+  gl_buffer_pool(create_t, gl_buffer block, gldefs::GLbitfield usage_flags);
+
+  gl_buffer_pool(gl_context& gl, gl_buffer::buffer_type type, size_t block_size,
+                 gldefs::GLbitfield usage_flags = gl_buffer::DEFAULT_INMUTABLE_USAGE);
+
+public:
+  static gl_expect<gl_buffer_pool>
+  create(gl_context& gl, gl_buffer::buffer_type type, size_t block_size,
+         gldefs::GLbitfield usage_flags = gl_buffer::DEFAULT_INMUTABLE_USAGE);
+
+  static void destroy(gl_context& gl, gl_buffer_pool& pool) noexcept;
+
+public:
+  // Allocates a new block if none of the current ones can fit the range.
+  // Alignment can be any value, use the vertex stride to keep base vertex offsets exact.
+  gl_expect<allocation> allocate(gl_context& gl, size_t size, size_t alignment = 1);
+  void deallocate(const allocation& alloc) noexcept;
+
+  gl_expect<void> upload(gl_context& gl, const allocation& alloc, const void* data, size_t size,
+                         size_t offset = 0);
+
+  // Moves every live range to the start of its block with glCopyBufferSubData.
+  // Offsets change but allocations stay valid, query their range again afterwards.
+  // Returns the number of bytes copied.
+  gl_expect<size_t> compact(gl_context& gl);
+
+public:
+  buffer_range range(const allocation& alloc) const;
+  const gl_buffer& block(u32 idx) const;
+  u32 block_count() const noexcept { return static_cast<u32>(_blocks.size()); }
+  size_t block_size() const;
+  size_t used_size() const noexcept;
+  size_t capacity() const noexcept;
+  u32 allocation_count() const noexcept;
+
+  bool invalidated() const noexcept;
+
+public:
+  explicit operator bool() const noexcept { return !invalidated(); }
+
+private:
+  std::vector<pool_block> _blocks;
+  gldefs::GLbitfield _usage;
+};
+
+static_assert(::shogle::meta::renderer_object_type<gl_buffer_pool>);
+
+template<>
+struct gl_deleter<gl_buffer_pool> {
+public:
+  gl_deleter(gl_context& gl) noexcept : _gl(&gl) {}
+
+public:
+  void operator()(gl_buffer_pool& pool) const noexcept { gl_buffer_pool::destroy(*_gl, pool); }
+
+private:
+  gl_context* _gl;
+};
+
+} // namespace shogle
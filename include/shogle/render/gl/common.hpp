@@ -25,11 +25,13 @@ typedef GLuint GLhandle; // just because
 class gl_private;
 class gl_context;
 class gl_texture;
+class gl_sampler;
 class gl_buffer;
 class gl_shader;
 class gl_graphics_pipeline;
 class gl_vertex_layout;
 class gl_framebuffer;
+class gl_gpu_profiler;
 
 template<typename T>
 concept gl_provider_type = requires(T prov, const char* name) {
@@ -39,6 +41,14 @@ concept gl_provider_type = requires(T prov, const char* name) {
   requires noexcept(prov.surface_extent());
 };
 
+// Providers without a window system framebuffer hand their own one to the context, frames get
+// cleared and drawn into it instead of framebuffer 0
+template<typename T>
+concept gl_offscreen_provider_type = gl_provider_type<T> && requires(const T prov) {
+  { prov.default_framebuffer() } -> std::same_as<gldefs::GLhandle>;
+  requires noexcept(prov.default_framebuffer());
+};
+
 struct gl_version {
   u32 major;
   u32 minor;
@@ -52,8 +62,21 @@ private:
   struct vtbl_t {
     void* (*gl_get_proc)(void* user, const char* name) noexcept;
     extent2d (*surface_extent)(void* user) noexcept;
+    gldefs::GLhandle (*default_framebuffer)(void* user) noexcept;
   };
 
+  template<typename T>
+  static constexpr auto default_framebuffer_for() noexcept {
+    using func_type = gldefs::GLhandle (*)(void*) noexcept;
+    if constexpr (gl_offscreen_provider_type<T>) {
+      return static_cast<func_type>(+[](void* user) noexcept -> gldefs::GLhandle {
+        return (*static_cast<const T*>(user)).default_framebuffer();
+      });
+    } else {
+      return static_cast<func_type>(nullptr);
+    }
+  }
+
   template<typename T>
   static constexpr vtbl_t vtbl_for{
     .gl_get_proc = +[](void* user, const char* name) noexcept -> void* {
@@ -61,6 +84,7 @@ private:
     },
     .surface_extent =
       +[](void* user) noexcept -> extent2d { return (*static_cast<T*>(user)).surface_extent(); },
+    .default_framebuffer = default_framebuffer_for<T>(),
   };
 
 public:
@@ -75,6 +99,10 @@ public:
 
   extent2d surface_extent() const noexcept { return _vtbl->surface_extent(_provider); }
 
+  gldefs::GLhandle default_framebuffer() const noexcept {
+    return _vtbl->default_framebuffer ? _vtbl->default_framebuffer(_provider) : 0;
+  }
+
 public:
   void* get_ptr() const noexcept { return _provider; }
 
@@ -78,11 +78,13 @@ public:
     gldefs::GLhandle texture;
     gldefs::GLenum type;
     u32 index;
+    gldefs::GLhandle sampler; // GL_DEFAULT_BINDING samples with the texture parameters
   };
 
   struct vertex_binding {
     gldefs::GLhandle buffer;
     u32 location;
+    size_t offset; // Byte offset of the first vertex in the buffer
   };
 
   struct shader_binding {
@@ -127,6 +129,107 @@ public:
   u32 instances;
 };
 
+struct gl_sort_opts {
+  u32 layer;
+  f32 depth;
+};
+
+// Same layout as DrawElementsIndirectCommand
+struct gl_indirect_command {
+  u32 count;
+  u32 instance_count;
+  u32 first_index;
+  i32 base_vertex;
+  u32 base_instance;
+};
+
+static_assert(sizeof(gl_indirect_command) == 5 * sizeof(u32));
+
+struct gl_indirect_batch {
+public:
+  struct draw_group {
+    gl_draw_command state; // Bindings shared by the group, draw parameters are ignored
+    u32 first_command;
+    u32 command_count;
+  };
+
+  struct draw_data_binding {
+    gldefs::GLhandle buffer;
+    size_t stride;
+    u32 location;
+  };
+
+public:
+  span<const gl_indirect_command> commands;
+  span<const draw_group> groups;
+  optional<draw_data_binding> draw_data;
+};
+
+// Groups indexed draws that only differ in their index range, vertex offset and instance count,
+// so each group gets issued with a single glMultiDrawElementsIndirect.
+// Per draw data can be fetched from a shader storage buffer indexed by gl_DrawID, each group gets
+// the range starting at its first command. Write the data for a draw at draw_slot() * stride.
+class gl_batch_builder {
+private:
+  struct binding_range {
+    u32 offset;
+    u32 count;
+  };
+
+  struct draw_group {
+    ref_view<const gl_vertex_layout> vertex_layout;
+    ref_view<const gl_graphics_pipeline> pipeline;
+    binding_range vertex_bindings;
+    binding_range shader_bindings;
+    binding_range texture_bindings;
+    gl_draw_command::index_binding index_bind;
+    optional<rectangle_pos<u32>> viewport;
+    optional<rectangle_pos<u32>> scissor;
+    u64 hash;
+    u32 draw_count;
+  };
+
+  struct batched_draw {
+    gl_indirect_command cmd;
+    u32 group;
+  };
+
+public:
+  gl_batch_builder() noexcept;
+
+public:
+  // Group ranges start at a multiple of alignment, use GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT
+  gl_batch_builder& set_draw_data(const gl_buffer& buffer, u32 location, size_t stride,
+                                  size_t alignment);
+
+  // Non indexed draws and draws with push uniforms can't be batched
+  bool add_draw(const gl_draw_command& cmd);
+
+public:
+  void reset();
+  gl_indirect_batch build();
+
+  // Packed command index of the nth added draw, valid after build
+  u32 draw_slot(u32 draw) const;
+  u32 draw_count() const;
+  u32 group_count() const;
+
+private:
+  optional<u32> _find_group(const gl_draw_command& cmd, u64 hash) const;
+
+private:
+  std::vector<draw_group> _groups;
+  std::vector<batched_draw> _draws;
+  std::vector<gl_draw_command::vertex_binding> _vertex_binds;
+  std::vector<gl_draw_command::shader_binding> _shader_binds;
+  std::vector<gl_draw_command::texture_binding> _texture_binds;
+  std::vector<gl_indirect_command> _commands;
+  std::vector<gl_indirect_batch::draw_group> _built_groups;
+  std::vector<u32> _slots;
+  optional<gl_indirect_batch::draw_data_binding> _draw_data;
+  size_t _draw_data_alignment;
+};
+
 class gl_command_builder {
 public:
   gl_command_builder() noexcept;
@@ -147,10 +250,14 @@ public:
                                        gl_draw_command::index_format format,
                                        size_t index_offset = 0);
 
-  gl_command_builder& add_vertex_buffer(const gl_buffer& buffer, u32 location = 0);
+  gl_command_builder& add_vertex_buffer(const gl_buffer& buffer, u32 location = 0,
+                                       size_t offset = 0);
   gl_command_builder& add_shader_buffer(u32 location, const gl_buffer& buffer, size_t size = 0,
                                         size_t offset = 0);
+  gl_command_builder& add_shader_binding(const gl_draw_command::shader_binding& binding);
   gl_command_builder& add_texture(const gl_texture& texture, u32 location);
+  gl_command_builder& add_texture(const gl_texture& texture, u32 location,
+                                  const gl_sampler& sampler);
 
   template<::shogle::meta::attribute_type T>
   gl_command_builder& add_uniform(const T& value, u32 location) {
@@ -237,6 +344,24 @@ private:
   optional<rectangle_pos<u32>> _scissor;
 };
 
+// Work done between two end_frame calls.
+// Compiled out with SHOGLE_GL_DISABLE_FRAME_STATS, every counter stays at zero.
+struct gl_frame_stats {
+  u32 draw_calls;
+  u32 instances;
+  u64 vertices; // Non indexed draws only, times instance count
+  u64 indices;  // Times instance count
+  u32 program_binds;
+  u32 vao_binds;
+  u32 fbo_binds;
+  u32 texture_binds;
+  u32 sampler_binds;
+  std::array<u32, ATTRIBUTE_COUNT> uniform_uploads; // Indexed by attribute_type
+  u64 buffer_upload_bytes;
+  u64 texture_upload_bytes;
+  u32 external_commands;
+};
+
 class gl_context {
 private:
   struct create_t {};
@@ -257,28 +382,71 @@ public:
     u32 minor;
   };
 
+  enum submit_mode {
+    SUBMIT_IMMEDIATE = 0,
+    // Record draws until end_frame, then sort them to minimize state changes.
+    // Everything referenced by the commands has to outlive the frame.
+    SUBMIT_DEFERRED,
+  };
+
+  enum layer_order {
+    LAYER_ORDER_STATE = 0,
+    LAYER_ORDER_BACK_TO_FRONT,
+    LAYER_ORDER_SUBMISSION,
+  };
+
+  enum error_check_policy {
+    // glGetError after every call, asserts on failure
+    ERROR_POLICY_PER_CALL = 0,
+    // One glGetError per submitted command and frame start, errors get logged.
+    // Calls that return their error to the caller still check it.
+    ERROR_POLICY_PER_SUBMIT,
+    // Never call glGetError, rely on the debug output callback.
+    // Calls that return an error will always succeed.
+    ERROR_POLICY_DEBUG_CALLBACK,
+  };
+
+  static constexpr u32 MAX_SORT_LAYERS = 16;
+  static constexpr error_check_policy DEFAULT_ERROR_POLICY =
+    static_cast<error_check_policy>(SHOGLE_GL_ERROR_POLICY);
+
 public:
   explicit gl_context(create_t, context_data&& ctx) noexcept;
 
-  explicit gl_context(const gl_surface_provider& surf_prov);
+  explicit gl_context(const gl_surface_provider& surf_prov,
+                      error_check_policy error_policy = DEFAULT_ERROR_POLICY);
 
   template<gl_provider_type T>
-  gl_context(T& surf_prov) : gl_context(::shogle::gl_surface_provider(surf_prov)) {}
+  gl_context(T& surf_prov, error_check_policy error_policy = DEFAULT_ERROR_POLICY) :
+      gl_context(::shogle::gl_surface_provider(surf_prov), error_policy) {}
 
 public:
-  static sv_expect<gl_context> create(const gl_surface_provider& surf_prov) noexcept;
+  static sv_expect<gl_context> create(const gl_surface_provider& surf_prov,
+                                      error_check_policy error_policy =
+                                        DEFAULT_ERROR_POLICY) noexcept;
 
   template<gl_provider_type T>
-  static sv_expect<gl_context> create(T& surf_prov) noexcept {
-    return ::shogle::gl_context::create(::shogle::gl_surface_provider(surf_prov));
+  static sv_expect<gl_context> create(T& surf_prov, error_check_policy error_policy =
+                                                      DEFAULT_ERROR_POLICY) noexcept {
+    return ::shogle::gl_context::create(::shogle::gl_surface_provider(surf_prov), error_policy);
   }
 
 public:
   void start_frame(const gl_clear_opts& clear);
   void submit_command(const gl_draw_command& cmd, ptr_view<const gl_framebuffer> target = {});
+  void submit_command(const gl_draw_command& cmd, const gl_sort_opts& sort,
+                      ptr_view<const gl_framebuffer> target = {});
   void submit_command(const gl_external_command& cmd, ptr_view<const gl_framebuffer> target = {});
+  // Uploads the packed commands to the indirect buffer before drawing
+  void submit_batch(const gl_indirect_batch& batch, gl_buffer& indirect_buffer,
+                    ptr_view<const gl_framebuffer> target = {});
   void end_frame();
 
+  void set_submit_mode(submit_mode mode);
+  void set_layer_order(u32 layer, layer_order order);
+  // Timestamps every frame between start_frame and end_frame, pass null to detach it
+  void set_profiler(ptr_view<gl_gpu_profiler> profiler);
+
   template<typename F>
   void scope_frame(const gl_clear_opts& clear, F&& scope)
   requires(_scope_frame_invocable<F>)
@@ -292,12 +460,19 @@ public:
     end_frame();
   }
 
+  // Call after issuing raw GL calls outside of an external command
+  void invalidate_state();
+
 public:
   void destroy() noexcept;
 
 public:
   gl_surface_provider provider() const;
   gldefs::GLenum get_error() const;
+  error_check_policy error_policy() const;
+  // Stats of the last finished frame
+  const gl_frame_stats& frame_stats() const;
+  ptr_view<gl_gpu_profiler> profiler() const;
   gl_version version() const;
   std::string_view renderer_string() const;
   std::string_view vendor_string() const;
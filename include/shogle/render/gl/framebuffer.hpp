@@ -102,6 +102,8 @@ public:
   explicit gl_framebuffer(gl_context& gl, extent2d extent, span<const texture_attachment> color,
                           const texture_attachment& buffer);
 
+  explicit gl_framebuffer(gl_context& gl, extent2d extent, span<const texture_attachment> color);
+
   explicit gl_framebuffer(gl_context& gl, extent2d extent, const gl_renderbuffer& color,
                           const gl_renderbuffer& buffer);
 
@@ -117,6 +119,10 @@ public:
                                                     span<const texture_attachment> color,
                                                     const texture_attachment& buffer);
 
+  // Color only, for targets that don't need depth or stencil testing
+  static gl_sv_expect<gl_framebuffer> with_textures(gl_context& gl, extent2d extent,
+                                                    span<const texture_attachment> color);
+
   static gl_sv_expect<gl_framebuffer> with_renderbuffer(gl_context& gl, extent2d extent,
                                                         const gl_renderbuffer& color,
                                                         const gl_renderbuffer& buffer);
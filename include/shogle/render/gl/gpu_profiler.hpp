@@ -0,0 +1,189 @@
+#pragma once
+
+#include <shogle/render/gl/context.hpp>
+
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace shogle {
+
+// Measures GPU time with timestamp queries around named zones.
+// Every frame writes to its own set of queries, pending sets are polled when a frame starts and
+// only read back once the GPU made them available, so the CPU never waits on it.
+// Frames still pending when their set gets reused, frame_latency frames later, are dropped.
+//
+// Attach it with gl_context::set_profiler to time whole frames, zones nest inside them. Zones
+// only time the commands issued while they are open, so they need SUBMIT_IMMEDIATE. Zones with
+// the same name are added up within a frame.
+class gl_gpu_profiler {
+public:
+  using context_type = gl_context;
+  using deleter_type = gl_deleter<gl_gpu_profiler>;
+
+public:
+  static constexpr u32 MAX_FRAME_LATENCY = 8;
+  static constexpr u32 DEFAULT_FRAME_LATENCY = 4;
+  static constexpr u32 DEFAULT_MAX_ZONES = 64;
+  static constexpr u32 DEFAULT_TRACE_FRAMES = 120;
+  static constexpr u32 FRAME_ZONE = 0; // Named "frame", spans start_frame to end_frame
+
+  struct create_args {
+    u32 max_zones;     // Per frame, zones past it are ignored
+    u32 frame_latency; // Query sets in flight
+    u32 trace_frames;  // Resolved frames kept for the trace dump
+
+    static constexpr inline create_args make_default() {
+      return {
+        .max_zones = DEFAULT_MAX_ZONES,
+        .frame_latency = DEFAULT_FRAME_LATENCY,
+        .trace_frames = DEFAULT_TRACE_FRAMES,
+      };
+    }
+  };
+
+  // Times in milliseconds, aggregated over every resolved frame since the last reset
+  struct zone_stats {
+    std::string_view name;
+    u32 depth;   // Nesting the last time it ran, the frame zone is at 0
+    u32 samples; // Frames it ran in
+    f64 last_ms;
+    f64 min_ms;
+    f64 avg_ms;
+    f64 max_ms;
+  };
+
+  struct trace_event {
+    u32 zone;
+    u32 depth;
+    u64 frame;
+    u64 begin_ns; // GPU clock
+    u64 end_ns;
+  };
+
+  // Closes the zone when it goes out of scope
+  class scope {
+  public:
+    scope(gl_context& gl, gl_gpu_profiler& profiler, std::string_view name) :
+        _gl(&gl), _profiler(&profiler) {
+      _profiler->begin_zone(gl, name);
+    }
+
+    scope(const scope&) = delete;
+    scope& operator=(const scope&) = delete;
+
+    ~scope() noexcept { _profiler->end_zone(*_gl); }
+
+  private:
+    gl_context* _gl;
+    gl_gpu_profiler* _profiler;
+  };
+
+private:
+  struct zone_record {
+    u32 zone;
+    u32 depth;
+  };
+
+  struct frame_set {
+    u64 frame;
+    u32 records; // Each one owns two queries, begin and end
+    bool pending;
+  };
+
+  struct create_t {};
+
+public:
+  gl_gpu_profiler(create_t, std::vector<gldefs::GLhandle>&& queries, const create_args& args);
+
+  gl_gpu_profiler(gl_context& gl, const create_args& args = create_args::make_default());
+
+public:
+  static gl_sv_expect<gl_gpu_profiler>
+  create(gl_context& gl, const create_args& args = create_args::make_default());
+
+  // Detaches it from the context if attached
+  static void destroy(gl_context& gl, gl_gpu_profiler& profiler) noexcept;
+
+public:
+  // Called by the context when attached
+  void begin_frame(gl_context& gl);
+  void end_frame(gl_context& gl);
+
+  void begin_zone(gl_context& gl, std::string_view name);
+  void end_zone(gl_context& gl);
+
+  // Blocks until every pending frame is resolved
+  void flush(gl_context& gl);
+  void reset_stats();
+
+public:
+  // Indexed by zone id, FRAME_ZONE first
+  span<const zone_stats> zones() const noexcept { return {_stats.data(), _stats.size()}; }
+  const std::deque<trace_event>& trace() const noexcept { return _trace; }
+  // Trace Event Format, loads in chrome://tracing and Perfetto
+  std::string chrome_trace() const;
+
+  u64 resolved_frames() const noexcept { return _resolved; }
+  u64 dropped_frames() const noexcept { return _dropped; }
+  // Zones past max_zones since creation
+  u64 overflowed_zones() const noexcept { return _overflowed; }
+  u32 pending_frames() const noexcept;
+  bool in_frame() const noexcept { return _in_frame; }
+
+#ifdef SHOGLE_ENABLE_IMGUI
+  // Table of the zone stats, call inside an ImGui window
+  void draw_imgui() const;
+#endif
+
+  bool invalidated() const noexcept { return _queries.empty(); }
+
+public:
+  explicit operator bool() const noexcept { return !invalidated(); }
+
+private:
+  u32 _intern_zone(std::string_view name);
+  bool _resolve_set(gl_context& gl, u32 set, bool wait);
+  gldefs::GLhandle _query(u32 set, u32 record, u32 end) const;
+
+private:
+  std::vector<gldefs::GLhandle> _queries;
+  std::vector<zone_record> _records; // max_zones + 1 per set, the frame zone first
+  std::vector<frame_set> _sets;
+  std::deque<std::string> _names;
+  std::unordered_map<std::string_view, u32> _zone_ids;
+  std::vector<zone_stats> _stats;
+  std::vector<u64> _totals_ns;
+  std::vector<u64> _frame_ns;
+  std::vector<u32> _touched; // Zones seen in the frame being resolved
+  std::vector<u32> _stack;
+  std::deque<trace_event> _trace;
+  std::deque<u32> _trace_sizes;
+  u32 _records_per_set;
+  u32 _trace_frames;
+  u32 _set;
+  u64 _frame;
+  u64 _resolved;
+  u64 _dropped;
+  u64 _overflowed;
+  bool _in_frame;
+};
+
+static_assert(::shogle::meta::renderer_object_type<gl_gpu_profiler>);
+
+template<>
+struct gl_deleter<gl_gpu_profiler> {
+public:
+  gl_deleter(gl_context& gl) noexcept : _gl(&gl) {}
+
+public:
+  void operator()(gl_gpu_profiler& profiler) const noexcept {
+    gl_gpu_profiler::destroy(*_gl, profiler);
+  }
+
+private:
+  gl_context* _gl;
+};
+
+} // namespace shogle
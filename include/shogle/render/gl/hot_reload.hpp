@@ -0,0 +1,169 @@
+#pragma once
+
+#include <shogle/render/gl/pipeline_compiler.hpp>
+#include <shogle/render/gl/texture.hpp>
+
+#include <chrono>
+#include <functional>
+
+namespace shogle {
+
+// Reloads pipelines and textures when their files change on disk, meant for development builds.
+// Files are watched through their parent directory, so editors that save by renaming a temporary
+// file still get picked up. Changed pipelines go through a gl_pipeline_compiler and get their
+// program swapped in update(), the old one is kept if compilation fails.
+// Watched objects must not move while they are being watched. Linux only, through inotify.
+class gl_hot_reloader {
+public:
+  using context_type = gl_context;
+  using deleter_type = gl_deleter<gl_hot_reloader>;
+
+public:
+  using watch_id = u32;
+  using clock = std::chrono::steady_clock;
+
+  // Called after a successful swap, to re-resolve uniform locations and block bindings
+  using pipeline_callback = std::function<void(gl_context& gl, gl_graphics_pipeline& pipeline)>;
+  using texture_loader =
+    std::function<gl_expect<void>(gl_context& gl, gl_texture& texture, span<const u8> file)>;
+
+  struct pipeline_files {
+    std::string_view vertex;
+    std::string_view fragment;
+    std::string_view geometry{};  // Optional
+    std::string_view tess_ctrl{}; // Optional
+    std::string_view tess_eval{}; // Optional
+  };
+
+  enum event_kind : u8 {
+    EVENT_PIPELINE = 0,
+    EVENT_TEXTURE,
+  };
+
+  struct reload_event {
+    watch_id id;
+    event_kind kind;
+    bool success;
+  };
+
+  struct create_args {
+    u32 debounce_ms; // Quiet time after the last change before reloading
+    u32 sync_budget; // Pipelines compiled per update without parallel compilation
+
+    static constexpr inline create_args make_default() {
+      return {
+        .debounce_ms = 100,
+        .sync_budget = gl_pipeline_compiler::DEFAULT_SYNC_BUDGET,
+      };
+    }
+  };
+
+private:
+  static constexpr u32 MAX_FILES = 5;
+
+  struct watched_dir {
+    std::string path;
+    i32 wd;
+  };
+
+  struct watched_file {
+    std::string name;
+    u32 dir;
+    watch_id owner;
+  };
+
+  struct watch_entry {
+    std::array<std::string, MAX_FILES> paths; // Textures only use the first one
+    ptr_view<gl_graphics_pipeline> pipeline;
+    ptr_view<gl_texture> texture;
+    pipeline_callback on_reload;
+    texture_loader loader;
+    optional<gl_pipeline_compiler::ticket> ticket;
+    event_kind kind;
+    bool dirty;
+    bool active;
+  };
+
+  struct create_t {};
+
+public:
+  gl_hot_reloader(create_t, gl_pipeline_compiler&& compiler, i32 fd, u32 debounce_ms) noexcept;
+
+  gl_hot_reloader(gl_context& gl, const create_args& args = create_args::make_default());
+
+  gl_hot_reloader(gl_hot_reloader&& other) noexcept;
+  gl_hot_reloader(const gl_hot_reloader&) = delete;
+  ~gl_hot_reloader() noexcept;
+
+public:
+  gl_hot_reloader& operator=(gl_hot_reloader&& other) noexcept;
+  gl_hot_reloader& operator=(const gl_hot_reloader&) = delete;
+
+public:
+  static bool is_supported() noexcept;
+
+  static gl_sv_expect<gl_hot_reloader> create(gl_context& gl,
+                                              const create_args& args = create_args::make_default());
+
+  static void destroy(gl_context& gl, gl_hot_reloader& reloader) noexcept;
+
+public:
+  // Fails if a parent directory can't be watched
+  gl_sv_expect<watch_id> watch_pipeline(gl_graphics_pipeline& pipeline,
+                                        const pipeline_files& files,
+                                        pipeline_callback on_reload = {});
+  // The loader gets the whole file and uploads it, on failure the texture should be left alone
+  gl_sv_expect<watch_id> watch_texture(gl_texture& texture, std::string_view path,
+                                       texture_loader loader);
+  void unwatch(watch_id id);
+
+  // Call between frames. When nothing changed this is a single non-blocking read.
+  // Events are valid until the next call.
+  span<const reload_event> update(gl_context& gl);
+
+public:
+  u32 watch_count() const noexcept;
+  u32 pending_count() const noexcept { return _in_flight; }
+
+  bool invalidated() const noexcept { return _fd < 0; }
+
+public:
+  explicit operator bool() const noexcept { return !invalidated(); }
+
+private:
+  gl_sv_expect<void> _watch_file(std::string_view path, watch_id owner);
+  void _read_events();
+  void _mark_dirty(watch_id owner);
+  void _reload(gl_context& gl, watch_id id);
+  void _collect(gl_context& gl);
+
+private:
+  gl_pipeline_compiler _compiler;
+  std::vector<watch_entry> _entries;
+  std::vector<watched_dir> _dirs;
+  std::vector<watched_file> _files;
+  std::vector<reload_event> _events;
+  clock::time_point _last_change;
+  std::chrono::milliseconds _debounce;
+  u32 _in_flight;
+  i32 _fd;
+  bool _dirty;
+};
+
+static_assert(::shogle::meta::renderer_object_type<gl_hot_reloader>);
+
+template<>
+struct gl_deleter<gl_hot_reloader> {
+public:
+  gl_deleter(gl_context& gl) noexcept : _gl(&gl) {}
+
+public:
+  void operator()(gl_hot_reloader& reloader) const noexcept {
+    gl_hot_reloader::destroy(*_gl, reloader);
+  }
+
+private:
+  gl_context* _gl;
+};
+
+} // namespace shogle
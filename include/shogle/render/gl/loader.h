@@ -40,10 +40,17 @@ SHOGLE_GLAPI_ENTRY void shogle_gl_get_version(const char* ver_str, shogle_gl_ver
 #define GL_RENDERER 0x1F01
 #define GL_VENDOR   0x1F00
 
-#define GL_FRAMEBUFFER      0x8D40
-#define GL_RENDERBUFFER     0x8D41
-#define GL_READ_FRAMEBUFFER 0x8CA8
-#define GL_DRAW_FRAMEBUFFER 0x8CA9
+#define GL_EXTENSIONS     0x1F03
+#define GL_NUM_EXTENSIONS 0x821D
+
+#define GL_FRAMEBUFFER              0x8D40
+#define GL_RENDERBUFFER             0x8D41
+#define GL_READ_FRAMEBUFFER         0x8CA8
+#define GL_DRAW_FRAMEBUFFER         0x8CA9
+#define GL_DRAW_FRAMEBUFFER_BINDING 0x8CA6
+#define GL_RENDERBUFFER_BINDING     0x8CA7
+#define GL_READ_FRAMEBUFFER_BINDING 0x8CAA
+#define GL_FRAMEBUFFER_COMPLETE     0x8CD5
 
 #define GL_TEXTURE_1D               0x0DE0
 #define GL_TEXTURE_2D               0x0DE1
@@ -54,6 +61,9 @@ SHOGLE_GLAPI_ENTRY void shogle_gl_get_version(const char* ver_str, shogle_gl_ver
 #define GL_STENCIL_ATTACHMENT       0x8D20
 #define GL_DEPTH_ATTACHMENT         0x8D00
 #define GL_DEPTH_COMPONENT          0x1902
+#define GL_RGBA                     0x1908
+#define GL_RGBA8                    0x8058
+#define GL_DEPTH24_STENCIL8         0x88F0
 
 #define GL_COMPILE_STATUS    0x8B81
 #define GL_LINK_STATUS       0x8B82
@@ -61,6 +71,24 @@ SHOGLE_GLAPI_ENTRY void shogle_gl_get_version(const char* ver_str, shogle_gl_ver
 #define GL_ACTIVE_UNIFORMS   0x8B86
 #define GL_ACTIVE_ATTRIBUTES 0x8B89
 
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+
+#define GL_ACTIVE_UNIFORM_BLOCKS                0x8A36
+#define GL_UNIFORM_TYPE                         0x8A37
+#define GL_UNIFORM_SIZE                         0x8A38
+#define GL_UNIFORM_OFFSET                       0x8A3B
+#define GL_UNIFORM_ARRAY_STRIDE                 0x8A3C
+#define GL_UNIFORM_MATRIX_STRIDE                0x8A3D
+#define GL_UNIFORM_BLOCK_BINDING                0x8A3F
+#define GL_UNIFORM_BLOCK_DATA_SIZE              0x8A40
+#define GL_UNIFORM_BLOCK_NAME_LENGTH            0x8A41
+#define GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS        0x8A42
+#define GL_UNIFORM_BLOCK_ACTIVE_UNIFORM_INDICES 0x8A43
+#define GL_INVALID_INDEX                        0xFFFFFFFFu
+
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH           0x8741
+
 #define GL_SCISSOR_TEST   0x0C11
 #define GL_DEPTH_TEST     0x0B71
 #define GL_STENCIL_TEST   0x0B90
@@ -78,6 +106,31 @@ SHOGLE_GLAPI_ENTRY void shogle_gl_get_version(const char* ver_str, shogle_gl_ver
 
 #define GL_ARRAY_BUFFER         0x8892
 #define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#define GL_PIXEL_PACK_BUFFER    0x88EB
+#define GL_PIXEL_UNPACK_BUFFER  0x88EC
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#define GL_COPY_READ_BUFFER     0x8F36
+#define GL_COPY_WRITE_BUFFER    0x8F37
+
+#define GL_PIXEL_PACK_BUFFER_BINDING 0x88ED
+#define GL_STREAM_READ               0x88E1
+#define GL_MAP_READ_BIT              0x0001
+
+#define GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT        0x8A34
+#define GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT 0x90DF
+
+#define GL_SHADER_STORAGE_BARRIER_BIT 0x00002000
+
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define GL_SYNC_FLUSH_COMMANDS_BIT    0x00000001
+#define GL_ALREADY_SIGNALED           0x911A
+#define GL_TIMEOUT_EXPIRED            0x911B
+#define GL_CONDITION_SATISFIED        0x911C
+#define GL_WAIT_FAILED                0x911D
+
+#define GL_TIMESTAMP              0x8E28
+#define GL_QUERY_RESULT           0x8866
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
 
 #define GL_FALSE 0
 #define GL_TRUE  1
@@ -104,10 +157,24 @@ SHOGLE_GLAPI_ENTRY void shogle_gl_get_version(const char* ver_str, shogle_gl_ver
 #define GL_DEBUG_SOURCE_APPLICATION     0x824A
 #define GL_DEBUG_SOURCE_OTHER           0x824B
 
+#define GL_DEBUG_OUTPUT             0x92E0
+#define GL_DEBUG_OUTPUT_SYNCHRONOUS 0x8242
+
 #define GL_TEXTURE0         0x84C0
 #define GL_UNPACK_ALIGNMENT 0x0CF5
+#define GL_PACK_ALIGNMENT   0x0D05
 #define GL_TEXTURE_MAG_FILTER 0x2801
-#define GL_TEXTURE_MIN_FILTER 0x2801
+#define GL_TEXTURE_MIN_FILTER 0x2800
+
+#define GL_TEXTURE_WRAP_S              0x2802
+#define GL_TEXTURE_WRAP_T              0x2803
+#define GL_TEXTURE_WRAP_R              0x8072
+#define GL_TEXTURE_LOD_BIAS            0x8501
+#define GL_TEXTURE_COMPARE_MODE        0x884C
+#define GL_TEXTURE_COMPARE_FUNC        0x884D
+#define GL_COMPARE_REF_TO_TEXTURE      0x884E
+#define GL_TEXTURE_MAX_ANISOTROPY      0x84FE
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY  0x84FF
 
 #ifndef APIENTRY
 #define APIENTRY
@@ -118,7 +185,9 @@ typedef void(APIENTRY* GLDEBUGPROC)(GLenum source, GLenum type, GLuint id, GLenu
 
 #define SHOGLE_GL_DOFUNCS(X)                                                                      \
   X(glGetString, const GLubyte*, GLenum name)                                                     \
+  X(glGetStringi, const GLubyte*, GLenum name, GLuint index)                                      \
   X(glGetError, GLenum, void)                                                                     \
+  X(glGetIntegerv, void, GLenum pname, GLint* data)                                               \
   X(glGenTextures, void, GLsizei n, GLuint* textures)                                             \
   X(glBindTexture, void, GLenum target, GLuint texture)                                           \
   X(glDeleteTextures, void, GLsizei n, const GLuint* textures)                                    \
@@ -146,12 +215,22 @@ typedef void(APIENTRY* GLDEBUGPROC)(GLenum source, GLenum type, GLuint id, GLenu
   X(glTexSubImage3D, void, GLenum target, GLint level, GLint xoffset, GLint yoffset,              \
     GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type,      \
     const void* pixels)                                                                           \
+  X(glCompressedTexSubImage2D, void, GLenum target, GLint level, GLint xoffset, GLint yoffset,    \
+    GLsizei width, GLsizei height, GLenum format, GLsizei imageSize, const void* data)            \
+  X(glCompressedTexSubImage3D, void, GLenum target, GLint level, GLint xoffset, GLint yoffset,    \
+    GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format,                   \
+    GLsizei imageSize, const void* data)                                                          \
   X(glTexImage3DMultisample, void, GLenum target, GLsizei samples, GLenum internalformat,         \
     GLsizei width, GLsizei height, GLsizei depth, GLboolean fixedsamplelocations)                 \
   X(glTexBuffer, void, GLenum target, GLenum internalformat, GLuint buffer)                       \
   X(glTexBufferRange, void, GLenum target, GLenum internalformat, GLuint buffer, GLintptr offset, \
     GLsizeiptr size)                                                                              \
   X(glTexParameteri, void, GLenum target, GLenum pname, GLint param)                              \
+  X(glGenSamplers, void, GLsizei count, GLuint* samplers)                                         \
+  X(glDeleteSamplers, void, GLsizei count, const GLuint* samplers)                                \
+  X(glBindSampler, void, GLuint unit, GLuint sampler)                                             \
+  X(glSamplerParameteri, void, GLuint sampler, GLenum pname, GLint param)                         \
+  X(glSamplerParameterf, void, GLuint sampler, GLenum pname, GLfloat param)                       \
   X(glGenerateMipmap, void, GLenum target)                                                        \
   X(glGenBuffers, void, GLsizei n, GLuint* buffers)                                               \
   X(glBindBuffer, void, GLenum target, GLuint buffer)                                             \
@@ -159,11 +238,21 @@ typedef void(APIENTRY* GLDEBUGPROC)(GLenum source, GLenum type, GLuint id, GLenu
   X(glBufferData, void, GLenum target, GLsizeiptr size, const void* data, GLenum usage)           \
   X(glBufferSubData, void, GLenum target, GLintptr offset, GLsizeiptr size, const void* data)     \
   X(glGetBufferSubData, void, GLenum target, GLintptr offset, GLsizeiptr size, void* data)        \
+  X(glCopyBufferSubData, void, GLenum readTarget, GLenum writeTarget, GLintptr readOffset,        \
+    GLintptr writeOffset, GLsizeiptr size)                                                        \
   X(glMapBuffer, void*, GLenum target, GLenum access)                                             \
   X(glBufferStorage, void, GLenum target, GLsizeiptr size, const void* data, GLbitfield flags)    \
   X(glMapBufferRange, void*, GLenum target, GLintptr offset, GLsizeiptr length,                   \
     GLbitfield access)                                                                            \
   X(glUnmapBuffer, void, GLenum target)                                                           \
+  X(glFenceSync, GLsync, GLenum condition, GLbitfield flags)                                      \
+  X(glClientWaitSync, GLenum, GLsync sync, GLbitfield flags, GLuint64 timeout)                    \
+  X(glDeleteSync, void, GLsync sync)                                                              \
+  X(glGenQueries, void, GLsizei n, GLuint* ids)                                                   \
+  X(glDeleteQueries, void, GLsizei n, const GLuint* ids)                                          \
+  X(glQueryCounter, void, GLuint id, GLenum target)                                               \
+  X(glGetQueryObjectiv, void, GLuint id, GLenum pname, GLint* params)                             \
+  X(glGetQueryObjectui64v, void, GLuint id, GLenum pname, GLuint64* params)                       \
   X(glCreateShader, GLuint, GLenum type)                                                          \
   X(glDeleteShader, void, GLuint shader)                                                          \
   X(glCreateProgram, GLuint, void)                                                                \
@@ -172,8 +261,13 @@ typedef void(APIENTRY* GLDEBUGPROC)(GLenum source, GLenum type, GLuint id, GLenu
     const GLint* length)                                                                          \
   X(glCompileShader, void, GLuint shader)                                                         \
   X(glLinkProgram, void, GLuint program)                                                          \
+  X(glProgramParameteri, void, GLuint program, GLenum pname, GLint value)                         \
+  X(glGetProgramBinary, void, GLuint program, GLsizei bufSize, GLsizei* length,                   \
+    GLenum* binaryFormat, void* binary)                                                           \
+  X(glProgramBinary, void, GLuint program, GLenum binaryFormat, const void* binary,               \
+    GLsizei length)                                                                               \
   X(glAttachShader, void, GLuint program, GLuint shader)                                          \
-  X(glDettachShader, void, GLuint program, GLuint shader)                                         \
+  X(glDetachShader, void, GLuint program, GLuint shader)                                          \
   X(glGetProgramiv, void, GLuint program, GLenum pname, GLint* params)                            \
   X(glGetUniformLocation, GLint, GLuint program, const char* name)                                \
   X(glGetAttribLocation, GLint, GLuint program, const char* name)                                 \
@@ -181,8 +275,21 @@ typedef void(APIENTRY* GLDEBUGPROC)(GLenum source, GLenum type, GLuint id, GLenu
     GLint* size, GLenum* type, GLchar* name)                                                      \
   X(glGetActiveAttrib, void, GLuint program, GLuint index, GLsizei bufSize, GLsizei* length,      \
     GLint* size, GLenum* type, GLchar* name)                                                      \
+  X(glGetActiveUniformName, void, GLuint program, GLuint uniformIndex, GLsizei bufSize,           \
+    GLsizei* length, GLchar* uniformName)                                                         \
+  X(glGetActiveUniformsiv, void, GLuint program, GLsizei uniformCount,                            \
+    const GLuint* uniformIndices, GLenum pname, GLint* params)                                    \
+  X(glGetUniformBlockIndex, GLuint, GLuint program, const GLchar* uniformBlockName)               \
+  X(glGetActiveUniformBlockiv, void, GLuint program, GLuint uniformBlockIndex, GLenum pname,      \
+    GLint* params)                                                                                \
+  X(glGetActiveUniformBlockName, void, GLuint program, GLuint uniformBlockIndex,                  \
+    GLsizei bufSize, GLsizei* length, GLchar* uniformBlockName)                                   \
+  X(glUniformBlockBinding, void, GLuint program, GLuint uniformBlockIndex,                        \
+    GLuint uniformBlockBinding)                                                                   \
   X(glGetShaderiv, void, GLuint shader, GLenum pname, GLint* params)                              \
   X(glGetShaderInfoLog, void, GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog)   \
+  X(glGetProgramInfoLog, void, GLuint program, GLsizei bufSize, GLsizei* length,                  \
+    GLchar* infoLog)                                                                              \
   X(glBindRenderbuffer, void, GLenum target, GLuint renderbuffer)                                 \
   X(glGenRenderbuffers, void, GLsizei n, GLuint* renderbuffers)                                   \
   X(glDeleteRenderbuffers, void, GLsizei n, const GLuint* renderbuffers)                          \
@@ -202,6 +309,7 @@ typedef void(APIENTRY* GLDEBUGPROC)(GLenum source, GLenum type, GLuint id, GLenu
     GLuint renderbuffer)                                                                          \
   X(glBlitFramebuffer, void, GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0,     \
     GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter)                        \
+  X(glDrawBuffers, void, GLsizei n, const GLenum* bufs)                                           \
   X(glCreateVertexArrays, void, GLsizei n, GLuint* arrays)                                        \
   X(glDeleteVertexArrays, void, GLsizei n, const GLuint* arrays)                                  \
   X(glViewport, void, GLint x, GLint y, GLsizei width, GLsizei height)                            \
@@ -263,8 +371,108 @@ typedef void(APIENTRY* GLDEBUGPROC)(GLenum source, GLenum type, GLuint id, GLenu
     GLint basevertex)                                                                             \
   X(glDrawArraysInstanced, void, GLenum mode, GLint first, GLsizei count, GLsizei instancecount)  \
   X(glDrawArrays, void, GLenum mode, GLint first, GLsizei count)                                  \
+  X(glMultiDrawElementsIndirect, void, GLenum mode, GLenum type, const void* indirect,            \
+    GLsizei drawcount, GLsizei stride)                                                            \
+  X(glMemoryBarrier, void, GLbitfield barriers)                                                   \
+  X(glDispatchCompute, void, GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z)       \
+  X(glInvalidateFramebuffer, void, GLenum target, GLsizei numAttachments,                         \
+    const GLenum* attachments)                                                                    \
   X(glUseProgram, void, GLenum program)                                                           \
-  X(glPixelStorei, void, GLenum pname, GLint param)
+  X(glPixelStorei, void, GLenum pname, GLint param)                                               \
+  X(glReadPixels, void, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format,           \
+    GLenum type, void* pixels)                                                                    \
+  X(glGetTexImage, void, GLenum target, GLint level, GLenum format, GLenum type, void* pixels)
+
+// Named object functions, core since 4.5 or through GL_ARB_direct_state_access.
+// Loaded when available, the legacy bind and modify path is used without them.
+#define SHOGLE_GL_DOFUNCS_DSA(X)                                                                  \
+  X(glCreateBuffers, void, GLsizei n, GLuint* buffers)                                            \
+  X(glNamedBufferStorage, void, GLuint buffer, GLsizeiptr size, const void* data,                 \
+    GLbitfield flags)                                                                             \
+  X(glNamedBufferData, void, GLuint buffer, GLsizeiptr size, const void* data, GLenum usage)      \
+  X(glNamedBufferSubData, void, GLuint buffer, GLintptr offset, GLsizeiptr size,                  \
+    const void* data)                                                                             \
+  X(glGetNamedBufferSubData, void, GLuint buffer, GLintptr offset, GLsizeiptr size, void* data)   \
+  X(glMapNamedBuffer, void*, GLuint buffer, GLenum access)                                        \
+  X(glMapNamedBufferRange, void*, GLuint buffer, GLintptr offset, GLsizeiptr length,              \
+    GLbitfield access)                                                                            \
+  X(glUnmapNamedBuffer, GLboolean, GLuint buffer)                                                 \
+  X(glCopyNamedBufferSubData, void, GLuint readBuffer, GLuint writeBuffer, GLintptr readOffset,  \
+    GLintptr writeOffset, GLsizeiptr size)                                                        \
+  X(glCreateTextures, void, GLenum target, GLsizei n, GLuint* textures)                           \
+  X(glTextureStorage1D, void, GLuint texture, GLsizei levels, GLenum internalformat,              \
+    GLsizei width)                                                                                \
+  X(glTextureStorage2D, void, GLuint texture, GLsizei levels, GLenum internalformat,              \
+    GLsizei width, GLsizei height)                                                                \
+  X(glTextureStorage2DMultisample, void, GLuint texture, GLsizei samples, GLenum internalformat,  \
+    GLsizei width, GLsizei height, GLboolean fixedsamplelocations)                                \
+  X(glTextureStorage3D, void, GLuint texture, GLsizei levels, GLenum internalformat,              \
+    GLsizei width, GLsizei height, GLsizei depth)                                                 \
+  X(glTextureStorage3DMultisample, void, GLuint texture, GLsizei samples, GLenum internalformat,  \
+    GLsizei width, GLsizei height, GLsizei depth, GLboolean fixedsamplelocations)                 \
+  X(glTextureSubImage1D, void, GLuint texture, GLint level, GLint xoffset, GLsizei width,         \
+    GLenum format, GLenum type, const void* pixels)                                               \
+  X(glTextureSubImage2D, void, GLuint texture, GLint level, GLint xoffset, GLint yoffset,         \
+    GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels)                \
+  X(glTextureSubImage3D, void, GLuint texture, GLint level, GLint xoffset, GLint yoffset,         \
+    GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type,      \
+    const void* pixels)                                                                           \
+  X(glCompressedTextureSubImage2D, void, GLuint texture, GLint level, GLint xoffset,              \
+    GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLsizei imageSize,               \
+    const void* data)                                                                             \
+  X(glCompressedTextureSubImage3D, void, GLuint texture, GLint level, GLint xoffset,              \
+    GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format,    \
+    GLsizei imageSize, const void* data)                                                          \
+  X(glTextureBufferRange, void, GLuint texture, GLenum internalformat, GLuint buffer,             \
+    GLintptr offset, GLsizeiptr size)                                                             \
+  X(glTextureParameteri, void, GLuint texture, GLenum pname, GLint param)                         \
+  X(glGenerateTextureMipmap, void, GLuint texture)                                                \
+  X(glCreateRenderbuffers, void, GLsizei n, GLuint* renderbuffers)                                \
+  X(glNamedRenderbufferStorage, void, GLuint renderbuffer, GLenum internalformat, GLsizei width,  \
+    GLsizei height)                                                                               \
+  X(glCreateFramebuffers, void, GLsizei n, GLuint* framebuffers)                                  \
+  X(glNamedFramebufferTexture, void, GLuint framebuffer, GLenum attachment, GLuint texture,       \
+    GLint level)                                                                                  \
+  X(glNamedFramebufferTextureLayer, void, GLuint framebuffer, GLenum attachment, GLuint texture,  \
+    GLint level, GLint layer)                                                                     \
+  X(glNamedFramebufferRenderbuffer, void, GLuint framebuffer, GLenum attachment,                  \
+    GLenum renderbuffertarget, GLuint renderbuffer)                                               \
+  X(glCheckNamedFramebufferStatus, GLenum, GLuint framebuffer, GLenum target)                     \
+  X(glBlitNamedFramebuffer, void, GLuint readFramebuffer, GLuint drawFramebuffer, GLint srcX0,    \
+    GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1,    \
+    GLbitfield mask, GLenum filter)                                                               \
+  X(glEnableVertexArrayAttrib, void, GLuint vaobj, GLuint index)                                  \
+  X(glVertexArrayAttribFormat, void, GLuint vaobj, GLuint attribindex, GLint size, GLenum type,   \
+    GLboolean normalized, GLuint relativeoffset)                                                  \
+  X(glVertexArrayAttribIFormat, void, GLuint vaobj, GLuint attribindex, GLint size, GLenum type,  \
+    GLuint relativeoffset)                                                                        \
+  X(glVertexArrayAttribLFormat, void, GLuint vaobj, GLuint attribindex, GLint size, GLenum type,  \
+    GLuint relativeoffset)                                                                        \
+  X(glVertexArrayAttribBinding, void, GLuint vaobj, GLuint attribindex, GLuint bindingindex)      \
+  X(glVertexArrayVertexBuffers, void, GLuint vaobj, GLuint first, GLsizei count,                  \
+    const GLuint* buffers, const GLintptr* offsets, const GLsizei* strides)                       \
+  X(glInvalidateNamedFramebufferData, void, GLuint framebuffer, GLsizei numAttachments,           \
+    const GLenum* attachments)                                                                    \
+  X(glNamedFramebufferDrawBuffers, void, GLuint framebuffer, GLsizei n, const GLenum* bufs)
+
+// Vertex formats separate from their buffers, core since 4.3 or through
+// GL_ARB_vertex_attrib_binding. Attribute pointers are used without them.
+#define SHOGLE_GL_DOFUNCS_ATTRIB_BINDING(X)                                                       \
+  X(glVertexAttribFormat, void, GLuint attribindex, GLint size, GLenum type,                      \
+    GLboolean normalized, GLuint relativeoffset)                                                  \
+  X(glVertexAttribIFormat, void, GLuint attribindex, GLint size, GLenum type,                     \
+    GLuint relativeoffset)                                                                        \
+  X(glVertexAttribLFormat, void, GLuint attribindex, GLint size, GLenum type,                     \
+    GLuint relativeoffset)                                                                        \
+  X(glVertexAttribBinding, void, GLuint attribindex, GLuint bindingindex)                         \
+  X(glBindVertexBuffer, void, GLuint bindingindex, GLuint buffer, GLintptr offset,                \
+    GLsizei stride)
+
+// GL_ARB_bindless_texture, textures sampled through 64-bit handles instead of texture units
+#define SHOGLE_GL_DOFUNCS_BINDLESS(X)                                                             \
+  X(glGetTextureHandleARB, GLuint64, GLuint texture)                                              \
+  X(glMakeTextureHandleResidentARB, void, GLuint64 handle)                                        \
+  X(glMakeTextureHandleNonResidentARB, void, GLuint64 handle)
 
 #define SHOGLE_GL_DECLPROC(name_, ret_, ...) \
   typedef ret_(SHOGLE_GLAPI_ENTRY* PFN_shogle_##name_)(__VA_ARGS__);
@@ -275,9 +483,15 @@ SHOGLE_GL_DECLPROC(glDebugProc, void, GLenum src, GLenum type, GLenum id, GLenum
                    GLsizei length, const char* message, const void* user)
 
 SHOGLE_GL_DOFUNCS(SHOGLE_GL_DECLPROC)
+SHOGLE_GL_DOFUNCS_DSA(SHOGLE_GL_DECLPROC)
+SHOGLE_GL_DOFUNCS_ATTRIB_BINDING(SHOGLE_GL_DECLPROC)
+SHOGLE_GL_DOFUNCS_BINDLESS(SHOGLE_GL_DECLPROC)
 
 typedef struct shogle_gl_functions {
   SHOGLE_GL_DOFUNCS(SHOGLE_GL_DEFPROC)
+  SHOGLE_GL_DOFUNCS_DSA(SHOGLE_GL_DEFPROC)
+  SHOGLE_GL_DOFUNCS_ATTRIB_BINDING(SHOGLE_GL_DEFPROC)
+  SHOGLE_GL_DOFUNCS_BINDLESS(SHOGLE_GL_DEFPROC)
 } shogle_gl_functions;
 
 typedef void* (*PFN_shogle_glGetProcAddress)(void* user, const char* name);
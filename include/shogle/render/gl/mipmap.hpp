@@ -0,0 +1,79 @@
+#pragma once
+
+#include <shogle/render/gl/texture.hpp>
+
+namespace shogle {
+
+// Builds a mipmap chain on the CPU, for when glGenerateMipmap's filter isn't good enough.
+// Generation doesn't touch the context, so chains can be built on a loader thread and uploaded
+// later from the render thread. Only 2D images with U8 or F32 color channels are supported.
+class gl_mip_chain {
+public:
+  enum mip_filter : u8 {
+    FILTER_BOX = 0,
+    FILTER_KAISER,
+  };
+
+  struct generate_args {
+    mip_filter filter;
+    bool srgb;         // Average U8 color channels in linear space, alpha is always linear
+    u32 max_levels;    // Including the base level, clamped to MAX_MIPMAP_LEVEL
+    f32 kaiser_beta;   // Window shape, higher values blur more and ring less
+    f32 kaiser_radius; // In destination texels
+
+    static constexpr inline generate_args make_default(mip_filter filter, bool srgb) {
+      return {
+        .filter = filter,
+        .srgb = srgb,
+        .max_levels = gl_texture::MAX_MIPMAP_LEVEL,
+        .kaiser_beta = 4.f,
+        .kaiser_radius = 2.f,
+      };
+    }
+  };
+
+private:
+  struct mip_level {
+    size_t offset;
+    extent2d extent;
+  };
+
+  struct create_t {};
+
+public:
+  gl_mip_chain(create_t, std::vector<u8>&& storage, std::vector<mip_level>&& levels,
+               gl_texture::pixel_format format, gl_texture::pixel_data_type datatype);
+
+  gl_mip_chain(const gl_texture::image_data& base,
+               const generate_args& args = generate_args::make_default(FILTER_BOX, false));
+
+public:
+  // Fails with GL_INVALID_ENUM on unsupported pixel formats and GL_INVALID_VALUE on 3D images
+  static gl_expect<gl_mip_chain>
+  generate(const gl_texture::image_data& base,
+           const generate_args& args = generate_args::make_default(FILTER_BOX, false));
+
+  // Averages 2x2 texel blocks of a tightly packed float image with even extent.
+  // Vectorized with AVX2, SSE2 or NEON when the target has them.
+  static void reduce_2x2(const f32* src, f32* dst, u32 width, u32 height, u32 channels) noexcept;
+  static void reduce_2x2_scalar(const f32* src, f32* dst, u32 width, u32 height,
+                                u32 channels) noexcept;
+
+public:
+  // Uploads every generated level that fits in the texture, the base level is left untouched
+  gl_expect<void> upload(gl_context& gl, gl_texture& texture, u32 layer = 0) const;
+
+public:
+  // Level zero is the base image, which isn't stored in the chain
+  gl_texture::image_data level(u32 level) const;
+  u32 level_count() const noexcept { return static_cast<u32>(_levels.size()); }
+  size_t storage_size() const noexcept { return _storage.size(); }
+
+private:
+  std::vector<u8> _storage;
+  std::vector<mip_level> _levels;
+  gl_texture::pixel_format _format;
+  gl_texture::pixel_data_type _datatype;
+};
+
+} // namespace shogle
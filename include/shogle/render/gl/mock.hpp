@@ -0,0 +1,78 @@
+#pragma once
+
+#include <shogle/render/gl/common.hpp>
+
+#include <shogle/util/function.hpp>
+
+namespace shogle {
+
+class gl_mock_state;
+
+// Software stand-in for an OpenGL driver, runs the renderer without a GPU.
+// Stubs track object names and bound state, and every call gets recorded in a binary trace.
+// Stubs act on the mock that was made current in the calling thread, like a real context.
+class gl_mock_provider {
+public:
+  struct call_stats {
+    u64 calls;
+    u64 draw_calls;
+    u64 state_changes;
+    u64 redundant_state_changes;
+  };
+
+  using trace_callback = fn_ref<void(std::string_view func, span<const u64> args)>;
+
+  // GPU time taken by every draw call, timestamp queries read this clock
+  static constexpr u64 DRAW_TIME_NS = 1000;
+
+public:
+  explicit gl_mock_provider(extent2d extent = {800, 600}, gl_version version = {4, 6});
+
+  gl_mock_provider(gl_mock_provider&&) noexcept;
+  gl_mock_provider(const gl_mock_provider&) = delete;
+  ~gl_mock_provider() noexcept;
+
+public:
+  gl_mock_provider& operator=(gl_mock_provider&&) noexcept;
+  gl_mock_provider& operator=(const gl_mock_provider&) = delete;
+
+public:
+  void* gl_get_proc(const char* name) noexcept;
+  extent2d surface_extent() const noexcept;
+
+public:
+  void make_current() noexcept;
+  void set_surface_extent(extent2d extent) noexcept;
+
+  // The next glGetError call will return this error
+  void push_error(gldefs::GLenum err) noexcept;
+
+  // Non-blocking fence waits report GL_TIMEOUT_EXPIRED this many times before signaling
+  void set_fence_latency(u32 polls) noexcept;
+
+  // Shaders and programs report GL_COMPLETION_STATUS_KHR as false this many times after
+  // compiling or linking. Status queries that block still see the result right away.
+  void set_compile_latency(u32 polls) noexcept;
+
+  // Timestamp queries report GL_QUERY_RESULT_AVAILABLE as false this many times after
+  // glQueryCounter. Blocking result reads see the timestamp right away.
+  void set_query_latency(u32 polls) noexcept;
+
+  // Hides an extension from contexts created afterwards
+  void disable_extension(std::string_view name) noexcept;
+
+  // Clears counters and the trace, object and binding tracking is kept
+  void reset_stats() noexcept;
+
+  call_stats stats() const noexcept;
+  u64 call_count(std::string_view func) const noexcept;
+  u32 live_objects() const noexcept;
+
+  span<const u8> trace() const noexcept;
+  void decode_trace(trace_callback callback) const;
+
+private:
+  std::unique_ptr<gl_mock_state> _state;
+};
+
+} // namespace shogle
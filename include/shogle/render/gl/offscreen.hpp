@@ -0,0 +1,96 @@
+#pragma once
+
+#include <shogle/render/gl/common.hpp>
+
+namespace shogle {
+
+struct gl_offscreen_state;
+
+// Headless OpenGL context for machines without a display server. EGL and OSMesa are loaded at
+// runtime, so nothing has to be installed at build time and a missing driver is just an error.
+// Frames go to a framebuffer object owned by the provider, read back with read_pixels or the
+// asynchronous readback queue.
+class gl_offscreen_provider {
+private:
+  struct create_t {};
+
+public:
+  enum platform_backend {
+    // EGL surfaceless first, then OSMesa
+    BACKEND_AUTO = 0,
+    BACKEND_EGL,
+    BACKEND_OSMESA,
+  };
+
+  struct create_args {
+    extent2d extent;
+    // Minimum core profile version, drivers usually hand out their newest one
+    gl_version version;
+    platform_backend backend;
+    bool debug;
+  };
+
+  // Readbacks in flight at once, request_readback fails while all of them are pending
+  static constexpr u32 READBACK_SLOTS = 2;
+
+  // Tightly packed RGBA8 rows, bottom row first like glReadPixels
+  static constexpr u32 PIXEL_SIZE = 4;
+
+public:
+  gl_offscreen_provider(create_t, std::unique_ptr<gl_offscreen_state>&& state) noexcept;
+
+  explicit gl_offscreen_provider(const create_args& args = {{800, 600}, {3, 3}, BACKEND_AUTO,
+                                                            false});
+
+public:
+  static sv_expect<gl_offscreen_provider> create(const create_args& args) noexcept;
+
+public:
+  gl_offscreen_provider(gl_offscreen_provider&&) noexcept;
+  gl_offscreen_provider(const gl_offscreen_provider&) = delete;
+  ~gl_offscreen_provider() noexcept;
+
+public:
+  gl_offscreen_provider& operator=(gl_offscreen_provider&&) noexcept;
+  gl_offscreen_provider& operator=(const gl_offscreen_provider&) = delete;
+
+public:
+  void* gl_get_proc(const char* name) noexcept;
+  extent2d surface_extent() const noexcept;
+  gldefs::GLhandle default_framebuffer() const noexcept;
+
+public:
+  void make_current() noexcept;
+
+  // Reallocates the attachments, the framebuffer name stays the same.
+  // Pending readbacks are dropped.
+  sv_expect<void> set_surface_extent(extent2d extent) noexcept;
+
+  // Blocks until the frame is done and copies it to `out`
+  sv_expect<void> read_pixels(span<u8> out) noexcept;
+
+  // Starts copying the framebuffer to a pixel buffer, the copy overlaps with the next frames
+  sv_expect<void> request_readback() noexcept;
+
+  // Copies the oldest requested readback to `out`, waits only if it is not done yet
+  sv_expect<void> resolve_readback(span<u8> out) noexcept;
+
+  void destroy() noexcept;
+
+public:
+  platform_backend backend() const noexcept;
+  u32 pending_readbacks() const noexcept;
+  size_t frame_size() const noexcept;
+
+  bool invalidated() const noexcept { return _state == nullptr; }
+
+public:
+  explicit operator bool() const noexcept { return !invalidated(); }
+
+private:
+  std::unique_ptr<gl_offscreen_state> _state;
+};
+
+static_assert(gl_offscreen_provider_type<gl_offscreen_provider>);
+
+} // namespace shogle
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <shogle/render/gl/context.hpp>
+#include <shogle/render/gl/ring_buffer.hpp>
+#include <shogle/render/gl/vertex.hpp>
+
+#include <deque>
+#include <vector>
+
+namespace shogle {
+
+// Spawns, simulates and draws particles in bulk, every particle of the system in one instanced
+// draw of a camera facing quad.
+// The GPU path runs a compute shader over two storage buffers, reading one and writing the
+// other, and never reads anything back. Emitters spawn into a ring of slots, overwriting
+// whatever was there, so the capacity should cover rate times lifetime of every emitter.
+// The CPU path keeps the particles packed in SoA arrays allocated from its own arena,
+// integrates them with AVX2, SSE2 or NEON when the target has them, and streams the live ones to
+// a ring buffer when drawn. It is used when compute shaders are missing (GL < 4.3).
+//
+// The pipeline takes a billboard_vertex at location 0, one per quad corner, and reads the
+// particle of each instance from the gpu_particle array bound at particle_binding. Slots on the
+// GPU path can hold dead particles, the vertex shader has to discard the ones with
+// age >= life. Draws read the state left by the last update and have to happen once per frame,
+// between begin_frame and end_frame.
+class gl_particle_system {
+public:
+  using context_type = gl_context;
+  using deleter_type = gl_deleter<gl_particle_system>;
+
+public:
+  static constexpr u32 DEFAULT_CAPACITY = 65536;
+  static constexpr u32 MAX_EMITTERS = 32;
+  static constexpr u32 MAX_UPDATES_PER_FRAME = 8; // GPU path, each one uploads its parameters
+  static constexpr u32 COMPUTE_GROUP_SIZE = 256;
+  static constexpr u32 VERTICES_PER_PARTICLE = 4;
+  static constexpr u32 INDICES_PER_PARTICLE = 6;
+
+  enum sim_path {
+    SIM_PATH_CPU = 0,
+    SIM_PATH_GPU,
+  };
+
+  struct billboard_vertex {
+  public:
+    static constexpr u32 attribute_count = 1u;
+    static constexpr inline auto attributes() noexcept;
+
+  public:
+    vec2 corner; // In [-.5, .5]
+  };
+
+  // std430 layout of the particle array
+  struct gpu_particle {
+    vec4 pos_age;  // Position, seconds since it spawned
+    vec4 vel_life; // Velocity, seconds it lives for
+  };
+
+  struct emitter_desc {
+    vec3 position;
+    vec3 position_spread; // Half extents of the spawn box
+    vec3 velocity;
+    vec3 velocity_spread; // Added in [-spread, spread] per axis
+    f32 min_life;
+    f32 max_life;
+    f32 rate; // Particles per second
+  };
+
+  struct create_args {
+    u32 capacity;
+    vec3 gravity;
+    f32 drag;             // Fraction of the velocity lost per second
+    sim_path path;        // SIM_PATH_GPU falls back to the CPU without compute shaders
+    u32 particle_binding; // Storage buffer location of the particle array when drawing
+    u32 frame_regions;    // Frames in flight
+    u32 seed;
+
+    static constexpr inline create_args make_default() {
+      return {
+        .capacity = DEFAULT_CAPACITY,
+        .gravity = {0.f, -9.8f, 0.f},
+        .drag = 0.f,
+        .path = SIM_PATH_GPU,
+        .particle_binding = 0,
+        .frame_regions = gl_ring_buffer::DEFAULT_FRAME_REGIONS,
+        .seed = 0x2545f491u,
+      };
+    }
+  };
+
+  // Views of the CPU path arrays, each one 64 byte aligned
+  struct particle_arrays {
+    f32* pos[3];
+    f32* vel[3];
+    f32* age;
+    f32* life;
+  };
+
+  struct step_args {
+    vec3 gravity;
+    f32 drag;
+    f32 dt;
+  };
+
+private:
+  struct emitter_state {
+    emitter_desc desc;
+    f32 accum; // Fractional spawns carried to the next update
+    u32 burst;
+  };
+
+  struct create_t {};
+
+public:
+  gl_particle_system(create_t, mem::scratch_arena&& arena, const particle_arrays& particles,
+                     std::vector<gl_buffer>&& particle_buffers, gldefs::GLhandle program,
+                     gl_ring_buffer&& ring, gl_buffer corners, gl_buffer indices,
+                     gl_vertex_layout layout, const create_args& args);
+
+  gl_particle_system(gl_context& gl, const create_args& args = create_args::make_default());
+
+public:
+  // Fails with the compiler log if the simulation shader doesn't build
+  static gl_s_expect<gl_particle_system>
+  create(gl_context& gl, const create_args& args = create_args::make_default());
+
+  static void destroy(gl_context& gl, gl_particle_system& particles) noexcept;
+
+  // Advances count particles by one step: velocity loses drag and gains gravity, then moves
+  // the position. Vectorized with AVX2, SSE2 or NEON when the target has them.
+  static void integrate(const particle_arrays& particles, u32 count,
+                        const step_args& args) noexcept;
+  static void integrate_scalar(const particle_arrays& particles, u32 count,
+                               const step_args& args) noexcept;
+
+public:
+  // Returns the emitter index, or nullopt past MAX_EMITTERS
+  optional<u32> add_emitter(const emitter_desc& desc);
+  // Moving an emitter only affects the particles it spawns afterwards
+  emitter_desc& emitter(u32 index);
+  // Spawned on the next update, on top of the emitter rate
+  void burst(u32 index, u32 count);
+
+  // Spawns and simulates dt seconds. Fails on the GPU path past MAX_UPDATES_PER_FRAME.
+  gl_sv_expect<void> update(gl_context& gl, f32 dt);
+
+  // Waits for the ring region of the frame
+  gl_expect<void> begin_frame(gl_context& gl);
+  void end_frame(gl_context& gl);
+
+  gl_sv_expect<void> draw(gl_context& gl, const gl_graphics_pipeline& pipeline,
+                          ptr_view<const gl_framebuffer> target = {},
+                          span<const gl_draw_command::push_uniform> uniforms = {});
+
+public:
+  const gl_vertex_layout& layout() const;
+  sim_path path() const;
+  u32 capacity() const;
+  // Live particles on the CPU path, every slot on the GPU path
+  u32 size() const;
+  // Empty views on the GPU path
+  const particle_arrays& cpu_particles() const;
+  // Holds the particles of the last update on the GPU path
+  const gl_buffer& particle_buffer() const;
+
+  bool invalidated() const noexcept;
+
+public:
+  explicit operator bool() const noexcept { return !invalidated(); }
+
+private:
+  // Fills _spawns, the total stays within budget
+  u32 _take_spawns(f32 dt, u32 budget);
+  gl_sv_expect<void> _update_gpu(gl_context& gl, f32 dt);
+  void _update_cpu(f32 dt);
+  f32 _random() noexcept; // In [0, 1)
+
+private:
+  mem::scratch_arena _arena;
+  particle_arrays _cpu;
+  std::vector<gl_buffer> _gpu; // Ping-pong pair, empty on the CPU path
+  gldefs::GLhandle _program;   // Simulation, GL_NULL_HANDLE on the CPU path
+  gl_ring_buffer _ring;
+  gl_buffer _corners;
+  gl_buffer _indices;
+  gl_vertex_layout _layout;
+  std::vector<emitter_state> _emitters;
+  std::vector<u32> _spawns; // Per emitter, for the update in progress
+  std::deque<gl_draw_command::shader_binding> _shader_binds;
+  std::deque<gl_draw_command::vertex_binding> _vertex_binds;
+  vec3 _gravity;
+  f32 _drag;
+  sim_path _path;
+  u32 _capacity;
+  u32 _particle_binding;
+  u32 _alive;
+  u32 _cursor;  // Next slot to spawn into on the GPU path
+  u32 _current; // Particle buffer written by the last update
+  u32 _rng;
+};
+
+constexpr inline auto gl_particle_system::billboard_vertex::attributes() noexcept {
+  return std::to_array<vertex_attribute>({
+    {.location = 0, .type = attribute_type::vec2, .offset = offsetof(billboard_vertex, corner)},
+  });
+}
+
+static_assert(::shogle::meta::renderer_object_type<gl_particle_system>);
+
+template<>
+struct gl_deleter<gl_particle_system> {
+public:
+  gl_deleter(gl_context& gl) noexcept : _gl(&gl) {}
+
+public:
+  void operator()(gl_particle_system& particles) const noexcept {
+    gl_particle_system::destroy(*_gl, particles);
+  }
+
+private:
+  gl_context* _gl;
+};
+
+} // namespace shogle
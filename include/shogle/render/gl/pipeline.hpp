@@ -394,6 +394,24 @@ public:
     shader_attrib_type type;
   };
 
+  struct uniform_block_props {
+    char name[MAX_NAME_SIZE];
+    size_t name_len;
+    size_t data_size;
+    u32 binding;
+    u32 member_count;
+  };
+
+  struct uniform_member_props {
+    char name[MAX_NAME_SIZE];
+    size_t name_len;
+    size_t offset;
+    size_t array_stride;  // Zero if the member is not an array
+    size_t matrix_stride; // Zero if the member is not a matrix
+    size_t size;
+    shader_attrib_type type;
+  };
+
 private:
   struct create_t {};
 
@@ -403,8 +421,16 @@ public:
   gl_graphics_pipeline(gl_context& gl, const gl_shader::graphics_set& shaders);
 
 public:
+  // A retrievable program can be read back with program_binary
   static gl_s_expect<gl_graphics_pipeline> create(gl_context& gl,
-                                                  const gl_shader::graphics_set& shaders);
+                                                  const gl_shader::graphics_set& shaders,
+                                                  bool retrievable_binary = false);
+
+  // Fails if the driver rejects the binary, it has to be rebuilt from source then
+  static gl_expect<gl_graphics_pipeline> create_from_binary(gl_context& gl,
+                                                            gldefs::GLenum binary_format,
+                                                            span<const u8> binary,
+                                                            gldefs::GLbitfield stages);
 
   static void destroy(gl_context& gl, gl_graphics_pipeline& pipeline) noexcept;
 
@@ -422,6 +448,17 @@ public:
   shader_attrib_type query_attribute_index(gl_context& gl, shader_attrib_props& props,
                                            u32 idx) const;
 
+  optional<u32> uniform_block_index(gl_context& gl, const char* name) const;
+  u32 uniform_block_count(gl_context& gl) const;
+  bool query_uniform_block(gl_context& gl, uniform_block_props& props, u32 block) const;
+  // Returns the number of members written, at most members.size()
+  u32 query_uniform_block_members(gl_context& gl, u32 block,
+                                  span<uniform_member_props> members) const;
+  void set_uniform_block_binding(gl_context& gl, u32 block, u32 binding) const;
+
+  // Returns the binary format, the binary itself gets written to out
+  gl_expect<gldefs::GLenum> program_binary(gl_context& gl, std::vector<u8>& out) const;
+
 public:
   gl_graphics_pipeline& reset_props();
 
@@ -434,6 +471,9 @@ public:
   gl_graphics_pipeline& set_blending(const gl_blending_props& blending);
   gl_graphics_pipeline& set_culling(const gl_culling_props& culling);
 
+  // Exchanges the programs of both pipelines, render state props stay where they are
+  void swap_program(gl_graphics_pipeline& other) noexcept;
+
 public:
   gldefs::GLhandle program() const;
   gldefs::GLbitfield stages() const;
@@ -462,6 +502,9 @@ private:
   primitive_mode _primitive;
   polygon_mode _poly_mode;
   f32 _poly_width;
+
+private:
+  friend class gl_pipeline_compiler;
 };
 
 static_assert(::shogle::meta::renderer_object_type<gl_graphics_pipeline>);
@@ -484,4 +527,12 @@ private:
   gl_context* _gl;
 };
 
+struct gl_pipeline_sources {
+  std::string_view vertex;
+  std::string_view fragment;
+  std::string_view geometry{};  // Optional
+  std::string_view tess_ctrl{}; // Optional
+  std::string_view tess_eval{}; // Optional
+};
+
 } // namespace shogle
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <shogle/render/gl/pipeline.hpp>
+
+namespace shogle {
+
+// On-disk cache of linked program binaries, keyed by the shader sources.
+// Entries live under <dir>/v<FORMAT_VERSION>/<driver hash>/, so a driver update or a format
+// change just misses instead of feeding a stale binary to glProgramBinary.
+class gl_pipeline_cache {
+public:
+  static constexpr u32 FORMAT_VERSION = 1;
+
+  struct cache_stats {
+    u32 hits;
+    u32 misses;
+    u32 rejected; // Entries the driver refused to load
+  };
+
+public:
+  gl_pipeline_cache(gl_context& gl, std::string_view dir);
+
+public:
+  // Hits skip shader compilation entirely
+  gl_s_expect<gl_graphics_pipeline> create_pipeline(gl_context& gl,
+                                                    const gl_pipeline_sources& sources);
+
+  static u64 hash_sources(const gl_pipeline_sources& sources) noexcept;
+
+public:
+  std::string entry_path(u64 source_hash) const;
+  std::string_view directory() const noexcept { return _dir; }
+  u64 driver_hash() const noexcept { return _driver_hash; }
+  const cache_stats& stats() const noexcept { return _stats; }
+
+private:
+  optional<gl_graphics_pipeline> _load(gl_context& gl, u64 source_hash);
+  void _store(gl_context& gl, const gl_graphics_pipeline& pipeline, u64 source_hash);
+
+private:
+  std::string _dir;
+  u64 _driver_hash;
+  cache_stats _stats;
+};
+
+} // namespace shogle
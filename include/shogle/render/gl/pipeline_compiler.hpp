@@ -0,0 +1,98 @@
+#pragma once
+
+#include <shogle/render/gl/pipeline.hpp>
+
+namespace shogle {
+
+// Builds pipelines without stalling on the driver's compiler.
+// With GL_KHR_parallel_shader_compile every shader and program is submitted right away and
+// poll() collects the ones the driver threads have finished. Without the extension submissions
+// are queued and poll() compiles up to sync_budget of them, so the cost is still spread over
+// several frames.
+class gl_pipeline_compiler {
+public:
+  using context_type = gl_context;
+  using deleter_type = gl_deleter<gl_pipeline_compiler>;
+
+public:
+  using ticket = u32;
+
+  static constexpr u32 DEFAULT_SYNC_BUDGET = 4;
+
+private:
+  static constexpr u32 MAX_STAGES = 5;
+
+  struct compile_job {
+    std::array<gldefs::GLhandle, MAX_STAGES> shaders;
+    std::array<std::string, MAX_STAGES> sources; // Queued jobs only
+    gldefs::GLhandle program;
+    gldefs::GLbitfield stages;
+    optional<gl_s_expect<gl_graphics_pipeline>> result;
+    bool retrievable_binary;
+    bool submitted;
+    bool active;
+  };
+
+public:
+  explicit gl_pipeline_compiler(gl_context& gl, u32 sync_budget = DEFAULT_SYNC_BUDGET);
+
+public:
+  // Deletes pending programs and every finished pipeline that wasn't taken
+  static void destroy(gl_context& gl, gl_pipeline_compiler& compiler) noexcept;
+
+public:
+  // A retrievable program can be read back with program_binary
+  ticket submit(gl_context& gl, const gl_pipeline_sources& sources,
+                bool retrievable_binary = false);
+
+  // Returns how many pipelines finished in this call
+  u32 poll(gl_context& gl);
+  // Blocks until every submitted pipeline is done
+  void finish(gl_context& gl);
+
+  bool is_ready(ticket job) const;
+  // Ready tickets only, the ticket can't be used again afterwards
+  gl_s_expect<gl_graphics_pipeline> take(ticket job);
+
+public:
+  bool parallel() const noexcept { return _parallel; }
+  u32 pending_count() const noexcept { return static_cast<u32>(_pending.size()); }
+  u32 sync_budget() const noexcept { return _sync_budget; }
+
+  bool invalidated() const noexcept { return _sync_budget == 0; }
+
+public:
+  explicit operator bool() const noexcept { return !invalidated(); }
+
+private:
+  void _submit_job(gl_context& gl, compile_job& job,
+                   const std::array<std::string_view, MAX_STAGES>& sources);
+  void _submit_queued(gl_context& gl, compile_job& job);
+  void _resolve_job(gl_context& gl, compile_job& job);
+  void _release_job(gl_context& gl, compile_job& job) noexcept;
+
+private:
+  std::vector<compile_job> _jobs;
+  std::vector<ticket> _free_jobs;
+  std::vector<ticket> _pending; // In submission order
+  u32 _sync_budget; // Zero once destroyed
+  bool _parallel;
+};
+
+static_assert(::shogle::meta::renderer_object_type<gl_pipeline_compiler>);
+
+template<>
+struct gl_deleter<gl_pipeline_compiler> {
+public:
+  gl_deleter(gl_context& gl) noexcept : _gl(&gl) {}
+
+public:
+  void operator()(gl_pipeline_compiler& compiler) const noexcept {
+    gl_pipeline_compiler::destroy(*_gl, compiler);
+  }
+
+private:
+  gl_context* _gl;
+};
+
+} // namespace shogle
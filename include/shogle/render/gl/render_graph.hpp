@@ -0,0 +1,170 @@
+#pragma once
+
+#include <shogle/render/gl/context.hpp>
+#include <shogle/render/gl/framebuffer.hpp>
+
+#include <functional>
+#include <vector>
+
+namespace shogle {
+
+// Frame described as passes that declare the textures they read and write.
+// Compiling culls passes that don't contribute to an output, orders the rest and lets transient
+// textures with the same format and extent share storage when their lifetimes don't overlap.
+// It doesn't touch the context, execute allocates the textures and framebuffers the schedule
+// needs and keeps them across frames until the graph gets recompiled with different ones.
+//
+// Every write to a texture happens before any read of it, several writers of the same texture
+// run in declaration order. Passes have to submit in immediate mode, since barriers and
+// invalidations are issued between them. With a profiler attached, every pass executed inside a
+// frame gets a zone named after it.
+class gl_render_graph {
+public:
+  using context_type = gl_context;
+  using deleter_type = gl_deleter<gl_render_graph>;
+
+public:
+  using resource_id = u32;
+  using pass_id = u32;
+
+  static constexpr u32 MAX_COLOR_ATTACHMENTS = 8;
+
+  enum texture_access : u8 {
+    ACCESS_SAMPLED = 0, // Read through a sampler
+    ACCESS_IMAGE_READ,  // Read with image loads
+    ACCESS_IMAGE_WRITE, // Written with image stores
+    ACCESS_COLOR,       // Color attachment, in declaration order
+    ACCESS_DEPTH,       // Depth or depth stencil attachment
+  };
+
+  enum barrier_bits : gldefs::GLbitfield {
+    BARRIER_NONE = 0x00000000,
+    BARRIER_TEXTURE_FETCH = 0x00000008, // GL_TEXTURE_FETCH_BARRIER_BIT
+    BARRIER_IMAGE_ACCESS = 0x00000020,  // GL_SHADER_IMAGE_ACCESS_BARRIER_BIT
+    BARRIER_FRAMEBUFFER = 0x00000400,   // GL_FRAMEBUFFER_BARRIER_BIT
+  };
+
+  struct texture_desc {
+    gl_texture::texture_format format;
+    extent2d extent;
+  };
+
+  struct pass_context {
+    ptr_view<const gl_framebuffer> target; // Empty for passes without attachments
+    extent2d extent;
+  };
+
+  using pass_callback = std::function<void(gl_context& gl, const pass_context& ctx)>;
+
+  struct compiled_pass {
+    pass_id pass;
+    gldefs::GLbitfield barriers; // Issued before the pass runs
+    u32 invalidate_colors;       // Color attachments dead after the pass, one bit each
+    bool invalidate_depth;
+  };
+
+private:
+  struct texture_access_node {
+    resource_id res;
+    texture_access access;
+  };
+
+  struct resource_node {
+    std::string name;
+    texture_desc desc;
+    ptr_view<const gl_texture> imported;
+    bool output;
+    u32 first_use;
+    u32 last_use;
+    u32 physical;
+  };
+
+  struct pass_node {
+    std::string name;
+    pass_callback callback;
+    std::vector<texture_access_node> reads;
+    std::vector<texture_access_node> writes;
+    bool side_effect;
+  };
+
+public:
+  static constexpr resource_id NULL_RESOURCE = std::numeric_limits<resource_id>::max();
+
+public:
+  gl_render_graph() noexcept;
+
+public:
+  // Releases the pooled textures and framebuffers, the passes and resources are kept
+  static void destroy(gl_context& gl, gl_render_graph& graph) noexcept;
+
+public:
+  // Transient textures only exist while passes use them
+  resource_id create_texture(std::string_view name, const texture_desc& desc);
+  // Imported textures are never aliased and count as outputs
+  resource_id import_texture(std::string_view name, const gl_texture& texture);
+  // Keeps a transient texture alive after the last pass, to read it back after execute
+  void set_output(resource_id res);
+
+  pass_id add_pass(std::string_view name, pass_callback callback);
+  gl_render_graph& read(pass_id pass, resource_id res, texture_access access = ACCESS_SAMPLED);
+  gl_render_graph& write(pass_id pass, resource_id res, texture_access access = ACCESS_COLOR);
+  // Never culled, for passes that present or write to untracked buffers
+  void set_side_effect(pass_id pass);
+
+  // Drops every pass and resource, pooled textures are kept for the next compile
+  void reset();
+
+public:
+  gl_sv_expect<void> compile();
+  gl_sv_expect<void> execute(gl_context& gl);
+
+public:
+  // Valid during and after execute
+  const gl_texture& texture(resource_id res) const;
+
+  span<const compiled_pass> schedule() const noexcept {
+    return {_schedule.data(), _schedule.size()};
+  }
+  bool culled(pass_id pass) const;
+  // Index of the pooled texture backing a transient resource
+  u32 physical_index(resource_id res) const;
+  u32 physical_count() const noexcept { return static_cast<u32>(_physical.size()); }
+  u32 transient_count() const noexcept;
+
+  // Nothing to release until the first execute
+  bool invalidated() const noexcept { return _textures.empty() && _framebuffers.empty(); }
+
+public:
+  explicit operator bool() const noexcept { return !invalidated(); }
+
+private:
+  void _release_framebuffers(gl_context& gl) noexcept;
+  void _invalidate_attachments(gl_context& gl, u32 position) const;
+  gl_sv_expect<void> _allocate_textures(gl_context& gl);
+  gl_sv_expect<void> _create_framebuffers(gl_context& gl);
+
+private:
+  std::vector<resource_node> _resources;
+  std::vector<pass_node> _passes;
+  std::vector<compiled_pass> _schedule;
+  std::vector<texture_desc> _physical;
+  std::vector<gl_texture> _textures;
+  std::vector<optional<gl_framebuffer>> _framebuffers; // By schedule position
+  bool _dirty;
+};
+
+static_assert(::shogle::meta::renderer_object_type<gl_render_graph>);
+
+template<>
+struct gl_deleter<gl_render_graph> {
+public:
+  gl_deleter(gl_context& gl) noexcept : _gl(&gl) {}
+
+public:
+  void operator()(gl_render_graph& graph) const noexcept { gl_render_graph::destroy(*_gl, graph); }
+
+private:
+  gl_context* _gl;
+};
+
+} // namespace shogle
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <shogle/render/gl/buffer.hpp>
+
+namespace shogle {
+
+// Persistently mapped buffer split in per-frame regions, each one guarded by a fence.
+// Writes go straight to mapped memory, the GPU only gets stalled if it still holds
+// the region we are about to reuse.
+class gl_ring_buffer {
+public:
+  using context_type = gl_context;
+  using deleter_type = gl_deleter<gl_ring_buffer>;
+
+public:
+  static constexpr u32 MAX_FRAME_REGIONS = 4;
+  static constexpr u32 DEFAULT_FRAME_REGIONS = 3;
+  static constexpr u64 DEFAULT_WAIT_TIMEOUT = 1000000000; // 1s, in nanoseconds
+
+  struct allocation {
+    void* ptr;
+    size_t offset; // Relative to the whole buffer
+    size_t size;
+  };
+
+private:
+  struct create_t {};
+
+public:
+  gl_ring_buffer(create_t, gl_buffer buffer, void* mapping, size_t region_size, u32 region_count,
+                 size_t alignment);
+
+  gl_ring_buffer(gl_context& gl, gl_buffer::buffer_type type, size_t region_size,
+                 u32 region_count = DEFAULT_FRAME_REGIONS);
+
+public:
+  static gl_expect<gl_ring_buffer> create(gl_context& gl, gl_buffer::buffer_type type,
+                                          size_t region_size,
+                                          u32 region_count = DEFAULT_FRAME_REGIONS);
+
+  static void destroy(gl_context& gl, gl_ring_buffer& ring) noexcept;
+
+public:
+  // Moves to the next region, waiting for the GPU to release it if needed
+  gl_expect<void> begin_frame(gl_context& gl, u64 timeout = DEFAULT_WAIT_TIMEOUT);
+
+  // Fences every command that may read the current region, call after the last draw using it
+  void end_frame(gl_context& gl);
+
+  // Offsets are a multiple of both `alignment` and the buffer alignment, any stride works.
+  // Returns nullopt if the current region can't fit the allocation
+  optional<allocation> allocate(size_t size, size_t alignment = 0);
+
+  template<typename T>
+  requires(std::is_trivially_copyable_v<T>)
+  optional<allocation> push(const T& data) {
+    return push(&data, sizeof(T));
+  }
+
+  template<typename T>
+  requires(std::is_trivially_copyable_v<T>)
+  optional<allocation> push(span<const T> data) {
+    return push(data.data(), data.size_bytes());
+  }
+
+  optional<allocation> push(const void* data, size_t size);
+
+public:
+  const gl_buffer& buffer() const;
+  size_t region_size() const;
+  u32 region_count() const;
+  u32 current_region() const;
+  size_t region_used() const;
+  size_t alignment() const;
+
+  // Times begin_frame had to block on a fence
+  u64 stall_count() const;
+
+  bool invalidated() const noexcept;
+
+public:
+  explicit operator bool() const noexcept { return !invalidated(); }
+
+private:
+  gl_buffer _buffer;
+  u8* _mapping;
+  size_t _region_size;
+  size_t _alignment;
+  size_t _offset;
+  u32 _region_count;
+  u32 _region;
+  u64 _stalls;
+  std::array<gldefs::GLsync, MAX_FRAME_REGIONS> _fences;
+};
+
+static_assert(::shogle::meta::renderer_object_type<gl_ring_buffer>);
+
+template<>
+struct gl_deleter<gl_ring_buffer> {
+public:
+  gl_deleter(gl_context& gl) noexcept : _gl(&gl) {}
+
+public:
+  void operator()(gl_ring_buffer& ring) const noexcept { gl_ring_buffer::destroy(*_gl, ring); }
+
+private:
+  gl_context* _gl;
+};
+
+} // namespace shogle
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <shogle/render/gl/texture.hpp>
+
+#include <unordered_map>
+
+namespace shogle {
+
+struct gl_sampler_desc {
+public:
+  enum compare_func : gldefs::GLenum {
+    COMPARE_NONE = 0x0000,      // GL_NONE, no depth comparison
+    COMPARE_NEVER = 0x0200,     // GL_NEVER
+    COMPARE_LESS = 0x0201,      // GL_LESS
+    COMPARE_EQUAL = 0x0202,     // GL_EQUAL
+    COMPARE_LEQUAL = 0x0203,    // GL_LEQUAL
+    COMPARE_GREATER = 0x0204,   // GL_GREATER
+    COMPARE_NOT_EQUAL = 0x0205, // GL_NOTEQUAL
+    COMPARE_GEQUAL = 0x0206,    // GL_GEQUAL
+    COMPARE_ALWAYS = 0x0207,    // GL_ALWAYS
+  };
+
+public:
+  gl_texture::texture_sampler min_filter;
+  gl_texture::texture_sampler mag_filter; // SAMPLER_NEAREST or SAMPLER_LINEAR
+  gl_texture::texture_wrap wrap_s;
+  gl_texture::texture_wrap wrap_t;
+  gl_texture::texture_wrap wrap_r;
+  f32 max_anisotropy; // Clamped to the driver limit, 1 disables it
+  f32 lod_bias;
+  compare_func compare;
+
+public:
+  static constexpr inline gl_sampler_desc make_default() {
+    return {
+      .min_filter = gl_texture::SAMPLER_LINEAR_MP_LINEAR,
+      .mag_filter = gl_texture::SAMPLER_LINEAR,
+      .wrap_s = gl_texture::WRAP_REPEAT,
+      .wrap_t = gl_texture::WRAP_REPEAT,
+      .wrap_r = gl_texture::WRAP_REPEAT,
+      .max_anisotropy = 1.f,
+      .lod_bias = 0.f,
+      .compare = COMPARE_NONE,
+    };
+  }
+
+  bool operator==(const gl_sampler_desc&) const = default;
+};
+
+// Sampling state kept apart from the texture, so one image can be sampled in several ways
+// without touching its parameters.
+class gl_sampler {
+public:
+  using context_type = gl_context;
+  using deleter_type = gl_deleter<gl_sampler>;
+
+private:
+  struct create_t {};
+
+public:
+  gl_sampler(create_t, gldefs::GLhandle id, const gl_sampler_desc& desc);
+  gl_sampler(gl_context& gl, const gl_sampler_desc& desc = gl_sampler_desc::make_default());
+
+public:
+  static gl_sv_expect<gl_sampler> create(gl_context& gl, const gl_sampler_desc& desc =
+                                                           gl_sampler_desc::make_default());
+
+  static void destroy(gl_context& gl, gl_sampler& sampler) noexcept;
+
+public:
+  gldefs::GLhandle id() const;
+  const gl_sampler_desc& desc() const;
+
+  bool invalidated() const noexcept;
+
+public:
+  explicit operator bool() const noexcept { return !invalidated(); }
+
+private:
+  gl_sampler_desc _desc;
+  gldefs::GLhandle _id;
+};
+
+static_assert(::shogle::meta::renderer_object_type<gl_sampler>);
+
+template<>
+struct gl_deleter<gl_sampler> {
+public:
+  gl_deleter(gl_context& gl) noexcept : _gl(&gl) {}
+
+public:
+  void operator()(gl_sampler& sampler) const noexcept { gl_sampler::destroy(*_gl, sampler); }
+
+private:
+  gl_context* _gl;
+};
+
+// Hands out one sampler per distinct description, so draws that sample the same way end up
+// with the same binding and the context can skip it. Samplers live until the cache is destroyed.
+class gl_sampler_cache {
+public:
+  using context_type = gl_context;
+  using deleter_type = gl_deleter<gl_sampler_cache>;
+
+private:
+  struct desc_hash {
+    size_t operator()(const gl_sampler_desc& desc) const noexcept;
+  };
+
+public:
+  gl_sampler_cache() noexcept = default;
+
+public:
+  static void destroy(gl_context& gl, gl_sampler_cache& cache) noexcept;
+
+public:
+  gl_sv_expect<ref_view<const gl_sampler>> get(gl_context& gl, const gl_sampler_desc& desc);
+
+public:
+  u32 size() const noexcept { return static_cast<u32>(_samplers.size()); }
+
+  // Nothing to release until the first get
+  bool invalidated() const noexcept { return _samplers.empty(); }
+
+public:
+  explicit operator bool() const noexcept { return !invalidated(); }
+
+private:
+  std::unordered_map<gl_sampler_desc, gl_sampler, desc_hash> _samplers;
+};
+
+static_assert(::shogle::meta::renderer_object_type<gl_sampler_cache>);
+
+template<>
+struct gl_deleter<gl_sampler_cache> {
+public:
+  gl_deleter(gl_context& gl) noexcept : _gl(&gl) {}
+
+public:
+  void operator()(gl_sampler_cache& cache) const noexcept {
+    gl_sampler_cache::destroy(*_gl, cache);
+  }
+
+private:
+  gl_context* _gl;
+};
+
+} // namespace shogle
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <shogle/render/gl/context.hpp>
+#include <shogle/render/gl/ring_buffer.hpp>
+#include <shogle/render/gl/vertex.hpp>
+
+#include <shogle/math/transform.hpp>
+
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+namespace shogle {
+
+// Expands sprites into quads on the CPU, straight into a persistently mapped ring buffer, and
+// draws them with one indexed draw per layer, pipeline and texture.
+// Sprites are unit quads centered at the origin, placed by a transform2d with the default roll
+// function. Draw order is only kept across layers, sprites in the same layer get grouped by
+// pipeline and texture. The pipeline takes a sprite_vertex at locations 0 (position),
+// 1 (uvs) and 2 (color), the texture gets bound to the unit given on creation.
+//
+// Flushes append to the current ring region, so every sprite queued in a frame has to fit in
+// it. In deferred submission mode the bindings of every flush are kept until the next begin_frame,
+// push uniforms have to outlive the frame.
+class gl_sprite_batch {
+public:
+  using context_type = gl_context;
+  using deleter_type = gl_deleter<gl_sprite_batch>;
+
+public:
+  static constexpr u32 DEFAULT_MAX_SPRITES = 16384;
+  static constexpr u32 MAX_LAYERS = 1u << 16;
+  static constexpr u32 VERTICES_PER_SPRITE = 4;
+  static constexpr u32 INDICES_PER_SPRITE = 6;
+
+  struct sprite_vertex {
+  public:
+    static constexpr u32 attribute_count = 3u;
+    static constexpr inline auto attributes() noexcept;
+
+  public:
+    vec2 pos;
+    vec2 uvs;
+    color4 color;
+  };
+
+  struct sprite_quad {
+    math::transform2d<f32> transform;
+    vec4 uvs; // u0, v0, u1, v1, v0 is the top row of the source
+    color4 color;
+  };
+
+  struct create_args {
+    u32 max_sprites;   // Per frame
+    u32 texture_unit;
+    u32 frame_regions; // Frames in flight
+
+    static constexpr inline create_args make_default() {
+      return {
+        .max_sprites = DEFAULT_MAX_SPRITES,
+        .texture_unit = 0,
+        .frame_regions = gl_ring_buffer::DEFAULT_FRAME_REGIONS,
+      };
+    }
+  };
+
+private:
+  struct sprite_group {
+    u64 key; // Layer, pipeline and texture, in that order
+    gldefs::GLhandle texture;
+    gldefs::GLenum texture_type;
+    u32 count;
+    u32 first;
+  };
+
+  struct create_t {};
+
+public:
+  gl_sprite_batch(create_t, gl_ring_buffer&& vertices, gl_buffer indices,
+                  gl_vertex_layout layout, const create_args& args);
+
+  gl_sprite_batch(gl_context& gl, const create_args& args = create_args::make_default());
+
+public:
+  static gl_sv_expect<gl_sprite_batch>
+  create(gl_context& gl, const create_args& args = create_args::make_default());
+
+  static void destroy(gl_context& gl, gl_sprite_batch& batch) noexcept;
+
+  // Writes four vertices per quad, bottom left first and counter clockwise
+  static void expand_quads(span<const sprite_quad> quads, sprite_vertex* out) noexcept;
+
+public:
+  // Waits for the ring region of the frame, call before queuing sprites
+  gl_expect<void> begin_frame(gl_context& gl);
+  void end_frame(gl_context& gl);
+
+  // Used by the sprites queued after it
+  void set_pipeline(const gl_graphics_pipeline& pipeline);
+
+  // Source in texels, with the origin at the top left of the image.
+  // Returns false once the frame is out of sprites.
+  bool draw(const gl_texture& texture, const rectangle_pos<u32>& source,
+            const math::transform2d<f32>& transform, const color4& color = {1.f, 1.f, 1.f, 1.f},
+            u32 layer = 0);
+
+  // Sorts the queued sprites, expands them and submits one draw per group
+  gl_sv_expect<void> flush(gl_context& gl, ptr_view<const gl_framebuffer> target = {},
+                           span<const gl_draw_command::push_uniform> uniforms = {});
+
+public:
+  const gl_vertex_layout& layout() const;
+  u32 size() const;
+  u32 capacity() const;
+  // Draws issued by the last flush
+  u32 draw_count() const;
+
+  bool invalidated() const noexcept;
+
+public:
+  explicit operator bool() const noexcept { return !invalidated(); }
+
+private:
+  u32 _find_group(u64 key, const gl_texture& texture);
+
+private:
+  gl_ring_buffer _vertices;
+  gl_buffer _indices;
+  gl_vertex_layout _layout;
+  std::vector<sprite_quad> _quads;
+  std::vector<u32> _quad_groups;
+  std::vector<sprite_group> _groups;
+  std::unordered_map<u64, u32> _group_lookup;
+  std::vector<ptr_view<const gl_graphics_pipeline>> _pipelines;
+  std::vector<u32> _cursors;
+  std::deque<gl_draw_command::vertex_binding> _vertex_binds;
+  std::deque<gl_draw_command::texture_binding> _texture_binds;
+  u64 _last_key;
+  u32 _last_group;
+  u32 _max_sprites;
+  u32 _texture_unit;
+  u32 _pipeline;
+  u32 _frame_sprites;
+  u32 _draw_count;
+};
+
+constexpr inline auto gl_sprite_batch::sprite_vertex::attributes() noexcept {
+  return std::to_array<vertex_attribute>({
+    {.location = 0, .type = attribute_type::vec2, .offset = offsetof(sprite_vertex, pos)},
+    {.location = 1, .type = attribute_type::vec2, .offset = offsetof(sprite_vertex, uvs)},
+    {.location = 2, .type = attribute_type::vec4, .offset = offsetof(sprite_vertex, color)},
+  });
+}
+
+static_assert(::shogle::meta::renderer_object_type<gl_sprite_batch>);
+
+template<>
+struct gl_deleter<gl_sprite_batch> {
+public:
+  gl_deleter(gl_context& gl) noexcept : _gl(&gl) {}
+
+public:
+  void operator()(gl_sprite_batch& batch) const noexcept { gl_sprite_batch::destroy(*_gl, batch); }
+
+private:
+  gl_context* _gl;
+};
+
+} // namespace shogle
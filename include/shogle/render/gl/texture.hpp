@@ -106,6 +106,20 @@ public:
 
     TEX_FORMAT_SRGB8 = 0x8C41,     // GL_SRGB8
     TEX_FORMAT_SRGB8_AL8 = 0x8C43, // GL_SRGB8_ALPHA8
+
+    TEX_FORMAT_BC1_RGB = 0x83F0,        // GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+    TEX_FORMAT_BC1_RGBA = 0x83F1,       // GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+    TEX_FORMAT_BC3_RGBA = 0x83F3,       // GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+    TEX_FORMAT_BC1_SRGB = 0x8C4C,       // GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+    TEX_FORMAT_BC3_SRGB_AL = 0x8C4F,    // GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+    TEX_FORMAT_BC4_R = 0x8DBB,          // GL_COMPRESSED_RED_RGTC1
+    TEX_FORMAT_BC5_RG = 0x8DBD,         // GL_COMPRESSED_RG_RGTC2
+    TEX_FORMAT_BC7_RGBA = 0x8E8C,       // GL_COMPRESSED_RGBA_BPTC_UNORM
+    TEX_FORMAT_BC7_SRGB_AL = 0x8E8D,    // GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM
+    TEX_FORMAT_ETC2_RGB8 = 0x9274,      // GL_COMPRESSED_RGB8_ETC2
+    TEX_FORMAT_ETC2_SRGB8 = 0x9275,     // GL_COMPRESSED_SRGB8_ETC2
+    TEX_FORMAT_ETC2_RGBA8 = 0x9278,     // GL_COMPRESSED_RGBA8_ETC2_EAC
+    TEX_FORMAT_ETC2_SRGB8_AL8 = 0x9279, // GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC
   };
 
   enum pixel_format : gldefs::GLenum {
@@ -193,7 +207,15 @@ public:
     pixel_alignment alignment;
   };
 
+  // Pre-encoded 4x4 blocks in the texture's own compressed format
+  struct compressed_image_data {
+    const void* data;
+    size_t size;
+    extent3d extent;
+  };
+
   static constexpr u32 MAX_MIPMAP_LEVEL = 7;
+  static constexpr u32 COMPRESSED_BLOCK_EXTENT = 4;
 
   struct cubemap_tag_t {};
 
@@ -307,15 +329,33 @@ public:
                                pixel_format format, const Ext& offset = {}, u32 layer = 0,
                                u32 level = 0, pixel_alignment alignment = ALIGN_4BYTES);
 
+  // One image per layer, starting at first_layer. Images past the last layer are skipped.
   n_err_return upload_image_layers(gl_context& gl, span<const image_data> layers,
-                                   const extent3d& offset = {}, u32 level = 0);
+                                   const extent3d& offset = {}, u32 level = 0,
+                                   u32 first_layer = 0);
 
   n_err_return upload_image_layers(gl_context& gl, const image_data* layers, u32 layer_count,
-                                   const extent3d& offset = {}, u32 level = 0);
+                                   const extent3d& offset = {}, u32 level = 0,
+                                   u32 first_layer = 0);
+
+  // Fails with GL_INVALID_OPERATION if the texture format isn't compressed and with
+  // GL_INVALID_VALUE if the data size doesn't match the extent
+  gl_expect<void> upload_compressed(gl_context& gl, const compressed_image_data& image,
+                                    const extent3d& offset = {}, u32 level = 0);
 
   void generate_mipmaps(gl_context& gl);
 
 public:
+  // Bytes per 4x4 block, zero for uncompressed formats
+  static u32 compressed_block_size(texture_format format) noexcept;
+  static size_t compressed_image_size(const extent3d& extent, texture_format format) noexcept;
+  static bool is_compressed(texture_format format) noexcept {
+    return compressed_block_size(format) != 0;
+  }
+
+public:
+  // Each call binds the texture to change its own parameters. For sampling state that changes
+  // between draws, bind a gl_sampler with the draw command instead.
   gl_texture& set_swizzle(gl_context& gl, swizzle_target target, swizzle_mask mask);
   gl_texture& set_wrap(gl_context& gl, wrap_direction dir, texture_wrap wrap);
   gl_texture& set_sampler(gl_context& gl, texture_sampler sampler);
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <shogle/render/gl/buffer.hpp>
+#include <shogle/render/gl/context.hpp>
+#include <shogle/render/gl/texture.hpp>
+
+#include <vector>
+
+namespace shogle {
+
+// Material textures looked up in shaders by index, so draws that only differ in their textures
+// can be merged into one. Each material is an entry in a shader storage buffer:
+//
+//   struct material { uvec2 handle; uint page; uint layer; }; // std430
+//
+// With GL_ARB_bindless_texture the entry holds a resident texture handle. Without it, images
+// are packed as layers of 2D array pages sharing format and extent, and the entry holds the page
+// and layer. Pages are bound to consecutive units, indexing them in a shader has to be
+// dynamically uniform, so draws should be split per page in that mode.
+class gl_texture_residency {
+public:
+  using context_type = gl_context;
+  using deleter_type = gl_deleter<gl_texture_residency>;
+
+public:
+  static constexpr u32 MAX_PAGES = 16;
+  static constexpr u32 DEFAULT_PAGE_LAYERS = 64;
+
+  enum residency_mode {
+    MODE_BINDLESS = 0,
+    MODE_TEXTURE_ARRAY,
+  };
+
+  struct material_entry {
+    u64 handle; // Zero in array mode
+    u32 page;   // Page and layer are zero in bindless mode
+    u32 layer;
+  };
+
+  struct create_args {
+    u32 max_materials;
+    u32 page_layers;
+    u32 levels;          // Mipmap levels of every material image
+    bool allow_bindless; // Forces texture arrays when false
+  };
+
+private:
+  struct page {
+    gl_texture texture;
+    std::vector<u32> free_layers;
+    bool dirty;
+  };
+
+  struct material {
+    optional<gl_texture> texture; // Bindless images owned by the residency
+    material_entry entry;
+    bool used;
+  };
+
+  struct create_t {};
+
+public:
+  gl_texture_residency(create_t, gl_buffer buffer, residency_mode mode, const create_args& args);
+
+  gl_texture_residency(gl_context& gl, const create_args& args);
+
+public:
+  static gl_sv_expect<gl_texture_residency> create(gl_context& gl, const create_args& args);
+
+  static void destroy(gl_context& gl, gl_texture_residency& residency) noexcept;
+
+public:
+  // Uploads the image as a new material and returns its index. Bindless mode allocates a texture
+  // for it, array mode stores it in a free layer of the first page with the same format and
+  // extent, opening a new page if there is none.
+  gl_sv_expect<u32> add_image(gl_context& gl, gl_texture::texture_format format,
+                              const gl_texture::image_data& image);
+
+  // Bindless mode only, the texture has to outlive its material. Getting a handle freezes the
+  // texture parameters, set them before adding it.
+  gl_sv_expect<u32> add_texture(gl_context& gl, const gl_texture& texture);
+
+  void remove(gl_context& gl, u32 material);
+
+  // Writes the entries changed since the last flush with a single upload and regenerates the
+  // mipmaps of pages that got new layers. Call it before drawing with new materials.
+  gl_expect<void> flush(gl_context& gl);
+
+  // Adds the material buffer and, in array mode, every page starting at first_unit
+  void add_bindings(gl_command_builder& builder, u32 buffer_location, u32 first_unit = 0) const;
+
+public:
+  residency_mode mode() const;
+  const material_entry& entry(u32 material) const;
+  const gl_buffer& buffer() const;
+  const gl_texture& page_texture(u32 page) const;
+  u32 page_count() const;
+  u32 size() const;
+
+  bool invalidated() const noexcept;
+
+public:
+  explicit operator bool() const noexcept { return !invalidated(); }
+
+private:
+  optional<u32> _acquire_material();
+  void _mark_dirty(u32 material);
+  gl_sv_expect<std::pair<u32, u32>> _acquire_layer(gl_context& gl,
+                                                   gl_texture::texture_format format,
+                                                   const extent2d& extent);
+
+private:
+  gl_buffer _buffer;
+  std::vector<material> _materials;
+  std::vector<u32> _free_materials;
+  std::vector<page> _pages;
+  residency_mode _mode;
+  u32 _page_layers;
+  u32 _levels;
+  u32 _dirty_first;
+  u32 _dirty_last;
+  u32 _size;
+};
+
+static_assert(::shogle::meta::renderer_object_type<gl_texture_residency>);
+
+template<>
+struct gl_deleter<gl_texture_residency> {
+public:
+  gl_deleter(gl_context& gl) noexcept : _gl(&gl) {}
+
+public:
+  void operator()(gl_texture_residency& residency) const noexcept {
+    gl_texture_residency::destroy(*_gl, residency);
+  }
+
+private:
+  gl_context* _gl;
+};
+
+} // namespace shogle
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <shogle/render/gl/ring_buffer.hpp>
+#include <shogle/render/gl/texture.hpp>
+
+namespace shogle {
+
+// Asynchronous texture uploads and pixel readbacks through pixel buffer objects.
+// Uploads get copied into a fenced staging ring and the texture copy is sourced from it, so the
+// driver never has to wait on client memory. Readbacks land in persistently mapped slots and
+// become readable once their fence signals. Call poll() once per frame.
+class gl_texture_streamer {
+public:
+  using context_type = gl_context;
+  using deleter_type = gl_deleter<gl_texture_streamer>;
+
+public:
+  static constexpr u32 MAX_READBACK_SLOTS = 8;
+
+  struct readback_ticket {
+    u32 slot;
+    u32 generation;
+  };
+
+  struct create_args {
+    size_t staging_size; // Per frame region
+    u32 staging_regions;
+    size_t readback_size; // Per slot, can be zero to disable readbacks
+    u32 readback_slots;
+  };
+
+private:
+  enum slot_state : u8 {
+    SLOT_FREE = 0,
+    SLOT_PENDING,
+    SLOT_READY,
+  };
+
+  struct readback_slot {
+    gldefs::GLsync fence;
+    size_t size;
+    u32 generation;
+    slot_state state;
+  };
+
+  struct create_t {};
+
+public:
+  gl_texture_streamer(create_t, const gl_ring_buffer& staging, optional<gl_buffer> readback,
+                      void* readback_mapping, size_t readback_size, u32 readback_slots);
+
+  gl_texture_streamer(gl_context& gl, const create_args& args);
+
+public:
+  static gl_expect<gl_texture_streamer> create(gl_context& gl, const create_args& args);
+
+  static void destroy(gl_context& gl, gl_texture_streamer& streamer) noexcept;
+
+public:
+  // Falls back to a synchronous upload if the image doesn't fit in the staging region
+  gl_expect<void> upload_image(gl_context& gl, gl_texture& texture,
+                               const gl_texture::image_data& image, const extent3d& offset = {},
+                               u32 layer = 0, u32 level = 0);
+
+  // Reads back from the framebuffer's current read buffer, zero is the default framebuffer.
+  // Fails with GL_OUT_OF_MEMORY if every slot is in use.
+  gl_expect<readback_ticket> read_pixels(gl_context& gl, gldefs::GLhandle fbo,
+                                         const rectangle_pos<u32>& area,
+                                         gl_texture::pixel_format format,
+                                         gl_texture::pixel_data_type datatype,
+                                         gl_texture::pixel_alignment alignment =
+                                           gl_texture::ALIGN_4BYTES);
+
+  gl_expect<readback_ticket> read_texture(gl_context& gl, const gl_texture& texture,
+                                          gl_texture::pixel_format format,
+                                          gl_texture::pixel_data_type datatype, u32 level = 0,
+                                          gl_texture::pixel_alignment alignment =
+                                            gl_texture::ALIGN_4BYTES);
+
+  // Fences this frame's uploads and checks pending readbacks
+  void poll(gl_context& gl);
+
+  // Returns nullopt while the readback is in flight. Data stays valid until released
+  optional<span<const u8>> readback_data(const readback_ticket& ticket) const;
+  void release(gl_context& gl, const readback_ticket& ticket);
+
+public:
+  const gl_ring_buffer& staging() const;
+  u64 staged_uploads() const;
+  u64 sync_uploads() const;
+
+  bool invalidated() const noexcept;
+
+public:
+  explicit operator bool() const noexcept { return !invalidated(); }
+
+private:
+  optional<readback_ticket> _acquire_slot(size_t size);
+  void _fence_slot(gl_context& gl, u32 slot);
+
+private:
+  gl_ring_buffer _staging;
+  optional<gl_buffer> _readback;
+  u8* _readback_mapping;
+  size_t _readback_size;
+  u32 _readback_slots;
+  std::array<readback_slot, MAX_READBACK_SLOTS> _slots;
+  u64 _staged_uploads;
+  u64 _sync_uploads;
+};
+
+static_assert(::shogle::meta::renderer_object_type<gl_texture_streamer>);
+
+template<>
+struct gl_deleter<gl_texture_streamer> {
+public:
+  gl_deleter(gl_context& gl) noexcept : _gl(&gl) {}
+
+public:
+  void operator()(gl_texture_streamer& streamer) const noexcept {
+    gl_texture_streamer::destroy(*_gl, streamer);
+  }
+
+private:
+  gl_context* _gl;
+};
+
+} // namespace shogle
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <shogle/render/gl/context.hpp>
+#include <shogle/render/gl/ring_buffer.hpp>
+
+namespace shogle {
+
+// Member offsets and strides of a uniform block, as laid out by the driver
+class gl_uniform_block_layout {
+public:
+  struct member {
+    std::string name;
+    size_t offset;
+    size_t array_stride;
+    size_t matrix_stride;
+    size_t size;
+    gl_graphics_pipeline::shader_attrib_type type;
+  };
+
+private:
+  struct create_t {};
+
+public:
+  gl_uniform_block_layout(create_t, std::vector<member> members, size_t data_size, u32 binding);
+
+public:
+  static optional<gl_uniform_block_layout> reflect(gl_context& gl,
+                                                   const gl_graphics_pipeline& pipeline,
+                                                   const char* block_name);
+
+public:
+  optional<u32> member_index(std::string_view name) const;
+
+  // Writes a push uniform into block memory, its location is the member index
+  void write(void* block, const gl_draw_command::push_uniform& uniform,
+             u32 array_index = 0) const;
+
+public:
+  span<const member> members() const noexcept { return {_members.data(), _members.size()}; }
+  size_t data_size() const noexcept { return _data_size; }
+  u32 binding() const noexcept { return _binding; }
+
+private:
+  std::vector<member> _members;
+  size_t _data_size;
+  u32 _binding;
+};
+
+// Per-frame uniform block storage on top of a ring buffer. Draws get a bound range inside a
+// single UBO instead of a glUniform call per value, and identical consecutive blocks on the
+// same binding reuse the previous range.
+class gl_uniform_arena {
+public:
+  using context_type = gl_context;
+  using deleter_type = gl_deleter<gl_uniform_arena>;
+
+public:
+  static constexpr u32 MAX_BLOCK_BINDINGS = 16;
+
+  struct arena_stats {
+    u32 pushes;
+    u32 reused;
+    size_t bytes;
+  };
+
+private:
+  struct create_t {};
+
+public:
+  gl_uniform_arena(create_t, gl_ring_buffer ring);
+
+  gl_uniform_arena(gl_context& gl, size_t region_size,
+                   u32 region_count = gl_ring_buffer::DEFAULT_FRAME_REGIONS);
+
+public:
+  static gl_expect<gl_uniform_arena> create(gl_context& gl, size_t region_size,
+                                            u32 region_count =
+                                              gl_ring_buffer::DEFAULT_FRAME_REGIONS);
+
+  static void destroy(gl_context& gl, gl_uniform_arena& arena) noexcept;
+
+public:
+  gl_expect<void> begin_frame(gl_context& gl, u64 timeout = gl_ring_buffer::DEFAULT_WAIT_TIMEOUT);
+  void end_frame(gl_context& gl);
+
+  // Returns nullopt if the current frame region is full
+  optional<gl_draw_command::shader_binding> push(u32 binding, const void* data, size_t size);
+
+  template<typename T>
+  requires(std::is_trivially_copyable_v<T>)
+  optional<gl_draw_command::shader_binding> push(u32 binding, const T& data) {
+    return push(binding, &data, sizeof(T));
+  }
+
+  // Packs the uniforms following the block layout, locations are member indices
+  optional<gl_draw_command::shader_binding>
+  push(const gl_uniform_block_layout& layout,
+       span<const gl_draw_command::push_uniform> uniforms);
+
+public:
+  const gl_ring_buffer& ring() const;
+  const arena_stats& stats() const noexcept { return _stats; }
+  void reset_stats() noexcept { _stats = {}; }
+
+  bool invalidated() const noexcept;
+
+public:
+  explicit operator bool() const noexcept { return !invalidated(); }
+
+private:
+  // CPU copy of the last block pushed on a binding, mapped memory is write only
+  struct last_block {
+    std::vector<u8> data;
+    size_t offset;
+    bool valid;
+  };
+
+private:
+  gl_ring_buffer _ring;
+  std::array<last_block, MAX_BLOCK_BINDINGS> _last;
+  std::vector<u8> _scratch;
+  arena_stats _stats;
+};
+
+static_assert(::shogle::meta::renderer_object_type<gl_uniform_arena>);
+
+template<>
+struct gl_deleter<gl_uniform_arena> {
+public:
+  gl_deleter(gl_context& gl) noexcept : _gl(&gl) {}
+
+public:
+  void operator()(gl_uniform_arena& arena) const noexcept {
+    gl_uniform_arena::destroy(*_gl, arena);
+  }
+
+private:
+  gl_context* _gl;
+};
+
+} // namespace shogle
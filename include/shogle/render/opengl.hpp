@@ -7,10 +7,26 @@
 #include <shogle/render/gl/common.hpp>
 
 #include <shogle/render/gl/buffer.hpp>
+#include <shogle/render/gl/buffer_pool.hpp>
+#include <shogle/render/gl/ring_buffer.hpp>
 #include <shogle/render/gl/texture.hpp>
+#include <shogle/render/gl/sampler.hpp>
+#include <shogle/render/gl/texture_stream.hpp>
+#include <shogle/render/gl/mipmap.hpp>
+#include <shogle/render/gl/bcn_encoder.hpp>
 #include <shogle/render/gl/vertex.hpp>
 
 #include <shogle/render/gl/framebuffer.hpp>
 #include <shogle/render/gl/pipeline.hpp>
+#include <shogle/render/gl/pipeline_cache.hpp>
+#include <shogle/render/gl/pipeline_compiler.hpp>
 
 #include <shogle/render/gl/context.hpp>
+#include <shogle/render/gl/offscreen.hpp>
+#include <shogle/render/gl/gpu_profiler.hpp>
+#include <shogle/render/gl/uniform_arena.hpp>
+#include <shogle/render/gl/texture_residency.hpp>
+#include <shogle/render/gl/render_graph.hpp>
+#include <shogle/render/gl/sprite_batch.hpp>
+#include <shogle/render/gl/particle_system.hpp>
+#include <shogle/render/gl/hot_reload.hpp>
@@ -0,0 +1,6 @@
+#pragma once
+
+#include <shogle/render/sw/common.hpp>
+
+#include <shogle/render/sw/texture.hpp>
+#include <shogle/render/sw/context.hpp>
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <shogle/render/common.hpp>
+
+#include <shogle/util/function.hpp>
+#include <shogle/util/ptr.hpp>
+
+#include <vector>
+
+#define SHOGLE_SW_LOG(level_, fmt_, ...) SHOGLE_RENDER_LOG(level_, "Software", fmt_, __VA_ARGS__)
+
+namespace shogle {
+
+class sw_context;
+class sw_framebuffer;
+class sw_texture;
+
+// Most floats a fragment shader can take as input
+constexpr inline u32 SW_MAX_VARYINGS = 32;
+
+namespace meta {
+
+template<>
+struct renderer_traits<sw_context> {
+  static constexpr bool is_specialized = true;
+  static constexpr render_context_tag tag = render_context_tag::software;
+};
+
+// Vertex shader outputs, interpolated across the triangle for the fragment shader.
+// Any struct made of floats works, every member gets interpolated with perspective correction.
+template<typename T>
+concept sw_varying_type = std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T> &&
+                          sizeof(T) % sizeof(f32) == 0 &&
+                          sizeof(T) / sizeof(f32) <= SW_MAX_VARYINGS;
+
+} // namespace meta
+
+// Framebuffers and textures store RGBA8 texels, red in the lowest byte
+constexpr inline u32 sw_pack_color(const color4& color) noexcept {
+  const auto unorm = [](f32 value) -> u32 {
+    value = value < 0.f ? 0.f : (value > 1.f ? 1.f : value);
+    return static_cast<u32>(value * 255.f + .5f);
+  };
+  return unorm(color.r) | (unorm(color.g) << 8) | (unorm(color.b) << 16) | (unorm(color.a) << 24);
+}
+
+constexpr inline color4 sw_unpack_color(u32 texel) noexcept {
+  constexpr f32 inv = 1.f / 255.f;
+  return {static_cast<f32>(texel & 0xFF) * inv, static_cast<f32>((texel >> 8) & 0xFF) * inv,
+          static_cast<f32>((texel >> 16) & 0xFF) * inv, static_cast<f32>(texel >> 24) * inv};
+}
+
+} // namespace shogle
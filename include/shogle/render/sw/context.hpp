@@ -0,0 +1,158 @@
+#pragma once
+
+#include <shogle/render/sw/texture.hpp>
+
+#include <cstring>
+#include <memory>
+
+namespace shogle {
+
+struct sw_draw_state {
+public:
+  enum depth_test {
+    TEST_NEVER = 0,
+    TEST_LESS,
+    TEST_EQUAL,
+    TEST_LEQUAL,
+    TEST_GREATER,
+    TEST_NOT_EQUAL,
+    TEST_GEQUAL,
+    TEST_ALWAYS,
+  };
+
+  enum blending_mode {
+    BLEND_NONE = 0,
+    BLEND_ALPHA,    // src * src.a + dst * (1 - src.a)
+    BLEND_ADDITIVE, // src + dst
+  };
+
+  enum cull_mode {
+    CULL_NONE = 0,
+    CULL_BACK,
+    CULL_FRONT,
+  };
+
+public:
+  static constexpr inline sw_draw_state make_default(bool depth) {
+    return {
+      .depth_enable = depth,
+      .depth_write = depth,
+      .test = TEST_LESS,
+      .blend = BLEND_NONE,
+      .cull = CULL_NONE,
+      .viewport = {0, 0, 0, 0},
+    };
+  }
+
+public:
+  bool depth_enable;
+  bool depth_write;
+  depth_test test;
+  blending_mode blend;
+  // Counter clockwise triangles in NDC are front facing, like the OpenGL defaults
+  cull_mode cull;
+  // Top left origin in framebuffer pixels, zero width or height covers the whole target
+  rectangle_pos<u32> viewport;
+};
+
+struct sw_draw_stats {
+  u32 triangles;
+  u32 culled;
+  u64 fragments;
+};
+
+// CPU rasterizer context. Owns a worker pool shared by the vertex stage, triangle setup and the
+// per tile rasterization; every tile belongs to a single worker so no pixel is ever contended.
+class sw_context {
+public:
+  static constexpr u32 DEFAULT_TILE_SIZE = 64;
+  // Input primitives set up and binned by a single job
+  static constexpr u32 SETUP_CHUNK_SIZE = 256;
+  static constexpr u32 VERTEX_CHUNK_SIZE = 512;
+
+  struct create_args {
+    // Zero picks the hardware concurrency
+    u32 threads;
+    // Multiple of 4, the coverage is evaluated four pixels at a time
+    u32 tile_size;
+  };
+
+  // Fragment shader input, a pointer to the perspective corrected varyings
+  using shade_fn = fn_ref<bool(const f32*, color4&) const>;
+
+private:
+  struct pool_t;
+  struct draw_scratch;
+
+public:
+  sw_context(const create_args& args = {0, DEFAULT_TILE_SIZE});
+
+public:
+  sw_context(sw_context&&) noexcept;
+  sw_context& operator=(sw_context&&) noexcept;
+  ~sw_context() noexcept;
+
+public:
+  // Splits [0, count) in ranges of at most `grain` elements and runs them on the pool,
+  // the calling thread helps and returns once every range is done
+  void parallel_for(u32 count, u32 grain, fn_ref<void(u32, u32)> func);
+
+  // Draws a triangle list. `vs` maps a vertex to its clip position and fills the varyings,
+  // `fs` returns the fragment color or takes an output color and returns false to discard.
+  // Both run concurrently on the pool and must not write shared state.
+  // An empty index span draws the vertices in order.
+  template<meta::sw_varying_type Varyings, meta::vertex_type Vertex, typename VertFunc,
+           typename FragFunc>
+  requires(std::is_invocable_r_v<vec4, VertFunc&, const Vertex&, Varyings&>)
+  sw_draw_stats draw(sw_framebuffer& target, const sw_draw_state& state,
+                     span<const Vertex> vertices, span<const u32> indices, VertFunc&& vs,
+                     FragFunc&& fs) {
+    constexpr u32 varying_count = sizeof(Varyings) / sizeof(f32);
+    const u32 vertex_count = static_cast<u32>(vertices.size());
+    auto [clip, varyings] = _begin_draw(vertex_count, varying_count);
+
+    auto vertex_stage = [&](u32 begin, u32 end) {
+      for (u32 i = begin; i < end; ++i) {
+        Varyings out{};
+        clip[i] = vs(vertices[i], out);
+        std::memcpy(varyings + size_t{i} * varying_count, &out, sizeof(Varyings));
+      }
+    };
+    parallel_for(vertex_count, VERTEX_CHUNK_SIZE, vertex_stage);
+
+    const auto fragment_stage = [&fs](const f32* in, color4& out) -> bool {
+      Varyings vars;
+      std::memcpy(&vars, in, sizeof(Varyings));
+      if constexpr (std::is_invocable_r_v<bool, FragFunc&, const Varyings&, color4&>) {
+        return fs(static_cast<const Varyings&>(vars), out);
+      } else {
+        static_assert(std::is_invocable_r_v<color4, FragFunc&, const Varyings&>,
+                      "Fragment shaders return a color4 or take one and return a bool");
+        out = fs(static_cast<const Varyings&>(vars));
+        return true;
+      }
+    };
+    return _rasterize(target, state, vertex_count, indices, shade_fn{fragment_stage});
+  }
+
+public:
+  u32 thread_count() const noexcept;
+  u32 tile_size() const noexcept { return _tile_size; }
+
+private:
+  struct draw_buffers {
+    vec4* clip;
+    f32* varyings;
+  };
+
+  draw_buffers _begin_draw(u32 vertex_count, u32 varying_count);
+  sw_draw_stats _rasterize(sw_framebuffer& target, const sw_draw_state& state, u32 vertex_count,
+                           span<const u32> indices, shade_fn shade);
+
+private:
+  std::unique_ptr<pool_t> _pool;
+  std::unique_ptr<draw_scratch> _scratch;
+  u32 _tile_size;
+};
+
+} // namespace shogle
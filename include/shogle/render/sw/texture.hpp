@@ -0,0 +1,89 @@
+#pragma once
+
+#include <shogle/render/sw/common.hpp>
+
+namespace shogle {
+
+// RGBA8 image sampled from fragment shaders, row 0 is the top of the image and v = 0 samples it
+class sw_texture {
+public:
+  using context_type = sw_context;
+
+public:
+  enum sampler_filter {
+    FILTER_NEAREST = 0,
+    FILTER_LINEAR,
+  };
+
+  enum sampler_wrap {
+    WRAP_REPEAT = 0,
+    WRAP_CLAMP,
+  };
+
+  struct sampler {
+    sampler_filter filter;
+    sampler_wrap wrap;
+  };
+
+public:
+  // Texels are tightly packed RGBA8 rows, left uninitialized if empty
+  sw_texture(extent2d extent, span<const u8> texels = {});
+
+public:
+  color4 sample(const vec2& uv, const sampler& samp = {FILTER_LINEAR, WRAP_REPEAT}) const;
+  color4 fetch(u32 x, u32 y) const;
+
+  span<u32> texels() noexcept { return {_texels.data(), _texels.size()}; }
+  span<const u32> texels() const noexcept { return {_texels.data(), _texels.size()}; }
+  extent2d extent() const noexcept { return _extent; }
+
+  bool invalidated() const noexcept { return _texels.empty(); }
+
+public:
+  explicit operator bool() const noexcept { return !invalidated(); }
+
+private:
+  std::vector<u32> _texels;
+  extent2d _extent;
+};
+
+static_assert(::shogle::meta::renderer_object_type<sw_texture>);
+
+// Render target of the software rasterizer, RGBA8 color with a float depth buffer.
+// Row 0 is the top of the image, NDC +y points up like in OpenGL.
+class sw_framebuffer {
+public:
+  using context_type = sw_context;
+
+public:
+  sw_framebuffer(extent2d extent);
+
+public:
+  void clear(const color4& color, f32 depth = 1.f);
+  void clear_color(const color4& color);
+  void clear_depth(f32 depth = 1.f);
+
+  // Tightly packed RGBA8 rows, ready to be written to an image file
+  void read_pixels(span<u8> out) const;
+
+  span<u32> color() noexcept { return {_color.data(), _color.size()}; }
+  span<const u32> color() const noexcept { return {_color.data(), _color.size()}; }
+  span<f32> depth() noexcept { return {_depth.data(), _depth.size()}; }
+  span<const f32> depth() const noexcept { return {_depth.data(), _depth.size()}; }
+  color4 pixel(u32 x, u32 y) const;
+  extent2d extent() const noexcept { return _extent; }
+
+  bool invalidated() const noexcept { return _color.empty(); }
+
+public:
+  explicit operator bool() const noexcept { return !invalidated(); }
+
+private:
+  std::vector<u32> _color;
+  std::vector<f32> _depth;
+  extent2d _extent;
+};
+
+static_assert(::shogle::meta::renderer_object_type<sw_framebuffer>);
+
+} // namespace shogle
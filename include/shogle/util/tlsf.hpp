@@ -0,0 +1,115 @@
+#pragma once
+
+#include <shogle/util/optional.hpp>
+
+#include <array>
+#include <vector>
+
+namespace shogle::mem {
+
+// Two level segregated fit allocator over an abstract [0, capacity) range.
+// It only does the bookkeeping, so it can manage GPU memory or anything else addressed by
+// offsets. Allocation and deallocation are O(1), free blocks get coalesced on release.
+class tlsf_allocator {
+public:
+  using handle = u32;
+
+  static constexpr handle NULL_HANDLE = std::numeric_limits<u32>::max();
+
+  static constexpr u32 SL_COUNT_LOG2 = 5;
+  static constexpr u32 SL_COUNT = 1u << SL_COUNT_LOG2;
+  static constexpr u32 FL_COUNT = 64 - SL_COUNT_LOG2 + 1;
+  static constexpr u64 SMALL_BLOCK_SIZE = SL_COUNT;
+
+  struct allocation {
+    u64 offset;
+    u64 size;
+    handle node;
+  };
+
+  // A live allocation that has to be copied from src_offset to dst_offset after compacting
+  struct block_move {
+    handle node;
+    u64 src_offset;
+    u64 dst_offset;
+    u64 size;
+  };
+
+public:
+  explicit tlsf_allocator(u64 capacity);
+
+public:
+  // Alignment doesn't need to be a power of two, vertex strides are valid alignments.
+  // Returns nullopt if no free block can fit the allocation.
+  optional<allocation> allocate(u64 size, u64 alignment = 1);
+  void deallocate(handle node) noexcept;
+
+  // Packs every live allocation at the start of the range, keeping their alignment.
+  // Handles stay valid but their offsets change, moves are sorted by source offset.
+  std::vector<block_move> compact();
+
+  void reset();
+
+public:
+  u64 offset(handle node) const;
+  u64 size(handle node) const;
+
+  u64 capacity() const noexcept { return _capacity; }
+  u64 used_size() const noexcept { return _used; }
+  u64 free_size() const noexcept { return _capacity - _used; }
+  u64 largest_free_block() const noexcept;
+  u32 allocation_count() const noexcept { return _alloc_count; }
+
+  // Walks every block in offset order, for validation and debugging
+  template<typename F>
+  void for_each_block(F&& func) const {
+    for (handle it = _phys_head; it != NULL_HANDLE; it = _nodes[it].next_phys) {
+      const auto& node = _nodes[it];
+      func(node.offset, node.size, node.used);
+    }
+  }
+
+private:
+  struct block_node {
+    u64 offset;
+    u64 size;
+    u64 alignment;
+    handle prev_phys;
+    handle next_phys;
+    handle prev_free;
+    handle next_free;
+    bool used;
+  };
+
+  struct bin_index {
+    u32 fl;
+    u32 sl;
+  };
+
+private:
+  static bin_index _map_insert(u64 size) noexcept;
+  static bin_index _map_search(u64 size) noexcept;
+
+  handle _new_node(u64 offset, u64 size);
+  void _release_node(handle node) noexcept;
+
+  void _insert_free(handle node) noexcept;
+  void _remove_free(handle node) noexcept;
+  handle _find_free(u64 size) const noexcept;
+
+  // Splits the tail of a block into a new free block
+  void _split(handle node, u64 size);
+
+private:
+  std::vector<block_node> _nodes;
+  std::vector<handle> _spare_nodes;
+  std::array<std::array<handle, SL_COUNT>, FL_COUNT> _free_heads;
+  std::array<u32, FL_COUNT> _sl_bitmap;
+  u64 _fl_bitmap;
+  handle _phys_head;
+  u64 _capacity;
+  u64 _used;
+  u32 _alloc_count;
+};
+
+} // namespace shogle::mem
@@ -0,0 +1,560 @@
+#include "./context_private.hpp"
+#include <shogle/render/gl/bcn_encoder.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <thread>
+
+namespace shogle {
+
+namespace {
+
+constexpr u32 BLOCK_TEXELS = gl_bcn_encoder::BLOCK_TEXELS;
+
+enum bc1_mode : u8 {
+  BC1_OPAQUE = 0,   // Four colors, or three if both endpoints match
+  BC1_PUNCHTHROUGH, // Three colors plus transparent black when any alpha is below 128
+  BC1_IN_BC3,       // Always four colors, alpha lives in its own block
+};
+
+struct bc1_fit {
+  u16 c0;
+  u16 c1;
+  u32 indices;
+  u32 error;
+};
+
+struct bc7_fit {
+  std::array<u8, 4> e0;
+  std::array<u8, 4> e1;
+  std::array<u8, BLOCK_TEXELS> indices;
+  u32 error;
+};
+
+constexpr std::array<u32, 16> BC7_WEIGHTS4{0,  4,  9,  13, 17, 21, 26, 30,
+                                           34, 38, 43, 47, 51, 55, 60, 64};
+
+// Principal axis of the point cloud through power iteration, zero for flat blocks
+template<u32 Dims>
+void principal_axis(const f32 (*points)[4], u32 count, f32* mean, f32* axis) {
+  std::fill_n(mean, Dims, 0.f);
+  for (u32 i = 0; i < count; ++i) {
+    for (u32 d = 0; d < Dims; ++d) {
+      mean[d] += points[i][d];
+    }
+  }
+  for (u32 d = 0; d < Dims; ++d) {
+    mean[d] /= static_cast<f32>(count);
+  }
+
+  f32 cov[Dims][Dims]{};
+  for (u32 i = 0; i < count; ++i) {
+    for (u32 a = 0; a < Dims; ++a) {
+      for (u32 b = a; b < Dims; ++b) {
+        cov[a][b] += (points[i][a] - mean[a]) * (points[i][b] - mean[b]);
+      }
+    }
+  }
+  for (u32 a = 0; a < Dims; ++a) {
+    for (u32 b = 0; b < a; ++b) {
+      cov[a][b] = cov[b][a];
+    }
+  }
+
+  std::fill_n(axis, Dims, 1.f);
+  for (u32 iter = 0; iter < 8; ++iter) {
+    f32 next[Dims]{};
+    f32 norm = 0.f;
+    for (u32 a = 0; a < Dims; ++a) {
+      for (u32 b = 0; b < Dims; ++b) {
+        next[a] += cov[a][b] * axis[b];
+      }
+      norm = std::max(norm, std::abs(next[a]));
+    }
+    if (norm < 1e-6f) {
+      std::fill_n(axis, Dims, 0.f);
+      return;
+    }
+    for (u32 a = 0; a < Dims; ++a) {
+      axis[a] = next[a] / norm;
+    }
+  }
+}
+
+// Endpoints at the extremes of the points projected on the principal axis
+template<u32 Dims>
+void axis_endpoints(const f32 (*points)[4], u32 count, f32* e0, f32* e1) {
+  f32 mean[Dims];
+  f32 axis[Dims];
+  principal_axis<Dims>(points, count, mean, axis);
+  f32 len_sq = 0.f;
+  for (u32 d = 0; d < Dims; ++d) {
+    len_sq += axis[d] * axis[d];
+  }
+  f32 tmin = 0.f;
+  f32 tmax = 0.f;
+  if (len_sq > 0.f) {
+    tmin = std::numeric_limits<f32>::max();
+    tmax = std::numeric_limits<f32>::lowest();
+    for (u32 i = 0; i < count; ++i) {
+      f32 t = 0.f;
+      for (u32 d = 0; d < Dims; ++d) {
+        t += (points[i][d] - mean[d]) * axis[d];
+      }
+      tmin = std::min(tmin, t / len_sq);
+      tmax = std::max(tmax, t / len_sq);
+    }
+  }
+  for (u32 d = 0; d < Dims; ++d) {
+    e0[d] = std::clamp(mean[d] + axis[d] * tmax, 0.f, 255.f);
+    e1[d] = std::clamp(mean[d] + axis[d] * tmin, 0.f, 255.f);
+  }
+}
+
+// Least squares endpoints for the given interpolation weights, false if the system is singular.
+// weights[i] is the contribution of e0 for point i
+template<u32 Dims>
+bool refine_endpoints(const f32 (*points)[4], const f32* weights, u32 count, f32* e0, f32* e1) {
+  f32 aa = 0.f, ab = 0.f, bb = 0.f;
+  f32 ax[Dims]{};
+  f32 bx[Dims]{};
+  for (u32 i = 0; i < count; ++i) {
+    const f32 a = weights[i];
+    const f32 b = 1.f - a;
+    aa += a * a;
+    ab += a * b;
+    bb += b * b;
+    for (u32 d = 0; d < Dims; ++d) {
+      ax[d] += a * points[i][d];
+      bx[d] += b * points[i][d];
+    }
+  }
+  const f32 det = aa * bb - ab * ab;
+  if (std::abs(det) < 1e-4f) {
+    return false;
+  }
+  for (u32 d = 0; d < Dims; ++d) {
+    e0[d] = std::clamp((bb * ax[d] - ab * bx[d]) / det, 0.f, 255.f);
+    e1[d] = std::clamp((aa * bx[d] - ab * ax[d]) / det, 0.f, 255.f);
+  }
+  return true;
+}
+
+u16 pack_565(const f32* color) noexcept {
+  const auto quant = [](f32 v, f32 max) {
+    return static_cast<u16>(std::lround(std::clamp(v, 0.f, 255.f) * max / 255.f));
+  };
+  return static_cast<u16>(quant(color[0], 31.f) << 11 | quant(color[1], 63.f) << 5 |
+                          quant(color[2], 31.f));
+}
+
+std::array<i32, 3> unpack_565(u16 color) noexcept {
+  const i32 r = color >> 11;
+  const i32 g = (color >> 5) & 0x3F;
+  const i32 b = color & 0x1F;
+  return {(r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2)};
+}
+
+bc1_fit bc1_select(const u8* texels, u16 c0, u16 c1, bc1_mode mode) noexcept {
+  const bool four = mode == BC1_IN_BC3 || (mode == BC1_OPAQUE && c0 > c1);
+  const auto p0 = unpack_565(c0);
+  const auto p1 = unpack_565(c1);
+  i32 palette[4][3];
+  for (u32 c = 0; c < 3; ++c) {
+    palette[0][c] = p0[c];
+    palette[1][c] = p1[c];
+    palette[2][c] = four ? (2 * p0[c] + p1[c]) / 3 : (p0[c] + p1[c]) / 2;
+    palette[3][c] = four ? (p0[c] + 2 * p1[c]) / 3 : 0;
+  }
+
+  bc1_fit fit{c0, c1, 0, 0};
+  for (u32 i = 0; i < BLOCK_TEXELS; ++i) {
+    const u8* texel = texels + i * 4;
+    if (mode == BC1_PUNCHTHROUGH && texel[3] < 128) {
+      fit.indices |= 3u << (i * 2);
+      continue;
+    }
+    u32 best = 0;
+    u32 best_err = std::numeric_limits<u32>::max();
+    for (u32 p = 0; p < (four ? 4u : 3u); ++p) {
+      u32 err = 0;
+      for (u32 c = 0; c < 3; ++c) {
+        const i32 diff = palette[p][c] - texel[c];
+        err += static_cast<u32>(diff * diff);
+      }
+      if (err < best_err) {
+        best_err = err;
+        best = p;
+      }
+    }
+    fit.indices |= best << (i * 2);
+    fit.error += best_err;
+  }
+  return fit;
+}
+
+// Orders the quantized endpoints for the mode before selecting indices
+bc1_fit bc1_quantize(const u8* texels, const f32* e0, const f32* e1, bc1_mode mode) noexcept {
+  u16 c0 = pack_565(e0);
+  u16 c1 = pack_565(e1);
+  if ((mode == BC1_PUNCHTHROUGH) == (c0 > c1)) {
+    std::swap(c0, c1);
+  }
+  return bc1_select(texels, c0, c1, mode);
+}
+
+void encode_bc1(const u8* texels, u8* out, bc1_mode mode) noexcept {
+  f32 points[BLOCK_TEXELS][4];
+  u32 count = 0;
+  bool transparent = false;
+  for (u32 i = 0; i < BLOCK_TEXELS; ++i) {
+    const u8* texel = texels + i * 4;
+    if (mode == BC1_PUNCHTHROUGH && texel[3] < 128) {
+      transparent = true;
+      continue;
+    }
+    points[count][0] = texel[0];
+    points[count][1] = texel[1];
+    points[count][2] = texel[2];
+    ++count;
+  }
+  if (!transparent && mode == BC1_PUNCHTHROUGH) {
+    mode = BC1_OPAQUE;
+  }
+
+  bc1_fit fit{0, 0, 0xFFFFFFFF, 0};
+  if (count) {
+    f32 e0[3];
+    f32 e1[3];
+    axis_endpoints<3>(points, count, e0, e1);
+    fit = bc1_quantize(texels, e0, e1, mode);
+
+    // One least squares pass over the selected indices, kept only if it helps
+    const bool four = mode == BC1_IN_BC3 || (mode == BC1_OPAQUE && fit.c0 > fit.c1);
+    const f32 four_weights[4]{1.f, 0.f, 2.f / 3.f, 1.f / 3.f};
+    const f32 three_weights[4]{1.f, 0.f, .5f, 0.f};
+    f32 weights[BLOCK_TEXELS];
+    for (u32 i = 0, n = 0; i < BLOCK_TEXELS; ++i) {
+      const u32 idx = (fit.indices >> (i * 2)) & 3;
+      if (mode == BC1_PUNCHTHROUGH && texels[i * 4 + 3] < 128) {
+        continue;
+      }
+      weights[n++] = four ? four_weights[idx] : three_weights[idx];
+    }
+    if (refine_endpoints<3>(points, weights, count, e0, e1)) {
+      const auto refined = bc1_quantize(texels, e0, e1, mode);
+      if (refined.error < fit.error) {
+        fit = refined;
+      }
+    }
+  }
+
+  out[0] = static_cast<u8>(fit.c0);
+  out[1] = static_cast<u8>(fit.c0 >> 8);
+  out[2] = static_cast<u8>(fit.c1);
+  out[3] = static_cast<u8>(fit.c1 >> 8);
+  for (u32 i = 0; i < 4; ++i) {
+    out[4 + i] = static_cast<u8>(fit.indices >> (i * 8));
+  }
+}
+
+// Single channel block, shared by BC3 alpha, BC4 and BC5
+void encode_bc4(const u8* texels, u32 channel, u8* out) noexcept {
+  u8 lo = 255;
+  u8 hi = 0;
+  for (u32 i = 0; i < BLOCK_TEXELS; ++i) {
+    lo = std::min(lo, texels[i * 4 + channel]);
+    hi = std::max(hi, texels[i * 4 + channel]);
+  }
+  out[0] = hi;
+  out[1] = lo;
+
+  u64 bits = 0;
+  if (hi != lo) {
+    i32 palette[8];
+    palette[0] = hi;
+    palette[1] = lo;
+    for (i32 k = 1; k < 7; ++k) {
+      palette[k + 1] = ((7 - k) * hi + k * lo + 3) / 7;
+    }
+    for (u32 i = 0; i < BLOCK_TEXELS; ++i) {
+      const i32 value = texels[i * 4 + channel];
+      u64 best = 0;
+      i32 best_err = std::numeric_limits<i32>::max();
+      for (u32 p = 0; p < 8; ++p) {
+        const i32 err = std::abs(palette[p] - value);
+        if (err < best_err) {
+          best_err = err;
+          best = p;
+        }
+      }
+      bits |= best << (i * 3);
+    }
+  }
+  for (u32 i = 0; i < 6; ++i) {
+    out[2 + i] = static_cast<u8>(bits >> (i * 8));
+  }
+}
+
+// Picks the p-bit with the lowest error for a 7 bit + shared p-bit endpoint
+void bc7_quantize_endpoint(const f32* color, std::array<u8, 4>& out) noexcept {
+  f32 best_err = std::numeric_limits<f32>::max();
+  for (i32 p = 0; p < 2; ++p) {
+    std::array<u8, 4> quant;
+    f32 err = 0.f;
+    for (u32 c = 0; c < 4; ++c) {
+      const i32 v = std::clamp(static_cast<i32>(std::lround((color[c] - p) * .5f)), 0, 127);
+      quant[c] = static_cast<u8>(v << 1 | p);
+      err += (quant[c] - color[c]) * (quant[c] - color[c]);
+    }
+    if (err < best_err) {
+      best_err = err;
+      out = quant;
+    }
+  }
+}
+
+bc7_fit bc7_select(const u8* texels, const f32* e0, const f32* e1) noexcept {
+  bc7_fit fit{};
+  bc7_quantize_endpoint(e0, fit.e0);
+  bc7_quantize_endpoint(e1, fit.e1);
+  i32 palette[16][4];
+  for (u32 p = 0; p < 16; ++p) {
+    const i32 w = static_cast<i32>(BC7_WEIGHTS4[p]);
+    for (u32 c = 0; c < 4; ++c) {
+      palette[p][c] = ((64 - w) * fit.e0[c] + w * fit.e1[c] + 32) >> 6;
+    }
+  }
+
+  // Project on the endpoint line for a first guess, then only check the neighbouring indices
+  i32 dir[4];
+  i32 len_sq = 0;
+  for (u32 c = 0; c < 4; ++c) {
+    dir[c] = fit.e1[c] - fit.e0[c];
+    len_sq += dir[c] * dir[c];
+  }
+  for (u32 i = 0; i < BLOCK_TEXELS; ++i) {
+    const u8* texel = texels + i * 4;
+    i32 guess = 0;
+    if (len_sq) {
+      i32 dot = 0;
+      for (u32 c = 0; c < 4; ++c) {
+        dot += (texel[c] - fit.e0[c]) * dir[c];
+      }
+      guess = std::clamp((dot * 15 + len_sq / 2) / len_sq, 0, 15);
+    }
+    u32 best_err = std::numeric_limits<u32>::max();
+    for (i32 p = std::max(guess - 1, 0); p <= std::min(guess + 1, 15); ++p) {
+      u32 err = 0;
+      for (u32 c = 0; c < 4; ++c) {
+        const i32 diff = palette[p][c] - texel[c];
+        err += static_cast<u32>(diff * diff);
+      }
+      if (err < best_err) {
+        best_err = err;
+        fit.indices[i] = static_cast<u8>(p);
+      }
+    }
+    fit.error += best_err;
+  }
+  return fit;
+}
+
+// Mode 6: one subset, RGBA endpoints with 7 bits plus a p-bit each, 4 bit indices
+void encode_bc7(const u8* texels, u8* out) noexcept {
+  f32 points[BLOCK_TEXELS][4];
+  for (u32 i = 0; i < BLOCK_TEXELS; ++i) {
+    for (u32 c = 0; c < 4; ++c) {
+      points[i][c] = texels[i * 4 + c];
+    }
+  }
+  f32 e0[4];
+  f32 e1[4];
+  axis_endpoints<4>(points, BLOCK_TEXELS, e0, e1);
+  auto fit = bc7_select(texels, e0, e1);
+  for (u32 pass = 0; pass < 2 && fit.error; ++pass) {
+    f32 weights[BLOCK_TEXELS];
+    for (u32 i = 0; i < BLOCK_TEXELS; ++i) {
+      weights[i] = 1.f - static_cast<f32>(BC7_WEIGHTS4[fit.indices[i]]) / 64.f;
+    }
+    if (!refine_endpoints<4>(points, weights, BLOCK_TEXELS, e0, e1)) {
+      break;
+    }
+    const auto refined = bc7_select(texels, e0, e1);
+    if (refined.error >= fit.error) {
+      break;
+    }
+    fit = refined;
+  }
+
+  // The anchor index is stored without its top bit, so it must be below 8
+  if (fit.indices[0] >= 8) {
+    std::swap(fit.e0, fit.e1);
+    for (auto& idx : fit.indices) {
+      idx = static_cast<u8>(15 - idx);
+    }
+  }
+
+  u64 words[2]{};
+  u32 pos = 0;
+  const auto put = [&](u64 value, u32 bits) {
+    words[pos / 64] |= value << (pos % 64);
+    if (pos % 64 + bits > 64) {
+      words[pos / 64 + 1] |= value >> (64 - pos % 64);
+    }
+    pos += bits;
+  };
+  put(1u << 6, 7);
+  for (u32 c = 0; c < 4; ++c) {
+    put(fit.e0[c] >> 1, 7);
+    put(fit.e1[c] >> 1, 7);
+  }
+  put(fit.e0[0] & 1, 1);
+  put(fit.e1[0] & 1, 1);
+  put(fit.indices[0], 3);
+  for (u32 i = 1; i < BLOCK_TEXELS; ++i) {
+    put(fit.indices[i], 4);
+  }
+  SHOGLE_ASSERT(pos == 128);
+  for (u32 i = 0; i < 16; ++i) {
+    out[i] = static_cast<u8>(words[i / 8] >> ((i % 8) * 8));
+  }
+}
+
+} // namespace
+
+bool gl_bcn_encoder::is_supported(gl_texture::texture_format format) noexcept {
+  switch (format) {
+    case gl_texture::TEX_FORMAT_BC1_RGB:
+      [[fallthrough]];
+    case gl_texture::TEX_FORMAT_BC1_RGBA:
+      [[fallthrough]];
+    case gl_texture::TEX_FORMAT_BC1_SRGB:
+      [[fallthrough]];
+    case gl_texture::TEX_FORMAT_BC3_RGBA:
+      [[fallthrough]];
+    case gl_texture::TEX_FORMAT_BC3_SRGB_AL:
+      [[fallthrough]];
+    case gl_texture::TEX_FORMAT_BC4_R:
+      [[fallthrough]];
+    case gl_texture::TEX_FORMAT_BC5_RG:
+      [[fallthrough]];
+    case gl_texture::TEX_FORMAT_BC7_RGBA:
+      [[fallthrough]];
+    case gl_texture::TEX_FORMAT_BC7_SRGB_AL:
+      return true;
+    default:
+      return false;
+  }
+}
+
+void gl_bcn_encoder::encode_block(gl_texture::texture_format format, const u8* texels,
+                                  u8* output) {
+  SHOGLE_ASSERT(is_supported(format), "Unsupported block compressed format");
+  switch (format) {
+    case gl_texture::TEX_FORMAT_BC1_RGB:
+      [[fallthrough]];
+    case gl_texture::TEX_FORMAT_BC1_SRGB: {
+      encode_bc1(texels, output, BC1_OPAQUE);
+    } break;
+    case gl_texture::TEX_FORMAT_BC1_RGBA: {
+      encode_bc1(texels, output, BC1_PUNCHTHROUGH);
+    } break;
+    case gl_texture::TEX_FORMAT_BC3_RGBA:
+      [[fallthrough]];
+    case gl_texture::TEX_FORMAT_BC3_SRGB_AL: {
+      encode_bc4(texels, 3, output);
+      encode_bc1(texels, output + 8, BC1_IN_BC3);
+    } break;
+    case gl_texture::TEX_FORMAT_BC4_R: {
+      encode_bc4(texels, 0, output);
+    } break;
+    case gl_texture::TEX_FORMAT_BC5_RG: {
+      encode_bc4(texels, 0, output);
+      encode_bc4(texels, 1, output + 8);
+    } break;
+    case gl_texture::TEX_FORMAT_BC7_RGBA:
+      [[fallthrough]];
+    case gl_texture::TEX_FORMAT_BC7_SRGB_AL: {
+      encode_bc7(texels, output);
+    } break;
+    default:
+      SHOGLE_UNREACHABLE();
+  }
+}
+
+gl_expect<size_t> gl_bcn_encoder::encode(const gl_texture::image_data& image, span<u8> output,
+                                         const encode_args& args) {
+  if (!is_supported(args.format) || image.format != gl_texture::PIXEL_FORMAT_RGBA ||
+      image.datatype != gl_texture::PIXEL_TYPE_U8) {
+    return {unexpect, GL_INVALID_ENUM};
+  }
+  const size_t size = gl_texture::compressed_image_size(image.extent, args.format);
+  if (!image.data || !image.extent.width || output.size() < size) {
+    return {unexpect, GL_INVALID_VALUE};
+  }
+
+  constexpr u32 block_extent = gl_texture::COMPRESSED_BLOCK_EXTENT;
+  const u32 width = image.extent.width;
+  const u32 height = std::max(image.extent.height, 1u);
+  const u32 blocks_x = (width + block_extent - 1) / block_extent;
+  const u32 blocks_y = (height + block_extent - 1) / block_extent;
+  const u32 rows = blocks_y * std::max(image.extent.depth, 1u);
+  const size_t block_size = gl_texture::compressed_block_size(args.format);
+  const size_t align = static_cast<size_t>(image.alignment);
+  const size_t row_stride = (size_t(width) * 4 + align - 1) / align * align;
+  const auto* pixels = static_cast<const u8*>(image.data);
+
+  // Partial blocks on the edges repeat the last row and column
+  const auto encode_rows = [&](u32 first, u32 last) {
+    u8 texels[BLOCK_TEXELS * 4];
+    for (u32 row = first; row < last; ++row) {
+      const u8* slice = pixels + (row / blocks_y) * row_stride * height;
+      const u32 by = row % blocks_y;
+      for (u32 bx = 0; bx < blocks_x; ++bx) {
+        for (u32 ty = 0; ty < block_extent; ++ty) {
+          const u32 y = std::min(by * block_extent + ty, height - 1);
+          for (u32 tx = 0; tx < block_extent; ++tx) {
+            const u32 x = std::min(bx * block_extent + tx, width - 1);
+            std::memcpy(texels + (ty * block_extent + tx) * 4, slice + y * row_stride + x * 4, 4);
+          }
+        }
+        u8* block = output.data() + (size_t(row) * blocks_x + bx) * block_size;
+        encode_block(args.format, texels, block);
+      }
+    }
+  };
+
+  u32 threads = args.threads ? args.threads : std::thread::hardware_concurrency();
+  threads = std::clamp(threads, 1u, rows);
+  if (threads == 1) {
+    encode_rows(0, rows);
+    return {in_place, size};
+  }
+
+  std::vector<std::thread> workers;
+  workers.reserve(threads - 1);
+  const u32 chunk = (rows + threads - 1) / threads;
+  for (u32 first = chunk; first < rows; first += chunk) {
+    workers.emplace_back(encode_rows, first, std::min(first + chunk, rows));
+  }
+  encode_rows(0, std::min(chunk, rows));
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  return {in_place, size};
+}
+
+gl_expect<std::vector<u8>> gl_bcn_encoder::encode(const gl_texture::image_data& image,
+                                                  const encode_args& args) {
+  std::vector<u8> output(gl_texture::compressed_image_size(image.extent, args.format));
+  auto ret = encode(image, {output.data(), output.size()}, args);
+  if (!ret) {
+    return {unexpect, ret.error()};
+  }
+  return {in_place, std::move(output)};
+}
+
+} // namespace shogle
@@ -16,6 +16,9 @@ std::string_view buffer_type_name(gl_buffer::buffer_type type) {
     STR(SHADER);
     STR(UNIFORM);
     STR(TEXTURE);
+    STR(PIXEL_PACK);
+    STR(PIXEL_UNPACK);
+    STR(INDIRECT);
     default:
       return "UNKNOWN";
   }
@@ -40,26 +43,47 @@ auto gl_buffer::_allocate_span(gl_context& gl, gldefs::GLhandle* buffs, size_t c
                                const void* data, bool is_mutable) -> n_err_return {
   SHOGLE_ASSERT(buffs);
   SHOGLE_ASSERT(count);
-  GL_ASSERT(glGenBuffers(count, buffs));
+  const bool dsa = impl::gl_get_private(gl).direct_state_access;
+  if (dsa) {
+    GL_ASSERT(glCreateBuffers(count, buffs));
+  } else {
+    GL_ASSERT(glGenBuffers(count, buffs));
+  }
   size_t i = 0;
   for (; i < count; ++i) {
-    GL_ASSERT(glBindBuffer(type, buffs[i]));
     gldefs::GLenum err = 0;
-    if (is_mutable) {
-      err = GL_RET_ERR(glBufferData(type, size, data, usage));
+    if (dsa) {
+      if (is_mutable) {
+        err = GL_RET_ERR(glNamedBufferData(buffs[i], size, data, usage));
+      } else {
+        err = GL_RET_ERR(glNamedBufferStorage(buffs[i], size, data, usage));
+      }
     } else {
-      err = GL_RET_ERR(glBufferStorage(type, size, data, usage));
+      GL_ASSERT(glBindBuffer(type, buffs[i]));
+      if (is_mutable) {
+        err = GL_RET_ERR(glBufferData(type, size, data, usage));
+      } else {
+        err = GL_RET_ERR(glBufferStorage(type, size, data, usage));
+      }
     }
     if (err) {
-      GL_ASSERT(glBindBuffer(type, GL_DEFAULT_BINDING));
-      GL_ASSERT(glDeleteBuffers(count - i + 1, buffs + i));
+      if (!dsa) {
+        GL_ASSERT(glBindBuffer(type, GL_DEFAULT_BINDING));
+        gl_get_state(gl).forget_bound_buffer(type);
+      }
+      GL_ASSERT(glDeleteBuffers(count - i, buffs + i));
       return {i, err};
     }
+    if (data) {
+      GL_FRAME_STAT(buffer_upload_bytes, size);
+    }
     SHOGLE_GL_LOG(VERBOSE, "BUFFER_ALLOC ({}) (sz: {}B, type: {}, mut: {})", buffs[i], size,
                   buffer_type_name(type), is_mutable);
   }
-  // GL_ASSERT(glBindBuffer(type, buff))
-  GL_ASSERT(glBindBuffer(type, GL_DEFAULT_BINDING));
+  if (!dsa) {
+    GL_ASSERT(glBindBuffer(type, GL_DEFAULT_BINDING));
+    gl_get_state(gl).forget_bound_buffer(type);
+  }
   return {i, GL_NO_ERROR};
 }
 
@@ -94,6 +118,7 @@ void gl_buffer::deallocate(gl_context& gl, gl_buffer& buff) noexcept {
     return;
   }
   GL_ASSERT(glDeleteBuffers(1, &buff._id));
+  gl_get_state(gl).forget_buffer(buff._id);
   SHOGLE_GL_LOG(VERBOSE, "BUFFER_DEALLOC ({}) (sz: {}B, type: {})", buff._id, buff._size,
                 buffer_type_name(buff._type));
   buff._id = GL_NULL_HANDLE;
@@ -108,6 +133,7 @@ void gl_buffer::deallocate_n(gl_context& gl, gl_buffer* buffs, size_t buff_count
       continue;
     }
     GL_CALL(glDeleteBuffers(1, &buffs[i]._id));
+    gl_get_state(gl).forget_buffer(buffs[i]._id);
     SHOGLE_GL_LOG(VERBOSE, "BUFFER_DEALLOC ({}) (sz: {}B, type: {})", buffs[i]._id, buffs[i]._size,
                   buffer_type_name(buffs[i]._type));
     buffs[i]._id = GL_NULL_HANDLE;
@@ -124,12 +150,19 @@ gl_expect<void> gl_buffer::upload_data(gl_context& gl, const void* data, size_t
   SHOGLE_ASSERT(data, "Buffer upload with null pointer");
   SHOGLE_ASSERT(size, "Buffer upload with no size");
   SHOGLE_ASSERT(size + offset <= _size, "Buffer upload out of bounds");
-  GL_ASSERT(glBindBuffer(_type, _id));
-  const auto err = GL_RET_ERR(glBufferSubData(_type, (GLintptr)offset, (GLsizeiptr)size, data));
-  GL_ASSERT(glBindBuffer(_type, GL_DEFAULT_BINDING));
+  GLenum err;
+  if (impl::gl_get_private(gl).direct_state_access) {
+    err = GL_RET_ERR(glNamedBufferSubData(_id, (GLintptr)offset, (GLsizeiptr)size, data));
+  } else {
+    GL_ASSERT(glBindBuffer(_type, _id));
+    err = GL_RET_ERR(glBufferSubData(_type, (GLintptr)offset, (GLsizeiptr)size, data));
+    GL_ASSERT(glBindBuffer(_type, GL_DEFAULT_BINDING));
+    gl_get_state(gl).forget_bound_buffer(_type);
+  }
   if (err) {
     return {unexpect, err};
   } else {
+    GL_FRAME_STAT(buffer_upload_bytes, size);
     SHOGLE_GL_LOG(VERBOSE, "BUFFER_WRITE ({}), (ptr: {}, sz: {}B/{}B, off: {}B)", _id,
                   fmt::ptr(data), size, _size, offset);
     return {};
@@ -141,9 +174,15 @@ gl_expect<void> gl_buffer::read_data(gl_context& gl, void* data, size_t size, si
   SHOGLE_ASSERT(data, "Buffer read with null pointer");
   SHOGLE_ASSERT(size, "Buffer read with no size");
   SHOGLE_ASSERT(size + offset <= _size, "Buffer read out of bounds");
-  GL_ASSERT(glBindBuffer(_type, _id));
-  const auto err = GL_RET_ERR(glGetBufferSubData(_type, (GLintptr)offset, (GLsizeiptr)size, data));
-  GL_ASSERT(glBindBuffer(_type, GL_DEFAULT_BINDING));
+  GLenum err;
+  if (impl::gl_get_private(gl).direct_state_access) {
+    err = GL_RET_ERR(glGetNamedBufferSubData(_id, (GLintptr)offset, (GLsizeiptr)size, data));
+  } else {
+    GL_ASSERT(glBindBuffer(_type, _id));
+    err = GL_RET_ERR(glGetBufferSubData(_type, (GLintptr)offset, (GLsizeiptr)size, data));
+    GL_ASSERT(glBindBuffer(_type, GL_DEFAULT_BINDING));
+    gl_get_state(gl).forget_bound_buffer(_type);
+  }
   if (err) {
     return {unexpect, err};
   } else {
@@ -156,10 +195,18 @@ gl_expect<void> gl_buffer::read_data(gl_context& gl, void* data, size_t size, si
 gl_expect<void*> gl_buffer::map_range(gl_context& gl, size_t size, size_t offset,
                                       gldefs::GLbitfield access_flags) {
   SHOGLE_ASSERT(!invalidated(), "gl_buffer use after free");
-  GL_ASSERT(glBindBuffer(_type, _id));
-  void* ptr = GL_CALL(glMapBufferRange(_type, offset, size, access_flags));
-  const auto err = gl.get_error();
-  GL_ASSERT(glBindBuffer(_type, GL_DEFAULT_BINDING));
+  void* ptr;
+  GLenum err;
+  if (impl::gl_get_private(gl).direct_state_access) {
+    ptr = GL_CALL(glMapNamedBufferRange(_id, offset, size, access_flags));
+    err = gl.get_error();
+  } else {
+    GL_ASSERT(glBindBuffer(_type, _id));
+    ptr = GL_CALL(glMapBufferRange(_type, offset, size, access_flags));
+    err = gl.get_error();
+    GL_ASSERT(glBindBuffer(_type, GL_DEFAULT_BINDING));
+    gl_get_state(gl).forget_bound_buffer(_type);
+  }
   if (err != GL_NO_ERROR) {
     return {unexpect, err};
   }
@@ -171,8 +218,14 @@ gl_expect<void*> gl_buffer::map_range(gl_context& gl, size_t size, size_t offset
 
 gl_expect<void*> gl_buffer::map(gl_context& gl, gl_buffer::mapping_access access) {
   SHOGLE_ASSERT(!invalidated(), "gl_buffer use after free");
-  GL_ASSERT(glBindBuffer(_type, _id));
-  void* ptr = GL_CALL(glMapBuffer(_type, access));
+  void* ptr;
+  if (impl::gl_get_private(gl).direct_state_access) {
+    ptr = GL_CALL(glMapNamedBuffer(_id, access));
+  } else {
+    GL_ASSERT(glBindBuffer(_type, _id));
+    gl_get_state(gl).forget_bound_buffer(_type);
+    ptr = GL_CALL(glMapBuffer(_type, access));
+  }
   const auto err = gl.get_error();
   if (err != GL_NO_ERROR) {
     return {unexpect, err};
@@ -186,16 +239,31 @@ gl_expect<void*> gl_buffer::map(gl_context& gl, gl_buffer::mapping_access access
 void gl_buffer::unmap(gl_context& gl) {
   SHOGLE_ASSERT(!invalidated(), "gl_buffer use after free");
   SHOGLE_GL_LOG(VERBOSE, "BUFFER_UNMAP ({})", _id);
+  if (impl::gl_get_private(gl).direct_state_access) {
+    GL_ASSERT(glUnmapNamedBuffer(_id));
+    return;
+  }
   GL_ASSERT(glBindBuffer(_type, _id));
   GL_ASSERT(glUnmapBuffer(_type));
   GL_ASSERT(glBindBuffer(_type, GL_DEFAULT_BINDING));
+  gl_get_state(gl).forget_bound_buffer(_type);
 }
 
 void gl_buffer::mut_realloc(gl_context& gl, size_t size, buffer_mut_usage usage,
                             const void* data) {
   SHOGLE_ASSERT(!invalidated(), "gl_buffer use after free");
   SHOGLE_ASSERT(is_mutable(), "Can't reallocate inmutable buffer");
-  GL_ASSERT(glBufferData(_id, size, data, _usage));
+  if (impl::gl_get_private(gl).direct_state_access) {
+    GL_ASSERT(glNamedBufferData(_id, size, data, usage));
+  } else {
+    GL_ASSERT(glBindBuffer(_type, _id));
+    GL_ASSERT(glBufferData(_type, size, data, usage));
+    GL_ASSERT(glBindBuffer(_type, GL_DEFAULT_BINDING));
+    gl_get_state(gl).forget_bound_buffer(_type);
+  }
+  if (data) {
+    GL_FRAME_STAT(buffer_upload_bytes, size);
+  }
   SHOGLE_GL_LOG(VERBOSE, "BUFFER_REALLOC ({}) (data: {}, sz: {}B -> {}B, usage: {})", _id,
                 fmt::ptr(data), _size, size, (gldefs::GLenum)usage);
   _size = size;
@@ -0,0 +1,203 @@
+#include "./context_private.hpp"
+#include <shogle/render/gl/buffer_pool.hpp>
+
+#include <algorithm>
+
+namespace shogle {
+
+gl_buffer_pool::gl_buffer_pool(create_t, gl_buffer block, gldefs::GLbitfield usage_flags) :
+    _usage(usage_flags) {
+  _blocks.emplace_back(block, mem::tlsf_allocator{block.size()});
+}
+
+gl_buffer_pool::gl_buffer_pool(gl_context& gl, gl_buffer::buffer_type type, size_t block_size,
+                               gldefs::GLbitfield usage_flags) :
+    gl_buffer_pool(::shogle::gl_buffer_pool::create(gl, type, block_size, usage_flags).value()) {}
+
+gl_expect<gl_buffer_pool> gl_buffer_pool::create(gl_context& gl, gl_buffer::buffer_type type,
+                                                 size_t block_size,
+                                                 gldefs::GLbitfield usage_flags) {
+  SHOGLE_ASSERT(block_size, "Buffer pool with no block size");
+  auto block = gl_buffer::allocate(gl, type, block_size, usage_flags);
+  if (!block) {
+    return {unexpect, block.error()};
+  }
+  SHOGLE_GL_LOG(VERBOSE, "BUFFER_POOL_ALLOC ({}) (block: {}B)", block->id(), block_size);
+  return {in_place, create_t{}, *block, usage_flags};
+}
+
+void gl_buffer_pool::destroy(gl_context& gl, gl_buffer_pool& pool) noexcept {
+  if (SHOGLE_UNLIKELY(pool.invalidated())) {
+    return;
+  }
+  for (auto& block : pool._blocks) {
+    gl_buffer::deallocate(gl, block.buffer);
+  }
+  pool._blocks.clear();
+}
+
+auto gl_buffer_pool::allocate(gl_context& gl, size_t size, size_t alignment)
+  -> gl_expect<allocation> {
+  SHOGLE_ASSERT(!invalidated(), "gl_buffer_pool use after free");
+  const size_t block_size = _blocks.front().buffer.size();
+  if (size + alignment - 1 > block_size) {
+    return {unexpect, GL_OUT_OF_MEMORY};
+  }
+  for (u32 i = 0; i < _blocks.size(); ++i) {
+    if (auto alloc = _blocks[i].allocator.allocate(size, alignment)) {
+      return {in_place, i, alloc->node};
+    }
+  }
+
+  auto buffer = gl_buffer::allocate(gl, _blocks.front().buffer.type(), block_size, _usage);
+  if (!buffer) {
+    return {unexpect, buffer.error()};
+  }
+  SHOGLE_GL_LOG(VERBOSE, "BUFFER_POOL_GROW ({}) (blocks: {})", buffer->id(), _blocks.size() + 1);
+  auto& block = _blocks.emplace_back(*buffer, mem::tlsf_allocator{block_size});
+  const auto alloc = block.allocator.allocate(size, alignment);
+  SHOGLE_ASSERT(alloc.has_value(), "Empty pool block can't fit allocation");
+  return {in_place, static_cast<u32>(_blocks.size() - 1), alloc->node};
+}
+
+void gl_buffer_pool::deallocate(const allocation& alloc) noexcept {
+  SHOGLE_ASSERT(!invalidated(), "gl_buffer_pool use after free");
+  SHOGLE_ASSERT(alloc.block < _blocks.size(), "Invalid buffer pool allocation");
+  _blocks[alloc.block].allocator.deallocate(alloc.node);
+}
+
+gl_expect<void> gl_buffer_pool::upload(gl_context& gl, const allocation& alloc, const void* data,
+                                       size_t size, size_t offset) {
+  SHOGLE_ASSERT(!invalidated(), "gl_buffer_pool use after free");
+  SHOGLE_ASSERT(alloc.block < _blocks.size(), "Invalid buffer pool allocation");
+  auto& block = _blocks[alloc.block];
+  SHOGLE_ASSERT(offset + size <= block.allocator.size(alloc.node),
+                "Buffer pool upload out of range");
+  return block.buffer.upload_data(gl, data, size, block.allocator.offset(alloc.node) + offset);
+}
+
+gl_expect<size_t> gl_buffer_pool::compact(gl_context& gl) {
+  SHOGLE_ASSERT(!invalidated(), "gl_buffer_pool use after free");
+  const bool fragmented = std::any_of(_blocks.begin(), _blocks.end(), [](const auto& block) {
+    return block.allocator.free_size() != block.allocator.largest_free_block();
+  });
+  if (!fragmented) {
+    return {in_place, 0u};
+  }
+
+  // Plan on copies so a failed scratch allocation leaves the pool as it was
+  std::vector<mem::tlsf_allocator> allocators;
+  std::vector<std::vector<mem::tlsf_allocator::block_move>> moves;
+  allocators.reserve(_blocks.size());
+  moves.reserve(_blocks.size());
+  size_t scratch_size = 0;
+  for (const auto& block : _blocks) {
+    auto& block_moves = moves.emplace_back(allocators.emplace_back(block.allocator).compact());
+    for (const auto& move : block_moves) {
+      if (move.src_offset - move.dst_offset < move.size) {
+        scratch_size = std::max(scratch_size, static_cast<size_t>(move.size));
+      }
+    }
+  }
+
+  // Ranges of the same buffer can't overlap, moves closer than their size bounce through here
+  optional<gl_buffer> scratch;
+  if (scratch_size) {
+    auto buffer = gl_buffer::allocate(gl, _blocks.front().buffer.type(), scratch_size, 0);
+    if (!buffer) {
+      return {unexpect, buffer.error()};
+    }
+    scratch.emplace(*buffer);
+  }
+
+  const bool dsa = impl::gl_get_private(gl).direct_state_access;
+  const auto copy = [&](GLuint src, GLuint dst, size_t src_offset, size_t dst_offset,
+                        size_t size) {
+    if (dsa) {
+      GL_ASSERT(glCopyNamedBufferSubData(src, dst, (GLintptr)src_offset, (GLintptr)dst_offset,
+                                         (GLsizeiptr)size));
+      return;
+    }
+    GL_ASSERT(glBindBuffer(GL_COPY_READ_BUFFER, src));
+    GL_ASSERT(glBindBuffer(GL_COPY_WRITE_BUFFER, dst));
+    GL_ASSERT(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (GLintptr)src_offset,
+                                  (GLintptr)dst_offset, (GLsizeiptr)size));
+  };
+
+  size_t copied = 0;
+  for (size_t i = 0; i < _blocks.size(); ++i) {
+    auto& block = _blocks[i];
+    block.allocator = std::move(allocators[i]);
+    const GLuint id = block.buffer.id();
+    for (const auto& move : moves[i]) {
+      if (move.src_offset - move.dst_offset < move.size) {
+        copy(id, scratch->id(), move.src_offset, 0, move.size);
+        copy(scratch->id(), id, 0, move.dst_offset, move.size);
+      } else {
+        copy(id, id, move.src_offset, move.dst_offset, move.size);
+      }
+      copied += move.size;
+    }
+    if (!moves[i].empty()) {
+      SHOGLE_GL_LOG(VERBOSE, "BUFFER_POOL_COMPACT ({}) (moves: {}, largest free: {}B)", id,
+                    moves[i].size(), block.allocator.largest_free_block());
+    }
+  }
+  if (!dsa) {
+    GL_ASSERT(glBindBuffer(GL_COPY_READ_BUFFER, GL_DEFAULT_BINDING));
+    GL_ASSERT(glBindBuffer(GL_COPY_WRITE_BUFFER, GL_DEFAULT_BINDING));
+  }
+  if (scratch) {
+    gl_buffer::deallocate(gl, *scratch);
+  }
+  return {in_place, copied};
+}
+
+auto gl_buffer_pool::range(const allocation& alloc) const -> buffer_range {
+  SHOGLE_ASSERT(!invalidated(), "gl_buffer_pool use after free");
+  SHOGLE_ASSERT(alloc.block < _blocks.size(), "Invalid buffer pool allocation");
+  const auto& block = _blocks[alloc.block];
+  return {block.buffer.id(), static_cast<size_t>(block.allocator.offset(alloc.node)),
+          static_cast<size_t>(block.allocator.size(alloc.node))};
+}
+
+const gl_buffer& gl_buffer_pool::block(u32 idx) const {
+  SHOGLE_ASSERT(!invalidated(), "gl_buffer_pool use after free");
+  SHOGLE_ASSERT(idx < _blocks.size(), "Buffer pool block out of range");
+  return _blocks[idx].buffer;
+}
+
+size_t gl_buffer_pool::block_size() const {
+  SHOGLE_ASSERT(!invalidated(), "gl_buffer_pool use after free");
+  return _blocks.front().buffer.size();
+}
+
+size_t gl_buffer_pool::used_size() const noexcept {
+  size_t used = 0;
+  for (const auto& block : _blocks) {
+    used += block.allocator.used_size();
+  }
+  return used;
+}
+
+size_t gl_buffer_pool::capacity() const noexcept {
+  size_t capacity = 0;
+  for (const auto& block : _blocks) {
+    capacity += block.allocator.capacity();
+  }
+  return capacity;
+}
+
+u32 gl_buffer_pool::allocation_count() const noexcept {
+  u32 count = 0;
+  for (const auto& block : _blocks) {
+    count += block.allocator.allocation_count();
+  }
+  return count;
+}
+
+bool gl_buffer_pool::invalidated() const noexcept {
+  return _blocks.empty();
+}
+
+} // namespace shogle
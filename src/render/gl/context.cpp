@@ -2,9 +2,14 @@
 #include <shogle/render/gl/buffer.hpp>
 #include <shogle/render/gl/context.hpp>
 #include <shogle/render/gl/framebuffer.hpp>
+#include <shogle/render/gl/gpu_profiler.hpp>
+#include <shogle/render/gl/sampler.hpp>
 #include <shogle/render/gl/texture.hpp>
 #include <shogle/render/gl/vertex.hpp>
 
+#include <algorithm>
+#include <numeric>
+
 namespace shogle {
 
 gl_clear_builder::gl_clear_builder() noexcept : _color(), _viewport(), _clear_flags(), _fbos() {}
@@ -169,9 +174,11 @@ gl_command_builder& gl_command_builder::set_index_buffer(const gl_buffer& buffer
   return *this;
 }
 
-gl_command_builder& gl_command_builder::add_vertex_buffer(const gl_buffer& buffer, u32 location) {
+gl_command_builder& gl_command_builder::add_vertex_buffer(const gl_buffer& buffer, u32 location,
+                                                          size_t offset) {
   SHOGLE_ASSERT(buffer.type() == gl_buffer::TYPE_VERTEX, "Binding non vertex buffer for vertices");
-  _vertex_binds.emplace_back(buffer.id(), location);
+  SHOGLE_ASSERT(offset < buffer.size(), "Vertex buffer offset out of range");
+  _vertex_binds.emplace_back(buffer.id(), location, offset);
   return *this;
 }
 
@@ -185,8 +192,20 @@ gl_command_builder& gl_command_builder::add_shader_buffer(u32 location, const gl
   return *this;
 }
 
+gl_command_builder&
+gl_command_builder::add_shader_binding(const gl_draw_command::shader_binding& binding) {
+  _shader_binds.emplace_back(binding);
+  return *this;
+}
+
 gl_command_builder& gl_command_builder::add_texture(const gl_texture& texture, u32 index) {
-  _texture_binds.emplace_back(texture.id(), texture.type(), index);
+  _texture_binds.emplace_back(texture.id(), texture.type(), index, GL_DEFAULT_BINDING);
+  return *this;
+}
+
+gl_command_builder& gl_command_builder::add_texture(const gl_texture& texture, u32 index,
+                                                    const gl_sampler& sampler) {
+  _texture_binds.emplace_back(texture.id(), texture.type(), index, sampler.id());
   return *this;
 }
 
@@ -209,6 +228,238 @@ gl_draw_command gl_command_builder::build() const {
   };
 }
 
+namespace {
+
+u64 batch_hash(u64 hash, u64 value) {
+  return (hash ^ value) * 0x100000001b3;
+}
+
+u64 batch_state_hash(const gl_draw_command& cmd) {
+  u64 hash = 0xcbf29ce484222325;
+  hash = batch_hash(hash, (u64{cmd.pipeline->program()} << 32) | cmd.vertex_layout->vao());
+  hash = batch_hash(hash, (u64{cmd.index_bind->buffer} << 32) | cmd.index_bind->format);
+  for (const auto& [buffer, location, offset] : cmd.vertex_bindings) {
+    hash = batch_hash(hash, (u64{location} << 32) | buffer);
+    hash = batch_hash(hash, offset);
+  }
+  for (const auto& [buffer, type, size, offset, location] : cmd.shader_bindings) {
+    hash = batch_hash(hash, (u64{location} << 32) | buffer);
+    hash = batch_hash(hash, offset ^ (u64{size} << 32));
+  }
+  for (const auto& [texture, type, index, sampler] : cmd.texture_bindings) {
+    hash = batch_hash(hash, (u64{index} << 32) | texture);
+    hash = batch_hash(hash, sampler);
+  }
+  return hash;
+}
+
+bool batch_rect_equal(const optional<rectangle_pos<u32>>& a,
+                      const optional<rectangle_pos<u32>>& b) {
+  if (a.has_value() != b.has_value()) {
+    return false;
+  }
+  return !a.has_value() ||
+         (a->x == b->x && a->y == b->y && a->width == b->width && a->height == b->height);
+}
+
+template<typename T, typename F>
+bool batch_bindings_equal(const T* a, size_t count, span<const T> b, F&& equal) {
+  if (count != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    if (!equal(a[i], b[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+gl_batch_builder::gl_batch_builder() noexcept :
+    _groups(), _draws(), _vertex_binds(), _shader_binds(), _texture_binds(), _commands(),
+    _built_groups(), _slots(), _draw_data(), _draw_data_alignment(1) {}
+
+void gl_batch_builder::reset() {
+  _groups.clear();
+  _draws.clear();
+  _vertex_binds.clear();
+  _shader_binds.clear();
+  _texture_binds.clear();
+  _commands.clear();
+  _built_groups.clear();
+  _slots.clear();
+  if (_draw_data.has_value()) {
+    _draw_data.reset();
+  }
+  _draw_data_alignment = 1;
+}
+
+gl_batch_builder& gl_batch_builder::set_draw_data(const gl_buffer& buffer, u32 location,
+                                                  size_t stride, size_t alignment) {
+  SHOGLE_ASSERT(buffer.type() == gl_buffer::TYPE_SHADER, "Draw data in non shader buffer");
+  SHOGLE_ASSERT(stride, "Draw data with no stride");
+  SHOGLE_ASSERT(alignment, "Draw data with no alignment");
+  _draw_data.emplace(buffer.id(), stride, location);
+  _draw_data_alignment = alignment;
+  return *this;
+}
+
+optional<u32> gl_batch_builder::_find_group(const gl_draw_command& cmd, u64 hash) const {
+  const auto vertex_equal = [](const auto& a, const auto& b) {
+    return a.buffer == b.buffer && a.location == b.location && a.offset == b.offset;
+  };
+  const auto shader_equal = [](const auto& a, const auto& b) {
+    return a.buffer == b.buffer && a.type == b.type && a.size == b.size &&
+           a.offset == b.offset && a.location == b.location;
+  };
+  const auto texture_equal = [](const auto& a, const auto& b) {
+    return a.texture == b.texture && a.type == b.type && a.index == b.index &&
+           a.sampler == b.sampler;
+  };
+
+  // Draws sharing state tend to be submitted together, look at the latest groups first
+  for (u32 i = _groups.size(); i-- > 0;) {
+    const auto& group = _groups[i];
+    if (group.hash != hash || &*group.pipeline != &*cmd.pipeline ||
+        &*group.vertex_layout != &*cmd.vertex_layout ||
+        group.index_bind.buffer != cmd.index_bind->buffer ||
+        group.index_bind.format != cmd.index_bind->format ||
+        !batch_rect_equal(group.viewport, cmd.viewport) ||
+        !batch_rect_equal(group.scissor, cmd.scissor)) {
+      continue;
+    }
+    const auto [voff, vcount] = group.vertex_bindings;
+    const auto [soff, scount] = group.shader_bindings;
+    const auto [toff, tcount] = group.texture_bindings;
+    if (batch_bindings_equal(_vertex_binds.data() + voff, vcount, cmd.vertex_bindings,
+                             vertex_equal) &&
+        batch_bindings_equal(_shader_binds.data() + soff, scount, cmd.shader_bindings,
+                             shader_equal) &&
+        batch_bindings_equal(_texture_binds.data() + toff, tcount, cmd.texture_bindings,
+                             texture_equal)) {
+      return i;
+    }
+  }
+  return nullopt;
+}
+
+bool gl_batch_builder::add_draw(const gl_draw_command& cmd) {
+  if (!cmd.index_bind.has_value() || !cmd.uniforms.empty()) {
+    return false;
+  }
+  SHOGLE_ASSERT(cmd.vertex_offset <= std::numeric_limits<i32>::max(),
+                "Vertex offset out of range");
+  SHOGLE_ASSERT(cmd.index_bind->index_offset <= std::numeric_limits<u32>::max(),
+                "Index offset out of range");
+
+  const u64 hash = batch_state_hash(cmd);
+  u32 group_idx;
+  if (const auto found = _find_group(cmd, hash)) {
+    group_idx = *found;
+  } else {
+    const auto append = [](auto& storage, const auto& bindings) -> binding_range {
+      const u32 offset = static_cast<u32>(storage.size());
+      storage.insert(storage.end(), bindings.begin(), bindings.end());
+      return {offset, static_cast<u32>(bindings.size())};
+    };
+    group_idx = static_cast<u32>(_groups.size());
+    _groups.push_back({
+      .vertex_layout = cmd.vertex_layout,
+      .pipeline = cmd.pipeline,
+      .vertex_bindings = append(_vertex_binds, cmd.vertex_bindings),
+      .shader_bindings = append(_shader_binds, cmd.shader_bindings),
+      .texture_bindings = append(_texture_binds, cmd.texture_bindings),
+      .index_bind = {cmd.index_bind->buffer, cmd.index_bind->format, 0},
+      .viewport = cmd.viewport,
+      .scissor = cmd.scissor,
+      .hash = hash,
+      .draw_count = 0,
+    });
+  }
+
+  ++_groups[group_idx].draw_count;
+  _draws.push_back({
+    .cmd =
+      {
+        .count = cmd.draw_count,
+        .instance_count = std::max(cmd.instances, 1u),
+        .first_index = static_cast<u32>(cmd.index_bind->index_offset),
+        .base_vertex = static_cast<i32>(cmd.vertex_offset),
+        .base_instance = 0,
+      },
+    .group = group_idx,
+  });
+  return true;
+}
+
+gl_indirect_batch gl_batch_builder::build() {
+  // Each group binds the draw data from its first command, that offset has to be aligned
+  size_t step = 1;
+  if (_draw_data.has_value()) {
+    step = _draw_data_alignment / std::gcd(_draw_data->stride, _draw_data_alignment);
+  }
+
+  _built_groups.clear();
+  u32 command_count = 0;
+  for (const auto& group : _groups) {
+    command_count = static_cast<u32>((command_count + step - 1) / step * step);
+    const auto [voff, vcount] = group.vertex_bindings;
+    const auto [soff, scount] = group.shader_bindings;
+    const auto [toff, tcount] = group.texture_bindings;
+    _built_groups.push_back({
+      .state =
+        {
+          .vertex_layout = group.vertex_layout,
+          .pipeline = group.pipeline,
+          .vertex_bindings = {_vertex_binds.data() + voff, vcount},
+          .shader_bindings = {_shader_binds.data() + soff, scount},
+          .texture_bindings = {_texture_binds.data() + toff, tcount},
+          .uniforms = {},
+          .index_bind = group.index_bind,
+          .viewport = group.viewport,
+          .scissor = group.scissor,
+          .vertex_offset = 0,
+          .draw_count = 0,
+          .instances = 1,
+        },
+      .first_command = command_count,
+      .command_count = 0,
+    });
+    command_count += group.draw_count;
+  }
+
+  // Padding between groups is left as empty commands, they never get drawn
+  _commands.assign(command_count, gl_indirect_command{});
+  _slots.resize(_draws.size());
+  for (u32 i = 0; i < _draws.size(); ++i) {
+    auto& group = _built_groups[_draws[i].group];
+    const u32 slot = group.first_command + group.command_count++;
+    _commands[slot] = _draws[i].cmd;
+    _slots[i] = slot;
+  }
+
+  return {
+    .commands = {_commands.data(), _commands.size()},
+    .groups = {_built_groups.data(), _built_groups.size()},
+    .draw_data = _draw_data,
+  };
+}
+
+u32 gl_batch_builder::draw_slot(u32 draw) const {
+  SHOGLE_ASSERT(draw < _slots.size(), "Draw slot out of range, was the batch built?");
+  return _slots[draw];
+}
+
+u32 gl_batch_builder::draw_count() const {
+  return static_cast<u32>(_draws.size());
+}
+
+u32 gl_batch_builder::group_count() const {
+  return static_cast<u32>(_groups.size());
+}
+
 gl_external_command_builder::gl_external_command_builder() noexcept :
     _callback(), _stencil(::shogle::gl_stencil_test_props::make_default(false)),
     _depth(::shogle::gl_depth_test_props::make_default(false)),
@@ -329,7 +580,6 @@ namespace {
 
 APIENTRY void debug_callback(GLenum src, GLenum type, GLuint id, GLenum severity, GLsizei,
                              const char* message, const void* user) {
-  SHOGLE_UNUSED(user);
 
   std::string_view severity_msg = [severity]() {
     switch (severity) {
@@ -399,15 +649,107 @@ APIENTRY void debug_callback(GLenum src, GLenum type, GLuint id, GLenum severity
   if (type == GL_DEBUG_TYPE_ERROR) {
     SHOGLE_GL_LOG(ERROR, "Debug ({})({})({})({}) {}", severity_msg, type_msg, src_msg, id,
                   message);
+    // Some drivers use the error code as the message id, the rest get a generic error
+    auto& ctx = *static_cast<gl_private*>(const_cast<void*>(user));
+    ctx.debug_error = id >= GL_INVALID_ENUM && id <= GL_INVALID_FRAMEBUFFER_OPERATION
+                        ? static_cast<GLenum>(id)
+                        : GL_INVALID_OPERATION;
   } else {
     SHOGLE_GL_LOG(VERBOSE, "Debug ({})({})({})({}) {}", severity_msg, type_msg, src_msg, id,
                   message);
   }
 }
 
+bool has_extension(gl_private& ctx, std::string_view name) {
+#if defined(SHOGLE_USE_SYSTEM_GL) && SHOGLE_USE_SYSTEM_GL
+#define CTX_CALL(func) (func)
+#else
+#define CTX_CALL(func) ctx.funcs.func
+#endif
+  GLint count = 0;
+  CTX_CALL(glGetIntegerv(GL_NUM_EXTENSIONS, &count));
+  for (GLint i = 0; i < count; ++i) {
+    const auto* ext = CTX_CALL(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+    if (ext && name == reinterpret_cast<const char*>(ext)) {
+      return true;
+    }
+  }
+  return false;
+#undef CTX_CALL
+}
+
+// Core since 4.6, an extension before that
+f32 query_max_anisotropy(gl_private& ctx) {
+  const bool supported = (ctx.ver.maj == 4 && ctx.ver.min >= 6) || ctx.ver.maj > 4 ||
+                         has_extension(ctx, "GL_ARB_texture_filter_anisotropic") ||
+                         has_extension(ctx, "GL_EXT_texture_filter_anisotropic");
+  if (!supported) {
+    return 0.f;
+  }
+#if defined(SHOGLE_USE_SYSTEM_GL) && SHOGLE_USE_SYSTEM_GL
+#define CTX_CALL(func) (func)
+#else
+#define CTX_CALL(func) ctx.funcs.func
+#endif
+  GLint max_anisotropy = 0;
+  CTX_CALL(glGetIntegerv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &max_anisotropy));
+  return static_cast<f32>(max_anisotropy);
+#undef CTX_CALL
+}
+
+// Core since 4.5, an extension before that. Every named function has to be there, some
+// drivers advertise the extension with entry points missing.
+bool query_direct_state_access(gl_private& ctx) {
+  const bool supported = (ctx.ver.maj == 4 && ctx.ver.min >= 5) || ctx.ver.maj > 4 ||
+                         has_extension(ctx, "GL_ARB_direct_state_access");
+  if (!supported) {
+    return false;
+  }
+#if defined(SHOGLE_USE_SYSTEM_GL) && SHOGLE_USE_SYSTEM_GL
+  return true;
+#else
+#define CHECK_LOADED(name_, ...) && ctx.funcs.name_ != nullptr
+  return true SHOGLE_GL_DOFUNCS_DSA(CHECK_LOADED);
+#undef CHECK_LOADED
+#endif
+}
+
+// Implied by direct state access, the named functions cover the same state
+bool query_vertex_attrib_binding(gl_private& ctx) {
+  if (ctx.direct_state_access) {
+    return true;
+  }
+  const bool supported = (ctx.ver.maj == 4 && ctx.ver.min >= 3) || ctx.ver.maj > 4 ||
+                         has_extension(ctx, "GL_ARB_vertex_attrib_binding");
+  if (!supported) {
+    return false;
+  }
+#if defined(SHOGLE_USE_SYSTEM_GL) && SHOGLE_USE_SYSTEM_GL
+  return true;
+#else
+#define CHECK_LOADED(name_, ...) && ctx.funcs.name_ != nullptr
+  return true SHOGLE_GL_DOFUNCS_ATTRIB_BINDING(CHECK_LOADED);
+#undef CHECK_LOADED
+#endif
+}
+
+bool query_bindless_texture(gl_private& ctx) {
+  if (!has_extension(ctx, "GL_ARB_bindless_texture")) {
+    return false;
+  }
+#if defined(SHOGLE_USE_SYSTEM_GL) && SHOGLE_USE_SYSTEM_GL
+  return true;
+#else
+#define CHECK_LOADED(name_, ...) && ctx.funcs.name_ != nullptr
+  return true SHOGLE_GL_DOFUNCS_BINDLESS(CHECK_LOADED);
+#undef CHECK_LOADED
+#endif
+}
+
 } // namespace
 
-sv_expect<gl_context> gl_context::create(const gl_surface_provider& surf_prov) noexcept {
+sv_expect<gl_context> gl_context::create(const gl_surface_provider& surf_prov,
+                                        error_check_policy error_policy) noexcept {
   static constexpr size_t initial_arena_pages = 16;
   const size_t initial_arena_size = initial_arena_pages * mem::system_page_size();
 
@@ -417,7 +759,7 @@ sv_expect<gl_context> gl_context::create(const gl_surface_provider& surf_prov) n
       return {unexpect, "Failed to allocate scratch arena"};
     }
 
-    context_data ctx(new gl_private(std::move(*arena), surf_prov));
+    context_data ctx(new gl_private(std::move(*arena), surf_prov, error_policy));
 
 #if defined(SHOGLE_USE_SYSTEM_GL) && SHOGLE_USE_SYSTEM_GL
     ctx->version_string = reinterpret_cast<const char*>(glGetString(GL_VERSION));
@@ -428,6 +770,10 @@ sv_expect<gl_context> gl_context::create(const gl_surface_provider& surf_prov) n
     ctx->vendor_string = reinterpret_cast<const char*>(glGetString(GL_VENDOR));
     ctx->renderer_string = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
     glDebugMessageCallback((GLDEBUGPROC)debug_callback, ctx.get());
+    if (error_policy == ERROR_POLICY_DEBUG_CALLBACK) {
+      glEnable(GL_DEBUG_OUTPUT);
+      glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    }
 #else
     const auto proc = ctx->surf_prov.get_proc_func();
     auto err = shogle_gl_load_funcs(ctx->surf_prov.get_ptr(), (PFN_shogle_glGetProcAddress)proc,
@@ -441,13 +787,25 @@ sv_expect<gl_context> gl_context::create(const gl_surface_provider& surf_prov) n
     ctx->vendor_string = reinterpret_cast<const char*>(ctx->funcs.glGetString(GL_VENDOR));
     ctx->renderer_string = reinterpret_cast<const char*>(ctx->funcs.glGetString(GL_RENDERER));
     ctx->funcs.glDebugMessageCallback((GLDEBUGPROC)debug_callback, ctx.get());
+    if (error_policy == ERROR_POLICY_DEBUG_CALLBACK) {
+      // Synchronous output, so errors get reported from the offending call
+      ctx->funcs.glEnable(GL_DEBUG_OUTPUT);
+      ctx->funcs.glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    }
 #endif
     SHOGLE_ASSERT(ctx->version_string);
     SHOGLE_ASSERT(ctx->vendor_string);
     SHOGLE_ASSERT(ctx->renderer_string);
+    ctx->parallel_shader_compile = has_extension(*ctx, "GL_KHR_parallel_shader_compile");
+    ctx->max_anisotropy = query_max_anisotropy(*ctx);
+    ctx->direct_state_access = query_direct_state_access(*ctx);
+    ctx->vertex_attrib_binding = query_vertex_attrib_binding(*ctx);
+    ctx->bindless_texture = query_bindless_texture(*ctx);
     SHOGLE_GL_LOG(DEBUG, "OpenGL context created (ptr: {})", fmt::ptr(ctx.get()));
     SHOGLE_GL_LOG(DEBUG, "{}, {}, {}", ctx->version_string, ctx->vendor_string,
                   ctx->renderer_string);
+    SHOGLE_GL_LOG(DEBUG, "Direct state access: {}, bindless textures: {}",
+                  ctx->direct_state_access, ctx->bindless_texture);
     return {in_place, create_t{}, std::move(ctx)};
   } catch (...) {
     return {unexpect, "Failed to allocate OpenGL context"};
@@ -461,8 +819,8 @@ void gl_context::context_deleter::operator()(gl_private* ptr) noexcept {
 
 gl_context::gl_context(create_t, context_data&& ctx) noexcept : _ctx(std::move(ctx)) {}
 
-gl_context::gl_context(const gl_surface_provider& surf_prov) :
-    gl_context(::shogle::gl_context::create(surf_prov).value()) {}
+gl_context::gl_context(const gl_surface_provider& surf_prov, error_check_policy error_policy) :
+    gl_context(::shogle::gl_context::create(surf_prov, error_policy).value()) {}
 
 gl_private& impl::gl_get_private(gl_context& gl) {
   SHOGLE_ASSERT(gl._ctx, "gl_context use after free");
@@ -489,6 +847,21 @@ gldefs::GLenum gl_context::get_error() const {
   return out;
 }
 
+gl_context::error_check_policy gl_context::error_policy() const {
+  SHOGLE_ASSERT(_ctx, "gl_context use after free");
+  return _ctx->error_policy;
+}
+
+const gl_frame_stats& gl_context::frame_stats() const {
+  SHOGLE_ASSERT(_ctx, "gl_context use after free");
+  return _ctx->last_frame_stats;
+}
+
+ptr_view<gl_gpu_profiler> gl_context::profiler() const {
+  SHOGLE_ASSERT(_ctx, "gl_context use after free");
+  return _ctx->profiler;
+}
+
 gl_context::gl_version gl_context::version() const {
   SHOGLE_ASSERT(_ctx, "gl_context use after free");
   return gl_version{.major = static_cast<u32>(_ctx->ver.maj),
@@ -510,106 +883,388 @@ std::string_view gl_context::version_string() const {
   return _ctx->version_string;
 }
 
+void gl_state_cache::invalidate() noexcept {
+  program = GL_NULL_HANDLE;
+  draw_fbo = GL_NULL_HANDLE;
+  vao = GL_NULL_HANDLE;
+  array_buffer = GL_NULL_HANDLE;
+  element_buffer = GL_NULL_HANDLE;
+  indirect_buffer = GL_NULL_HANDLE;
+  vertex_buffers.fill({.buffer = GL_NULL_HANDLE, .offset = 0});
+
+  active_texture = GL_NULL_HANDLE;
+  textures.fill({
+    .type = GL_NULL_HANDLE,
+    .texture = GL_NULL_HANDLE,
+    .sampler = GL_NULL_HANDLE,
+  });
+  uniform_buffers.fill({.buffer = GL_NULL_HANDLE, .offset = 0, .size = 0});
+  storage_buffers.fill({.buffer = GL_NULL_HANDLE, .offset = 0, .size = 0});
+
+  viewport_valid = false;
+  scissor_valid = false;
+  scissor_test_valid = false;
+  clear_color_valid = false;
+
+  poly_mode = GL_NULL_HANDLE;
+  line_width = -1.f;
+  point_size = -1.f;
+  depth.enable_valid = depth.params_valid = false;
+  stencil.enable_valid = stencil.params_valid = false;
+  blending.enable_valid = blending.params_valid = false;
+  culling.enable_valid = culling.params_valid = false;
+}
+
+void gl_state_cache::forget_bound_buffer(GLenum target) noexcept {
+  switch (target) {
+    case GL_ARRAY_BUFFER: {
+      array_buffer = GL_NULL_HANDLE;
+    } break;
+    case GL_ELEMENT_ARRAY_BUFFER: {
+      // Element bindings live in the currently bound VAO
+      element_buffer = GL_NULL_HANDLE;
+    } break;
+    case GL_DRAW_INDIRECT_BUFFER: {
+      indirect_buffer = GL_NULL_HANDLE;
+    } break;
+    default:
+      // Generic bindings don't alias the indexed ones
+      break;
+  }
+}
+
+void gl_state_cache::forget_bound_texture() noexcept {
+  if (active_texture >= MAX_TEXTURE_UNITS) {
+    for (auto& unit : textures) {
+      unit.type = GL_NULL_HANDLE;
+      unit.texture = GL_NULL_HANDLE;
+    }
+    return;
+  }
+  textures[active_texture].texture = GL_NULL_HANDLE;
+}
+
+void gl_state_cache::forget_bound_framebuffer() noexcept {
+  draw_fbo = GL_NULL_HANDLE;
+}
+
+void gl_state_cache::forget_buffer(GLuint buffer) noexcept {
+  if (array_buffer == buffer) {
+    array_buffer = GL_NULL_HANDLE;
+  }
+  if (element_buffer == buffer) {
+    element_buffer = GL_NULL_HANDLE;
+  }
+  if (indirect_buffer == buffer) {
+    indirect_buffer = GL_NULL_HANDLE;
+  }
+  for (auto& source : vertex_buffers) {
+    if (source.buffer == buffer) {
+      source.buffer = GL_NULL_HANDLE;
+    }
+  }
+  for (auto& range : uniform_buffers) {
+    if (range.buffer == buffer) {
+      range.buffer = GL_NULL_HANDLE;
+    }
+  }
+  for (auto& range : storage_buffers) {
+    if (range.buffer == buffer) {
+      range.buffer = GL_NULL_HANDLE;
+    }
+  }
+}
+
+void gl_state_cache::forget_texture(GLuint texture) noexcept {
+  for (auto& unit : textures) {
+    if (unit.texture == texture) {
+      unit.texture = GL_NULL_HANDLE;
+    }
+  }
+}
+
+void gl_state_cache::forget_vertex_array(GLuint vao_) noexcept {
+  if (vao == vao_) {
+    vao = GL_NULL_HANDLE;
+    element_buffer = GL_NULL_HANDLE;
+    vertex_buffers.fill({.buffer = GL_NULL_HANDLE, .offset = 0});
+  }
+}
+
+void gl_state_cache::forget_framebuffer(GLuint fbo) noexcept {
+  if (draw_fbo == fbo) {
+    draw_fbo = GL_NULL_HANDLE;
+  }
+}
+
+void gl_state_cache::forget_program(GLuint program_) noexcept {
+  if (program == program_) {
+    program = GL_NULL_HANDLE;
+  }
+}
+
+void gl_state_cache::forget_sampler(GLuint sampler) noexcept {
+  for (auto& unit : textures) {
+    if (unit.sampler == sampler) {
+      unit.sampler = GL_NULL_HANDLE;
+    }
+  }
+}
+
 namespace {
 
-constexpr GLuint DEFAULT_FRAMEBUFFER = 0;
+bool rect_equal(const rectangle_pos<u32>& a, const rectangle_pos<u32>& b) {
+  return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
+}
+
+bool color_equal(const color4& a, const color4& b) {
+  return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
 
-void setup_framebuffer(gl_context& gl, GLuint fbo, const rectangle_pos<u32>& viewport,
-                       const rectangle_pos<u32>& scissor) {
+void bind_draw_framebuffer(gl_context& gl, gl_state_cache& state, GLuint fbo) {
+  if (state.draw_fbo == fbo) {
+    return;
+  }
   GL_ASSERT(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo));
+  GL_FRAME_STAT(fbo_binds, 1);
+  state.draw_fbo = fbo;
+}
+
+void set_viewport(gl_context& gl, gl_state_cache& state, const rectangle_pos<u32>& viewport) {
+  if (state.viewport_valid && rect_equal(state.viewport, viewport)) {
+    return;
+  }
   GL_ASSERT(glViewport(viewport.x, viewport.y, viewport.width, viewport.height));
-  GL_ASSERT(glEnable(GL_SCISSOR_TEST));
-  GL_ASSERT(glScissor(scissor.x, scissor.y, scissor.width, scissor.height));
+  state.viewport = viewport;
+  state.viewport_valid = true;
+}
+
+void setup_framebuffer(gl_context& gl, gl_state_cache& state, GLuint fbo,
+                       const rectangle_pos<u32>& viewport, const rectangle_pos<u32>& scissor) {
+  bind_draw_framebuffer(gl, state, fbo);
+  set_viewport(gl, state, viewport);
+  if (!state.scissor_test_valid) {
+    GL_ASSERT(glEnable(GL_SCISSOR_TEST));
+    state.scissor_test_valid = true;
+  }
+  if (!state.scissor_valid || !rect_equal(state.scissor, scissor)) {
+    GL_ASSERT(glScissor(scissor.x, scissor.y, scissor.width, scissor.height));
+    state.scissor = scissor;
+    state.scissor_valid = true;
+  }
 }
 
-void setup_render_state(gl_context& gl, const gl_depth_test_props& depth_test,
+template<typename Props>
+bool toggle_capability(gl_context& gl, gl_state_cache::cached_props<Props>& cached, GLenum cap,
+                       const Props& props) {
+  if (!cached.enable_valid || cached.props.enable != props.enable) {
+    if (props.enable) {
+      GL_ASSERT(glEnable(cap));
+    } else {
+      GL_ASSERT(glDisable(cap));
+    }
+    cached.props.enable = props.enable;
+    cached.enable_valid = true;
+  }
+  return props.enable;
+}
+
+void setup_render_state(gl_context& gl, gl_state_cache& state,
+                        const gl_depth_test_props& depth_test,
                         const gl_stencil_test_props& stencil_test,
                         const gl_blending_props& blending, const gl_culling_props& culling,
                         GLenum poly_mode, f32 poly_width) {
-  GL_ASSERT(glPolygonMode(GL_FRONT_AND_BACK, poly_mode));
+  if (state.poly_mode != poly_mode) {
+    GL_ASSERT(glPolygonMode(GL_FRONT_AND_BACK, poly_mode));
+    state.poly_mode = poly_mode;
+  }
   if (poly_mode == GL_LINE) {
-    GL_ASSERT(glLineWidth(poly_width));
+    if (state.line_width != poly_width) {
+      GL_ASSERT(glLineWidth(poly_width));
+      state.line_width = poly_width;
+    }
   } else {
-    GL_ASSERT(glPointSize(poly_width));
+    if (state.point_size != poly_width) {
+      GL_ASSERT(glPointSize(poly_width));
+      state.point_size = poly_width;
+    }
   }
 
-  if (depth_test.enable) {
-    GL_ASSERT(glEnable(GL_DEPTH_TEST));
-    GL_ASSERT(glDepthFunc(depth_test.test));
-    GL_ASSERT(glDepthRange(depth_test.near, depth_test.far));
-    GL_ASSERT(glDepthMask(depth_test.mask));
-  } else {
-    GL_ASSERT(glDisable(GL_DEPTH_TEST));
+  if (toggle_capability(gl, state.depth, GL_DEPTH_TEST, depth_test)) {
+    auto& props = state.depth.props;
+    bool& valid = state.depth.params_valid;
+    if (!valid || props.test != depth_test.test) {
+      GL_ASSERT(glDepthFunc(depth_test.test));
+    }
+    if (!valid || props.near != depth_test.near || props.far != depth_test.far) {
+      GL_ASSERT(glDepthRange(depth_test.near, depth_test.far));
+    }
+    if (!valid || props.mask != depth_test.mask) {
+      GL_ASSERT(glDepthMask(depth_test.mask));
+    }
+    props = depth_test;
+    valid = true;
   }
 
-  if (stencil_test.enable) {
-    GL_ASSERT(glEnable(GL_STENCIL_TEST));
-    GL_ASSERT(glStencilFunc(stencil_test.test, stencil_test.test_ref, stencil_test.test_mask));
-    GL_ASSERT(
-      glStencilOp(stencil_test.on_stencil_fail, stencil_test.on_depth_fail, stencil_test.on_pass));
-    GL_ASSERT(glStencilMask(stencil_test.stencil_mask));
-  } else {
-    GL_ASSERT(glDisable(GL_STENCIL_TEST));
+  if (toggle_capability(gl, state.stencil, GL_STENCIL_TEST, stencil_test)) {
+    auto& props = state.stencil.props;
+    bool& valid = state.stencil.params_valid;
+    if (!valid || props.test != stencil_test.test || props.test_ref != stencil_test.test_ref ||
+        props.test_mask != stencil_test.test_mask) {
+      GL_ASSERT(glStencilFunc(stencil_test.test, stencil_test.test_ref, stencil_test.test_mask));
+    }
+    if (!valid || props.on_stencil_fail != stencil_test.on_stencil_fail ||
+        props.on_depth_fail != stencil_test.on_depth_fail ||
+        props.on_pass != stencil_test.on_pass) {
+      GL_ASSERT(glStencilOp(stencil_test.on_stencil_fail, stencil_test.on_depth_fail,
+                            stencil_test.on_pass));
+    }
+    if (!valid || props.stencil_mask != stencil_test.stencil_mask) {
+      GL_ASSERT(glStencilMask(stencil_test.stencil_mask));
+    }
+    props = stencil_test;
+    valid = true;
   }
 
-  if (blending.enable) {
-    GL_ASSERT(glEnable(GL_BLEND));
-    GL_ASSERT(glBlendEquation(blending.mode));
-    GL_ASSERT(glBlendFuncSeparate(blending.src_color, blending.dst_color, blending.src_alpha,
-                                  blending.dst_alpha));
-    GL_ASSERT(
-      glBlendColor(blending.color.r, blending.color.g, blending.color.b, blending.color.a));
-  } else {
-    GL_ASSERT(glDisable(GL_BLEND));
+  if (toggle_capability(gl, state.blending, GL_BLEND, blending)) {
+    auto& props = state.blending.props;
+    bool& valid = state.blending.params_valid;
+    if (!valid || props.mode != blending.mode) {
+      GL_ASSERT(glBlendEquation(blending.mode));
+    }
+    if (!valid || props.src_color != blending.src_color || props.dst_color != blending.dst_color ||
+        props.src_alpha != blending.src_alpha || props.dst_alpha != blending.dst_alpha) {
+      GL_ASSERT(glBlendFuncSeparate(blending.src_color, blending.dst_color, blending.src_alpha,
+                                    blending.dst_alpha));
+    }
+    if (!valid || !color_equal(props.color, blending.color)) {
+      GL_ASSERT(
+        glBlendColor(blending.color.r, blending.color.g, blending.color.b, blending.color.a));
+    }
+    props = blending;
+    valid = true;
   }
 
-  if (culling.enable) {
-    GL_ASSERT(glEnable(GL_CULL_FACE));
-    GL_ASSERT(glCullFace(culling.mode));
-    GL_ASSERT(glFrontFace(culling.face));
-  } else {
-    GL_ASSERT(glDisable(GL_CULL_FACE));
-  }
-}
-
-gldefs::GLenum underlying_attribute_type(attribute_type attrib) {
-  static constexpr auto attrs = std::to_array({
-    GL_FLOAT,        // f32
-    GL_FLOAT,        // vec2
-    GL_FLOAT,        // vec3
-    GL_FLOAT,        // vec4
-    GL_FLOAT,        // mat3
-    GL_FLOAT,        // mat4
-    GL_DOUBLE,       // f64
-    GL_DOUBLE,       // dvec2
-    GL_DOUBLE,       // dvec3
-    GL_DOUBLE,       // dvec4
-    GL_INT,          // i32
-    GL_INT,          // ivec2
-    GL_INT,          // ivec3
-    GL_INT,          // ivec4
-    GL_UNSIGNED_INT, // u32
-    GL_UNSIGNED_INT, // uvec2
-    GL_UNSIGNED_INT, // uvec3
-    GL_UNSIGNED_INT, // uvec4
-  });
-  const u32 idx = static_cast<u32>(attrib);
-  return idx < attrs.size() ? attrs[idx] : 0;
-};
+  if (toggle_capability(gl, state.culling, GL_CULL_FACE, culling)) {
+    auto& props = state.culling.props;
+    bool& valid = state.culling.params_valid;
+    if (!valid || props.mode != culling.mode) {
+      GL_ASSERT(glCullFace(culling.mode));
+    }
+    if (!valid || props.face != culling.face) {
+      GL_ASSERT(glFrontFace(culling.face));
+    }
+    props = culling;
+    valid = true;
+  }
+}
 
 u32 attribute_dimension(attribute_type attrib) {
   return ::shogle::meta::attribute_dim(attrib);
 }
 
-void setup_vertex_attributes(gl_context& gl, const gl_vertex_layout& layout,
-                             span<const gl_draw_command::vertex_binding> vertex_buffers) {
+void bind_array_buffer(gl_context& gl, gl_state_cache& state, GLuint buffer) {
+  if (state.array_buffer == buffer) {
+    return;
+  }
+  GL_ASSERT(glBindBuffer(GL_ARRAY_BUFFER, buffer));
+  state.array_buffer = buffer;
+}
+
+void bind_element_buffer(gl_context& gl, gl_state_cache& state, GLuint buffer) {
+  if (state.element_buffer == buffer) {
+    return;
+  }
+  GL_ASSERT(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer));
+  state.element_buffer = buffer;
+}
+
+void bind_indirect_buffer(gl_context& gl, gl_state_cache& state, GLuint buffer) {
+  if (state.indirect_buffer == buffer) {
+    return;
+  }
+  GL_ASSERT(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer));
+  state.indirect_buffer = buffer;
+}
+
+// Vertex formats were set in the VAO on creation, a draw only changes the buffers they source
+void bind_vertex_buffers(gl_context& gl, gl_state_cache& state, const gl_vertex_layout& layout,
+                         span<const gl_draw_command::vertex_binding> vertex_buffers) {
+  constexpr u32 MAX_BINDINGS = gl_vertex_layout::MAX_ATTRIBUTE_BINDINGS;
+  std::array<GLuint, MAX_BINDINGS> buffers{};
+  std::array<GLintptr, MAX_BINDINGS> offsets{};
+  std::array<GLsizei, MAX_BINDINGS> strides{};
+  if (layout.type() == gl_vertex_layout::TYPE_AOS_LAYOUT) {
+    buffers[0] = vertex_buffers[0].buffer;
+    offsets[0] = static_cast<GLintptr>(vertex_buffers[0].offset);
+    strides[0] = static_cast<GLsizei>(layout.stride());
+  } else {
+    // One binding per attribute location, the attribute offset is applied to its buffer
+    for (const auto& attrib : layout.attributes()) {
+      offsets[attrib.location] = static_cast<GLintptr>(attrib.offset);
+      strides[attrib.location] = static_cast<GLsizei>(::shogle::meta::attribute_size(attrib.type));
+    }
+    for (const auto& [buffer, location, offset] : vertex_buffers) {
+      buffers[location] = buffer;
+      offsets[location] += static_cast<GLintptr>(offset);
+    }
+  }
+
+  u32 first = MAX_BINDINGS;
+  u32 last = 0;
+  for (u32 i = 0; i < MAX_BINDINGS; ++i) {
+    auto& source = state.vertex_buffers[i];
+    const size_t offset = static_cast<size_t>(offsets[i]);
+    if (source.buffer == buffers[i] && source.offset == offset) {
+      continue;
+    }
+    source = {.buffer = buffers[i], .offset = offset};
+    first = std::min(first, i);
+    last = i;
+  }
+  if (first > last) {
+    return;
+  }
+  // Unchanged bindings in between are sent again, still a single call for the whole range
+  if (impl::gl_get_private(gl).direct_state_access) {
+    GL_ASSERT(glVertexArrayVertexBuffers(layout.vao(), first, last - first + 1, &buffers[first],
+                                         &offsets[first], &strides[first]));
+    return;
+  }
+  // Multi bind is 4.4, the VAO is already bound so each binding goes on its own
+  for (u32 i = first; i <= last; ++i) {
+    GL_ASSERT(glBindVertexBuffer(i, buffers[i], offsets[i], strides[i]));
+  }
+}
+
+void bind_vertex_pointers(gl_context& gl, gl_state_cache& state, const gl_vertex_layout& layout,
+                          span<const gl_draw_command::vertex_binding> vertex_buffers) {
   const auto attribs = layout.attributes();
-  SHOGLE_ASSERT(!attribs.empty());
+
+  // Attribute location -> source buffer
+  std::array<gl_state_cache::vertex_buffer, gl_vertex_layout::MAX_ATTRIBUTE_BINDINGS> bind_map{};
+  if (layout.type() == gl_vertex_layout::TYPE_AOS_LAYOUT) {
+    for (const auto& attrib : attribs) {
+      bind_map[attrib.location] = {vertex_buffers[0].buffer, vertex_buffers[0].offset};
+    }
+  } else {
+    for (const auto [buffer, location, offset] : vertex_buffers) {
+      bind_map[location] = {buffer, offset};
+    }
+  }
+
+  // Attribute pointers are VAO state, nothing to do if the same buffers are already sourced
+  const auto same_source = [](const auto& a, const auto& b) {
+    return a.buffer == b.buffer && a.offset == b.offset;
+  };
+  if (std::equal(bind_map.begin(), bind_map.end(), state.vertex_buffers.begin(), same_source)) {
+    return;
+  }
 
   const auto bind_attrib_pointer = [&](shogle::attribute_type type, u32 location, size_t offset_) {
     void* offset = reinterpret_cast<void*>(offset_);
     const u32 dimension = attribute_dimension(type);
-    const auto underlying = underlying_attribute_type(type);
+    const auto underlying = gl_attribute_type(type);
 
     GL_ASSERT(glEnableVertexAttribArray(location));
     switch (underlying) {
@@ -621,7 +1276,9 @@ void setup_vertex_attributes(gl_context& gl, const gl_vertex_layout& layout,
         GL_ASSERT(
           glVertexAttribLPointer(location, dimension, underlying, layout.stride(), offset));
       } break;
-      case GL_INT: {
+      case GL_INT:
+        [[fallthrough]];
+      case GL_UNSIGNED_INT: {
         GL_ASSERT(
           glVertexAttribIPointer(location, dimension, underlying, layout.stride(), offset));
       } break;
@@ -630,43 +1287,56 @@ void setup_vertex_attributes(gl_context& gl, const gl_vertex_layout& layout,
     }
   };
 
-  GL_ASSERT(glBindVertexArray(layout.vao()));
+  for (const auto& attrib : attribs) {
+    const auto [buffer, offset] = bind_map[attrib.location];
+    if (buffer == 0) {
+      continue;
+    }
+    bind_array_buffer(gl, state, buffer);
+    bind_attrib_pointer(attrib.type, attrib.location, attrib.offset + offset);
+  }
+  state.vertex_buffers = bind_map;
+}
+
+void setup_vertex_attributes(gl_context& gl, gl_state_cache& state,
+                             const gl_vertex_layout& layout,
+                             span<const gl_draw_command::vertex_binding> vertex_buffers) {
+  const auto attribs = layout.attributes();
+  SHOGLE_ASSERT(!attribs.empty());
   if (layout.type() == gl_vertex_layout::TYPE_AOS_LAYOUT) {
     SHOGLE_ASSERT(vertex_buffers.size() == 1,
                   "AOS vertex layouts uses only a single vertex buffer");
-    GL_ASSERT(glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers[0].buffer));
-    for (const auto& attrib : attribs) {
-      SHOGLE_ASSERT(attrib.location < gl_vertex_layout::MAX_ATTRIBUTE_BINDINGS,
-                    "Attribute location out of range");
-      bind_attrib_pointer(attrib.type, attrib.location, attrib.offset);
-    }
   } else {
     SHOGLE_ASSERT(vertex_buffers.size() == attribs.size(),
                   "SOA vertex layout needs equal number of vertex buffers and attributes");
-    SHOGLE_ASSERT(vertex_buffers.size() >= gl_vertex_layout::MAX_ATTRIBUTE_BINDINGS,
-                  "Vertex buffer count out ofr attribute range");
-
-    std::array<GLuint, gl_vertex_layout::MAX_ATTRIBUTE_BINDINGS> bind_map{};
-    for (const auto [buffer, location] : vertex_buffers) {
-      SHOGLE_ASSERT(location < gl_vertex_layout::MAX_ATTRIBUTE_BINDINGS,
+    SHOGLE_ASSERT(vertex_buffers.size() <= gl_vertex_layout::MAX_ATTRIBUTE_BINDINGS,
+                  "Vertex buffer count out of attribute range");
+    for (const auto& binding : vertex_buffers) {
+      SHOGLE_ASSERT(binding.location < gl_vertex_layout::MAX_ATTRIBUTE_BINDINGS,
                     "Vertex buffer binding out of range");
-      bind_map[location] = buffer;
-    }
-    for (const auto& attrib : attribs) {
-      SHOGLE_ASSERT(attrib.location < gl_vertex_layout::MAX_ATTRIBUTE_BINDINGS,
-                    "Attribute location out of range");
-      const GLuint buffer = bind_map[attrib.location];
-      if (buffer == 0) {
-        continue;
-      }
-      GL_ASSERT(glBindBuffer(GL_ARRAY_BUFFER, buffer));
-      bind_attrib_pointer(attrib.type, attrib.location, attrib.offset);
     }
   }
+
+  // Buffer sources are VAO state, forget them along with the previous VAO
+  const GLuint vao = layout.vao();
+  if (state.vao != vao) {
+    GL_ASSERT(glBindVertexArray(vao));
+    GL_FRAME_STAT(vao_binds, 1);
+    state.vao = vao;
+    state.element_buffer = GL_NULL_HANDLE;
+    state.vertex_buffers.fill({.buffer = GL_NULL_HANDLE, .offset = 0});
+  }
+
+  if (impl::gl_get_private(gl).vertex_attrib_binding) {
+    bind_vertex_buffers(gl, state, layout, vertex_buffers);
+  } else {
+    bind_vertex_pointers(gl, state, layout, vertex_buffers);
+  }
 }
 
 void upload_uniforms(gl_context& gl, span<const gl_draw_command::push_uniform> uniforms) {
   for (const auto& [data, type, location] : uniforms) {
+    GL_FRAME_STAT(uniform_uploads[static_cast<u32>(type)], 1);
     switch (type) {
       case attribute_type::f32: {
         f32 val;
@@ -748,55 +1418,96 @@ void upload_uniforms(gl_context& gl, span<const gl_draw_command::push_uniform> u
   }
 }
 
-} // namespace
-
-void gl_context::start_frame(const gl_clear_opts& clear) {
-  SHOGLE_ASSERT(_ctx, "gl_context use after free");
-  auto& gl = *this;
+constexpr auto INDEX_FORMATS = std::to_array<gldefs::GLenum>({
+  0x1400, // GL_BYTE
+  0x1401, // GL_UNSIGNED_BYTE
+  0x1402, // GL_SHORT
+  0x1403, // GL_UNSIGNED_SHORT
+  0x1404, // GL_INT
+  0x1405, // GL_UNSIGNED_INT
+});
+
+constexpr auto INDEX_SIZES = std::to_array<size_t>({
+  sizeof(i8),  // GL_BYTE
+  sizeof(u8),  // GL_UNSIGNED_BYTE
+  sizeof(i16), // GL_SHORT
+  sizeof(u16), // GL_UNSIGNED_SHORT
+  sizeof(i32), // GL_INT
+  sizeof(u32), // GL_UNSIGNED_INT
+});
+
+void bind_shader_buffer(gl_context& gl, gl_state_cache& state, GLenum type, GLuint buffer,
+                        size_t offset, size_t size, u32 location) {
+  if (location >= gl_state_cache::MAX_BUFFER_BINDINGS) {
+    GL_ASSERT(glBindBufferRange(type, location, buffer, offset, size));
+    return;
+  }
+  auto& range = type == gl_buffer::TYPE_UNIFORM ? state.uniform_buffers[location]
+                                                : state.storage_buffers[location];
+  if (range.buffer == buffer && range.offset == offset && range.size == size) {
+    return;
+  }
+  GL_ASSERT(glBindBufferRange(type, location, buffer, offset, size));
+  range.buffer = buffer;
+  range.offset = offset;
+  range.size = size;
+}
 
-  const auto clear_framebuffer = [&](GLuint fbo, const color4& color, GLbitfield clear_flags,
-                                     const rectangle_pos<u32>& viewport) {
-    GL_ASSERT(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo));
-    GL_ASSERT(glViewport(viewport.x, viewport.y, viewport.width, viewport.height));
-    GL_ASSERT(glClearColor(color.r, color.g, color.b, color.a));
-    GL_ASSERT(glClear(clear_flags));
-  };
+// Everything but uniforms and the draw call itself
+void setup_draw_state(gl_context& gl, gl_state_cache& state, const gl_draw_command& cmd,
+                      GLuint fbo) {
+  const gl_graphics_pipeline& pipeline = *cmd.pipeline;
   const auto viewport = [&]() -> rectangle_pos<u32> {
-    if (clear.viewport) {
-      return *clear.viewport;
+    if (cmd.viewport.has_value()) {
+      return *cmd.viewport;
     } else {
-      const auto [w, h] = provider().surface_extent();
+      const auto [w, h] = gl.provider().surface_extent();
       return {0, 0, w, h};
     }
   }();
-
-  clear_framebuffer(DEFAULT_FRAMEBUFFER, clear.clear_color, clear.clear_flags, viewport);
-  for (const auto& [clear_color, viewport, clear_flags, fbo] : clear.fbos) {
-    clear_framebuffer(fbo, clear_color, clear_flags, viewport);
+  const auto scissor = cmd.scissor ? *cmd.scissor : viewport;
+  setup_framebuffer(gl, state, fbo, viewport, scissor);
+  if (state.program != pipeline.program()) {
+    GL_ASSERT(glUseProgram(pipeline.program()));
+    GL_FRAME_STAT(program_binds, 1);
+    state.program = pipeline.program();
   }
-}
+  setup_render_state(gl, state, pipeline.depth_test(), pipeline.stencil_test(),
+                     pipeline.blending(), pipeline.culling(), pipeline.poly_mode(),
+                     pipeline.poly_width());
 
-void gl_context::submit_command(const gl_draw_command& cmd,
-                                ptr_view<const gl_framebuffer> target) {
-  SHOGLE_ASSERT(_ctx, "gl_context use after free");
-  auto& gl = *this;
-  const gl_graphics_pipeline& pipeline = *cmd.pipeline;
-  const auto primitive = pipeline.primitive();
-
-  const auto bind_shader_buffers = [&]() {
-    for (const auto [buffer, type, offset, size, location] : cmd.shader_bindings) {
-      GL_ASSERT(glBindBufferRange(type, location, buffer, offset, size));
+  setup_vertex_attributes(gl, state, cmd.vertex_layout, cmd.vertex_bindings);
+  for (const auto [buffer, type, size, offset, location] : cmd.shader_bindings) {
+    bind_shader_buffer(gl, state, type, buffer, offset, size, location);
+  }
+  for (const auto& [texture, type, index, sampler] : cmd.texture_bindings) {
+    SHOGLE_ASSERT(index < gl_state_cache::MAX_TEXTURE_UNITS, "Texture unit out of range");
+    auto& unit = state.textures[index];
+    // Sampler bindings take the unit index directly, no need to switch the active unit
+    if (unit.sampler != sampler) {
+      GL_ASSERT(glBindSampler(index, sampler));
+      GL_FRAME_STAT(sampler_binds, 1);
+      unit.sampler = sampler;
     }
-  };
-  const auto bind_textures = [&]() {
-    for (const auto& [texture, type, index] : cmd.texture_bindings) {
+    if (unit.texture == texture && unit.type == type) {
+      continue;
+    }
+    if (state.active_texture != index) {
       GL_ASSERT(glActiveTexture(GL_TEXTURE0 + index));
-      GL_ASSERT(glBindTexture(type, texture));
+      state.active_texture = index;
     }
-  };
+    GL_ASSERT(glBindTexture(type, texture));
+    GL_FRAME_STAT(texture_binds, 1);
+    unit.type = type;
+    unit.texture = texture;
+  }
+}
+
+void execute_draw(gl_context& gl, gl_state_cache& state, const gl_draw_command& cmd, GLuint fbo) {
+  const auto primitive = cmd.pipeline->primitive();
 
   const auto draw_arrays = [&]() {
-    GL_ASSERT(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_DEFAULT_BINDING));
+    bind_element_buffer(gl, state, GL_DEFAULT_BINDING);
     if (cmd.instances > 1) {
       GL_ASSERT(
         glDrawArraysInstanced(primitive, cmd.vertex_offset, cmd.draw_count, cmd.instances));
@@ -807,29 +1518,13 @@ void gl_context::submit_command(const gl_draw_command& cmd,
 
   const auto draw_indexed = [&]() {
     SHOGLE_ASSERT(cmd.index_bind.has_value());
-    static constexpr auto idx_formats = std::to_array<gldefs::GLenum>({
-      0x1400, // GL_BYTE
-      0x1401, // GL_UNSIGNED_BYTE
-      0x1402, // GL_SHORT
-      0x1403, // GL_UNSIGNED_SHORT
-      0x1404, // GL_INT
-      0x1405, // GL_UNSIGNED_INT
-    });
-    static constexpr auto idx_sizes = std::to_array<size_t>({
-      sizeof(i8),  // GL_BYTE
-      sizeof(u8),  // GL_UNSIGNED_BYTE
-      sizeof(i16), // GL_SHORT
-      sizeof(u16), // GL_UNSIGNED_SHORT
-      sizeof(i32), // GL_INT
-      sizeof(u32), // GL_UNSIGNED_INT
-    });
-    SHOGLE_ASSERT(cmd.index_bind->format < idx_formats.size(), "Invalid index buffer format");
+    SHOGLE_ASSERT(cmd.index_bind->format < INDEX_FORMATS.size(), "Invalid index buffer format");
     const u32 format_idx = cmd.index_bind->format;
-    GL_ASSERT(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cmd.index_bind->buffer));
+    bind_element_buffer(gl, state, cmd.index_bind->buffer);
 
     const void* idx_offset =
-      reinterpret_cast<const void*>(cmd.index_bind->index_offset * idx_sizes[format_idx]);
-    const gldefs::GLenum format = idx_formats[format_idx];
+      reinterpret_cast<const void*>(cmd.index_bind->index_offset * INDEX_SIZES[format_idx]);
+    const gldefs::GLenum format = INDEX_FORMATS[format_idx];
     if (cmd.instances > 1) {
       GL_ASSERT(glDrawElementsInstancedBaseVertex(primitive, cmd.draw_count, format, idx_offset,
                                                   cmd.instances, cmd.vertex_offset));
@@ -840,43 +1535,361 @@ void gl_context::submit_command(const gl_draw_command& cmd,
     }
   };
 
+  setup_draw_state(gl, state, cmd, fbo);
+  upload_uniforms(gl, cmd.uniforms);
+  if (cmd.index_bind.has_value()) {
+    draw_indexed();
+    GL_FRAME_STAT(indices, u64{cmd.draw_count} * std::max(cmd.instances, 1u));
+  } else {
+    draw_arrays();
+    GL_FRAME_STAT(vertices, u64{cmd.draw_count} * std::max(cmd.instances, 1u));
+  }
+  GL_FRAME_STAT(draw_calls, 1);
+  GL_FRAME_STAT(instances, std::max(cmd.instances, 1u));
+}
+
+void execute_batch(gl_context& gl, gl_state_cache& state, const gl_indirect_batch& batch,
+                   GLuint fbo) {
+  constexpr size_t command_size = sizeof(gl_indirect_command);
+  for (const auto& group : batch.groups) {
+    if (!group.command_count) {
+      continue;
+    }
+    const auto& cmd = group.state;
+    SHOGLE_ASSERT(cmd.index_bind.has_value());
+    SHOGLE_ASSERT(cmd.index_bind->format < INDEX_FORMATS.size(), "Invalid index buffer format");
+    setup_draw_state(gl, state, cmd, fbo);
+    bind_element_buffer(gl, state, cmd.index_bind->buffer);
+    if (batch.draw_data.has_value()) {
+      const auto& [buffer, stride, location] = *batch.draw_data;
+      bind_shader_buffer(gl, state, gl_buffer::TYPE_SHADER, buffer, group.first_command * stride,
+                         group.command_count * stride, location);
+    }
+
+    const void* offset = reinterpret_cast<const void*>(group.first_command * command_size);
+    GL_ASSERT(glMultiDrawElementsIndirect(cmd.pipeline->primitive(),
+                                          INDEX_FORMATS[cmd.index_bind->format], offset,
+                                          group.command_count, command_size));
+    GL_FRAME_STAT(draw_calls, 1);
+#ifndef SHOGLE_GL_DISABLE_FRAME_STATS
+    for (u32 i = 0; i < group.command_count; ++i) {
+      const auto& command = batch.commands[group.first_command + i];
+      GL_FRAME_STAT(instances, command.instance_count);
+      GL_FRAME_STAT(indices, u64{command.count} * command.instance_count);
+    }
+#endif
+  }
+}
+
+template<typename T>
+span<const T> copy_to_arena(mem::scratch_arena& arena, span<const T> data) {
+  if (data.empty()) {
+    return {};
+  }
+  T* ptr = static_cast<T*>(arena.allocate(data.size() * sizeof(T), alignof(T)));
+  std::uninitialized_copy(data.begin(), data.end(), ptr);
+  return {ptr, data.size()};
+}
+
+constexpr u64 key_bits(u64 value, u32 bits) {
+  return value & ((u64{1} << bits) - 1);
+}
+
+// Maps the float bits to an unsigned integer with the same ordering
+u64 depth_key(f32 depth) {
+  u32 bits = std::bit_cast<u32>(depth);
+  bits = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+  return static_cast<u64>(bits >> 16);
+}
+
+u64 texture_set_key(span<const gl_draw_command::texture_binding> textures) {
+  u64 hash = 0xcbf29ce484222325;
+  for (const auto& [texture, type, index, sampler] : textures) {
+    hash = (hash ^ ((static_cast<u64>(index) << 32) | texture)) * 0x100000001b3;
+    hash = (hash ^ sampler) * 0x100000001b3;
+  }
+  return hash ^ (hash >> 32);
+}
+
+u64 framebuffer_rank(gl_command_queue& queue, GLuint fbo) {
+  for (u32 i = 0; i < queue.fbo_count; ++i) {
+    if (queue.fbo_ranks[i] == fbo) {
+      return i;
+    }
+  }
+  if (queue.fbo_count == gl_command_queue::MAX_FBO_RANKS) {
+    return gl_command_queue::MAX_FBO_RANKS - 1;
+  }
+  queue.fbo_ranks[queue.fbo_count] = fbo;
+  return queue.fbo_count++;
+}
+
+// layer:4 | fbo:8 | pipeline:12 | layout:10 | textures:14 | depth:16 for state ordering, depth
+// goes right after the framebuffer for back to front. Submission order relies on the sort
+// being stable.
+u64 build_sort_key(gl_command_queue& queue, const gl_draw_command& cmd, const gl_sort_opts& sort,
+                   GLuint fbo) {
+  SHOGLE_ASSERT(sort.layer < gl_context::MAX_SORT_LAYERS, "Sort layer out of range");
+  const u64 layer = static_cast<u64>(sort.layer) << 60;
+  const auto order = queue.layers[sort.layer];
+  if (order == gl_context::LAYER_ORDER_SUBMISSION) {
+    return layer;
+  }
+
+  const u64 fbo_rank = framebuffer_rank(queue, fbo);
+  const u64 pipeline = key_bits(cmd.pipeline->program(), 12);
+  const u64 layout = key_bits(cmd.vertex_layout->vao(), 10);
+  const u64 textures = key_bits(texture_set_key(cmd.texture_bindings), 14);
+  const u64 depth = depth_key(sort.depth);
+  if (order == gl_context::LAYER_ORDER_BACK_TO_FRONT) {
+    return layer | (fbo_rank << 52) | (key_bits(~depth, 16) << 36) | (pipeline << 24) |
+           (layout << 14) | textures;
+  }
+  return layer | (fbo_rank << 52) | (pipeline << 40) | (layout << 30) | (textures << 16) | depth;
+}
+
+void record_draw(gl_private& ctx, const gl_draw_command& cmd, const gl_sort_opts& sort,
+                 GLuint fbo) {
+  using deferred_draw = gl_command_queue::deferred_draw;
+  auto& queue = ctx.queue;
+  auto& arena = ctx.arena;
+
+  if (queue.draw_count == queue.draw_capacity) {
+    const u32 capacity = std::max(queue.draw_capacity * 2u, 64u);
+    auto* draws = static_cast<deferred_draw*>(
+      arena.allocate(capacity * sizeof(deferred_draw), alignof(deferred_draw)));
+    std::uninitialized_copy_n(queue.draws, queue.draw_count, draws);
+    queue.draws = draws;
+    queue.draw_capacity = capacity;
+  }
+
+  // The command spans usually point to builder storage, copy them before the builder is reset
+  const gl_draw_command copy{
+    .vertex_layout = cmd.vertex_layout,
+    .pipeline = cmd.pipeline,
+    .vertex_bindings = copy_to_arena(arena, cmd.vertex_bindings),
+    .shader_bindings = copy_to_arena(arena, cmd.shader_bindings),
+    .texture_bindings = copy_to_arena(arena, cmd.texture_bindings),
+    .uniforms = copy_to_arena(arena, cmd.uniforms),
+    .index_bind = cmd.index_bind,
+    .viewport = cmd.viewport,
+    .scissor = cmd.scissor,
+    .vertex_offset = cmd.vertex_offset,
+    .draw_count = cmd.draw_count,
+    .instances = cmd.instances,
+  };
+  new (queue.draws + queue.draw_count) deferred_draw{
+    .cmd = copy,
+    .fbo = fbo,
+    .key = build_sort_key(queue, cmd, sort, fbo),
+  };
+  ++queue.draw_count;
+}
+
+// LSD radix sort over the 8 key bytes, skipping bytes shared by every key
+gl_command_queue::sort_entry* radix_sort(gl_command_queue::sort_entry* entries,
+                                         gl_command_queue::sort_entry* tmp, u32 count) {
+  static constexpr u32 RADIX_BITS = 8;
+  static constexpr u32 RADIX_SIZE = 1u << RADIX_BITS;
+  static constexpr u32 PASSES = sizeof(u64) * CHAR_BIT / RADIX_BITS;
+
+  for (u32 pass = 0; pass < PASSES; ++pass) {
+    const u32 shift = pass * RADIX_BITS;
+    std::array<u32, RADIX_SIZE> offsets{};
+    for (u32 i = 0; i < count; ++i) {
+      ++offsets[(entries[i].key >> shift) & (RADIX_SIZE - 1)];
+    }
+    if (offsets[(entries[0].key >> shift) & (RADIX_SIZE - 1)] == count) {
+      continue;
+    }
+
+    u32 sum = 0;
+    for (auto& offset : offsets) {
+      const u32 bucket = offset;
+      offset = sum;
+      sum += bucket;
+    }
+    for (u32 i = 0; i < count; ++i) {
+      tmp[offsets[(entries[i].key >> shift) & (RADIX_SIZE - 1)]++] = entries[i];
+    }
+    std::swap(entries, tmp);
+  }
+  return entries;
+}
+
+void flush_queue(gl_context& gl, gl_private& ctx) {
+  using sort_entry = gl_command_queue::sort_entry;
+  auto& queue = ctx.queue;
+  if (!queue.draw_count) {
+    return;
+  }
+
+  const u32 count = queue.draw_count;
+  auto* entries = ctx.arena.construct_n<sort_entry>(mem::uninitialized, count);
+  auto* tmp = ctx.arena.construct_n<sort_entry>(mem::uninitialized, count);
+  for (u32 i = 0; i < count; ++i) {
+    entries[i].key = queue.draws[i].key;
+    entries[i].index = i;
+  }
+  const auto* sorted = radix_sort(entries, tmp, count);
+  for (u32 i = 0; i < count; ++i) {
+    const auto& draw = queue.draws[sorted[i].index];
+    execute_draw(gl, ctx.state, draw.cmd, draw.fbo);
+  }
+
+  std::destroy_n(queue.draws, count);
+  queue.draw_count = 0;
+  queue.fbo_count = 0;
+}
+
+void check_submit_errors(gl_context& gl, const gl_private& ctx, std::string_view where) {
+  if (ctx.error_policy != gl_context::ERROR_POLICY_PER_SUBMIT) {
+    return;
+  }
+  const GLenum err = gl.get_error();
+  if (SHOGLE_UNLIKELY(err != GL_NO_ERROR)) {
+    SHOGLE_GL_LOG(ERROR, "Error on {}: {}", where, gl_error_string(err));
+  }
+}
+
+} // namespace
+
+void gl_context::start_frame(const gl_clear_opts& clear) {
+  SHOGLE_ASSERT(_ctx, "gl_context use after free");
+  auto& gl = *this;
+  auto& state = _ctx->state;
+  flush_queue(gl, *_ctx);
+  _ctx->queue.recording = _ctx->queue.mode == SUBMIT_DEFERRED;
+
+  const auto clear_framebuffer = [&](GLuint fbo, const color4& color, GLbitfield clear_flags,
+                                     const rectangle_pos<u32>& viewport) {
+    bind_draw_framebuffer(gl, state, fbo);
+    set_viewport(gl, state, viewport);
+    if (!state.clear_color_valid || !color_equal(state.clear_color, color)) {
+      GL_ASSERT(glClearColor(color.r, color.g, color.b, color.a));
+      state.clear_color = color;
+      state.clear_color_valid = true;
+    }
+    GL_ASSERT(glClear(clear_flags));
+  };
   const auto viewport = [&]() -> rectangle_pos<u32> {
-    if (cmd.viewport.has_value()) {
-      return *cmd.viewport;
+    if (clear.viewport) {
+      return *clear.viewport;
     } else {
       const auto [w, h] = provider().surface_extent();
       return {0, 0, w, h};
     }
   }();
-  const auto scissor = cmd.scissor ? *cmd.scissor : viewport;
-  setup_framebuffer(gl, target.empty() ? DEFAULT_FRAMEBUFFER : target->id(), viewport, scissor);
-  GL_ASSERT(glUseProgram(pipeline.program()));
-  setup_render_state(gl, pipeline.depth_test(), pipeline.stencil_test(), pipeline.blending(),
-                     pipeline.culling(), pipeline.poly_mode(), pipeline.poly_width());
-
-  setup_vertex_attributes(gl, cmd.vertex_layout, cmd.vertex_bindings);
-  bind_shader_buffers();
-  bind_textures();
-  upload_uniforms(gl, cmd.uniforms);
-  if (cmd.index_bind.has_value()) {
-    draw_indexed();
+
+  if (_ctx->profiler) {
+    _ctx->profiler->begin_frame(gl);
+  }
+  clear_framebuffer(_ctx->surf_prov.default_framebuffer(), clear.clear_color, clear.clear_flags,
+                    viewport);
+  for (const auto& [clear_color, viewport, clear_flags, fbo] : clear.fbos) {
+    clear_framebuffer(fbo, clear_color, clear_flags, viewport);
+  }
+  check_submit_errors(gl, *_ctx, "start_frame");
+}
+
+void gl_context::submit_command(const gl_draw_command& cmd,
+                                ptr_view<const gl_framebuffer> target) {
+  submit_command(cmd, gl_sort_opts{.layer = 0, .depth = 0.f}, target);
+}
+
+void gl_context::submit_command(const gl_draw_command& cmd, const gl_sort_opts& sort,
+                                ptr_view<const gl_framebuffer> target) {
+  SHOGLE_ASSERT(_ctx, "gl_context use after free");
+  const GLuint fbo = target.empty() ? _ctx->surf_prov.default_framebuffer() : target->id();
+  if (_ctx->queue.recording) {
+    record_draw(*_ctx, cmd, sort, fbo);
   } else {
-    draw_arrays();
+    execute_draw(*this, _ctx->state, cmd, fbo);
+    check_submit_errors(*this, *_ctx, "submit_command");
   }
 }
 
 void gl_context::submit_command(const gl_external_command& cmd,
                                 ptr_view<const gl_framebuffer> target) {
   SHOGLE_ASSERT(_ctx, "gl_context use after free");
-  const GLuint fbo = target.empty() ? DEFAULT_FRAMEBUFFER : target->id();
-  setup_framebuffer(*this, fbo, cmd.viewport, cmd.scissor);
-  setup_render_state(*this, cmd.depth_test, cmd.stencil_test, cmd.blending, cmd.culling,
+  auto& gl = *this;
+  auto& state = _ctx->state;
+  // External commands can depend on anything submitted before them
+  flush_queue(gl, *_ctx);
+  const GLuint fbo = target.empty() ? _ctx->surf_prov.default_framebuffer() : target->id();
+  setup_framebuffer(gl, state, fbo, cmd.viewport, cmd.scissor);
+  setup_render_state(gl, state, cmd.depth_test, cmd.stencil_test, cmd.blending, cmd.culling,
                      cmd.poly_mode, cmd.poly_width);
-  std::invoke(cmd.callback, *this, fbo);
+  GL_FRAME_STAT(external_commands, 1);
+  std::invoke(cmd.callback, gl, fbo);
+
+  // The callback can touch anything
+  state.invalidate();
+  check_submit_errors(gl, *_ctx, "external command");
+}
+
+void gl_context::submit_batch(const gl_indirect_batch& batch, gl_buffer& indirect_buffer,
+                              ptr_view<const gl_framebuffer> target) {
+  SHOGLE_ASSERT(_ctx, "gl_context use after free");
+  SHOGLE_ASSERT(indirect_buffer.type() == gl_buffer::TYPE_INDIRECT,
+                "Batch submitted with non indirect buffer");
+  const size_t size = batch.commands.size_bytes();
+  SHOGLE_ASSERT(size <= indirect_buffer.size(), "Batch commands don't fit in indirect buffer");
+  if (batch.commands.empty()) {
+    return;
+  }
+  auto& gl = *this;
+  auto& state = _ctx->state;
+  // Batches skip the deferred queue, keep them ordered with everything submitted before
+  flush_queue(gl, *_ctx);
+  const auto ret = indirect_buffer.upload_data(gl, batch.commands.data(), size, 0);
+  if (!ret) {
+    SHOGLE_GL_LOG(ERROR, "Failed to upload indirect commands: {}", ret.error().code_str());
+    return;
+  }
+
+  const GLuint fbo = target.empty() ? _ctx->surf_prov.default_framebuffer() : target->id();
+  bind_indirect_buffer(gl, state, indirect_buffer.id());
+  execute_batch(gl, state, batch, fbo);
+  check_submit_errors(gl, *_ctx, "submit_batch");
+}
+
+void gl_context::invalidate_state() {
+  SHOGLE_ASSERT(_ctx, "gl_context use after free");
+  _ctx->state.invalidate();
 }
 
 void gl_context::end_frame() {
-  // No-op
+  SHOGLE_ASSERT(_ctx, "gl_context use after free");
+  flush_queue(*this, *_ctx);
+  if (_ctx->profiler) {
+    _ctx->profiler->end_frame(*this);
+  }
+  check_submit_errors(*this, *_ctx, "end_frame");
+#ifndef SHOGLE_GL_DISABLE_FRAME_STATS
+  _ctx->last_frame_stats = _ctx->frame_stats;
+  _ctx->frame_stats = {};
+#endif
+  _ctx->queue.recording = false;
+  _ctx->queue.reset();
+  _ctx->arena.clear();
+}
+
+void gl_context::set_submit_mode(submit_mode mode) {
+  SHOGLE_ASSERT(_ctx, "gl_context use after free");
+  SHOGLE_ASSERT(!_ctx->queue.recording, "Can't change submit mode mid frame");
+  _ctx->queue.mode = mode;
+}
+
+void gl_context::set_layer_order(u32 layer, layer_order order) {
+  SHOGLE_ASSERT(_ctx, "gl_context use after free");
+  SHOGLE_ASSERT(layer < MAX_SORT_LAYERS, "Sort layer out of range");
+  _ctx->queue.layers[layer] = order;
+}
+
+void gl_context::set_profiler(ptr_view<gl_gpu_profiler> profiler) {
+  SHOGLE_ASSERT(_ctx, "gl_context use after free");
+  _ctx->profiler = profiler.data();
 }
 
 void gl_context::destroy() noexcept {
@@ -5,6 +5,12 @@
 #include <shogle/util/memory.hpp>
 
 #include <shogle/render/gl/common.hpp>
+#include <shogle/render/gl/context.hpp>
+#include <shogle/render/gl/pipeline.hpp>
+#include <shogle/render/gl/texture.hpp>
+#include <shogle/render/gl/vertex.hpp>
+
+#include <utility>
 
 #if defined(SHOGLE_USE_SYSTEM_GL) && SHOGLE_USE_SYSTEM_GL
 #define GL_CALL(func) (func)
@@ -12,34 +18,174 @@
 #define GL_CALL(func) ::shogle::impl::gl_get_private(gl).funcs.func
 #endif
 
-#define GL_ASSERT(func)                                                 \
-  do {                                                                  \
-    GL_CALL(func);                                                      \
-    const GLenum glerr = gl.get_error();                                \
-    SHOGLE_ASSERT(glerr == 0, ::shogle::gl_error_string(glerr).data()); \
+#define GL_ASSERT(func)                                                   \
+  do {                                                                    \
+    GL_CALL(func);                                                        \
+    if (::shogle::gl_check_calls(gl)) {                                   \
+      const GLenum glerr = gl.get_error();                                \
+      SHOGLE_ASSERT(glerr == 0, ::shogle::gl_error_string(glerr).data()); \
+    }                                                                     \
   } while (0)
 
-#define GL_ASSERT_RET(func)                                             \
-  [&]() {                                                               \
-    const auto ret = GL_CALL(func);                                     \
-    const GLenum glerr = gl.get_error();                                \
-    SHOGLE_ASSERT(glerr == 0, ::shogle::gl_error_string(glerr).data()); \
-    return ret;                                                         \
+#define GL_ASSERT_RET(func)                                               \
+  [&]() {                                                                 \
+    const auto ret = GL_CALL(func);                                       \
+    if (::shogle::gl_check_calls(gl)) {                                   \
+      const GLenum glerr = gl.get_error();                                \
+      SHOGLE_ASSERT(glerr == 0, ::shogle::gl_error_string(glerr).data()); \
+    }                                                                     \
+    return ret;                                                           \
   }();
 
-#define GL_RET_ERR(func)                 \
-  [&]() {                                \
-    GL_CALL(func);                       \
-    const GLenum glerr = gl.get_error(); \
-    return glerr;                        \
+#define GL_RET_ERR(func)                \
+  [&]() {                               \
+    GL_CALL(func);                      \
+    return ::shogle::gl_call_error(gl); \
   }()
 
+#ifdef SHOGLE_GL_DISABLE_FRAME_STATS
+#define GL_FRAME_STAT(stat, count) SHOGLE_NOOP
+#else
+#define GL_FRAME_STAT(stat, count) \
+  (::shogle::impl::gl_get_private(gl).frame_stats.stat += (count))
+#endif
+
 namespace shogle {
 
+// Shadow copy of the driver state touched by the context, used to skip redundant state changes.
+// Any binding that holds GL_NULL_HANDLE is unknown and will always be re-applied.
+struct gl_state_cache {
+public:
+  static constexpr u32 MAX_TEXTURE_UNITS = 32;
+  static constexpr u32 MAX_BUFFER_BINDINGS = 16;
+
+  struct texture_unit {
+    GLenum type;
+    GLuint texture;
+    GLuint sampler;
+  };
+
+  struct buffer_range {
+    GLuint buffer;
+    size_t offset;
+    size_t size;
+  };
+
+  struct vertex_buffer {
+    GLuint buffer;
+    size_t offset;
+  };
+
+  template<typename Props>
+  struct cached_props {
+    Props props;
+    bool enable_valid;
+    bool params_valid;
+  };
+
+public:
+  gl_state_cache() noexcept { invalidate(); }
+
+public:
+  void invalidate() noexcept;
+
+  // Called after binding something outside of the cache's knowledge
+  void forget_bound_buffer(GLenum target) noexcept;
+  void forget_bound_texture() noexcept;
+  void forget_bound_framebuffer() noexcept;
+
+  // Called on deletion, GL names can be recycled
+  void forget_buffer(GLuint buffer) noexcept;
+  void forget_texture(GLuint texture) noexcept;
+  void forget_vertex_array(GLuint vao) noexcept;
+  void forget_framebuffer(GLuint fbo) noexcept;
+  void forget_program(GLuint program) noexcept;
+  void forget_sampler(GLuint sampler) noexcept;
+
+public:
+  GLuint program;
+  GLuint draw_fbo;
+  GLuint vao;
+  GLuint array_buffer;
+  GLuint element_buffer;
+  GLuint indirect_buffer;
+  // Sources of the bound VAO, by binding index or by attribute location without vertex formats
+  std::array<vertex_buffer, gl_vertex_layout::MAX_ATTRIBUTE_BINDINGS> vertex_buffers;
+
+  GLuint active_texture;
+  std::array<texture_unit, MAX_TEXTURE_UNITS> textures;
+  std::array<buffer_range, MAX_BUFFER_BINDINGS> uniform_buffers;
+  std::array<buffer_range, MAX_BUFFER_BINDINGS> storage_buffers;
+
+  rectangle_pos<u32> viewport;
+  rectangle_pos<u32> scissor;
+  color4 clear_color;
+  bool viewport_valid;
+  bool scissor_valid;
+  bool scissor_test_valid;
+  bool clear_color_valid;
+
+  GLenum poly_mode;
+  f32 line_width;
+  f32 point_size;
+  cached_props<gl_depth_test_props> depth;
+  cached_props<gl_stencil_test_props> stencil;
+  cached_props<gl_blending_props> blending;
+  cached_props<gl_culling_props> culling;
+};
+
+// Draws recorded in deferred mode, lives in the context arena until end_frame
+struct gl_command_queue {
+public:
+  // Framebuffers get ranked by first use, so passes keep their relative order
+  static constexpr u32 MAX_FBO_RANKS = 256;
+
+  struct deferred_draw {
+    gl_draw_command cmd;
+    GLuint fbo;
+    u64 key;
+  };
+
+  struct sort_entry {
+    u64 key;
+    u32 index;
+  };
+
+public:
+  gl_command_queue() noexcept :
+      draws(nullptr), draw_count(0), draw_capacity(0), fbo_ranks(), fbo_count(0),
+      mode(gl_context::SUBMIT_IMMEDIATE), recording(false), layers() {
+    layers.fill(gl_context::LAYER_ORDER_STATE);
+  }
+
+public:
+  void reset() noexcept {
+    draws = nullptr;
+    draw_count = 0;
+    draw_capacity = 0;
+    fbo_count = 0;
+  }
+
+public:
+  deferred_draw* draws;
+  u32 draw_count;
+  u32 draw_capacity;
+  std::array<GLuint, MAX_FBO_RANKS> fbo_ranks;
+  u32 fbo_count;
+  gl_context::submit_mode mode;
+  bool recording;
+  std::array<gl_context::layer_order, gl_context::MAX_SORT_LAYERS> layers;
+};
+
 class gl_private {
 public:
-  gl_private(mem::scratch_arena&& arena_, const gl_surface_provider& surf_prov_) noexcept :
-      arena(std::move(arena_)), surf_prov(surf_prov_) {}
+  gl_private(mem::scratch_arena&& arena_, const gl_surface_provider& surf_prov_,
+             gl_context::error_check_policy error_policy_) noexcept :
+      arena(std::move(arena_)), surf_prov(surf_prov_), state(), queue(),
+      error_policy(error_policy_), debug_error(GL_NO_ERROR), frame_stats(), last_frame_stats(),
+      profiler(nullptr), max_anisotropy(0.f),
+      parallel_shader_compile(false), direct_state_access(false), vertex_attrib_binding(false),
+      bindless_texture(false) {}
 
 public:
   mem::scratch_arena arena;
@@ -51,6 +197,44 @@ public:
   shogle_gl_functions funcs;
 #endif
   gl_surface_provider surf_prov;
+  gl_state_cache state;
+  gl_command_queue queue;
+  gl_context::error_check_policy error_policy;
+  GLenum debug_error; // Last error reported to the debug callback
+  gl_frame_stats frame_stats;
+  gl_frame_stats last_frame_stats;
+  gl_gpu_profiler* profiler;
+  f32 max_anisotropy; // Zero without anisotropic filtering support
+  bool parallel_shader_compile; // GL_KHR_parallel_shader_compile
+  bool direct_state_access;     // GL 4.5 or GL_ARB_direct_state_access, objects edited by name
+  bool vertex_attrib_binding;   // GL 4.3 or GL_ARB_vertex_attrib_binding, formats set once
+  bool bindless_texture;        // GL_ARB_bindless_texture
 };
 
+inline gl_state_cache& gl_get_state(gl_context& gl) {
+  return ::shogle::impl::gl_get_private(gl).state;
+}
+
+// Size of the pixel data in an image, rows are padded to the given alignment
+size_t gl_image_size(const extent3d& extent, gl_texture::pixel_format format,
+                     gl_texture::pixel_data_type datatype, gl_texture::pixel_alignment alignment);
+
+// Component type of a vertex attribute, matrices are made of float columns
+GLenum gl_attribute_type(attribute_type type);
+
+// Assert only checks, skipped unless checking every call
+inline bool gl_check_calls(gl_context& gl) {
+  return ::shogle::impl::gl_get_private(gl).error_policy == gl_context::ERROR_POLICY_PER_CALL;
+}
+
+// Checks for calls that hand their error back to the caller
+inline GLenum gl_call_error(gl_context& gl) {
+  auto& ctx = ::shogle::impl::gl_get_private(gl);
+  if (ctx.error_policy == gl_context::ERROR_POLICY_DEBUG_CALLBACK) {
+    // Debug output is synchronous, the callback already ran for the offending call
+    return std::exchange(ctx.debug_error, GL_NO_ERROR);
+  }
+  return gl.get_error();
+}
+
 } // namespace shogle
@@ -8,11 +8,16 @@ namespace shogle {
 gl_sv_expect<gl_renderbuffer> gl_renderbuffer::create(gl_context& gl, buffer_format format,
                                                       extent2d extent) {
   GLuint rbo;
-  GL_ASSERT(glGenRenderbuffers(1, &rbo));
-  GL_ASSERT(glBindRenderbuffer(GL_RENDERBUFFER, rbo));
-  const auto err =
-    GL_RET_ERR(glRenderbufferStorage(GL_RENDERBUFFER, format, extent.width, extent.height));
-  GL_ASSERT(glBindRenderbuffer(GL_RENDERBUFFER, GL_DEFAULT_BINDING));
+  GLenum err;
+  if (impl::gl_get_private(gl).direct_state_access) {
+    GL_ASSERT(glCreateRenderbuffers(1, &rbo));
+    err = GL_RET_ERR(glNamedRenderbufferStorage(rbo, format, extent.width, extent.height));
+  } else {
+    GL_ASSERT(glGenRenderbuffers(1, &rbo));
+    GL_ASSERT(glBindRenderbuffer(GL_RENDERBUFFER, rbo));
+    err = GL_RET_ERR(glRenderbufferStorage(GL_RENDERBUFFER, format, extent.width, extent.height));
+    GL_ASSERT(glBindRenderbuffer(GL_RENDERBUFFER, GL_DEFAULT_BINDING));
+  }
   if (err) {
     GL_ASSERT(glDeleteRenderbuffers(1, &rbo));
     return {unexpect, "Failed to create renderbuffer", err};
@@ -72,40 +77,139 @@ bool gl_renderbuffer::invalidated() const noexcept {
 
 namespace {
 
-u32 attach_colors(gl_context& gl, [[maybe_unused]] extent2d extent,
-                  span<const gl_framebuffer::texture_attachment> attachments) {
-  u32 attachment_count = 0;
-  for (const auto& [texture, level, layer] : attachments) {
-    const gl_texture& tex = texture.get();
-    const auto [twidth, theight, _] = tex.extent();
-    const auto type = tex.type();
-    GL_ASSERT(glBindTexture(type, tex.id()));
+// Lowest GL_MAX_DRAW_BUFFERS any implementation reports
+constexpr u32 MAX_DRAW_BUFFERS = 8;
+
+// Legacy framebuffers stay bound to GL_FRAMEBUFFER from creation until they are complete, named
+// ones are never bound
+GLuint create_framebuffer(gl_context& gl) {
+  GLuint fbo;
+  if (impl::gl_get_private(gl).direct_state_access) {
+    GL_ASSERT(glCreateFramebuffers(1, &fbo));
+  } else {
+    GL_ASSERT(glGenFramebuffers(1, &fbo));
+    GL_ASSERT(glBindFramebuffer(GL_FRAMEBUFFER, fbo));
+  }
+  return fbo;
+}
+
+void discard_framebuffer(gl_context& gl, GLuint fbo) {
+  if (!impl::gl_get_private(gl).direct_state_access) {
+    GL_ASSERT(glBindFramebuffer(GL_FRAMEBUFFER, GL_DEFAULT_BINDING));
+    gl_get_state(gl).forget_bound_framebuffer();
+  }
+  GL_ASSERT(glDeleteFramebuffers(1, &fbo));
+}
+
+GLenum check_framebuffer(gl_context& gl, GLuint fbo) {
+  if (impl::gl_get_private(gl).direct_state_access) {
+    return GL_CALL(glCheckNamedFramebufferStatus(fbo, GL_FRAMEBUFFER));
+  }
+  const GLenum status = GL_CALL(glCheckFramebufferStatus(GL_FRAMEBUFFER));
+  GL_ASSERT(glBindFramebuffer(GL_FRAMEBUFFER, GL_DEFAULT_BINDING));
+  gl_get_state(gl).forget_bound_framebuffer();
+  return status;
+}
+
+GLenum attach_renderbuffer(gl_context& gl, GLuint fbo, gldefs::GLenum attachment,
+                           const gl_renderbuffer& rbo) {
+  if (impl::gl_get_private(gl).direct_state_access) {
+    return GL_RET_ERR(
+      glNamedFramebufferRenderbuffer(fbo, attachment, GL_RENDERBUFFER, rbo.id()));
+  }
+  GL_ASSERT(glBindRenderbuffer(GL_RENDERBUFFER, rbo.id()));
+  const auto err =
+    GL_RET_ERR(glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment, GL_RENDERBUFFER, rbo.id()));
+  GL_ASSERT(glBindRenderbuffer(GL_RENDERBUFFER, GL_DEFAULT_BINDING));
+  return err;
+}
+
+GLenum attach_texture(gl_context& gl, GLuint fbo, const gl_framebuffer::texture_attachment& att,
+                      gldefs::GLenum attachment) {
+  const gl_texture& tex = att.tex.get();
+  const auto type = tex.type();
+  if (impl::gl_get_private(gl).direct_state_access) {
     switch (type) {
-      case GL_TEXTURE_1D: {
-        SHOGLE_ASSERT(twidth == extent.width, "Color texture width mismatch");
-        GL_ASSERT(glFramebufferTexture1D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + attachment_count,
-                                         GL_TEXTURE_1D, tex.id(), level));
+      case gl_texture::TEX_TYPE_1D:
+        [[fallthrough]];
+      case gl_texture::TEX_TYPE_2D: {
+        return GL_RET_ERR(glNamedFramebufferTexture(fbo, attachment, tex.id(), att.level));
       } break;
-      case GL_TEXTURE_2D: {
+      case gl_texture::TEX_TYPE_CUBEMAP:
+        [[fallthrough]];
+      case gl_texture::TEX_TYPE_3D: {
+        return GL_RET_ERR(
+          glNamedFramebufferTextureLayer(fbo, attachment, tex.id(), att.level, att.layer));
+      } break;
+      default: {
+        return GL_INVALID_VALUE;
+      } break;
+    }
+  }
+
+  GLenum err = GL_INVALID_VALUE;
+  GL_ASSERT(glBindTexture(type, tex.id()));
+  switch (type) {
+    case gl_texture::TEX_TYPE_1D: {
+      err = GL_RET_ERR(
+        glFramebufferTexture1D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_1D, tex.id(), att.level));
+    } break;
+    case gl_texture::TEX_TYPE_2D: {
+      err = GL_RET_ERR(
+        glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, tex.id(), att.level));
+    } break;
+    case gl_texture::TEX_TYPE_CUBEMAP:
+      [[fallthrough]];
+    case gl_texture::TEX_TYPE_3D: {
+      err = GL_RET_ERR(glFramebufferTexture3D(GL_FRAMEBUFFER, attachment, type, tex.id(),
+                                              att.level, att.layer));
+    } break;
+    default:
+      break;
+  }
+  GL_ASSERT(glBindTexture(type, GL_DEFAULT_BINDING));
+  gl_get_state(gl).forget_bound_texture();
+  return err;
+}
+
+u32 attach_colors(gl_context& gl, GLuint fbo, [[maybe_unused]] extent2d extent,
+                  span<const gl_framebuffer::texture_attachment> attachments) {
+  u32 attachment_count = 0;
+  for (const auto& attachment : attachments) {
+    const auto [twidth, theight, _] = attachment.tex->extent();
+    switch (attachment.tex->type()) {
+      case gl_texture::TEX_TYPE_1D: {
         SHOGLE_ASSERT(twidth == extent.width, "Color texture width mismatch");
-        SHOGLE_ASSERT(theight == extent.height, "Color texture height mismatch");
-        GL_ASSERT(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + attachment_count,
-                                         GL_TEXTURE_2D, tex.id(), level));
       } break;
-      case GL_TEXTURE_CUBE_MAP:
+      case gl_texture::TEX_TYPE_2D:
+        [[fallthrough]];
+      case gl_texture::TEX_TYPE_CUBEMAP:
         [[fallthrough]];
-      case GL_TEXTURE_3D: {
+      case gl_texture::TEX_TYPE_3D: {
         SHOGLE_ASSERT(twidth == extent.width, "Color texture width mismatch");
         SHOGLE_ASSERT(theight == extent.height, "Color texture height mismatch");
-        GL_ASSERT(glFramebufferTexture3D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + attachment_count,
-                                         type, tex.id(), level, layer));
       } break;
       default:
         continue;
     }
-    GL_ASSERT(glBindTexture(type, GL_DEFAULT_BINDING));
+    attach_texture(gl, fbo, attachment, GL_COLOR_ATTACHMENT0 + attachment_count);
     ++attachment_count;
   }
+
+  // Framebuffers only draw to the first attachment until told otherwise
+  if (attachment_count > 1) {
+    SHOGLE_ASSERT(attachment_count <= MAX_DRAW_BUFFERS, "Too many color attachments");
+    std::array<GLenum, MAX_DRAW_BUFFERS> buffers;
+    for (u32 i = 0; i < attachment_count; ++i) {
+      buffers[i] = GL_COLOR_ATTACHMENT0 + i;
+    }
+    if (impl::gl_get_private(gl).direct_state_access) {
+      GL_ASSERT(glNamedFramebufferDrawBuffers(fbo, attachment_count, buffers.data()));
+    } else {
+      // Still bound from create_framebuffer
+      GL_ASSERT(glDrawBuffers(attachment_count, buffers.data()));
+    }
+  }
   return attachment_count;
 }
 
@@ -131,27 +235,28 @@ gldefs::GLenum find_rbo_attachment(gl_renderbuffer::buffer_format format) {
   SHOGLE_UNREACHABLE();
 }
 
-GLenum attach_tex_buffer(gl_context& gl, const gl_framebuffer::texture_attachment& buffer,
-                         extent2d extent, gldefs::GLenum attachment) {
-  switch (buffer.tex->type()) {
-    case gl_texture::TEX_TYPE_1D: {
-      return GL_RET_ERR(glFramebufferTexture1D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_1D,
-                                               buffer.tex->id(), buffer.level));
-    } break;
-    case gl_texture::TEX_TYPE_2D: {
-      return GL_RET_ERR(glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D,
-                                               buffer.tex->id(), buffer.level));
-    } break;
-    case gl_texture::TEX_TYPE_CUBEMAP:
+gldefs::GLenum find_texture_attachment(gl_texture::texture_format format) {
+  switch (format) {
+    case gl_texture::TEX_FORMAT_DEPTH_STENCIL:
       [[fallthrough]];
-    case gl_texture::TEX_TYPE_3D: {
-      return GL_RET_ERR(glFramebufferTexture3D(GL_FRAMEBUFFER, attachment, buffer.tex->type(),
-                                               buffer.tex->id(), buffer.level, buffer.layer));
-    } break;
-    default: {
-      return GL_INVALID_VALUE;
-    } break;
-  }
+    case gl_texture::TEX_FORMAT_D24_S8:
+      [[fallthrough]];
+    case gl_texture::TEX_FORMAT_D32F_S8:
+      return GL_DEPTH_STENCIL_ATTACHMENT;
+    case gl_texture::TEX_FORMAT_DEPTH_COMPONENT:
+      [[fallthrough]];
+    case gl_texture::TEX_FORMAT_D16:
+      [[fallthrough]];
+    case gl_texture::TEX_FORMAT_D24:
+      [[fallthrough]];
+    case gl_texture::TEX_FORMAT_D32:
+      [[fallthrough]];
+    case gl_texture::TEX_FORMAT_D32F:
+      return GL_DEPTH_ATTACHMENT;
+    default:
+      return 0;
+  };
+  SHOGLE_UNREACHABLE();
 }
 
 } // namespace
@@ -163,23 +268,15 @@ gl_sv_expect<gl_framebuffer> gl_framebuffer::with_textures(gl_context& gl, exten
   if (!attachment) {
     return {unexpect, "Invalid renderbuffer attachment format"};
   }
-  GLuint fbo;
-  GL_ASSERT(glGenFramebuffers(1, &fbo));
-  GL_ASSERT(glBindFramebuffer(GL_FRAMEBUFFER, fbo));
-
-  GL_ASSERT(glBindRenderbuffer(GL_RENDERBUFFER, buffer.id()));
-  auto err = GL_RET_ERR(
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment, GL_RENDERBUFFER, buffer.id()));
-  GL_ASSERT(glBindRenderbuffer(GL_RENDERBUFFER, GL_DEFAULT_BINDING));
+  GLuint fbo = create_framebuffer(gl);
+  auto err = attach_renderbuffer(gl, fbo, attachment, buffer);
   if (err) {
-    GL_ASSERT(glBindFramebuffer(GL_FRAMEBUFFER, GL_DEFAULT_BINDING));
-    GL_ASSERT(glDeleteFramebuffers(1, &fbo));
+    discard_framebuffer(gl, fbo);
     return {unexpect, "Failed to bind renderbuffer", err};
   }
 
-  attach_colors(gl, extent, color);
-  err = GL_CALL(glCheckFramebufferStatus(GL_FRAMEBUFFER));
-  GL_ASSERT(glBindFramebuffer(GL_FRAMEBUFFER, GL_DEFAULT_BINDING));
+  attach_colors(gl, fbo, extent, color);
+  err = check_framebuffer(gl, fbo);
   if (err != GL_FRAMEBUFFER_COMPLETE) {
     GL_ASSERT(glDeleteFramebuffers(1, &fbo));
     return {unexpect, "Incomplete framebuffer", err};
@@ -195,30 +292,19 @@ gl_sv_expect<gl_framebuffer> gl_framebuffer::with_textures(gl_context& gl, exten
 gl_sv_expect<gl_framebuffer> gl_framebuffer::with_textures(gl_context& gl, extent2d extent,
                                                            span<const texture_attachment> color,
                                                            const texture_attachment& buffer) {
-  const auto format = buffer.tex->format();
-  if (format != gl_texture::TEX_FORMAT_DEPTH_STENCIL || gl_texture::TEX_FORMAT_DEPTH_COMPONENT) {
+  const auto attachment = find_texture_attachment(buffer.tex->format());
+  if (!attachment) {
     return {unexpect, "Invalid buffer texture attachment format"};
   }
-  GLuint fbo;
-  GL_ASSERT(glGenFramebuffers(1, &fbo));
-  GL_ASSERT(glBindFramebuffer(GL_FRAMEBUFFER, fbo));
-
-  const auto attachment = format == gl_texture::TEX_FORMAT_DEPTH_STENCIL
-                          ? GL_DEPTH_STENCIL_ATTACHMENT
-                          : GL_DEPTH_ATTACHMENT;
-  const auto [twidth, theight, _] = buffer.tex->extent();
-  const auto type = buffer.tex->type();
-  GL_ASSERT(glBindTexture(type, buffer.tex->id()));
-  GLenum err = attach_tex_buffer(gl, buffer, extent, attachment);
+  GLuint fbo = create_framebuffer(gl);
+  GLenum err = attach_texture(gl, fbo, buffer, attachment);
   if (err) {
-    GL_ASSERT(glBindFramebuffer(GL_FRAMEBUFFER, GL_DEFAULT_BINDING));
-    GL_ASSERT(glDeleteFramebuffers(1, &fbo));
+    discard_framebuffer(gl, fbo);
     return {unexpect, "Failed to bind texture buffer", err};
   }
 
-  attach_colors(gl, extent, color);
-  err = GL_CALL(glCheckFramebufferStatus(GL_FRAMEBUFFER));
-  GL_ASSERT(glBindFramebuffer(GL_FRAMEBUFFER, GL_DEFAULT_BINDING));
+  attach_colors(gl, fbo, extent, color);
+  err = check_framebuffer(gl, fbo);
   if (err != GL_FRAMEBUFFER_COMPLETE) {
     GL_ASSERT(glDeleteFramebuffers(1, &fbo));
     return {unexpect, "Incomplete framebuffer", err};
@@ -231,6 +317,25 @@ gl_sv_expect<gl_framebuffer> gl_framebuffer::with_textures(gl_context& gl, exten
   return {in_place, create_t{}, fbo, extent};
 }
 
+gl_sv_expect<gl_framebuffer> gl_framebuffer::with_textures(gl_context& gl, extent2d extent,
+                                                           span<const texture_attachment> color) {
+  if (color.empty()) {
+    return {unexpect, "No color attachments"};
+  }
+  GLuint fbo = create_framebuffer(gl);
+  attach_colors(gl, fbo, extent, color);
+  const GLenum err = check_framebuffer(gl, fbo);
+  if (err != GL_FRAMEBUFFER_COMPLETE) {
+    GL_ASSERT(glDeleteFramebuffers(1, &fbo));
+    return {unexpect, "Incomplete framebuffer", err};
+  }
+
+  SHOGLE_GL_LOG(VERBOSE, "FRAMEBUFFER_CREATE ({}) [ext: {}x{}, col_att: {} (tex)]", fbo,
+                extent.width, extent.height, color.size());
+
+  return {in_place, create_t{}, fbo, extent};
+}
+
 gl_sv_expect<gl_framebuffer> gl_framebuffer::with_renderbuffer(gl_context& gl, extent2d extent,
                                                                const gl_renderbuffer& color,
                                                                const gl_renderbuffer& buffer) {
@@ -242,31 +347,20 @@ gl_sv_expect<gl_framebuffer> gl_framebuffer::with_renderbuffer(gl_context& gl, e
       color.format() != gl_renderbuffer::FORMAT_RGB10_A2UI) {
     return {unexpect, "Invalid color attachment format"};
   }
-  GLuint fbo;
-  GL_ASSERT(glGenFramebuffers(1, &fbo));
-  GL_ASSERT(glBindFramebuffer(GL_FRAMEBUFFER, fbo));
-
-  GL_ASSERT(glBindRenderbuffer(GL_RENDERBUFFER, buffer.id()));
-  auto err = GL_RET_ERR(
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment, GL_RENDERBUFFER, buffer.id()));
+  GLuint fbo = create_framebuffer(gl);
+  auto err = attach_renderbuffer(gl, fbo, attachment, buffer);
   if (err) {
-    GL_ASSERT(glBindFramebuffer(GL_FRAMEBUFFER, GL_DEFAULT_BINDING));
-    GL_ASSERT(glDeleteFramebuffers(1, &fbo));
+    discard_framebuffer(gl, fbo);
     return {unexpect, "Failed to bind buffer renderbuffer", err};
   }
 
-  GL_ASSERT(glBindRenderbuffer(GL_RENDERBUFFER, color.id()));
-  err = GL_RET_ERR(
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color.id()));
-  GL_ASSERT(glBindRenderbuffer(GL_RENDERBUFFER, GL_DEFAULT_BINDING));
+  err = attach_renderbuffer(gl, fbo, GL_COLOR_ATTACHMENT0, color);
   if (err) {
-    GL_ASSERT(glBindFramebuffer(GL_FRAMEBUFFER, GL_DEFAULT_BINDING));
-    GL_ASSERT(glDeleteFramebuffers(1, &fbo));
+    discard_framebuffer(gl, fbo);
     return {unexpect, "Failed to bind buffer renderbuffer", err};
   }
 
-  err = GL_CALL(glCheckFramebufferStatus(GL_FRAMEBUFFER));
-  GL_ASSERT(glBindFramebuffer(GL_FRAMEBUFFER, GL_DEFAULT_BINDING));
+  err = check_framebuffer(gl, fbo);
   if (err != GL_FRAMEBUFFER_COMPLETE) {
     GL_ASSERT(glDeleteFramebuffers(1, &fbo));
     return {unexpect, "Incomplete framebuffer", err};
@@ -281,8 +375,8 @@ gl_sv_expect<gl_framebuffer> gl_framebuffer::with_renderbuffer(gl_context& gl, e
 gl_sv_expect<gl_framebuffer> gl_framebuffer::with_renderbuffer(gl_context& gl, extent2d extent,
                                                                const gl_renderbuffer& color,
                                                                const texture_attachment& buffer) {
-  const auto format = buffer.tex->format();
-  if (format != gl_texture::TEX_FORMAT_DEPTH_STENCIL || gl_texture::TEX_FORMAT_DEPTH_COMPONENT) {
+  const auto attachment = find_texture_attachment(buffer.tex->format());
+  if (!attachment) {
     return {unexpect, "Invalid buffer texture attachment format"};
   }
   if (color.format() != gl_renderbuffer::FORMAT_SRGB8_A8 ||
@@ -290,38 +384,20 @@ gl_sv_expect<gl_framebuffer> gl_framebuffer::with_renderbuffer(gl_context& gl, e
     return {unexpect, "Invalid color attachment format"};
   }
 
-  GLuint fbo;
-  GL_ASSERT(glGenFramebuffers(1, &fbo));
-  GL_ASSERT(glBindFramebuffer(GL_FRAMEBUFFER, fbo));
-
-  const u32 level = buffer.level;
-  const u32 layer = buffer.layer;
-  const auto attachment = format == gl_texture::TEX_FORMAT_DEPTH_STENCIL
-                          ? GL_DEPTH_STENCIL_ATTACHMENT
-                          : GL_DEPTH_ATTACHMENT;
-  const auto [twidth, theight, _] = buffer.tex->extent();
-  const auto type = buffer.tex->type();
-  GL_ASSERT(glBindTexture(type, buffer.tex->id()));
-  GLenum err = attach_tex_buffer(gl, buffer, extent, attachment);
-  GL_ASSERT(glBindTexture(type, GL_DEFAULT_BINDING));
+  GLuint fbo = create_framebuffer(gl);
+  GLenum err = attach_texture(gl, fbo, buffer, attachment);
   if (err) {
-    GL_ASSERT(glBindFramebuffer(GL_FRAMEBUFFER, GL_DEFAULT_BINDING));
-    GL_ASSERT(glDeleteFramebuffers(1, &fbo));
+    discard_framebuffer(gl, fbo);
     return {unexpect, "Failed to bind texture buffer", err};
   }
 
-  GL_ASSERT(glBindRenderbuffer(GL_RENDERBUFFER, color.id()));
-  err = GL_RET_ERR(
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color.id()));
-  GL_ASSERT(glBindRenderbuffer(GL_RENDERBUFFER, GL_DEFAULT_BINDING));
+  err = attach_renderbuffer(gl, fbo, GL_COLOR_ATTACHMENT0, color);
   if (err) {
-    GL_ASSERT(glBindFramebuffer(GL_FRAMEBUFFER, GL_DEFAULT_BINDING));
-    GL_ASSERT(glDeleteFramebuffers(1, &fbo));
+    discard_framebuffer(gl, fbo);
     return {unexpect, "Failed to bind buffer renderbuffer", err};
   }
 
-  err = GL_CALL(glCheckFramebufferStatus(GL_FRAMEBUFFER));
-  GL_ASSERT(glBindFramebuffer(GL_FRAMEBUFFER, GL_DEFAULT_BINDING));
+  err = check_framebuffer(gl, fbo);
   if (err != GL_FRAMEBUFFER_COMPLETE) {
     GL_ASSERT(glDeleteFramebuffers(1, &fbo));
     return {unexpect, "Incomplete framebuffer", err};
@@ -347,6 +423,10 @@ gl_framebuffer::gl_framebuffer(gl_context& gl, extent2d extent,
                                const texture_attachment& buffer) :
     gl_framebuffer(::shogle::gl_framebuffer::with_textures(gl, extent, color, buffer).value()) {}
 
+gl_framebuffer::gl_framebuffer(gl_context& gl, extent2d extent,
+                               span<const texture_attachment> color) :
+    gl_framebuffer(::shogle::gl_framebuffer::with_textures(gl, extent, color).value()) {}
+
 gl_framebuffer::gl_framebuffer(gl_context& gl, extent2d extent, const gl_renderbuffer& color,
                                const gl_renderbuffer& buffer) :
     gl_framebuffer(
@@ -362,6 +442,7 @@ void gl_framebuffer::destroy(gl_context& gl, gl_framebuffer& fbo) noexcept {
     return;
   }
   GL_CALL(glDeleteFramebuffers(1, &fbo._id));
+  gl_get_state(gl).forget_framebuffer(fbo._id);
   fbo._id = GL_NULL_HANDLE;
 }
 
@@ -374,6 +455,7 @@ void gl_framebuffer::destroy_n(gl_context& gl, gl_framebuffer* fbos, size_t coun
       continue;
     }
     GL_CALL(glDeleteFramebuffers(1, &fbos[i]._id));
+    gl_get_state(gl).forget_framebuffer(fbos[i]._id);
     fbos[i]._id = GL_NULL_HANDLE;
   }
 }
@@ -389,12 +471,22 @@ gl_expect<void> gl_framebuffer::blit(gl_context& gl, gldefs::GLhandle src_fbo,
                                      gl_framebuffer::buffer_filter filter) {
   const auto [src_x, src_y, src_w, src_h] = src_area;
   const auto [dst_x, dst_y, dst_w, dst_h] = dest_area;
+  if (impl::gl_get_private(gl).direct_state_access) {
+    const auto err =
+      GL_RET_ERR(glBlitNamedFramebuffer(src_fbo, dst_fbo, src_x, src_y, src_w, src_h, dst_x, dst_y,
+                                        dst_w, dst_h, target_mask, filter));
+    if (err != GL_NO_ERROR) {
+      return {unexpect, err};
+    }
+    return {};
+  }
   GL_ASSERT(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dst_fbo));
   GL_ASSERT(glBindFramebuffer(GL_READ_FRAMEBUFFER, src_fbo));
   const auto err = GL_RET_ERR(glBlitFramebuffer(src_x, src_y, src_w, src_h, dst_x, dst_y, dst_w,
                                                 dst_h, target_mask, filter));
   GL_ASSERT(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, GL_DEFAULT_BINDING));
   GL_ASSERT(glBindFramebuffer(GL_READ_FRAMEBUFFER, GL_DEFAULT_BINDING));
+  gl_get_state(gl).forget_bound_framebuffer();
   if (err != GL_NO_ERROR) {
     return {unexpect, err};
   }
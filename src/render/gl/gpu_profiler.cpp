@@ -0,0 +1,301 @@
+#include "./context_private.hpp"
+#include <shogle/render/gl/gpu_profiler.hpp>
+
+#ifdef SHOGLE_ENABLE_IMGUI
+#ifndef IMGUI_API
+#include <shogle/extern/imgui.h>
+#endif
+#endif
+
+#include <algorithm>
+#include <iterator>
+
+namespace shogle {
+
+namespace {
+
+constexpr u32 NO_RECORD = std::numeric_limits<u32>::max();
+constexpr u32 QUERIES_PER_RECORD = 2;
+constexpr std::string_view FRAME_ZONE_NAME = "frame";
+
+void append_json_string(std::string& out, std::string_view str) {
+  out.push_back('"');
+  for (const char c : str) {
+    if (c == '"' || c == '\\') {
+      out.push_back('\\');
+      out.push_back(c);
+    } else if (static_cast<u8>(c) < 0x20) {
+      fmt::format_to(std::back_inserter(out), "\\u{:04x}", static_cast<u32>(c));
+    } else {
+      out.push_back(c);
+    }
+  }
+  out.push_back('"');
+}
+
+} // namespace
+
+gl_gpu_profiler::gl_gpu_profiler(create_t, std::vector<gldefs::GLhandle>&& queries,
+                                 const create_args& args) :
+    _queries(std::move(queries)),
+    _records(size_t{args.frame_latency} * (args.max_zones + 1), zone_record{FRAME_ZONE, 0}),
+    _sets(args.frame_latency, frame_set{0, 0, false}), _records_per_set(args.max_zones + 1),
+    _trace_frames(args.trace_frames), _set(0), _frame(0), _resolved(0), _dropped(0),
+    _overflowed(0), _in_frame(false) {
+  _intern_zone(FRAME_ZONE_NAME);
+}
+
+gl_gpu_profiler::gl_gpu_profiler(gl_context& gl, const create_args& args) :
+    gl_gpu_profiler(::shogle::gl_gpu_profiler::create(gl, args).value()) {}
+
+gl_sv_expect<gl_gpu_profiler> gl_gpu_profiler::create(gl_context& gl, const create_args& args) {
+  if (!args.max_zones || !args.frame_latency || args.frame_latency > MAX_FRAME_LATENCY) {
+    return {unexpect, "Invalid profiler zone count or frame latency", GL_INVALID_VALUE};
+  }
+  const size_t count = size_t{args.frame_latency} * (args.max_zones + 1) * QUERIES_PER_RECORD;
+  std::vector<gldefs::GLhandle> queries(count);
+  const auto err = GL_RET_ERR(glGenQueries(static_cast<GLsizei>(count), queries.data()));
+  if (err) {
+    return {unexpect, "Failed to create timestamp queries", err};
+  }
+  SHOGLE_GL_LOG(VERBOSE, "GPU_PROFILER_CREATE [zones: {}, latency: {}, queries: {}]",
+                args.max_zones, args.frame_latency, count);
+  return {in_place, create_t{}, std::move(queries), args};
+}
+
+void gl_gpu_profiler::destroy(gl_context& gl, gl_gpu_profiler& profiler) noexcept {
+  if (SHOGLE_UNLIKELY(profiler.invalidated())) {
+    return;
+  }
+  if (gl.profiler().data() == &profiler) {
+    gl.set_profiler(nullptr);
+  }
+  GL_CALL(glDeleteQueries(static_cast<GLsizei>(profiler._queries.size()),
+                          profiler._queries.data()));
+  profiler._queries.clear();
+  profiler._stack.clear();
+  profiler._in_frame = false;
+}
+
+gldefs::GLhandle gl_gpu_profiler::_query(u32 set, u32 record, u32 end) const {
+  return _queries[(size_t{set} * _records_per_set + record) * QUERIES_PER_RECORD + end];
+}
+
+u32 gl_gpu_profiler::_intern_zone(std::string_view name) {
+  auto it = _zone_ids.find(name);
+  if (it != _zone_ids.end()) {
+    return it->second;
+  }
+  const u32 zone = static_cast<u32>(_stats.size());
+  // Deque elements never move, the map and the stats can point to them
+  const auto& stored = _names.emplace_back(name);
+  _zone_ids.emplace(stored, zone);
+  _stats.emplace_back(stored, 0u, 0u, 0., 0., 0., 0.);
+  _totals_ns.emplace_back(0);
+  _frame_ns.emplace_back(0);
+  return zone;
+}
+
+void gl_gpu_profiler::begin_frame(gl_context& gl) {
+  SHOGLE_ASSERT(!invalidated(), "gl_gpu_profiler use after free");
+  SHOGLE_ASSERT(!_in_frame, "Profiler frame started twice");
+  // Sets are reused in order, the current one is the oldest in flight
+  const u32 set_count = static_cast<u32>(_sets.size());
+  for (u32 i = 0; i < set_count; ++i) {
+    const u32 set = (_set + i) % set_count;
+    if (_sets[set].pending && !_resolve_set(gl, set, false)) {
+      break;
+    }
+  }
+
+  auto& current = _sets[_set];
+  if (current.pending) {
+    SHOGLE_GL_LOG(DEBUG, "GPU_PROFILER_DROP (frame: {}, set: {})", current.frame, _set);
+    ++_dropped;
+  }
+  current = {_frame, 1, false};
+  _records[size_t{_set} * _records_per_set] = {FRAME_ZONE, 0};
+  GL_ASSERT(glQueryCounter(_query(_set, 0, 0), GL_TIMESTAMP));
+  _stack.assign(1, 0);
+  _in_frame = true;
+}
+
+void gl_gpu_profiler::end_frame(gl_context& gl) {
+  SHOGLE_ASSERT(!invalidated(), "gl_gpu_profiler use after free");
+  if (!_in_frame) {
+    return;
+  }
+  SHOGLE_ASSERT(_stack.size() == 1, "Profiler zones left open at the end of the frame");
+  GL_ASSERT(glQueryCounter(_query(_set, 0, 1), GL_TIMESTAMP));
+  _sets[_set].pending = true;
+  _set = (_set + 1) % static_cast<u32>(_sets.size());
+  ++_frame;
+  _stack.clear();
+  _in_frame = false;
+}
+
+void gl_gpu_profiler::begin_zone(gl_context& gl, std::string_view name) {
+  SHOGLE_ASSERT(!invalidated(), "gl_gpu_profiler use after free");
+  SHOGLE_ASSERT(_in_frame, "Profiler zone outside of a frame");
+  auto& current = _sets[_set];
+  if (current.records == _records_per_set) {
+    ++_overflowed;
+    _stack.emplace_back(NO_RECORD);
+    return;
+  }
+  const u32 record = current.records++;
+  _records[size_t{_set} * _records_per_set + record] = {_intern_zone(name),
+                                                        static_cast<u32>(_stack.size())};
+  GL_ASSERT(glQueryCounter(_query(_set, record, 0), GL_TIMESTAMP));
+  _stack.emplace_back(record);
+}
+
+void gl_gpu_profiler::end_zone(gl_context& gl) {
+  SHOGLE_ASSERT(!invalidated(), "gl_gpu_profiler use after free");
+  SHOGLE_ASSERT(_stack.size() > 1, "Profiler zone ended without being started");
+  const u32 record = _stack.back();
+  _stack.pop_back();
+  if (record != NO_RECORD) {
+    GL_ASSERT(glQueryCounter(_query(_set, record, 1), GL_TIMESTAMP));
+  }
+}
+
+bool gl_gpu_profiler::_resolve_set(gl_context& gl, u32 set, bool wait) {
+  auto& frame = _sets[set];
+  // The frame end is the last timestamp written, every other one is done once it is
+  if (!wait) {
+    GLint available = GL_FALSE;
+    GL_ASSERT(glGetQueryObjectiv(_query(set, 0, 1), GL_QUERY_RESULT_AVAILABLE, &available));
+    if (!available) {
+      return false;
+    }
+  }
+
+  _touched.clear();
+  const zone_record* records = _records.data() + size_t{set} * _records_per_set;
+  for (u32 i = 0; i < frame.records; ++i) {
+    GLuint64 begin = 0, end = 0;
+    GL_ASSERT(glGetQueryObjectui64v(_query(set, i, 0), GL_QUERY_RESULT, &begin));
+    GL_ASSERT(glGetQueryObjectui64v(_query(set, i, 1), GL_QUERY_RESULT, &end));
+    end = std::max(begin, end);
+    const auto [zone, depth] = records[i];
+    if (std::find(_touched.begin(), _touched.end(), zone) == _touched.end()) {
+      _touched.emplace_back(zone);
+    }
+    _frame_ns[zone] += end - begin;
+    _stats[zone].depth = depth;
+    if (_trace_frames) {
+      _trace.emplace_back(zone, depth, frame.frame, begin, end);
+    }
+  }
+  if (_trace_frames) {
+    _trace_sizes.emplace_back(frame.records);
+    if (_trace_sizes.size() > _trace_frames) {
+      _trace.erase(_trace.begin(), _trace.begin() + _trace_sizes.front());
+      _trace_sizes.pop_front();
+    }
+  }
+
+  for (const u32 zone : _touched) {
+    auto& stats = _stats[zone];
+    const f64 ms = static_cast<f64>(_frame_ns[zone]) * 1e-6;
+    stats.min_ms = stats.samples ? std::min(stats.min_ms, ms) : ms;
+    stats.max_ms = stats.samples ? std::max(stats.max_ms, ms) : ms;
+    stats.last_ms = ms;
+    ++stats.samples;
+    _totals_ns[zone] += _frame_ns[zone];
+    stats.avg_ms = static_cast<f64>(_totals_ns[zone]) * 1e-6 / stats.samples;
+    _frame_ns[zone] = 0;
+  }
+  frame.pending = false;
+  ++_resolved;
+  return true;
+}
+
+void gl_gpu_profiler::flush(gl_context& gl) {
+  SHOGLE_ASSERT(!invalidated(), "gl_gpu_profiler use after free");
+  const u32 set_count = static_cast<u32>(_sets.size());
+  for (u32 i = 0; i < set_count; ++i) {
+    const u32 set = (_set + i) % set_count;
+    if (_sets[set].pending) {
+      _resolve_set(gl, set, true);
+    }
+  }
+}
+
+void gl_gpu_profiler::reset_stats() {
+  for (auto& stats : _stats) {
+    stats = {stats.name, 0u, 0u, 0., 0., 0., 0.};
+  }
+  std::fill(_totals_ns.begin(), _totals_ns.end(), 0);
+  _trace.clear();
+  _trace_sizes.clear();
+}
+
+std::string gl_gpu_profiler::chrome_trace() const {
+  std::string out = R"({"displayTimeUnit":"ms","traceEvents":[)";
+  // Timestamps are in microseconds, relative to the oldest frame kept
+  const u64 base = _trace.empty() ? 0 : _trace.front().begin_ns;
+  for (bool first = true; const auto& event : _trace) {
+    if (!first) {
+      out.push_back(',');
+    }
+    first = false;
+    out += R"({"name":)";
+    append_json_string(out, _stats[event.zone].name);
+    fmt::format_to(std::back_inserter(out),
+                   R"(,"cat":"gpu","ph":"X","pid":0,"tid":0,"ts":{:.3f},"dur":{:.3f},)"
+                   R"("args":{{"frame":{},"depth":{}}}}})",
+                   static_cast<f64>(event.begin_ns - base) * 1e-3,
+                   static_cast<f64>(event.end_ns - event.begin_ns) * 1e-3, event.frame,
+                   event.depth);
+  }
+  out += "]}";
+  return out;
+}
+
+u32 gl_gpu_profiler::pending_frames() const noexcept {
+  return static_cast<u32>(
+    std::count_if(_sets.begin(), _sets.end(), [](const frame_set& set) { return set.pending; }));
+}
+
+#ifdef SHOGLE_ENABLE_IMGUI
+void gl_gpu_profiler::draw_imgui() const {
+  constexpr ImGuiTableFlags flags =
+    ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit;
+  ImGui::Text("Resolved: %llu, dropped: %llu", static_cast<unsigned long long>(_resolved),
+              static_cast<unsigned long long>(_dropped));
+  if (!ImGui::BeginTable("gpu_profiler", 5, flags)) {
+    return;
+  }
+  ImGui::TableSetupColumn("Zone");
+  ImGui::TableSetupColumn("Last");
+  ImGui::TableSetupColumn("Min");
+  ImGui::TableSetupColumn("Avg");
+  ImGui::TableSetupColumn("Max");
+  ImGui::TableHeadersRow();
+  for (const auto& stats : _stats) {
+    if (!stats.samples) {
+      continue;
+    }
+    ImGui::TableNextRow();
+    ImGui::TableNextColumn();
+    // Zero indents by the default spacing, skip it for top level zones
+    const f32 indent = static_cast<f32>(stats.depth) * ImGui::GetStyle().IndentSpacing;
+    if (indent > 0.f) {
+      ImGui::Indent(indent);
+    }
+    ImGui::TextUnformatted(stats.name.data(), stats.name.data() + stats.name.size());
+    if (indent > 0.f) {
+      ImGui::Unindent(indent);
+    }
+    for (const f64 ms : {stats.last_ms, stats.min_ms, stats.avg_ms, stats.max_ms}) {
+      ImGui::TableNextColumn();
+      ImGui::Text("%.3f ms", ms);
+    }
+  }
+  ImGui::EndTable();
+}
+#endif
+
+} // namespace shogle
@@ -0,0 +1,344 @@
+#include "./context_private.hpp"
+#include <shogle/render/gl/hot_reload.hpp>
+
+#include <shogle/util/filesystem.hpp>
+
+#include <algorithm>
+#include <filesystem>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#define SHOGLE_HOT_RELOAD_INOTIFY 1
+#else
+#define SHOGLE_HOT_RELOAD_INOTIFY 0
+#endif
+
+namespace shogle {
+
+namespace stdfs = std::filesystem;
+
+gl_hot_reloader::gl_hot_reloader(create_t, gl_pipeline_compiler&& compiler, i32 fd,
+                                 u32 debounce_ms) noexcept :
+    _compiler(std::move(compiler)), _last_change(), _debounce(debounce_ms), _in_flight(0),
+    _fd(fd), _dirty(false) {}
+
+gl_hot_reloader::gl_hot_reloader(gl_context& gl, const create_args& args) :
+    gl_hot_reloader(::shogle::gl_hot_reloader::create(gl, args).value()) {}
+
+gl_hot_reloader::gl_hot_reloader(gl_hot_reloader&& other) noexcept :
+    _compiler(std::move(other._compiler)), _entries(std::move(other._entries)),
+    _dirs(std::move(other._dirs)), _files(std::move(other._files)),
+    _events(std::move(other._events)), _last_change(other._last_change),
+    _debounce(other._debounce), _in_flight(other._in_flight), _fd(other._fd),
+    _dirty(other._dirty) {
+  other._fd = -1;
+  other._in_flight = 0;
+}
+
+gl_hot_reloader::~gl_hot_reloader() noexcept {
+#if SHOGLE_HOT_RELOAD_INOTIFY
+  if (_fd >= 0) {
+    ::close(_fd);
+  }
+#endif
+}
+
+gl_hot_reloader& gl_hot_reloader::operator=(gl_hot_reloader&& other) noexcept {
+  if (this == &other) {
+    return *this;
+  }
+#if SHOGLE_HOT_RELOAD_INOTIFY
+  if (_fd >= 0) {
+    ::close(_fd);
+  }
+#endif
+  _compiler = std::move(other._compiler);
+  _entries = std::move(other._entries);
+  _dirs = std::move(other._dirs);
+  _files = std::move(other._files);
+  _events = std::move(other._events);
+  _last_change = other._last_change;
+  _debounce = other._debounce;
+  _in_flight = std::exchange(other._in_flight, 0);
+  _fd = std::exchange(other._fd, -1);
+  _dirty = other._dirty;
+  return *this;
+}
+
+bool gl_hot_reloader::is_supported() noexcept {
+  return SHOGLE_HOT_RELOAD_INOTIFY;
+}
+
+gl_sv_expect<gl_hot_reloader> gl_hot_reloader::create(gl_context& gl, const create_args& args) {
+#if SHOGLE_HOT_RELOAD_INOTIFY
+  const i32 fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fd < 0) {
+    return {unexpect, "Failed to initialize inotify"};
+  }
+  SHOGLE_GL_LOG(DEBUG, "HOT_RELOAD_CREATE (fd: {}, debounce: {}ms)", fd, args.debounce_ms);
+  return {in_place, create_t{}, gl_pipeline_compiler{gl, args.sync_budget}, fd, args.debounce_ms};
+#else
+  SHOGLE_UNUSED(gl);
+  SHOGLE_UNUSED(args);
+  return {unexpect, "Hot reloading is not supported on this platform"};
+#endif
+}
+
+void gl_hot_reloader::destroy(gl_context& gl, gl_hot_reloader& reloader) noexcept {
+  if (SHOGLE_UNLIKELY(reloader.invalidated())) {
+    return;
+  }
+  gl_pipeline_compiler::destroy(gl, reloader._compiler);
+#if SHOGLE_HOT_RELOAD_INOTIFY
+  ::close(reloader._fd);
+#endif
+  reloader._fd = -1;
+  reloader._entries.clear();
+  reloader._dirs.clear();
+  reloader._files.clear();
+  reloader._events.clear();
+  reloader._in_flight = 0;
+  reloader._dirty = false;
+}
+
+gl_sv_expect<void> gl_hot_reloader::_watch_file(std::string_view path, watch_id owner) {
+  SHOGLE_ASSERT(!invalidated(), "gl_hot_reloader use after free");
+  std::error_code ec;
+  const auto abs_path = stdfs::absolute(stdfs::path{path}, ec);
+  if (ec || !abs_path.has_filename()) {
+    return {unexpect, "Invalid file path"};
+  }
+  const auto dir_path = abs_path.parent_path().string();
+
+  u32 dir = 0;
+  while (dir < _dirs.size() && _dirs[dir].path != dir_path) {
+    ++dir;
+  }
+  if (dir == _dirs.size()) {
+#if SHOGLE_HOT_RELOAD_INOTIFY
+    // Atomic saves replace the file, so watching it directly would lose track after one save
+    const i32 wd = ::inotify_add_watch(_fd, dir_path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (wd < 0) {
+      return {unexpect, "Failed to watch directory"};
+    }
+    SHOGLE_GL_LOG(VERBOSE, "HOT_RELOAD_WATCH ({}) {}", wd, dir_path);
+    _dirs.emplace_back(dir_path, wd);
+#else
+    return {unexpect, "Hot reloading is not supported on this platform"};
+#endif
+  }
+  _files.emplace_back(abs_path.filename().string(), dir, owner);
+  return {};
+}
+
+gl_sv_expect<gl_hot_reloader::watch_id>
+gl_hot_reloader::watch_pipeline(gl_graphics_pipeline& pipeline, const pipeline_files& files,
+                                pipeline_callback on_reload) {
+  SHOGLE_ASSERT(!invalidated(), "gl_hot_reloader use after free");
+  SHOGLE_ASSERT(!files.vertex.empty(), "No vertex shader file");
+  SHOGLE_ASSERT(!files.fragment.empty(), "No fragment shader file");
+  const watch_id id = static_cast<watch_id>(_entries.size());
+  const std::array<std::string_view, MAX_FILES> paths{
+    files.vertex, files.fragment, files.geometry, files.tess_ctrl, files.tess_eval,
+  };
+
+  watch_entry entry{};
+  for (u32 i = 0; i < MAX_FILES; ++i) {
+    if (paths[i].empty()) {
+      continue;
+    }
+    if (auto ret = _watch_file(paths[i], id); !ret) {
+      std::erase_if(_files, [id](const watched_file& file) { return file.owner == id; });
+      return {unexpect, ret.error()};
+    }
+    entry.paths[i].assign(paths[i]);
+  }
+  entry.pipeline = pipeline;
+  entry.on_reload = std::move(on_reload);
+  entry.kind = EVENT_PIPELINE;
+  entry.active = true;
+  _entries.emplace_back(std::move(entry));
+  return {in_place, id};
+}
+
+gl_sv_expect<gl_hot_reloader::watch_id>
+gl_hot_reloader::watch_texture(gl_texture& texture, std::string_view path,
+                               texture_loader loader) {
+  SHOGLE_ASSERT(!invalidated(), "gl_hot_reloader use after free");
+  SHOGLE_ASSERT(loader, "No texture loader");
+  const watch_id id = static_cast<watch_id>(_entries.size());
+  if (auto ret = _watch_file(path, id); !ret) {
+    return {unexpect, ret.error()};
+  }
+
+  watch_entry entry{};
+  entry.paths[0].assign(path);
+  entry.texture = texture;
+  entry.loader = std::move(loader);
+  entry.kind = EVENT_TEXTURE;
+  entry.active = true;
+  _entries.emplace_back(std::move(entry));
+  return {in_place, id};
+}
+
+void gl_hot_reloader::unwatch(watch_id id) {
+  SHOGLE_ASSERT(id < _entries.size() && _entries[id].active, "Invalid watch id");
+  // Directory watches are kept, other files might still live there
+  std::erase_if(_files, [id](const watched_file& file) { return file.owner == id; });
+  auto& entry = _entries[id];
+  entry.active = false;
+  entry.dirty = false;
+  entry.on_reload = {};
+  entry.loader = {};
+}
+
+u32 gl_hot_reloader::watch_count() const noexcept {
+  return static_cast<u32>(
+    std::count_if(_entries.begin(), _entries.end(), [](const auto& e) { return e.active; }));
+}
+
+void gl_hot_reloader::_mark_dirty(watch_id owner) {
+  auto& entry = _entries[owner];
+  if (entry.active) {
+    entry.dirty = true;
+    _dirty = true;
+    _last_change = clock::now();
+  }
+}
+
+void gl_hot_reloader::_read_events() {
+#if SHOGLE_HOT_RELOAD_INOTIFY
+  // One read per update, a burst that doesn't fit gets picked up next time
+  alignas(inotify_event) char buffer[4096];
+  const ssize_t len = ::read(_fd, buffer, sizeof(buffer));
+  if (len <= 0) {
+    return;
+  }
+  for (ssize_t offset = 0; offset < len;) {
+    const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+    offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+    if (event->mask & IN_Q_OVERFLOW) {
+      for (const auto& file : _files) {
+        _mark_dirty(file.owner);
+      }
+      continue;
+    }
+    if (!event->len) {
+      continue;
+    }
+    const std::string_view name{event->name};
+    for (const auto& file : _files) {
+      if (_dirs[file.dir].wd == event->wd && file.name == name) {
+        _mark_dirty(file.owner);
+      }
+    }
+  }
+#endif
+}
+
+void gl_hot_reloader::_reload(gl_context& gl, watch_id id) {
+  auto& entry = _entries[id];
+  entry.dirty = false;
+  if (entry.kind == EVENT_TEXTURE) {
+    auto file = read_entire_file(entry.paths[0].c_str());
+    bool success = false;
+    if (file) {
+      auto ret = entry.loader(gl, *entry.texture, {file->data(), file->size()});
+      success = ret.has_value();
+    }
+    if (success) {
+      SHOGLE_GL_LOG(DEBUG, "HOT_RELOAD_TEXTURE ({}) {}", id, entry.paths[0]);
+    } else {
+      SHOGLE_GL_LOG(ERROR, "HOT_RELOAD_TEXTURE ({}) Failed to reload {}", id, entry.paths[0]);
+    }
+    _events.emplace_back(id, EVENT_TEXTURE, success);
+    return;
+  }
+
+  std::array<std::string, MAX_FILES> sources;
+  for (u32 i = 0; i < MAX_FILES; ++i) {
+    if (entry.paths[i].empty()) {
+      continue;
+    }
+    auto src = read_entire_file_str(entry.paths[i].c_str());
+    if (!src) {
+      // Probably caught mid write, the next change will retry
+      SHOGLE_GL_LOG(ERROR, "HOT_RELOAD_PIPELINE ({}) Failed to read {}", id, entry.paths[i]);
+      _events.emplace_back(id, EVENT_PIPELINE, false);
+      return;
+    }
+    sources[i] = std::move(*src);
+  }
+  const gl_pipeline_sources pipeline_sources{
+    .vertex = sources[0],
+    .fragment = sources[1],
+    .geometry = sources[2],
+    .tess_ctrl = sources[3],
+    .tess_eval = sources[4],
+  };
+  entry.ticket.emplace(_compiler.submit(gl, pipeline_sources));
+  ++_in_flight;
+}
+
+void gl_hot_reloader::_collect(gl_context& gl) {
+  _compiler.poll(gl);
+  for (watch_id id = 0; id < _entries.size(); ++id) {
+    auto& entry = _entries[id];
+    if (!entry.ticket || !_compiler.is_ready(*entry.ticket)) {
+      continue;
+    }
+    auto pipeline = _compiler.take(*entry.ticket);
+    entry.ticket.reset();
+    --_in_flight;
+    if (!entry.active) {
+      if (pipeline) {
+        gl_graphics_pipeline::destroy(gl, *pipeline);
+      }
+      continue;
+    }
+    if (!pipeline) {
+      SHOGLE_GL_LOG(ERROR, "HOT_RELOAD_PIPELINE ({}) Keeping program {}: {}", id,
+                    entry.pipeline->program(), pipeline.error().what());
+      _events.emplace_back(id, EVENT_PIPELINE, false);
+      continue;
+    }
+    // Nothing recorded for the current frame can reference the old program anymore
+    entry.pipeline->swap_program(*pipeline);
+    SHOGLE_GL_LOG(DEBUG, "HOT_RELOAD_PIPELINE ({}) Program {} -> {}", id, pipeline->program(),
+                  entry.pipeline->program());
+    gl_graphics_pipeline::destroy(gl, *pipeline);
+    if (entry.on_reload) {
+      entry.on_reload(gl, *entry.pipeline);
+    }
+    _events.emplace_back(id, EVENT_PIPELINE, true);
+  }
+}
+
+span<const gl_hot_reloader::reload_event> gl_hot_reloader::update(gl_context& gl) {
+  SHOGLE_ASSERT(!invalidated(), "gl_hot_reloader use after free");
+  _events.clear();
+  _read_events();
+
+  if (_dirty && clock::now() - _last_change >= _debounce) {
+    _dirty = false;
+    for (watch_id id = 0; id < _entries.size(); ++id) {
+      auto& entry = _entries[id];
+      if (!entry.dirty) {
+        continue;
+      }
+      // Wait for the previous compile before starting another one
+      if (entry.ticket) {
+        _dirty = true;
+        continue;
+      }
+      _reload(gl, id);
+    }
+  }
+  if (_in_flight) {
+    _collect(gl);
+  }
+  return {_events.data(), _events.size()};
+}
+
+} // namespace shogle
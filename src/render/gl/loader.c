@@ -14,7 +14,7 @@
   (GLLOAD(name_)) == NULL
 
 #ifdef NDEBUG
-#define GLLOADREQ(name_) \
+#define GLLOADREQ(name_, ...) \
   if (GLLOADCHECK(name_)) { \
     return SHOGLE_GL_LOAD_NO_FUNC; \
   }
@@ -24,6 +24,10 @@
   assert(funcs->name_);
 #endif
 
+// Optional functions are left NULL when missing, the context checks for them
+#define GLLOADOPT(name_, ...) \
+  GLLOAD(name_);
+
 #define CHECK_VER(maj_, min_) \
   ((ver->maj == maj_ && ver->min >= min_) || ver->maj > maj_)
 
@@ -79,6 +83,9 @@ shogle_gl_load_ret shogle_gl_load_funcs(void* user, PFN_shogle_glGetProcAddress
   }
 
   SHOGLE_GL_DOFUNCS(GLLOADREQ)
+  SHOGLE_GL_DOFUNCS_DSA(GLLOADOPT)
+  SHOGLE_GL_DOFUNCS_ATTRIB_BINDING(GLLOADOPT)
+  SHOGLE_GL_DOFUNCS_BINDLESS(GLLOADOPT)
 
   return SHOGLE_GL_LOAD_NO_ERROR;
 }
@@ -0,0 +1,414 @@
+#include "./context_private.hpp"
+#include <shogle/render/gl/mipmap.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace shogle {
+
+namespace {
+
+struct float_image {
+  std::vector<f32> texels;
+  u32 width;
+  u32 height;
+};
+
+struct filter_taps {
+  std::vector<u32> index;
+  std::vector<f32> weight;
+  u32 stride;
+};
+
+u32 format_channels(gl_texture::pixel_format format) noexcept {
+  switch (format) {
+    case gl_texture::PIXEL_FORMAT_R:
+      return 1;
+    case gl_texture::PIXEL_FORMAT_RG:
+      return 2;
+    case gl_texture::PIXEL_FORMAT_RGB:
+      [[fallthrough]];
+    case gl_texture::PIXEL_FORMAT_BGR:
+      return 3;
+    case gl_texture::PIXEL_FORMAT_RGBA:
+      [[fallthrough]];
+    case gl_texture::PIXEL_FORMAT_BGRA:
+      return 4;
+    default:
+      return 0;
+  }
+}
+
+f32 srgb_to_linear(f32 value) noexcept {
+  return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+f32 linear_to_srgb(f32 value) noexcept {
+  return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.f / 2.4f) - 0.055f;
+}
+
+const std::array<f32, 256>& srgb_decode_table() noexcept {
+  static const auto table = [] {
+    std::array<f32, 256> out;
+    for (u32 i = 0; i < out.size(); ++i) {
+      out[i] = srgb_to_linear(static_cast<f32>(i) / 255.f);
+    }
+    return out;
+  }();
+  return table;
+}
+
+// Modified Bessel function of the first kind, order zero
+f32 bessel_i0(f32 x) noexcept {
+  f32 sum = 1.f;
+  f32 term = 1.f;
+  const f32 half_sq = x * x * .25f;
+  for (u32 k = 1; k < 32 && term > sum * 1e-7f; ++k) {
+    term *= half_sq / static_cast<f32>(k * k);
+    sum += term;
+  }
+  return sum;
+}
+
+f32 kaiser_kernel(f32 t, f32 radius, f32 beta) noexcept {
+  const f32 x = t / radius;
+  if (std::abs(x) >= 1.f) {
+    return 0.f;
+  }
+  const f32 window = bessel_i0(beta * std::sqrt(1.f - x * x)) / bessel_i0(beta);
+  if (std::abs(t) < 1e-6f) {
+    return window;
+  }
+  const f32 pit = std::numbers::pi_v<f32> * t;
+  return std::sin(pit) / pit * window;
+}
+
+// Taps for every destination texel, with out of range source texels clamped to the edge
+filter_taps make_taps(u32 src, u32 dst, const gl_mip_chain::generate_args& args) {
+  const bool box = args.filter == gl_mip_chain::FILTER_BOX;
+  const f32 scale = static_cast<f32>(src) / static_cast<f32>(dst);
+  const f32 radius = box ? .5f : args.kaiser_radius;
+  const u32 stride = static_cast<u32>(std::ceil(2.f * radius * scale)) + 1;
+
+  filter_taps taps{
+    .index = std::vector<u32>(size_t(dst) * stride, 0),
+    .weight = std::vector<f32>(size_t(dst) * stride, 0.f),
+    .stride = stride,
+  };
+  for (u32 i = 0; i < dst; ++i) {
+    const f32 center = (static_cast<f32>(i) + .5f) * scale;
+    const i32 first = static_cast<i32>(std::ceil(center - radius * scale - .5f));
+    f32 sum = 0.f;
+    for (u32 k = 0; k < stride; ++k) {
+      const i32 j = first + static_cast<i32>(k);
+      const f32 t = (static_cast<f32>(j) + .5f - center) / scale;
+      const f32 w = box ? (t >= -.5f && t < .5f ? 1.f : 0.f)
+                        : kaiser_kernel(t, radius, args.kaiser_beta);
+      taps.index[i * stride + k] = static_cast<u32>(std::clamp(j, 0, static_cast<i32>(src) - 1));
+      taps.weight[i * stride + k] = w;
+      sum += w;
+    }
+    if (sum != 0.f) {
+      for (u32 k = 0; k < stride; ++k) {
+        taps.weight[i * stride + k] /= sum;
+      }
+    }
+  }
+  return taps;
+}
+
+float_image resample(const float_image& src, u32 width, u32 height, u32 channels,
+                     const gl_mip_chain::generate_args& args) {
+  const auto htaps = make_taps(src.width, width, args);
+  const auto vtaps = make_taps(src.height, height, args);
+
+  std::vector<f32> rows(size_t(width) * src.height * channels, 0.f);
+  for (u32 y = 0; y < src.height; ++y) {
+    const f32* in = src.texels.data() + size_t(y) * src.width * channels;
+    f32* out = rows.data() + size_t(y) * width * channels;
+    for (u32 x = 0; x < width; ++x) {
+      for (u32 k = 0; k < htaps.stride; ++k) {
+        const f32 w = htaps.weight[x * htaps.stride + k];
+        const f32* texel = in + size_t(htaps.index[x * htaps.stride + k]) * channels;
+        for (u32 c = 0; c < channels; ++c) {
+          out[x * channels + c] += w * texel[c];
+        }
+      }
+    }
+  }
+
+  float_image dst{std::vector<f32>(size_t(width) * height * channels, 0.f), width, height};
+  const size_t row_size = size_t(width) * channels;
+  for (u32 y = 0; y < height; ++y) {
+    f32* out = dst.texels.data() + y * row_size;
+    for (u32 k = 0; k < vtaps.stride; ++k) {
+      const f32 w = vtaps.weight[y * vtaps.stride + k];
+      const f32* in = rows.data() + vtaps.index[y * vtaps.stride + k] * row_size;
+      for (size_t i = 0; i < row_size; ++i) {
+        out[i] += w * in[i];
+      }
+    }
+  }
+  return dst;
+}
+
+float_image decode_base(const gl_texture::image_data& base, u32 channels, bool srgb) {
+  const u32 width = base.extent.width;
+  const u32 height = std::max(base.extent.height, 1u);
+  const size_t texel_size = channels * (base.datatype == gl_texture::PIXEL_TYPE_F32 ? 4 : 1);
+  const size_t align = static_cast<size_t>(base.alignment);
+  const size_t stride = (width * texel_size + align - 1) / align * align;
+  const auto* bytes = static_cast<const u8*>(base.data);
+
+  float_image image{std::vector<f32>(size_t(width) * height * channels), width, height};
+  for (u32 y = 0; y < height; ++y) {
+    f32* out = image.texels.data() + size_t(y) * width * channels;
+    const u8* row = bytes + y * stride;
+    if (base.datatype == gl_texture::PIXEL_TYPE_F32) {
+      std::memcpy(out, row, width * texel_size);
+      continue;
+    }
+    const auto& decode = srgb_decode_table();
+    for (u32 i = 0; i < width * channels; ++i) {
+      const bool linear = !srgb || (channels == 4 && i % 4 == 3);
+      out[i] = linear ? static_cast<f32>(row[i]) / 255.f : decode[row[i]];
+    }
+  }
+  return image;
+}
+
+void encode_level(const float_image& image, u32 channels, gl_texture::pixel_data_type datatype,
+                  bool srgb, u8* out) {
+  const size_t count = image.texels.size();
+  if (datatype == gl_texture::PIXEL_TYPE_F32) {
+    std::memcpy(out, image.texels.data(), count * sizeof(f32));
+    return;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    f32 value = std::clamp(image.texels[i], 0.f, 1.f);
+    if (srgb && (channels != 4 || i % 4 != 3)) {
+      value = linear_to_srgb(value);
+    }
+    out[i] = static_cast<u8>(value * 255.f + .5f);
+  }
+}
+
+// Returns the number of destination texels written
+u32 reduce_row_simd(const f32* r0, const f32* r1, f32* out, u32 count, u32 channels) noexcept {
+  u32 x = 0;
+#if defined(__AVX2__)
+  if (channels == 4) {
+    const __m256 quarter = _mm256_set1_ps(.25f);
+    for (; x + 2 <= count; x += 2) {
+      const size_t i = size_t(x) * 8;
+      const __m256 s01 = _mm256_add_ps(_mm256_loadu_ps(r0 + i), _mm256_loadu_ps(r1 + i));
+      const __m256 s23 = _mm256_add_ps(_mm256_loadu_ps(r0 + i + 8), _mm256_loadu_ps(r1 + i + 8));
+      const __m256 even = _mm256_permute2f128_ps(s01, s23, 0x20);
+      const __m256 odd = _mm256_permute2f128_ps(s01, s23, 0x31);
+      _mm256_storeu_ps(out + x * 4, _mm256_mul_ps(_mm256_add_ps(even, odd), quarter));
+    }
+  } else if (channels == 1) {
+    const __m256 quarter = _mm256_set1_ps(.25f);
+    for (; x + 8 <= count; x += 8) {
+      const size_t i = size_t(x) * 2;
+      const __m256 s0 = _mm256_add_ps(_mm256_loadu_ps(r0 + i), _mm256_loadu_ps(r1 + i));
+      const __m256 s1 = _mm256_add_ps(_mm256_loadu_ps(r0 + i + 8), _mm256_loadu_ps(r1 + i + 8));
+      // Pairs get shuffled per 128 bit lane, put the lanes back in order afterwards
+      const __m256 sum =
+        _mm256_add_ps(_mm256_shuffle_ps(s0, s1, _MM_SHUFFLE(2, 0, 2, 0)),
+                      _mm256_shuffle_ps(s0, s1, _MM_SHUFFLE(3, 1, 3, 1)));
+      const __m256 ordered = _mm256_castpd_ps(
+        _mm256_permute4x64_pd(_mm256_castps_pd(sum), _MM_SHUFFLE(3, 1, 2, 0)));
+      _mm256_storeu_ps(out + x, _mm256_mul_ps(ordered, quarter));
+    }
+  }
+#endif
+#if defined(__SSE2__)
+  const __m128 quarter = _mm_set1_ps(.25f);
+  if (channels == 4) {
+    for (; x < count; ++x) {
+      const size_t i = size_t(x) * 8;
+      const __m128 s0 = _mm_add_ps(_mm_loadu_ps(r0 + i), _mm_loadu_ps(r1 + i));
+      const __m128 s1 = _mm_add_ps(_mm_loadu_ps(r0 + i + 4), _mm_loadu_ps(r1 + i + 4));
+      _mm_storeu_ps(out + x * 4, _mm_mul_ps(_mm_add_ps(s0, s1), quarter));
+    }
+  } else if (channels == 2) {
+    for (; x + 2 <= count; x += 2) {
+      const size_t i = size_t(x) * 4;
+      const __m128 s0 = _mm_add_ps(_mm_loadu_ps(r0 + i), _mm_loadu_ps(r1 + i));
+      const __m128 s1 = _mm_add_ps(_mm_loadu_ps(r0 + i + 4), _mm_loadu_ps(r1 + i + 4));
+      const __m128 sum = _mm_add_ps(_mm_shuffle_ps(s0, s1, _MM_SHUFFLE(1, 0, 1, 0)),
+                                    _mm_shuffle_ps(s0, s1, _MM_SHUFFLE(3, 2, 3, 2)));
+      _mm_storeu_ps(out + x * 2, _mm_mul_ps(sum, quarter));
+    }
+  } else if (channels == 1) {
+    for (; x + 4 <= count; x += 4) {
+      const size_t i = size_t(x) * 2;
+      const __m128 s0 = _mm_add_ps(_mm_loadu_ps(r0 + i), _mm_loadu_ps(r1 + i));
+      const __m128 s1 = _mm_add_ps(_mm_loadu_ps(r0 + i + 4), _mm_loadu_ps(r1 + i + 4));
+      const __m128 sum = _mm_add_ps(_mm_shuffle_ps(s0, s1, _MM_SHUFFLE(2, 0, 2, 0)),
+                                    _mm_shuffle_ps(s0, s1, _MM_SHUFFLE(3, 1, 3, 1)));
+      _mm_storeu_ps(out + x, _mm_mul_ps(sum, quarter));
+    }
+  }
+#elif defined(__ARM_NEON)
+  if (channels == 4) {
+    for (; x < count; ++x) {
+      const size_t i = size_t(x) * 8;
+      const float32x4_t s0 = vaddq_f32(vld1q_f32(r0 + i), vld1q_f32(r1 + i));
+      const float32x4_t s1 = vaddq_f32(vld1q_f32(r0 + i + 4), vld1q_f32(r1 + i + 4));
+      vst1q_f32(out + x * 4, vmulq_n_f32(vaddq_f32(s0, s1), .25f));
+    }
+  } else if (channels == 1) {
+    for (; x + 4 <= count; x += 4) {
+      const size_t i = size_t(x) * 2;
+      const float32x4x2_t a = vld2q_f32(r0 + i);
+      const float32x4x2_t b = vld2q_f32(r1 + i);
+      const float32x4_t sum =
+        vaddq_f32(vaddq_f32(a.val[0], b.val[0]), vaddq_f32(a.val[1], b.val[1]));
+      vst1q_f32(out + x, vmulq_n_f32(sum, .25f));
+    }
+  }
+#else
+  SHOGLE_UNUSED(r0);
+  SHOGLE_UNUSED(r1);
+  SHOGLE_UNUSED(out);
+  SHOGLE_UNUSED(count);
+  SHOGLE_UNUSED(channels);
+#endif
+  return x;
+}
+
+// Same summation order as the vector paths, so both produce identical results
+void reduce_texels_scalar(const f32* r0, const f32* r1, f32* out, u32 first, u32 count,
+                          u32 channels) noexcept {
+  for (u32 x = first; x < count; ++x) {
+    const size_t a = size_t(x) * 2 * channels;
+    const size_t b = a + channels;
+    for (u32 c = 0; c < channels; ++c) {
+      out[x * channels + c] = ((r0[a + c] + r1[a + c]) + (r0[b + c] + r1[b + c])) * .25f;
+    }
+  }
+}
+
+} // namespace
+
+gl_mip_chain::gl_mip_chain(create_t, std::vector<u8>&& storage, std::vector<mip_level>&& levels,
+                           gl_texture::pixel_format format,
+                           gl_texture::pixel_data_type datatype) :
+    _storage(std::move(storage)), _levels(std::move(levels)), _format(format),
+    _datatype(datatype) {}
+
+gl_mip_chain::gl_mip_chain(const gl_texture::image_data& base, const generate_args& args) :
+    gl_mip_chain(::shogle::gl_mip_chain::generate(base, args).value()) {}
+
+gl_expect<gl_mip_chain> gl_mip_chain::generate(const gl_texture::image_data& base,
+                                               const generate_args& args) {
+  SHOGLE_ASSERT(base.data, "Mipmap generation with no base image");
+  const u32 channels = format_channels(base.format);
+  if (!channels || (base.datatype != gl_texture::PIXEL_TYPE_U8 &&
+                    base.datatype != gl_texture::PIXEL_TYPE_F32)) {
+    return {unexpect, GL_INVALID_ENUM};
+  }
+  if (base.extent.depth > 1 || !base.extent.width) {
+    return {unexpect, GL_INVALID_VALUE};
+  }
+
+  const u32 width = base.extent.width;
+  const u32 height = std::max(base.extent.height, 1u);
+  const u32 full_chain = std::bit_width(std::max(width, height));
+  const u32 level_total =
+    std::min({args.max_levels, gl_texture::MAX_MIPMAP_LEVEL, full_chain});
+  const size_t texel_size = channels * (base.datatype == gl_texture::PIXEL_TYPE_F32 ? 4 : 1);
+  const bool srgb = args.srgb && base.datatype == gl_texture::PIXEL_TYPE_U8;
+
+  std::vector<mip_level> levels;
+  size_t storage_size = 0;
+  for (u32 i = 1, w = width, h = height; i < level_total; ++i) {
+    w = std::max(w / 2, 1u);
+    h = std::max(h / 2, 1u);
+    levels.emplace_back(storage_size, extent2d{w, h});
+    storage_size += size_t(w) * h * texel_size;
+  }
+  std::vector<u8> storage(storage_size);
+
+  float_image current = decode_base(base, channels, srgb);
+  for (const auto& level : levels) {
+    const u32 w = level.extent.width;
+    const u32 h = level.extent.height;
+    if (args.filter == FILTER_BOX && current.width == w * 2 && current.height == h * 2) {
+      float_image next{std::vector<f32>(size_t(w) * h * channels), w, h};
+      reduce_2x2(current.texels.data(), next.texels.data(), current.width, current.height,
+                 channels);
+      current = std::move(next);
+    } else {
+      current = resample(current, w, h, channels, args);
+    }
+    encode_level(current, channels, base.datatype, srgb, storage.data() + level.offset);
+  }
+
+  return {in_place, create_t{}, std::move(storage), std::move(levels), base.format,
+          base.datatype};
+}
+
+void gl_mip_chain::reduce_2x2(const f32* src, f32* dst, u32 width, u32 height,
+                              u32 channels) noexcept {
+  SHOGLE_ASSERT(width % 2 == 0 && height % 2 == 0, "2x2 reduce on odd extent");
+  const u32 dst_width = width / 2;
+  const size_t src_row = size_t(width) * channels;
+  for (u32 y = 0; y < height / 2; ++y) {
+    const f32* r0 = src + size_t(y) * 2 * src_row;
+    const f32* r1 = r0 + src_row;
+    f32* out = dst + size_t(y) * dst_width * channels;
+    const u32 done = reduce_row_simd(r0, r1, out, dst_width, channels);
+    reduce_texels_scalar(r0, r1, out, done, dst_width, channels);
+  }
+}
+
+void gl_mip_chain::reduce_2x2_scalar(const f32* src, f32* dst, u32 width, u32 height,
+                                     u32 channels) noexcept {
+  SHOGLE_ASSERT(width % 2 == 0 && height % 2 == 0, "2x2 reduce on odd extent");
+  const u32 dst_width = width / 2;
+  const size_t src_row = size_t(width) * channels;
+  for (u32 y = 0; y < height / 2; ++y) {
+    const f32* r0 = src + size_t(y) * 2 * src_row;
+    reduce_texels_scalar(r0, r0 + src_row, dst + size_t(y) * dst_width * channels, 0, dst_width,
+                         channels);
+  }
+}
+
+gl_expect<void> gl_mip_chain::upload(gl_context& gl, gl_texture& texture, u32 layer) const {
+  const u32 levels = std::min(level_count() + 1, texture.levels());
+  for (u32 i = 1; i < levels; ++i) {
+    auto ret = texture.upload_image(gl, level(i), {}, layer, i);
+    if (!ret) {
+      return ret;
+    }
+  }
+  SHOGLE_GL_LOG(VERBOSE, "MIP_CHAIN_UPLOAD ({}) (levels: {}, size: {}B)", texture.id(),
+                levels ? levels - 1 : 0, _storage.size());
+  return {};
+}
+
+gl_texture::image_data gl_mip_chain::level(u32 level) const {
+  SHOGLE_ASSERT(level > 0 && level <= _levels.size(), "Mip level out of range");
+  const auto& mip = _levels[level - 1];
+  return {
+    .data = _storage.data() + mip.offset,
+    .extent = {mip.extent.width, mip.extent.height, 1},
+    .format = _format,
+    .datatype = _datatype,
+    .alignment = gl_texture::ALIGN_1BYTE,
+  };
+}
+
+} // namespace shogle
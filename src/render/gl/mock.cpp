@@ -0,0 +1,1684 @@
+#include <shogle/render/gl/loader.h>
+#include <shogle/render/gl/mock.hpp>
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#if !defined(SHOGLE_USE_SYSTEM_GL) || !SHOGLE_USE_SYSTEM_GL
+
+namespace shogle {
+
+namespace {
+
+// Optional functions get stubs too, the mock reports the version or extension that has them
+#define MOCK_DOFUNCS(X)                                                             \
+  SHOGLE_GL_DOFUNCS(X) SHOGLE_GL_DOFUNCS_DSA(X) SHOGLE_GL_DOFUNCS_ATTRIB_BINDING(X) \
+  SHOGLE_GL_DOFUNCS_BINDLESS(X)
+
+#define MOCK_FUNC_ID(name_, ...) MOCK_FUNC_##name_,
+enum mock_func : u32 {
+  MOCK_DOFUNCS(MOCK_FUNC_ID) MOCK_FUNC_COUNT,
+};
+#undef MOCK_FUNC_ID
+
+#define MOCK_FUNC_NAME(name_, ...) #name_,
+constexpr auto mock_func_names =
+  std::to_array<std::string_view>({MOCK_DOFUNCS(MOCK_FUNC_NAME)});
+#undef MOCK_FUNC_NAME
+
+static_assert(mock_func_names.size() == MOCK_FUNC_COUNT);
+
+enum mock_object_kind : u8 {
+  OBJECT_TEXTURE = 0,
+  OBJECT_BUFFER,
+  OBJECT_FRAMEBUFFER,
+  OBJECT_RENDERBUFFER,
+  OBJECT_VERTEX_ARRAY,
+  OBJECT_SHADER,
+  OBJECT_PROGRAM,
+  OBJECT_SAMPLER,
+  OBJECT_QUERY,
+};
+
+// Bindings that live inside other objects or units
+enum mock_scope : u8 {
+  SCOPE_NONE = 0,
+  SCOPE_TEXTURE_UNIT,
+  SCOPE_VERTEX_ARRAY,
+  SCOPE_BUFFER_TARGET, // Only the element buffer binding is VAO state
+};
+
+struct mock_block_member {
+  std::string name;
+  GLenum type;
+  GLint size;
+  GLint offset;
+  GLint array_stride;
+  GLint matrix_stride;
+};
+
+struct mock_uniform_block {
+  std::string name;
+  std::vector<mock_block_member> members;
+  GLint data_size;
+  GLuint binding;
+};
+
+struct mock_object {
+  mock_object_kind kind;
+  std::vector<u8> storage;
+  GLint status = GL_TRUE; // Compile or link status
+  u32 pending_polls = 0;   // Completion status or result availability queries left
+  u64 timestamp = 0;       // Queries only
+  std::string source{};                     // Shaders only
+  std::vector<GLuint> attached{};           // Programs only
+  std::vector<mock_uniform_block> blocks{}; // Programs only, filled on link
+};
+
+constexpr GLenum MOCK_BINARY_FORMAT = 0x5348;
+constexpr std::string_view MOCK_BINARY_MAGIC = "shogle mock program";
+
+constexpr u64 FNV_OFFSET = 0xcbf29ce484222325;
+constexpr u64 FNV_PRIME = 0x100000001b3;
+
+constexpr u64 hash_mix(u64 hash, u64 value) {
+  return (hash ^ value) * FNV_PRIME;
+}
+
+struct mock_std140_type {
+  std::string_view name;
+  GLenum type;
+  GLint align;
+  GLint size;
+  GLint columns; // Zero for non matrices
+};
+
+constexpr mock_std140_type MOCK_STD140_TYPES[] = {
+  {"float", 0x1406, 4, 4, 0},  {"vec2", 0x8B50, 8, 8, 0},   {"vec3", 0x8B51, 16, 12, 0},
+  {"vec4", 0x8B52, 16, 16, 0}, {"int", 0x1404, 4, 4, 0},    {"ivec2", 0x8B53, 8, 8, 0},
+  {"ivec3", 0x8B54, 16, 12, 0}, {"ivec4", 0x8B55, 16, 16, 0}, {"uint", 0x1405, 4, 4, 0},
+  {"uvec2", 0x8DC6, 8, 8, 0},  {"uvec3", 0x8DC7, 16, 12, 0}, {"uvec4", 0x8DC8, 16, 16, 0},
+  {"bool", 0x8B56, 4, 4, 0},   {"mat3", 0x8B5B, 16, 48, 3}, {"mat4", 0x8B5C, 16, 64, 4},
+};
+
+constexpr GLint std140_align(GLint value, GLint alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+std::vector<std::string_view> tokenize_source(std::string_view src) {
+  const auto is_ident = [](char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+  };
+  std::vector<std::string_view> tokens;
+  size_t i = 0;
+  while (i < src.size()) {
+    const char c = src[i];
+    if (c == '/' && i + 1 < src.size() && src[i + 1] == '/') {
+      while (i < src.size() && src[i] != '\n') {
+        ++i;
+      }
+    } else if (is_ident(c)) {
+      const size_t start = i;
+      while (i < src.size() && is_ident(src[i])) {
+        ++i;
+      }
+      tokens.emplace_back(src.substr(start, i - start));
+    } else {
+      if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+        tokens.emplace_back(src.substr(i, 1));
+      }
+      ++i;
+    }
+  }
+  return tokens;
+}
+
+// Enough of GLSL to lay out simple std140 blocks, like a driver would report them
+void parse_uniform_blocks(std::string_view src, std::vector<mock_uniform_block>& blocks) {
+  const auto tokens = tokenize_source(src);
+  const auto to_int = [](std::string_view tok) {
+    GLint value = 0;
+    for (const char c : tok) {
+      value = value * 10 + (c - '0');
+    }
+    return value;
+  };
+  GLuint binding = 0;
+  for (size_t i = 0; i < tokens.size(); ++i) {
+    if (tokens[i] == "binding" && i + 2 < tokens.size() && tokens[i + 1] == "=") {
+      binding = static_cast<GLuint>(to_int(tokens[i + 2]));
+      continue;
+    }
+    if (tokens[i] == ";") {
+      binding = 0;
+      continue;
+    }
+    if (tokens[i] != "uniform" || i + 2 >= tokens.size() || tokens[i + 2] != "{") {
+      continue;
+    }
+    mock_uniform_block block{std::string{tokens[i + 1]}, {}, 0, binding};
+    GLint offset = 0;
+    for (i += 3; i + 2 < tokens.size() && tokens[i] != "}";) {
+      const auto type = std::find_if(std::begin(MOCK_STD140_TYPES), std::end(MOCK_STD140_TYPES),
+                                     [&](const auto& t) { return t.name == tokens[i]; });
+      if (type == std::end(MOCK_STD140_TYPES)) {
+        ++i;
+        continue;
+      }
+      mock_block_member member{std::string{tokens[i + 1]}, type->type, 1, 0, 0, 0};
+      i += 2;
+      GLint align = type->align;
+      GLint size = type->size;
+      if (tokens[i] == "[") {
+        member.size = to_int(tokens[i + 1]);
+        member.array_stride = std140_align(type->size, 16);
+        align = 16;
+        size = member.array_stride * member.size;
+        i += 3;
+      }
+      if (type->columns) {
+        member.matrix_stride = 16;
+      }
+      member.offset = std140_align(offset, align);
+      offset = member.offset + size;
+      block.members.emplace_back(std::move(member));
+      ++i; // ';'
+    }
+    block.data_size = std140_align(offset, 16);
+    const auto dup = std::find_if(blocks.begin(), blocks.end(),
+                                  [&](const auto& other) { return other.name == block.name; });
+    if (dup == blocks.end()) {
+      blocks.emplace_back(std::move(block));
+    }
+    binding = 0;
+  }
+}
+
+constexpr GLenum FRAMEBUFFER_COMPLETE = 0x8CD5;
+constexpr u32 MAX_TRACE_ARGS = 16;
+
+} // namespace
+
+class gl_mock_state {
+public:
+  gl_mock_state(extent2d extent_, gl_version version_) :
+      extent(extent_), version(version_),
+      version_string(fmt::format("{}.{}.0 shogle mock", version_.major, version_.minor)) {}
+
+public:
+  GLuint alloc_object(mock_object_kind kind) {
+    const GLuint name = next_name++;
+    objects.emplace(name, mock_object{kind, {}});
+    return name;
+  }
+
+  void free_object(GLuint name, mock_object_kind kind) {
+    // Deleting zero or unused names is silently ignored
+    auto it = objects.find(name);
+    if (it == objects.end() || it->second.kind != kind) {
+      return;
+    }
+    objects.erase(it);
+    if (kind == OBJECT_VERTEX_ARRAY && vao == name) {
+      vao = 0;
+    }
+    if (kind == OBJECT_BUFFER) {
+      for (auto& [_, buffer] : buffer_bindings) {
+        if (buffer == name) {
+          buffer = 0;
+        }
+      }
+    }
+  }
+
+  mock_object* find_object(GLuint name, mock_object_kind kind) {
+    auto it = objects.find(name);
+    if (it == objects.end() || it->second.kind != kind) {
+      return nullptr;
+    }
+    return &it->second;
+  }
+
+  bool check_bind(GLuint name, mock_object_kind kind) {
+    if (name == 0 || find_object(name, kind)) {
+      return true;
+    }
+    push_error(GL_INVALID_OPERATION);
+    return false;
+  }
+
+  GLuint& buffer_binding(GLenum target) {
+    const u64 key = target == GL_ELEMENT_ARRAY_BUFFER ? (static_cast<u64>(vao) << 32) | target
+                                                      : static_cast<u64>(target);
+    return buffer_bindings[key];
+  }
+
+  mock_object* bound_buffer(GLenum target) {
+    return named_object(buffer_binding(target), OBJECT_BUFFER);
+  }
+
+  mock_object* named_object(GLuint name, mock_object_kind kind) {
+    auto* obj = find_object(name, kind);
+    if (!obj) {
+      push_error(GL_INVALID_OPERATION);
+    }
+    return obj;
+  }
+
+  bool is_enabled(GLenum cap) const {
+    auto it = state_values.find(hash_mix(hash_mix(FNV_OFFSET, MOCK_FUNC_glEnable), cap));
+    return it != state_values.end() && it->second;
+  }
+
+  void push_error(GLenum err) {
+    errors.emplace_back(err);
+    // Reported like a synchronous debug output, with the error code as the message id
+    if (debug_proc && is_enabled(GL_DEBUG_OUTPUT)) {
+      debug_proc(GL_DEBUG_SOURCE_API, GL_DEBUG_TYPE_ERROR, err, GL_DEBUG_SEVERITY_HIGH, -1,
+                 "mock error", debug_user);
+    }
+  }
+
+  void write_varint(u64 value) {
+    while (value >= 0x80) {
+      trace.emplace_back(static_cast<u8>(value) | 0x80);
+      value >>= 7;
+    }
+    trace.emplace_back(static_cast<u8>(value));
+  }
+
+  void record(u32 func, span<const u64> args) {
+    ++stats.calls;
+    ++call_counts[func];
+    write_varint(func);
+    write_varint(args.size());
+    for (const u64 arg : args) {
+      write_varint(arg);
+    }
+  }
+
+  void set_state(u64 key, u64 value) {
+    ++stats.state_changes;
+    auto [it, inserted] = state_values.try_emplace(key, value);
+    if (inserted) {
+      return;
+    }
+    if (it->second == value) {
+      ++stats.redundant_state_changes;
+    } else {
+      it->second = value;
+    }
+  }
+
+  void state_change(u32 func, u32 key_args, mock_scope scope, span<const u64> args) {
+    u64 key = hash_mix(FNV_OFFSET, func);
+    switch (scope) {
+      case SCOPE_TEXTURE_UNIT: {
+        key = hash_mix(key, active_unit);
+      } break;
+      case SCOPE_VERTEX_ARRAY: {
+        key = hash_mix(key, vao);
+      } break;
+      case SCOPE_BUFFER_TARGET: {
+        if (args[0] == GL_ELEMENT_ARRAY_BUFFER) {
+          key = hash_mix(key, vao);
+        }
+      } break;
+      default:
+        break;
+    }
+    u64 value = FNV_OFFSET;
+    for (u32 i = 0; i < args.size(); ++i) {
+      if (i < key_args) {
+        key = hash_mix(key, args[i]);
+      } else {
+        value = hash_mix(value, args[i]);
+      }
+    }
+    set_state(key, value);
+  }
+
+public:
+  extent2d extent;
+  gl_version version;
+  std::string version_string;
+
+  std::unordered_map<GLuint, mock_object> objects;
+  GLuint next_name = 1;
+  std::unordered_map<u64, GLuint> buffer_bindings;
+  std::unordered_map<u64, u64> state_values;
+  GLuint vao = 0;
+  u32 active_unit = 0;
+  std::vector<GLenum> errors;
+  GLDEBUGPROC debug_proc = nullptr;
+  const void* debug_user = nullptr;
+
+  // Fences report as unsignaled for this many non-blocking waits
+  std::unordered_map<uintptr_t, u32> fences;
+  uintptr_t next_fence = 1;
+  u32 fence_latency = 0;
+
+  // Shaders and programs report as incomplete for this many completion status queries
+  u32 compile_latency = 0;
+
+  // Timestamp queries report as unavailable for this many polls, draws advance the clock
+  u32 query_latency = 0;
+  u64 gpu_time = 0;
+  std::vector<std::string> extensions{"GL_KHR_parallel_shader_compile",
+                                      "GL_ARB_bindless_texture"};
+
+  // Bindless handle -> residency, handles die with their texture
+  std::unordered_map<u64, bool> texture_handles;
+
+  std::array<u64, MOCK_FUNC_COUNT> call_counts{};
+  gl_mock_provider::call_stats stats{};
+  std::vector<u8> trace;
+};
+
+namespace {
+
+thread_local gl_mock_state* current_mock = nullptr;
+
+template<typename T>
+u64 pack_arg(T arg) noexcept {
+  if constexpr (std::is_pointer_v<T>) {
+    return static_cast<u64>(reinterpret_cast<uintptr_t>(arg));
+  } else if constexpr (std::is_same_v<T, f32>) {
+    return std::bit_cast<u32>(arg);
+  } else if constexpr (std::is_same_v<T, f64>) {
+    return std::bit_cast<u64>(arg);
+  } else {
+    return static_cast<u64>(arg);
+  }
+}
+
+template<u32 Id>
+struct mock_handler {};
+
+template<u32 Id>
+struct mock_state_func {
+  static constexpr i32 key_args = -1;
+  static constexpr mock_scope scope = SCOPE_NONE;
+};
+
+template<u32 Id>
+constexpr bool mock_is_draw = false;
+
+template<u32 Id, typename Fn>
+struct mock_stub;
+
+template<u32 Id, typename Ret, typename... Args>
+struct mock_stub<Id, Ret(SHOGLE_GLAPI_ENTRY*)(Args...)> {
+  static Ret SHOGLE_GLAPI_ENTRY call(Args... args) {
+    SHOGLE_ASSERT(current_mock, "No gl_mock_provider bound to this thread");
+    auto& mock = *current_mock;
+    const std::array<u64, sizeof...(Args)> packed{pack_arg(args)...};
+    mock.record(Id, packed);
+    if constexpr (mock_is_draw<Id>) {
+      ++mock.stats.draw_calls;
+      mock.gpu_time += gl_mock_provider::DRAW_TIME_NS;
+    }
+    if constexpr (mock_state_func<Id>::key_args >= 0) {
+      mock.state_change(Id, mock_state_func<Id>::key_args, mock_state_func<Id>::scope, packed);
+    }
+    if constexpr (requires { mock_handler<Id>::handle(mock, args...); }) {
+      return mock_handler<Id>::handle(mock, args...);
+    } else if constexpr (!std::is_void_v<Ret>) {
+      return Ret{};
+    }
+  }
+};
+
+#define MOCK_DRAW_FUNC(name_) \
+  template<>              \
+  constexpr bool mock_is_draw<MOCK_FUNC_##name_> = true;
+
+MOCK_DRAW_FUNC(glDrawArrays)
+MOCK_DRAW_FUNC(glDrawArraysInstanced)
+MOCK_DRAW_FUNC(glDrawElementsBaseVertex)
+MOCK_DRAW_FUNC(glDrawElementsInstancedBaseVertex)
+MOCK_DRAW_FUNC(glMultiDrawElementsIndirect)
+
+#undef MOCK_DRAW_FUNC
+
+// Leading arguments that select the piece of state, the rest is the value
+#define MOCK_STATE_FUNC(name_, key_args_, scope_)                 \
+  template<>                                                      \
+  struct mock_state_func<MOCK_FUNC_##name_> {                     \
+    static constexpr i32 key_args = key_args_;                    \
+    static constexpr mock_scope scope = scope_;                   \
+  };
+
+MOCK_STATE_FUNC(glBindBuffer, 1, SCOPE_BUFFER_TARGET)
+MOCK_STATE_FUNC(glBindBufferRange, 2, SCOPE_NONE)
+MOCK_STATE_FUNC(glBindTexture, 1, SCOPE_TEXTURE_UNIT)
+MOCK_STATE_FUNC(glBindSampler, 1, SCOPE_NONE)
+MOCK_STATE_FUNC(glBindFramebuffer, 1, SCOPE_NONE)
+MOCK_STATE_FUNC(glBindRenderbuffer, 1, SCOPE_NONE)
+MOCK_STATE_FUNC(glBindVertexArray, 0, SCOPE_NONE)
+MOCK_STATE_FUNC(glUseProgram, 0, SCOPE_NONE)
+MOCK_STATE_FUNC(glActiveTexture, 0, SCOPE_NONE)
+MOCK_STATE_FUNC(glViewport, 0, SCOPE_NONE)
+MOCK_STATE_FUNC(glScissor, 0, SCOPE_NONE)
+MOCK_STATE_FUNC(glPolygonMode, 1, SCOPE_NONE)
+MOCK_STATE_FUNC(glLineWidth, 0, SCOPE_NONE)
+MOCK_STATE_FUNC(glPointSize, 0, SCOPE_NONE)
+MOCK_STATE_FUNC(glDepthFunc, 0, SCOPE_NONE)
+MOCK_STATE_FUNC(glDepthRange, 0, SCOPE_NONE)
+MOCK_STATE_FUNC(glDepthMask, 0, SCOPE_NONE)
+MOCK_STATE_FUNC(glStencilFunc, 0, SCOPE_NONE)
+MOCK_STATE_FUNC(glStencilOp, 0, SCOPE_NONE)
+MOCK_STATE_FUNC(glStencilMask, 0, SCOPE_NONE)
+MOCK_STATE_FUNC(glBlendEquation, 0, SCOPE_NONE)
+MOCK_STATE_FUNC(glBlendFuncSeparate, 0, SCOPE_NONE)
+MOCK_STATE_FUNC(glBlendColor, 0, SCOPE_NONE)
+MOCK_STATE_FUNC(glCullFace, 0, SCOPE_NONE)
+MOCK_STATE_FUNC(glFrontFace, 0, SCOPE_NONE)
+MOCK_STATE_FUNC(glClearColor, 0, SCOPE_NONE)
+MOCK_STATE_FUNC(glPixelStorei, 1, SCOPE_NONE)
+MOCK_STATE_FUNC(glEnableVertexAttribArray, 1, SCOPE_VERTEX_ARRAY)
+MOCK_STATE_FUNC(glVertexAttribPointer, 1, SCOPE_VERTEX_ARRAY)
+MOCK_STATE_FUNC(glVertexAttribIPointer, 1, SCOPE_VERTEX_ARRAY)
+MOCK_STATE_FUNC(glVertexAttribLPointer, 1, SCOPE_VERTEX_ARRAY)
+MOCK_STATE_FUNC(glVertexAttribFormat, 1, SCOPE_VERTEX_ARRAY)
+MOCK_STATE_FUNC(glVertexAttribIFormat, 1, SCOPE_VERTEX_ARRAY)
+MOCK_STATE_FUNC(glVertexAttribLFormat, 1, SCOPE_VERTEX_ARRAY)
+MOCK_STATE_FUNC(glVertexAttribBinding, 1, SCOPE_VERTEX_ARRAY)
+MOCK_STATE_FUNC(glBindVertexBuffer, 1, SCOPE_VERTEX_ARRAY)
+
+#undef MOCK_STATE_FUNC
+
+#define MOCK_HANDLER(name_) \
+  template<>                \
+  struct mock_handler<MOCK_FUNC_##name_>
+
+u64 texture_handle(GLuint texture) {
+  return (u64{1} << 32) | texture;
+}
+
+void gen_objects(gl_mock_state& mock, mock_object_kind kind, GLsizei n, GLuint* names) {
+  if (n < 0) {
+    mock.push_error(GL_INVALID_VALUE);
+    return;
+  }
+  for (GLsizei i = 0; i < n; ++i) {
+    names[i] = mock.alloc_object(kind);
+  }
+}
+
+void delete_objects(gl_mock_state& mock, mock_object_kind kind, GLsizei n, const GLuint* names) {
+  if (n < 0) {
+    mock.push_error(GL_INVALID_VALUE);
+    return;
+  }
+  for (GLsizei i = 0; i < n; ++i) {
+    mock.free_object(names[i], kind);
+  }
+}
+
+GLint fake_location(const char* name) {
+  u64 hash = FNV_OFFSET;
+  for (; *name; ++name) {
+    hash = hash_mix(hash, static_cast<u8>(*name));
+  }
+  return static_cast<GLint>(hash % 1024);
+}
+
+MOCK_HANDLER(glGetStringi) {
+  static const GLubyte* handle(gl_mock_state& mock, GLenum name, GLuint index) {
+    if (name != GL_EXTENSIONS) {
+      mock.push_error(GL_INVALID_ENUM);
+      return nullptr;
+    }
+    if (index >= mock.extensions.size()) {
+      mock.push_error(GL_INVALID_VALUE);
+      return nullptr;
+    }
+    return reinterpret_cast<const GLubyte*>(mock.extensions[index].c_str());
+  }
+};
+
+MOCK_HANDLER(glGetString) {
+  static const GLubyte* handle(gl_mock_state& mock, GLenum name) {
+    switch (name) {
+      case GL_VERSION:
+        return reinterpret_cast<const GLubyte*>(mock.version_string.c_str());
+      case GL_VENDOR:
+        return reinterpret_cast<const GLubyte*>("shogle");
+      case GL_RENDERER:
+        return reinterpret_cast<const GLubyte*>("shogle mock renderer");
+      default:
+        break;
+    }
+    mock.push_error(GL_INVALID_ENUM);
+    return nullptr;
+  }
+};
+
+MOCK_HANDLER(glGetError) {
+  static GLenum handle(gl_mock_state& mock) {
+    if (mock.errors.empty()) {
+      return GL_NO_ERROR;
+    }
+    const GLenum err = mock.errors.front();
+    mock.errors.erase(mock.errors.begin());
+    return err;
+  }
+};
+
+MOCK_HANDLER(glDebugMessageCallback) {
+  static void handle(gl_mock_state& mock, GLDEBUGPROC callback, const void* user) {
+    mock.debug_proc = callback;
+    mock.debug_user = user;
+  }
+};
+
+MOCK_HANDLER(glEnable) {
+  static void handle(gl_mock_state& mock, GLenum cap) {
+    mock.set_state(hash_mix(hash_mix(FNV_OFFSET, MOCK_FUNC_glEnable), cap), 1);
+  }
+};
+
+MOCK_HANDLER(glDisable) {
+  static void handle(gl_mock_state& mock, GLenum cap) {
+    mock.set_state(hash_mix(hash_mix(FNV_OFFSET, MOCK_FUNC_glEnable), cap), 0);
+  }
+};
+
+MOCK_HANDLER(glGetIntegerv) {
+  static void handle(gl_mock_state& mock, GLenum pname, GLint* data) {
+    switch (pname) {
+      case GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT: {
+        *data = 256;
+      } break;
+      case GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT: {
+        *data = 32;
+      } break;
+      case GL_NUM_EXTENSIONS: {
+        *data = static_cast<GLint>(mock.extensions.size());
+      } break;
+      case GL_MAX_TEXTURE_MAX_ANISOTROPY: {
+        *data = 16;
+      } break;
+      default: {
+        mock.push_error(GL_INVALID_ENUM);
+      } break;
+    }
+  }
+};
+
+MOCK_HANDLER(glFenceSync) {
+  static GLsync handle(gl_mock_state& mock, GLenum condition, GLbitfield flags) {
+    if (condition != GL_SYNC_GPU_COMMANDS_COMPLETE || flags != 0) {
+      mock.push_error(condition != GL_SYNC_GPU_COMMANDS_COMPLETE ? GL_INVALID_ENUM
+                                                                 : GL_INVALID_VALUE);
+      return nullptr;
+    }
+    const uintptr_t fence = mock.next_fence++;
+    mock.fences.emplace(fence, mock.fence_latency);
+    return reinterpret_cast<GLsync>(fence);
+  }
+};
+
+MOCK_HANDLER(glClientWaitSync) {
+  static GLenum handle(gl_mock_state& mock, GLsync sync, GLbitfield, GLuint64 timeout) {
+    auto it = mock.fences.find(reinterpret_cast<uintptr_t>(sync));
+    if (it == mock.fences.end()) {
+      mock.push_error(GL_INVALID_VALUE);
+      return GL_WAIT_FAILED;
+    }
+    if (!it->second) {
+      return GL_ALREADY_SIGNALED;
+    }
+    if (!timeout) {
+      --it->second;
+      return GL_TIMEOUT_EXPIRED;
+    }
+    // Blocking waits always see the GPU catching up
+    it->second = 0;
+    return GL_CONDITION_SATISFIED;
+  }
+};
+
+MOCK_HANDLER(glDeleteSync) {
+  static void handle(gl_mock_state& mock, GLsync sync) {
+    if (!sync) {
+      return;
+    }
+    if (!mock.fences.erase(reinterpret_cast<uintptr_t>(sync))) {
+      mock.push_error(GL_INVALID_VALUE);
+    }
+  }
+};
+
+MOCK_HANDLER(glGenQueries) {
+  static void handle(gl_mock_state& mock, GLsizei n, GLuint* ids) {
+    gen_objects(mock, OBJECT_QUERY, n, ids);
+  }
+};
+
+MOCK_HANDLER(glDeleteQueries) {
+  static void handle(gl_mock_state& mock, GLsizei n, const GLuint* ids) {
+    delete_objects(mock, OBJECT_QUERY, n, ids);
+  }
+};
+
+MOCK_HANDLER(glQueryCounter) {
+  static void handle(gl_mock_state& mock, GLuint id, GLenum target) {
+    if (target != GL_TIMESTAMP) {
+      mock.push_error(GL_INVALID_ENUM);
+      return;
+    }
+    auto* obj = mock.find_object(id, OBJECT_QUERY);
+    if (!obj) {
+      mock.push_error(GL_INVALID_OPERATION);
+      return;
+    }
+    obj->timestamp = mock.gpu_time;
+    obj->pending_polls = mock.query_latency;
+  }
+};
+
+template<typename T>
+void query_object(gl_mock_state& mock, GLuint id, GLenum pname, T* params) {
+  auto* obj = mock.find_object(id, OBJECT_QUERY);
+  if (!obj) {
+    mock.push_error(GL_INVALID_OPERATION);
+    return;
+  }
+  switch (pname) {
+    case GL_QUERY_RESULT_AVAILABLE: {
+      *params = obj->pending_polls ? GL_FALSE : GL_TRUE;
+      obj->pending_polls -= obj->pending_polls ? 1 : 0;
+    } break;
+    case GL_QUERY_RESULT: {
+      // Blocking query, waits for the GPU
+      obj->pending_polls = 0;
+      *params = static_cast<T>(obj->timestamp);
+    } break;
+    default: {
+      mock.push_error(GL_INVALID_ENUM);
+    } break;
+  }
+}
+
+MOCK_HANDLER(glGetQueryObjectiv) {
+  static void handle(gl_mock_state& mock, GLuint id, GLenum pname, GLint* params) {
+    query_object(mock, id, pname, params);
+  }
+};
+
+MOCK_HANDLER(glGetQueryObjectui64v) {
+  static void handle(gl_mock_state& mock, GLuint id, GLenum pname, GLuint64* params) {
+    query_object(mock, id, pname, params);
+  }
+};
+
+MOCK_HANDLER(glGenTextures) {
+  static void handle(gl_mock_state& mock, GLsizei n, GLuint* textures) {
+    gen_objects(mock, OBJECT_TEXTURE, n, textures);
+  }
+};
+
+MOCK_HANDLER(glDeleteTextures) {
+  static void handle(gl_mock_state& mock, GLsizei n, const GLuint* textures) {
+    delete_objects(mock, OBJECT_TEXTURE, n, textures);
+    for (GLsizei i = 0; i < n; ++i) {
+      mock.texture_handles.erase(texture_handle(textures[i]));
+    }
+  }
+};
+
+MOCK_HANDLER(glGetTextureHandleARB) {
+  static GLuint64 handle(gl_mock_state& mock, GLuint texture) {
+    if (!mock.named_object(texture, OBJECT_TEXTURE)) {
+      return 0;
+    }
+    const u64 handle = texture_handle(texture);
+    mock.texture_handles.try_emplace(handle, false);
+    return handle;
+  }
+};
+
+MOCK_HANDLER(glMakeTextureHandleResidentARB) {
+  static void handle(gl_mock_state& mock, GLuint64 handle) {
+    auto it = mock.texture_handles.find(handle);
+    if (it == mock.texture_handles.end() || it->second) {
+      mock.push_error(GL_INVALID_OPERATION);
+      return;
+    }
+    it->second = true;
+  }
+};
+
+MOCK_HANDLER(glMakeTextureHandleNonResidentARB) {
+  static void handle(gl_mock_state& mock, GLuint64 handle) {
+    auto it = mock.texture_handles.find(handle);
+    if (it == mock.texture_handles.end() || !it->second) {
+      mock.push_error(GL_INVALID_OPERATION);
+      return;
+    }
+    it->second = false;
+  }
+};
+
+MOCK_HANDLER(glBindTexture) {
+  static void handle(gl_mock_state& mock, GLenum, GLuint texture) {
+    mock.check_bind(texture, OBJECT_TEXTURE);
+  }
+};
+
+MOCK_HANDLER(glActiveTexture) {
+  static void handle(gl_mock_state& mock, GLenum texture) {
+    if (texture < GL_TEXTURE0) {
+      mock.push_error(GL_INVALID_ENUM);
+      return;
+    }
+    mock.active_unit = texture - GL_TEXTURE0;
+  }
+};
+
+MOCK_HANDLER(glGenSamplers) {
+  static void handle(gl_mock_state& mock, GLsizei n, GLuint* samplers) {
+    gen_objects(mock, OBJECT_SAMPLER, n, samplers);
+  }
+};
+
+MOCK_HANDLER(glDeleteSamplers) {
+  static void handle(gl_mock_state& mock, GLsizei n, const GLuint* samplers) {
+    delete_objects(mock, OBJECT_SAMPLER, n, samplers);
+  }
+};
+
+MOCK_HANDLER(glBindSampler) {
+  static void handle(gl_mock_state& mock, GLuint, GLuint sampler) {
+    mock.check_bind(sampler, OBJECT_SAMPLER);
+  }
+};
+
+MOCK_HANDLER(glSamplerParameteri) {
+  static void handle(gl_mock_state& mock, GLuint sampler, GLenum, GLint) {
+    if (!mock.find_object(sampler, OBJECT_SAMPLER)) {
+      mock.push_error(GL_INVALID_OPERATION);
+    }
+  }
+};
+
+MOCK_HANDLER(glSamplerParameterf) {
+  static void handle(gl_mock_state& mock, GLuint sampler, GLenum, GLfloat) {
+    if (!mock.find_object(sampler, OBJECT_SAMPLER)) {
+      mock.push_error(GL_INVALID_OPERATION);
+    }
+  }
+};
+
+MOCK_HANDLER(glGenBuffers) {
+  static void handle(gl_mock_state& mock, GLsizei n, GLuint* buffers) {
+    gen_objects(mock, OBJECT_BUFFER, n, buffers);
+  }
+};
+
+MOCK_HANDLER(glDeleteBuffers) {
+  static void handle(gl_mock_state& mock, GLsizei n, const GLuint* buffers) {
+    delete_objects(mock, OBJECT_BUFFER, n, buffers);
+  }
+};
+
+MOCK_HANDLER(glBindBuffer) {
+  static void handle(gl_mock_state& mock, GLenum target, GLuint buffer) {
+    if (mock.check_bind(buffer, OBJECT_BUFFER)) {
+      mock.buffer_binding(target) = buffer;
+    }
+  }
+};
+
+MOCK_HANDLER(glBindBufferRange) {
+  static void handle(gl_mock_state& mock, GLenum target, GLuint, GLuint buffer, GLintptr offset,
+                     GLsizeiptr size) {
+    if (!mock.check_bind(buffer, OBJECT_BUFFER)) {
+      return;
+    }
+    auto* obj = mock.find_object(buffer, OBJECT_BUFFER);
+    if (obj && (offset < 0 || size <= 0 || static_cast<size_t>(offset + size) > obj->storage.size())) {
+      mock.push_error(GL_INVALID_VALUE);
+      return;
+    }
+    mock.buffer_binding(target) = buffer;
+  }
+};
+
+// Buffer contents are shared by the bound target and named functions
+void buffer_data(gl_mock_state& mock, mock_object* obj, GLsizeiptr size, const void* data) {
+  if (!obj) {
+    return;
+  }
+  if (size < 0) {
+    mock.push_error(GL_INVALID_VALUE);
+    return;
+  }
+  obj->storage.assign(static_cast<size_t>(size), 0);
+  if (data) {
+    std::memcpy(obj->storage.data(), data, static_cast<size_t>(size));
+  }
+}
+
+u8* buffer_range(gl_mock_state& mock, mock_object* obj, GLintptr offset, GLsizeiptr size) {
+  if (!obj) {
+    return nullptr;
+  }
+  if (offset < 0 || size < 0 || static_cast<size_t>(offset + size) > obj->storage.size()) {
+    mock.push_error(GL_INVALID_VALUE);
+    return nullptr;
+  }
+  return obj->storage.data() + offset;
+}
+
+MOCK_HANDLER(glBufferData) {
+  static void handle(gl_mock_state& mock, GLenum target, GLsizeiptr size, const void* data,
+                     GLenum) {
+    buffer_data(mock, mock.bound_buffer(target), size, data);
+  }
+};
+
+MOCK_HANDLER(glBufferStorage) {
+  static void handle(gl_mock_state& mock, GLenum target, GLsizeiptr size, const void* data,
+                     GLbitfield) {
+    buffer_data(mock, mock.bound_buffer(target), size, data);
+  }
+};
+
+MOCK_HANDLER(glBufferSubData) {
+  static void handle(gl_mock_state& mock, GLenum target, GLintptr offset, GLsizeiptr size,
+                     const void* data) {
+    if (auto* dst = buffer_range(mock, mock.bound_buffer(target), offset, size)) {
+      std::memcpy(dst, data, static_cast<size_t>(size));
+    }
+  }
+};
+
+MOCK_HANDLER(glGetBufferSubData) {
+  static void handle(gl_mock_state& mock, GLenum target, GLintptr offset, GLsizeiptr size,
+                     void* data) {
+    if (const auto* src = buffer_range(mock, mock.bound_buffer(target), offset, size)) {
+      std::memcpy(data, src, static_cast<size_t>(size));
+    }
+  }
+};
+
+MOCK_HANDLER(glCreateBuffers) {
+  static void handle(gl_mock_state& mock, GLsizei n, GLuint* buffers) {
+    gen_objects(mock, OBJECT_BUFFER, n, buffers);
+  }
+};
+
+MOCK_HANDLER(glNamedBufferData) {
+  static void handle(gl_mock_state& mock, GLuint buffer, GLsizeiptr size, const void* data,
+                     GLenum) {
+    buffer_data(mock, mock.named_object(buffer, OBJECT_BUFFER), size, data);
+  }
+};
+
+MOCK_HANDLER(glNamedBufferStorage) {
+  static void handle(gl_mock_state& mock, GLuint buffer, GLsizeiptr size, const void* data,
+                     GLbitfield) {
+    buffer_data(mock, mock.named_object(buffer, OBJECT_BUFFER), size, data);
+  }
+};
+
+MOCK_HANDLER(glNamedBufferSubData) {
+  static void handle(gl_mock_state& mock, GLuint buffer, GLintptr offset, GLsizeiptr size,
+                     const void* data) {
+    if (auto* dst = buffer_range(mock, mock.named_object(buffer, OBJECT_BUFFER), offset, size)) {
+      std::memcpy(dst, data, static_cast<size_t>(size));
+    }
+  }
+};
+
+MOCK_HANDLER(glGetNamedBufferSubData) {
+  static void handle(gl_mock_state& mock, GLuint buffer, GLintptr offset, GLsizeiptr size,
+                     void* data) {
+    const auto* src = buffer_range(mock, mock.named_object(buffer, OBJECT_BUFFER), offset, size);
+    if (src) {
+      std::memcpy(data, src, static_cast<size_t>(size));
+    }
+  }
+};
+
+MOCK_HANDLER(glMapNamedBuffer) {
+  static void* handle(gl_mock_state& mock, GLuint buffer, GLenum) {
+    auto* obj = mock.named_object(buffer, OBJECT_BUFFER);
+    return obj ? obj->storage.data() : nullptr;
+  }
+};
+
+MOCK_HANDLER(glMapNamedBufferRange) {
+  static void* handle(gl_mock_state& mock, GLuint buffer, GLintptr offset, GLsizeiptr length,
+                      GLbitfield) {
+    if (length <= 0) {
+      mock.push_error(GL_INVALID_VALUE);
+      return nullptr;
+    }
+    return buffer_range(mock, mock.named_object(buffer, OBJECT_BUFFER), offset, length);
+  }
+};
+
+MOCK_HANDLER(glUnmapNamedBuffer) {
+  static GLboolean handle(gl_mock_state& mock, GLuint buffer) {
+    return mock.named_object(buffer, OBJECT_BUFFER) ? GL_TRUE : GL_FALSE;
+  }
+};
+
+void copy_buffer_range(gl_mock_state& mock, mock_object* src, mock_object* dst,
+                       GLintptr read_offset, GLintptr write_offset, GLsizeiptr size) {
+  if (!src || !dst) {
+    return;
+  }
+  if (read_offset < 0 || write_offset < 0 || size < 0 ||
+      static_cast<size_t>(read_offset + size) > src->storage.size() ||
+      static_cast<size_t>(write_offset + size) > dst->storage.size()) {
+    mock.push_error(GL_INVALID_VALUE);
+    return;
+  }
+  // Overlapping ranges within the same buffer are an error
+  if (src == dst && read_offset < write_offset + size && write_offset < read_offset + size) {
+    mock.push_error(GL_INVALID_VALUE);
+    return;
+  }
+  std::memcpy(dst->storage.data() + write_offset, src->storage.data() + read_offset,
+              static_cast<size_t>(size));
+}
+
+MOCK_HANDLER(glCopyBufferSubData) {
+  static void handle(gl_mock_state& mock, GLenum read_target, GLenum write_target,
+                     GLintptr read_offset, GLintptr write_offset, GLsizeiptr size) {
+    copy_buffer_range(mock, mock.bound_buffer(read_target), mock.bound_buffer(write_target),
+                      read_offset, write_offset, size);
+  }
+};
+
+MOCK_HANDLER(glCopyNamedBufferSubData) {
+  static void handle(gl_mock_state& mock, GLuint read_buffer, GLuint write_buffer,
+                     GLintptr read_offset, GLintptr write_offset, GLsizeiptr size) {
+    copy_buffer_range(mock, mock.named_object(read_buffer, OBJECT_BUFFER),
+                      mock.named_object(write_buffer, OBJECT_BUFFER), read_offset, write_offset,
+                      size);
+  }
+};
+
+MOCK_HANDLER(glMapBuffer) {
+  static void* handle(gl_mock_state& mock, GLenum target, GLenum) {
+    auto* obj = mock.bound_buffer(target);
+    return obj ? obj->storage.data() : nullptr;
+  }
+};
+
+MOCK_HANDLER(glMapBufferRange) {
+  static void* handle(gl_mock_state& mock, GLenum target, GLintptr offset, GLsizeiptr length,
+                      GLbitfield) {
+    auto* obj = mock.bound_buffer(target);
+    if (!obj) {
+      return nullptr;
+    }
+    if (offset < 0 || length <= 0 || static_cast<size_t>(offset + length) > obj->storage.size()) {
+      mock.push_error(GL_INVALID_VALUE);
+      return nullptr;
+    }
+    return obj->storage.data() + offset;
+  }
+};
+
+MOCK_HANDLER(glGenRenderbuffers) {
+  static void handle(gl_mock_state& mock, GLsizei n, GLuint* renderbuffers) {
+    gen_objects(mock, OBJECT_RENDERBUFFER, n, renderbuffers);
+  }
+};
+
+MOCK_HANDLER(glDeleteRenderbuffers) {
+  static void handle(gl_mock_state& mock, GLsizei n, const GLuint* renderbuffers) {
+    delete_objects(mock, OBJECT_RENDERBUFFER, n, renderbuffers);
+  }
+};
+
+MOCK_HANDLER(glBindRenderbuffer) {
+  static void handle(gl_mock_state& mock, GLenum, GLuint renderbuffer) {
+    mock.check_bind(renderbuffer, OBJECT_RENDERBUFFER);
+  }
+};
+
+MOCK_HANDLER(glGenFramebuffers) {
+  static void handle(gl_mock_state& mock, GLsizei n, GLuint* framebuffers) {
+    gen_objects(mock, OBJECT_FRAMEBUFFER, n, framebuffers);
+  }
+};
+
+MOCK_HANDLER(glDeleteFramebuffers) {
+  static void handle(gl_mock_state& mock, GLsizei n, GLuint* framebuffers) {
+    delete_objects(mock, OBJECT_FRAMEBUFFER, n, framebuffers);
+  }
+};
+
+MOCK_HANDLER(glBindFramebuffer) {
+  static void handle(gl_mock_state& mock, GLenum, GLuint framebuffer) {
+    mock.check_bind(framebuffer, OBJECT_FRAMEBUFFER);
+  }
+};
+
+MOCK_HANDLER(glCheckFramebufferStatus) {
+  static GLenum handle(gl_mock_state&, GLenum) { return FRAMEBUFFER_COMPLETE; }
+};
+
+MOCK_HANDLER(glCreateTextures) {
+  static void handle(gl_mock_state& mock, GLenum, GLsizei n, GLuint* textures) {
+    gen_objects(mock, OBJECT_TEXTURE, n, textures);
+  }
+};
+
+MOCK_HANDLER(glCreateRenderbuffers) {
+  static void handle(gl_mock_state& mock, GLsizei n, GLuint* renderbuffers) {
+    gen_objects(mock, OBJECT_RENDERBUFFER, n, renderbuffers);
+  }
+};
+
+MOCK_HANDLER(glCreateFramebuffers) {
+  static void handle(gl_mock_state& mock, GLsizei n, GLuint* framebuffers) {
+    gen_objects(mock, OBJECT_FRAMEBUFFER, n, framebuffers);
+  }
+};
+
+MOCK_HANDLER(glCheckNamedFramebufferStatus) {
+  static GLenum handle(gl_mock_state& mock, GLuint framebuffer, GLenum) {
+    return mock.named_object(framebuffer, OBJECT_FRAMEBUFFER) ? FRAMEBUFFER_COMPLETE : 0;
+  }
+};
+
+// Named functions that only need their object to exist
+#define MOCK_NAMED_FUNC(name_, kind_)                                    \
+  MOCK_HANDLER(name_) {                                                  \
+    template<typename... Args>                                           \
+    static void handle(gl_mock_state& mock, GLuint name, Args...) {      \
+      mock.named_object(name, kind_);                                    \
+    }                                                                    \
+  };
+
+MOCK_NAMED_FUNC(glTextureStorage1D, OBJECT_TEXTURE)
+MOCK_NAMED_FUNC(glTextureStorage2D, OBJECT_TEXTURE)
+MOCK_NAMED_FUNC(glTextureStorage2DMultisample, OBJECT_TEXTURE)
+MOCK_NAMED_FUNC(glTextureStorage3D, OBJECT_TEXTURE)
+MOCK_NAMED_FUNC(glTextureStorage3DMultisample, OBJECT_TEXTURE)
+MOCK_NAMED_FUNC(glTextureSubImage1D, OBJECT_TEXTURE)
+MOCK_NAMED_FUNC(glTextureSubImage2D, OBJECT_TEXTURE)
+MOCK_NAMED_FUNC(glTextureSubImage3D, OBJECT_TEXTURE)
+MOCK_NAMED_FUNC(glCompressedTextureSubImage2D, OBJECT_TEXTURE)
+MOCK_NAMED_FUNC(glCompressedTextureSubImage3D, OBJECT_TEXTURE)
+MOCK_NAMED_FUNC(glTextureBufferRange, OBJECT_TEXTURE)
+MOCK_NAMED_FUNC(glTextureParameteri, OBJECT_TEXTURE)
+MOCK_NAMED_FUNC(glGenerateTextureMipmap, OBJECT_TEXTURE)
+MOCK_NAMED_FUNC(glNamedRenderbufferStorage, OBJECT_RENDERBUFFER)
+MOCK_NAMED_FUNC(glNamedFramebufferTexture, OBJECT_FRAMEBUFFER)
+MOCK_NAMED_FUNC(glNamedFramebufferTextureLayer, OBJECT_FRAMEBUFFER)
+MOCK_NAMED_FUNC(glNamedFramebufferRenderbuffer, OBJECT_FRAMEBUFFER)
+MOCK_NAMED_FUNC(glInvalidateNamedFramebufferData, OBJECT_FRAMEBUFFER)
+MOCK_NAMED_FUNC(glNamedFramebufferDrawBuffers, OBJECT_FRAMEBUFFER)
+MOCK_NAMED_FUNC(glEnableVertexArrayAttrib, OBJECT_VERTEX_ARRAY)
+MOCK_NAMED_FUNC(glVertexArrayAttribFormat, OBJECT_VERTEX_ARRAY)
+MOCK_NAMED_FUNC(glVertexArrayAttribIFormat, OBJECT_VERTEX_ARRAY)
+MOCK_NAMED_FUNC(glVertexArrayAttribLFormat, OBJECT_VERTEX_ARRAY)
+MOCK_NAMED_FUNC(glVertexArrayAttribBinding, OBJECT_VERTEX_ARRAY)
+MOCK_NAMED_FUNC(glVertexArrayVertexBuffers, OBJECT_VERTEX_ARRAY)
+
+#undef MOCK_NAMED_FUNC
+
+MOCK_HANDLER(glCreateVertexArrays) {
+  static void handle(gl_mock_state& mock, GLsizei n, GLuint* arrays) {
+    gen_objects(mock, OBJECT_VERTEX_ARRAY, n, arrays);
+  }
+};
+
+MOCK_HANDLER(glDeleteVertexArrays) {
+  static void handle(gl_mock_state& mock, GLsizei n, const GLuint* arrays) {
+    delete_objects(mock, OBJECT_VERTEX_ARRAY, n, arrays);
+  }
+};
+
+MOCK_HANDLER(glBindVertexArray) {
+  static void handle(gl_mock_state& mock, GLenum array) {
+    if (mock.check_bind(array, OBJECT_VERTEX_ARRAY)) {
+      mock.vao = array;
+    }
+  }
+};
+
+MOCK_HANDLER(glCreateShader) {
+  static GLuint handle(gl_mock_state& mock, GLenum) { return mock.alloc_object(OBJECT_SHADER); }
+};
+
+MOCK_HANDLER(glDeleteShader) {
+  static void handle(gl_mock_state& mock, GLuint shader) {
+    mock.free_object(shader, OBJECT_SHADER);
+  }
+};
+
+MOCK_HANDLER(glShaderSource) {
+  static void handle(gl_mock_state& mock, GLuint shader, GLsizei count, const GLchar* const* str,
+                     const GLint* length) {
+    auto* obj = mock.find_object(shader, OBJECT_SHADER);
+    if (!obj) {
+      mock.push_error(GL_INVALID_VALUE);
+      return;
+    }
+    obj->source.clear();
+    for (GLsizei i = 0; i < count; ++i) {
+      if (length && length[i] >= 0) {
+        obj->source.append(str[i], static_cast<size_t>(length[i]));
+      } else {
+        obj->source.append(str[i]);
+      }
+    }
+  }
+};
+
+// Sources with an #error directive fail to compile
+MOCK_HANDLER(glCompileShader) {
+  static void handle(gl_mock_state& mock, GLuint shader) {
+    auto* obj = mock.find_object(shader, OBJECT_SHADER);
+    if (!obj) {
+      mock.push_error(GL_INVALID_VALUE);
+      return;
+    }
+    obj->status = obj->source.find("#error") == std::string::npos ? GL_TRUE : GL_FALSE;
+    obj->pending_polls = mock.compile_latency;
+  }
+};
+
+MOCK_HANDLER(glCreateProgram) {
+  static GLuint handle(gl_mock_state& mock) { return mock.alloc_object(OBJECT_PROGRAM); }
+};
+
+MOCK_HANDLER(glDeleteProgram) {
+  static void handle(gl_mock_state& mock, GLuint program) {
+    mock.free_object(program, OBJECT_PROGRAM);
+  }
+};
+
+MOCK_HANDLER(glAttachShader) {
+  static void handle(gl_mock_state& mock, GLuint program, GLuint shader) {
+    auto* obj = mock.find_object(program, OBJECT_PROGRAM);
+    if (!obj || !mock.find_object(shader, OBJECT_SHADER)) {
+      mock.push_error(GL_INVALID_VALUE);
+      return;
+    }
+    obj->attached.emplace_back(shader);
+  }
+};
+
+MOCK_HANDLER(glDetachShader) {
+  static void handle(gl_mock_state& mock, GLuint program, GLuint shader) {
+    auto* obj = mock.find_object(program, OBJECT_PROGRAM);
+    if (!obj) {
+      mock.push_error(GL_INVALID_VALUE);
+      return;
+    }
+    std::erase(obj->attached, shader);
+  }
+};
+
+MOCK_HANDLER(glUseProgram) {
+  static void handle(gl_mock_state& mock, GLenum program) {
+    mock.check_bind(program, OBJECT_PROGRAM);
+  }
+};
+
+MOCK_HANDLER(glGetShaderiv) {
+  static void handle(gl_mock_state& mock, GLuint shader, GLenum pname, GLint* params) {
+    if (!mock.find_object(shader, OBJECT_SHADER)) {
+      mock.push_error(GL_INVALID_VALUE);
+      return;
+    }
+    auto* obj = mock.find_object(shader, OBJECT_SHADER);
+    switch (pname) {
+      case GL_COMPILE_STATUS: {
+        // Blocking query, waits for the compiler
+        obj->pending_polls = 0;
+        *params = obj->status;
+      } break;
+      case GL_COMPLETION_STATUS_KHR: {
+        *params = obj->pending_polls ? GL_FALSE : GL_TRUE;
+        obj->pending_polls -= obj->pending_polls ? 1 : 0;
+      } break;
+      default: {
+        *params = 0;
+      } break;
+    }
+  }
+};
+
+void write_info_log(const mock_object* obj, std::string_view msg, GLsizei buf_size,
+                    GLsizei* length, GLchar* log) {
+  if (obj && obj->status) {
+    msg = {};
+  }
+  const auto len = std::min(static_cast<GLsizei>(msg.size()), std::max(buf_size - 1, 0));
+  if (length) {
+    *length = len;
+  }
+  if (buf_size > 0) {
+    std::memcpy(log, msg.data(), static_cast<size_t>(len));
+    log[len] = '\0';
+  }
+}
+
+MOCK_HANDLER(glGetShaderInfoLog) {
+  static void handle(gl_mock_state& mock, GLuint shader, GLsizei buf_size, GLsizei* length,
+                     GLchar* log) {
+    write_info_log(mock.find_object(shader, OBJECT_SHADER), "0:1: #error directive", buf_size,
+                   length, log);
+  }
+};
+
+MOCK_HANDLER(glGetProgramInfoLog) {
+  static void handle(gl_mock_state& mock, GLuint program, GLsizei buf_size, GLsizei* length,
+                     GLchar* log) {
+    write_info_log(mock.find_object(program, OBJECT_PROGRAM), "attached shader failed to compile",
+                   buf_size, length, log);
+  }
+};
+
+MOCK_HANDLER(glGetProgramiv) {
+  static void handle(gl_mock_state& mock, GLuint program, GLenum pname, GLint* params) {
+    if (!mock.find_object(program, OBJECT_PROGRAM)) {
+      mock.push_error(GL_INVALID_VALUE);
+      return;
+    }
+    switch (pname) {
+      case GL_LINK_STATUS: {
+        auto* obj = mock.find_object(program, OBJECT_PROGRAM);
+        obj->pending_polls = 0;
+        *params = obj->status;
+      } break;
+      case GL_COMPLETION_STATUS_KHR: {
+        auto* obj = mock.find_object(program, OBJECT_PROGRAM);
+        *params = obj->pending_polls ? GL_FALSE : GL_TRUE;
+        obj->pending_polls -= obj->pending_polls ? 1 : 0;
+      } break;
+      case GL_PROGRAM_BINARY_LENGTH: {
+        *params = static_cast<GLint>(MOCK_BINARY_MAGIC.size());
+      } break;
+      case GL_ACTIVE_UNIFORM_BLOCKS: {
+        *params = static_cast<GLint>(mock.find_object(program, OBJECT_PROGRAM)->blocks.size());
+      } break;
+      default: {
+        *params = 0;
+      } break;
+    }
+  }
+};
+
+MOCK_HANDLER(glLinkProgram) {
+  static void handle(gl_mock_state& mock, GLuint program) {
+    auto* obj = mock.find_object(program, OBJECT_PROGRAM);
+    if (!obj) {
+      mock.push_error(GL_INVALID_VALUE);
+      return;
+    }
+    obj->status = GL_TRUE;
+    obj->pending_polls = mock.compile_latency;
+    obj->blocks.clear();
+    for (const GLuint shader : obj->attached) {
+      if (const auto* shader_obj = mock.find_object(shader, OBJECT_SHADER)) {
+        obj->status &= shader_obj->status;
+        parse_uniform_blocks(shader_obj->source, obj->blocks);
+      }
+    }
+  }
+};
+
+// Binaries are a fixed magic string, anything else fails to link
+MOCK_HANDLER(glGetProgramBinary) {
+  static void handle(gl_mock_state& mock, GLuint program, GLsizei buf_size, GLsizei* length,
+                     GLenum* format, void* binary) {
+    if (!mock.find_object(program, OBJECT_PROGRAM)) {
+      mock.push_error(GL_INVALID_VALUE);
+      return;
+    }
+    if (buf_size < static_cast<GLsizei>(MOCK_BINARY_MAGIC.size())) {
+      mock.push_error(GL_INVALID_OPERATION);
+      return;
+    }
+    std::memcpy(binary, MOCK_BINARY_MAGIC.data(), MOCK_BINARY_MAGIC.size());
+    *format = MOCK_BINARY_FORMAT;
+    if (length) {
+      *length = static_cast<GLsizei>(MOCK_BINARY_MAGIC.size());
+    }
+  }
+};
+
+MOCK_HANDLER(glProgramBinary) {
+  static void handle(gl_mock_state& mock, GLuint program, GLenum format, const void* binary,
+                     GLsizei length) {
+    auto* obj = mock.find_object(program, OBJECT_PROGRAM);
+    if (!obj) {
+      mock.push_error(GL_INVALID_VALUE);
+      return;
+    }
+    if (format != MOCK_BINARY_FORMAT) {
+      mock.push_error(GL_INVALID_ENUM);
+      return;
+    }
+    const std::string_view data{static_cast<const char*>(binary), static_cast<size_t>(length)};
+    obj->status = data == MOCK_BINARY_MAGIC ? GL_TRUE : GL_FALSE;
+  }
+};
+
+MOCK_HANDLER(glGetUniformLocation) {
+  static GLint handle(gl_mock_state&, GLuint, const char* name) { return fake_location(name); }
+};
+
+MOCK_HANDLER(glGetAttribLocation) {
+  static GLint handle(gl_mock_state&, GLuint, const char* name) { return fake_location(name); }
+};
+
+// Uniform indices are flattened over the members of every block, in block order
+const mock_block_member* find_block_member(const mock_object& program, GLuint index) {
+  for (const auto& block : program.blocks) {
+    if (index < block.members.size()) {
+      return &block.members[index];
+    }
+    index -= static_cast<GLuint>(block.members.size());
+  }
+  return nullptr;
+}
+
+void copy_mock_name(std::string_view name, GLsizei buf_size, GLsizei* length, GLchar* out) {
+  if (buf_size <= 0) {
+    return;
+  }
+  const size_t len = std::min(name.size(), static_cast<size_t>(buf_size - 1));
+  std::memcpy(out, name.data(), len);
+  out[len] = '\0';
+  if (length) {
+    *length = static_cast<GLsizei>(len);
+  }
+}
+
+MOCK_HANDLER(glGetUniformBlockIndex) {
+  static GLuint handle(gl_mock_state& mock, GLuint program, const GLchar* name) {
+    const auto* obj = mock.find_object(program, OBJECT_PROGRAM);
+    if (!obj) {
+      mock.push_error(GL_INVALID_VALUE);
+      return GL_INVALID_INDEX;
+    }
+    for (GLuint i = 0; i < obj->blocks.size(); ++i) {
+      if (obj->blocks[i].name == name) {
+        return i;
+      }
+    }
+    return GL_INVALID_INDEX;
+  }
+};
+
+MOCK_HANDLER(glGetActiveUniformBlockiv) {
+  static void handle(gl_mock_state& mock, GLuint program, GLuint block_idx, GLenum pname,
+                     GLint* params) {
+    const auto* obj = mock.find_object(program, OBJECT_PROGRAM);
+    if (!obj || block_idx >= obj->blocks.size()) {
+      mock.push_error(GL_INVALID_VALUE);
+      return;
+    }
+    const auto& block = obj->blocks[block_idx];
+    switch (pname) {
+      case GL_UNIFORM_BLOCK_BINDING: {
+        *params = static_cast<GLint>(block.binding);
+      } break;
+      case GL_UNIFORM_BLOCK_DATA_SIZE: {
+        *params = block.data_size;
+      } break;
+      case GL_UNIFORM_BLOCK_NAME_LENGTH: {
+        *params = static_cast<GLint>(block.name.size() + 1);
+      } break;
+      case GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS: {
+        *params = static_cast<GLint>(block.members.size());
+      } break;
+      case GL_UNIFORM_BLOCK_ACTIVE_UNIFORM_INDICES: {
+        GLint base = 0;
+        for (GLuint i = 0; i < block_idx; ++i) {
+          base += static_cast<GLint>(obj->blocks[i].members.size());
+        }
+        for (size_t i = 0; i < block.members.size(); ++i) {
+          params[i] = base + static_cast<GLint>(i);
+        }
+      } break;
+      default: {
+        mock.push_error(GL_INVALID_ENUM);
+      } break;
+    }
+  }
+};
+
+MOCK_HANDLER(glGetActiveUniformBlockName) {
+  static void handle(gl_mock_state& mock, GLuint program, GLuint block_idx, GLsizei buf_size,
+                     GLsizei* length, GLchar* name) {
+    const auto* obj = mock.find_object(program, OBJECT_PROGRAM);
+    if (!obj || block_idx >= obj->blocks.size()) {
+      mock.push_error(GL_INVALID_VALUE);
+      return;
+    }
+    copy_mock_name(obj->blocks[block_idx].name, buf_size, length, name);
+  }
+};
+
+MOCK_HANDLER(glGetActiveUniformsiv) {
+  static void handle(gl_mock_state& mock, GLuint program, GLsizei count, const GLuint* indices,
+                     GLenum pname, GLint* params) {
+    const auto* obj = mock.find_object(program, OBJECT_PROGRAM);
+    if (!obj) {
+      mock.push_error(GL_INVALID_VALUE);
+      return;
+    }
+    for (GLsizei i = 0; i < count; ++i) {
+      const auto* member = find_block_member(*obj, indices[i]);
+      if (!member) {
+        mock.push_error(GL_INVALID_VALUE);
+        return;
+      }
+      switch (pname) {
+        case GL_UNIFORM_TYPE: {
+          params[i] = static_cast<GLint>(member->type);
+        } break;
+        case GL_UNIFORM_SIZE: {
+          params[i] = member->size;
+        } break;
+        case GL_UNIFORM_OFFSET: {
+          params[i] = member->offset;
+        } break;
+        case GL_UNIFORM_ARRAY_STRIDE: {
+          params[i] = member->array_stride;
+        } break;
+        case GL_UNIFORM_MATRIX_STRIDE: {
+          params[i] = member->matrix_stride;
+        } break;
+        default: {
+          mock.push_error(GL_INVALID_ENUM);
+          return;
+        }
+      }
+    }
+  }
+};
+
+MOCK_HANDLER(glGetActiveUniformName) {
+  static void handle(gl_mock_state& mock, GLuint program, GLuint index, GLsizei buf_size,
+                     GLsizei* length, GLchar* name) {
+    const auto* obj = mock.find_object(program, OBJECT_PROGRAM);
+    const auto* member = obj ? find_block_member(*obj, index) : nullptr;
+    if (!member) {
+      mock.push_error(GL_INVALID_VALUE);
+      return;
+    }
+    copy_mock_name(member->name, buf_size, length, name);
+  }
+};
+
+MOCK_HANDLER(glUniformBlockBinding) {
+  static void handle(gl_mock_state& mock, GLuint program, GLuint block_idx, GLuint binding) {
+    auto* obj = mock.find_object(program, OBJECT_PROGRAM);
+    if (!obj || block_idx >= obj->blocks.size()) {
+      mock.push_error(GL_INVALID_VALUE);
+      return;
+    }
+    obj->blocks[block_idx].binding = binding;
+  }
+};
+
+#undef MOCK_HANDLER
+
+#define MOCK_FUNC_PROC(name_, ...) \
+  reinterpret_cast<void*>(&mock_stub<MOCK_FUNC_##name_, PFN_shogle_##name_>::call),
+
+const std::array<void*, MOCK_FUNC_COUNT> mock_procs{MOCK_DOFUNCS(MOCK_FUNC_PROC)};
+
+#undef MOCK_FUNC_PROC
+#undef MOCK_DOFUNCS
+
+optional<u32> find_func(std::string_view name) {
+  for (u32 i = 0; i < mock_func_names.size(); ++i) {
+    if (mock_func_names[i] == name) {
+      return i;
+    }
+  }
+  return nullopt;
+}
+
+} // namespace
+
+gl_mock_provider::gl_mock_provider(extent2d extent, gl_version version) :
+    _state(std::make_unique<gl_mock_state>(extent, version)) {
+  make_current();
+}
+
+gl_mock_provider::gl_mock_provider(gl_mock_provider&& other) noexcept = default;
+
+gl_mock_provider& gl_mock_provider::operator=(gl_mock_provider&& other) noexcept {
+  if (_state && current_mock == _state.get()) {
+    current_mock = nullptr;
+  }
+  _state = std::move(other._state);
+  return *this;
+}
+
+gl_mock_provider::~gl_mock_provider() noexcept {
+  if (_state && current_mock == _state.get()) {
+    current_mock = nullptr;
+  }
+}
+
+void* gl_mock_provider::gl_get_proc(const char* name) noexcept {
+  SHOGLE_ASSERT(_state, "gl_mock_provider use after move");
+  const auto func = find_func(name);
+  if (!func) {
+    return nullptr;
+  }
+  return mock_procs[*func];
+}
+
+extent2d gl_mock_provider::surface_extent() const noexcept {
+  SHOGLE_ASSERT(_state, "gl_mock_provider use after move");
+  return _state->extent;
+}
+
+void gl_mock_provider::make_current() noexcept {
+  SHOGLE_ASSERT(_state, "gl_mock_provider use after move");
+  current_mock = _state.get();
+}
+
+void gl_mock_provider::set_surface_extent(extent2d extent) noexcept {
+  SHOGLE_ASSERT(_state, "gl_mock_provider use after move");
+  _state->extent = extent;
+}
+
+void gl_mock_provider::push_error(gldefs::GLenum err) noexcept {
+  SHOGLE_ASSERT(_state, "gl_mock_provider use after move");
+  _state->push_error(err);
+}
+
+void gl_mock_provider::set_fence_latency(u32 polls) noexcept {
+  SHOGLE_ASSERT(_state, "gl_mock_provider use after move");
+  _state->fence_latency = polls;
+}
+
+void gl_mock_provider::set_compile_latency(u32 polls) noexcept {
+  SHOGLE_ASSERT(_state, "gl_mock_provider use after move");
+  _state->compile_latency = polls;
+}
+
+void gl_mock_provider::set_query_latency(u32 polls) noexcept {
+  SHOGLE_ASSERT(_state, "gl_mock_provider use after move");
+  _state->query_latency = polls;
+}
+
+void gl_mock_provider::disable_extension(std::string_view name) noexcept {
+  SHOGLE_ASSERT(_state, "gl_mock_provider use after move");
+  std::erase(_state->extensions, name);
+}
+
+void gl_mock_provider::reset_stats() noexcept {
+  SHOGLE_ASSERT(_state, "gl_mock_provider use after move");
+  _state->stats = {};
+  _state->call_counts.fill(0);
+  _state->trace.clear();
+}
+
+auto gl_mock_provider::stats() const noexcept -> call_stats {
+  SHOGLE_ASSERT(_state, "gl_mock_provider use after move");
+  return _state->stats;
+}
+
+u64 gl_mock_provider::call_count(std::string_view func) const noexcept {
+  SHOGLE_ASSERT(_state, "gl_mock_provider use after move");
+  const auto idx = find_func(func);
+  return idx ? _state->call_counts[*idx] : 0;
+}
+
+u32 gl_mock_provider::live_objects() const noexcept {
+  SHOGLE_ASSERT(_state, "gl_mock_provider use after move");
+  return static_cast<u32>(_state->objects.size() + _state->fences.size());
+}
+
+span<const u8> gl_mock_provider::trace() const noexcept {
+  SHOGLE_ASSERT(_state, "gl_mock_provider use after move");
+  return {_state->trace.data(), _state->trace.size()};
+}
+
+void gl_mock_provider::decode_trace(trace_callback callback) const {
+  SHOGLE_ASSERT(_state, "gl_mock_provider use after move");
+  const auto& trace = _state->trace;
+  size_t pos = 0;
+  const auto read_varint = [&]() -> u64 {
+    u64 value = 0;
+    u32 shift = 0;
+    while (pos < trace.size()) {
+      const u8 byte = trace[pos++];
+      value |= static_cast<u64>(byte & 0x7F) << shift;
+      if (!(byte & 0x80)) {
+        break;
+      }
+      shift += 7;
+    }
+    return value;
+  };
+
+  std::array<u64, MAX_TRACE_ARGS> args;
+  while (pos < trace.size()) {
+    const u64 func = read_varint();
+    const u64 argc = read_varint();
+    SHOGLE_ASSERT(func < MOCK_FUNC_COUNT && argc <= MAX_TRACE_ARGS, "Corrupted GL trace");
+    for (u64 i = 0; i < argc; ++i) {
+      args[i] = read_varint();
+    }
+    callback(mock_func_names[func], {args.data(), static_cast<size_t>(argc)});
+  }
+}
+
+} // namespace shogle
+
+#endif
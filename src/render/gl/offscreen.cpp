@@ -0,0 +1,613 @@
+#include <shogle/render/gl/loader.h>
+#include <shogle/render/gl/offscreen.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <limits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <dlfcn.h>
+#define SHOGLE_OFFSCREEN_HAS_DLOPEN 1
+#else
+#define SHOGLE_OFFSCREEN_HAS_DLOPEN 0
+#endif
+
+#if !defined(SHOGLE_USE_SYSTEM_GL) || !SHOGLE_USE_SYSTEM_GL
+
+namespace shogle {
+
+namespace {
+
+// Only what the provider itself needs, the context loads the rest
+#define OFFSCREEN_DOFUNCS(X)                                                                 \
+  X(glGetError) X(glGetIntegerv) X(glPixelStorei) X(glReadPixels) X(glGenFramebuffers)       \
+  X(glDeleteFramebuffers) X(glBindFramebuffer) X(glCheckFramebufferStatus)                   \
+  X(glFramebufferRenderbuffer) X(glGenRenderbuffers) X(glDeleteRenderbuffers)                \
+  X(glBindRenderbuffer) X(glRenderbufferStorage) X(glGenBuffers) X(glDeleteBuffers)          \
+  X(glBindBuffer) X(glBufferData) X(glMapBufferRange) X(glUnmapBuffer) X(glFenceSync)        \
+  X(glClientWaitSync) X(glDeleteSync)
+
+#define OFFSCREEN_DEFPROC(name_) PFN_shogle_##name_ name_;
+struct offscreen_functions {
+  OFFSCREEN_DOFUNCS(OFFSCREEN_DEFPROC)
+};
+#undef OFFSCREEN_DEFPROC
+
+// Just enough of EGL and OSMesa to make a context, no headers needed at build time
+using EGLDisplay = void*;
+using EGLConfig = void*;
+using EGLContext = void*;
+using EGLSurface = void*;
+using EGLint = i32;
+using EGLBoolean = u32;
+using EGLenum = u32;
+
+constexpr EGLint EGL_NONE = 0x3038;
+constexpr EGLint EGL_EXTENSIONS = 0x3055;
+constexpr EGLint EGL_RENDERABLE_TYPE = 0x3040;
+constexpr EGLint EGL_SURFACE_TYPE = 0x3033;
+constexpr EGLint EGL_OPENGL_BIT = 0x0008;
+constexpr EGLenum EGL_OPENGL_API = 0x30A2;
+constexpr EGLint EGL_CONTEXT_MAJOR_VERSION = 0x3098;
+constexpr EGLint EGL_CONTEXT_MINOR_VERSION = 0x30FB;
+constexpr EGLint EGL_CONTEXT_OPENGL_PROFILE_MASK = 0x30FD;
+constexpr EGLint EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT = 0x0001;
+constexpr EGLint EGL_CONTEXT_OPENGL_DEBUG = 0x31B0;
+constexpr EGLenum EGL_PLATFORM_SURFACELESS_MESA = 0x31DD;
+
+struct egl_functions {
+  void* (*GetProcAddress)(const char* name);
+  const char* (*QueryString)(EGLDisplay dpy, EGLint name);
+  EGLDisplay (*GetDisplay)(void* native);
+  EGLDisplay (*GetPlatformDisplayEXT)(EGLenum platform, void* native, const EGLint* attribs);
+  EGLBoolean (*Initialize)(EGLDisplay dpy, EGLint* major, EGLint* minor);
+  EGLBoolean (*BindAPI)(EGLenum api);
+  EGLBoolean (*ChooseConfig)(EGLDisplay dpy, const EGLint* attribs, EGLConfig* configs,
+                             EGLint size, EGLint* count);
+  EGLContext (*CreateContext)(EGLDisplay dpy, EGLConfig config, EGLContext share,
+                              const EGLint* attribs);
+  EGLBoolean (*DestroyContext)(EGLDisplay dpy, EGLContext ctx);
+  EGLBoolean (*MakeCurrent)(EGLDisplay dpy, EGLSurface draw, EGLSurface read, EGLContext ctx);
+};
+
+using OSMesaContext = void*;
+
+constexpr int OSMESA_FORMAT = 0x22;
+constexpr int OSMESA_DEPTH_BITS = 0x30;
+constexpr int OSMESA_STENCIL_BITS = 0x31;
+constexpr int OSMESA_PROFILE = 0x33;
+constexpr int OSMESA_CORE_PROFILE = 0x34;
+constexpr int OSMESA_CONTEXT_MAJOR_VERSION = 0x36;
+constexpr int OSMESA_CONTEXT_MINOR_VERSION = 0x37;
+
+struct osmesa_functions {
+  OSMesaContext (*CreateContextAttribs)(const int* attribs, OSMesaContext share);
+  void (*DestroyContext)(OSMesaContext ctx);
+  u8 (*MakeCurrent)(OSMesaContext ctx, void* buffer, GLenum type, GLsizei width, GLsizei height);
+  void* (*GetProcAddress)(const char* name);
+};
+
+void* open_library(std::initializer_list<const char*> names) noexcept {
+#if SHOGLE_OFFSCREEN_HAS_DLOPEN
+  for (const char* name : names) {
+    // Never closed, drivers don't like being unloaded while the process is still running
+    if (void* lib = dlopen(name, RTLD_NOW | RTLD_LOCAL)) {
+      return lib;
+    }
+  }
+#else
+  SHOGLE_UNUSED(names);
+#endif
+  return nullptr;
+}
+
+template<typename F>
+bool load_symbol(void* lib, F& func, const char* name) noexcept {
+#if SHOGLE_OFFSCREEN_HAS_DLOPEN
+  func = reinterpret_cast<F>(dlsym(lib, name));
+#else
+  SHOGLE_UNUSED(lib);
+  SHOGLE_UNUSED(name);
+  func = nullptr;
+#endif
+  return func != nullptr;
+}
+
+bool has_extension(const char* extensions, std::string_view name) noexcept {
+  if (!extensions) {
+    return false;
+  }
+  std::string_view list{extensions};
+  while (!list.empty()) {
+    const size_t end = std::min(list.find(' '), list.size());
+    if (list.substr(0, end) == name) {
+      return true;
+    }
+    list.remove_prefix(std::min(end + 1, list.size()));
+  }
+  return false;
+}
+
+} // namespace
+
+struct gl_offscreen_state {
+  struct readback_slot {
+    GLuint pbo;
+    size_t size;
+    GLsync fence;
+  };
+
+  gl_offscreen_provider::platform_backend backend{gl_offscreen_provider::BACKEND_AUTO};
+  egl_functions egl{};
+  EGLDisplay display{nullptr};
+  EGLContext egl_context{nullptr};
+  osmesa_functions osmesa{};
+  OSMesaContext osmesa_context{nullptr};
+  // OSMesa wants a color buffer to make a context current, frames never touch it
+  u32 osmesa_pixel{0};
+
+  offscreen_functions gl{};
+  bool gl_loaded{false};
+  extent2d extent{0, 0};
+  GLuint fbo{0};
+  GLuint color_rbo{0};
+  GLuint depth_rbo{0};
+
+  readback_slot slots[gl_offscreen_provider::READBACK_SLOTS]{};
+  u32 slot_head{0};
+  u32 slot_count{0};
+
+  ~gl_offscreen_state() noexcept;
+
+  void* get_proc(const char* name) const noexcept {
+    if (backend == gl_offscreen_provider::BACKEND_EGL) {
+      return egl.GetProcAddress(name);
+    }
+    return osmesa.GetProcAddress(name);
+  }
+
+  void make_current() noexcept {
+    if (backend == gl_offscreen_provider::BACKEND_EGL) {
+      egl.MakeCurrent(display, nullptr, nullptr, egl_context);
+    } else if (backend == gl_offscreen_provider::BACKEND_OSMESA) {
+      osmesa.MakeCurrent(osmesa_context, &osmesa_pixel, GL_UNSIGNED_BYTE, 1, 1);
+    }
+  }
+
+  size_t frame_size() const noexcept {
+    return size_t{extent.width} * extent.height * gl_offscreen_provider::PIXEL_SIZE;
+  }
+
+  void drop_readbacks() noexcept {
+    for (u32 i = 0; i < slot_count; ++i) {
+      auto& slot = slots[(slot_head + i) % gl_offscreen_provider::READBACK_SLOTS];
+      gl.glDeleteSync(slot.fence);
+      slot.fence = nullptr;
+    }
+    slot_head = 0;
+    slot_count = 0;
+  }
+};
+
+namespace {
+
+// Raw calls behind the back of any gl_context, bindings get restored afterwards
+struct offscreen_bindings {
+  offscreen_bindings(const offscreen_functions& gl_) noexcept : gl(gl_) {
+    gl.glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &read_fbo);
+    gl.glGetIntegerv(GL_RENDERBUFFER_BINDING, &rbo);
+    gl.glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &pack_buffer);
+    gl.glGetIntegerv(GL_PACK_ALIGNMENT, &pack_alignment);
+  }
+
+  ~offscreen_bindings() noexcept {
+    gl.glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(read_fbo));
+    gl.glBindRenderbuffer(GL_RENDERBUFFER, static_cast<GLuint>(rbo));
+    gl.glBindBuffer(GL_PIXEL_PACK_BUFFER, static_cast<GLuint>(pack_buffer));
+    gl.glPixelStorei(GL_PACK_ALIGNMENT, pack_alignment);
+  }
+
+  const offscreen_functions& gl;
+  GLint read_fbo{0};
+  GLint rbo{0};
+  GLint pack_buffer{0};
+  GLint pack_alignment{4};
+};
+
+const char* init_egl(gl_offscreen_state& state,
+                     const gl_offscreen_provider::create_args& args) noexcept {
+  void* lib = open_library({"libEGL.so.1", "libEGL.so"});
+  if (!lib) {
+    return "Failed to load libEGL";
+  }
+  auto& egl = state.egl;
+  const bool loaded =
+    load_symbol(lib, egl.GetProcAddress, "eglGetProcAddress") &&
+    load_symbol(lib, egl.QueryString, "eglQueryString") &&
+    load_symbol(lib, egl.GetDisplay, "eglGetDisplay") &&
+    load_symbol(lib, egl.Initialize, "eglInitialize") &&
+    load_symbol(lib, egl.BindAPI, "eglBindAPI") &&
+    load_symbol(lib, egl.ChooseConfig, "eglChooseConfig") &&
+    load_symbol(lib, egl.CreateContext, "eglCreateContext") &&
+    load_symbol(lib, egl.DestroyContext, "eglDestroyContext") &&
+    load_symbol(lib, egl.MakeCurrent, "eglMakeCurrent");
+  if (!loaded) {
+    return "Failed to load EGL functions";
+  }
+
+  // Surfaceless needs no display server or render node access, fall back to the default one
+  EGLDisplay display = nullptr;
+  const char* client_exts = egl.QueryString(nullptr, EGL_EXTENSIONS);
+  if (has_extension(client_exts, "EGL_MESA_platform_surfaceless")) {
+    egl.GetPlatformDisplayEXT = reinterpret_cast<decltype(egl.GetPlatformDisplayEXT)>(
+      egl.GetProcAddress("eglGetPlatformDisplayEXT"));
+    if (egl.GetPlatformDisplayEXT) {
+      display = egl.GetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, nullptr, nullptr);
+    }
+  }
+  if (!display) {
+    display = egl.GetDisplay(nullptr);
+  }
+  EGLint egl_major, egl_minor;
+  if (!display || !egl.Initialize(display, &egl_major, &egl_minor)) {
+    return "No EGL display available";
+  }
+
+  const char* display_exts = egl.QueryString(display, EGL_EXTENSIONS);
+  if (!has_extension(display_exts, "EGL_KHR_surfaceless_context")) {
+    return "EGL display can't make surfaceless contexts";
+  }
+  if (!egl.BindAPI(EGL_OPENGL_API)) {
+    return "EGL display has no desktop OpenGL";
+  }
+  EGLConfig config = nullptr;
+  EGLint config_count = 0;
+  // No surface is ever created, the default EGL_WINDOW_BIT would filter out surfaceless configs
+  const EGLint config_attribs[] = {EGL_SURFACE_TYPE, 0, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                                   EGL_NONE};
+  if (!egl.ChooseConfig(display, config_attribs, &config, 1, &config_count) || !config_count) {
+    if (!has_extension(display_exts, "EGL_KHR_no_config_context")) {
+      return "No EGL config supports OpenGL";
+    }
+    config = nullptr;
+  }
+
+  EGLint context_attribs[] = {
+    EGL_CONTEXT_MAJOR_VERSION,
+    static_cast<EGLint>(args.version.major),
+    EGL_CONTEXT_MINOR_VERSION,
+    static_cast<EGLint>(args.version.minor),
+    EGL_CONTEXT_OPENGL_PROFILE_MASK,
+    EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+    EGL_NONE,
+    EGL_NONE,
+    EGL_NONE,
+  };
+  if (args.debug) {
+    context_attribs[6] = EGL_CONTEXT_OPENGL_DEBUG;
+    context_attribs[7] = 1;
+  }
+  EGLContext context = egl.CreateContext(display, config, nullptr, context_attribs);
+  if (!context) {
+    return "Failed to create EGL context";
+  }
+  if (!egl.MakeCurrent(display, nullptr, nullptr, context)) {
+    egl.DestroyContext(display, context);
+    return "Failed to make EGL context current";
+  }
+  state.backend = gl_offscreen_provider::BACKEND_EGL;
+  state.display = display;
+  state.egl_context = context;
+  return nullptr;
+}
+
+const char* init_osmesa(gl_offscreen_state& state,
+                        const gl_offscreen_provider::create_args& args) noexcept {
+  void* lib = open_library({"libOSMesa.so.8", "libOSMesa.so.6", "libOSMesa.so"});
+  if (!lib) {
+    return "Failed to load libOSMesa";
+  }
+  auto& osmesa = state.osmesa;
+  const bool loaded =
+    load_symbol(lib, osmesa.CreateContextAttribs, "OSMesaCreateContextAttribs") &&
+    load_symbol(lib, osmesa.DestroyContext, "OSMesaDestroyContext") &&
+    load_symbol(lib, osmesa.MakeCurrent, "OSMesaMakeCurrent") &&
+    load_symbol(lib, osmesa.GetProcAddress, "OSMesaGetProcAddress");
+  if (!loaded) {
+    return "Failed to load OSMesa functions";
+  }
+
+  const int attribs[] = {
+    OSMESA_FORMAT,
+    GL_RGBA,
+    OSMESA_DEPTH_BITS,
+    0,
+    OSMESA_STENCIL_BITS,
+    0,
+    OSMESA_PROFILE,
+    OSMESA_CORE_PROFILE,
+    OSMESA_CONTEXT_MAJOR_VERSION,
+    static_cast<int>(args.version.major),
+    OSMESA_CONTEXT_MINOR_VERSION,
+    static_cast<int>(args.version.minor),
+    0,
+  };
+  OSMesaContext context = osmesa.CreateContextAttribs(attribs, nullptr);
+  if (!context) {
+    return "Failed to create OSMesa context";
+  }
+  state.backend = gl_offscreen_provider::BACKEND_OSMESA;
+  state.osmesa_context = context;
+  if (!osmesa.MakeCurrent(context, &state.osmesa_pixel, GL_UNSIGNED_BYTE, 1, 1)) {
+    return "Failed to make OSMesa context current";
+  }
+  return nullptr;
+}
+
+const char* load_functions(gl_offscreen_state& state) noexcept {
+#define OFFSCREEN_LOADPROC(name_)                                                     \
+  state.gl.name_ = reinterpret_cast<PFN_shogle_##name_>(state.get_proc(#name_)); \
+  if (!state.gl.name_) {                                                              \
+    return "Failed to load OpenGL functions";                                         \
+  }
+  OFFSCREEN_DOFUNCS(OFFSCREEN_LOADPROC)
+#undef OFFSCREEN_LOADPROC
+  return nullptr;
+}
+
+const char* allocate_attachments(gl_offscreen_state& state, extent2d extent) noexcept {
+  const auto& gl = state.gl;
+  offscreen_bindings bindings{gl};
+  const auto width = static_cast<GLsizei>(extent.width);
+  const auto height = static_cast<GLsizei>(extent.height);
+  gl.glBindRenderbuffer(GL_RENDERBUFFER, state.color_rbo);
+  gl.glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+  gl.glBindRenderbuffer(GL_RENDERBUFFER, state.depth_rbo);
+  gl.glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+  if (gl.glGetError() != GL_NO_ERROR) {
+    return "Failed to allocate offscreen attachments";
+  }
+  gl.glBindFramebuffer(GL_READ_FRAMEBUFFER, state.fbo);
+  gl.glFramebufferRenderbuffer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER,
+                               state.color_rbo);
+  gl.glFramebufferRenderbuffer(GL_READ_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER,
+                               state.depth_rbo);
+  if (gl.glCheckFramebufferStatus(GL_READ_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    return "Offscreen framebuffer is incomplete";
+  }
+  state.extent = extent;
+  return nullptr;
+}
+
+// Reads the framebuffer into the bound pack buffer, or client memory if there is none
+void read_framebuffer(const gl_offscreen_state& state, void* dst) noexcept {
+  const auto& gl = state.gl;
+  gl.glBindFramebuffer(GL_READ_FRAMEBUFFER, state.fbo);
+  gl.glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  gl.glReadPixels(0, 0, static_cast<GLsizei>(state.extent.width),
+                  static_cast<GLsizei>(state.extent.height), GL_RGBA, GL_UNSIGNED_BYTE, dst);
+}
+
+} // namespace
+
+gl_offscreen_state::~gl_offscreen_state() noexcept {
+  if (backend == gl_offscreen_provider::BACKEND_AUTO) {
+    return;
+  }
+  make_current();
+  if (gl_loaded) {
+    drop_readbacks();
+    for (auto& slot : slots) {
+      if (slot.pbo) {
+        gl.glDeleteBuffers(1, &slot.pbo);
+      }
+    }
+    const GLuint rbos[] = {color_rbo, depth_rbo};
+    gl.glDeleteRenderbuffers(2, rbos);
+    gl.glDeleteFramebuffers(1, &fbo);
+  }
+  if (backend == gl_offscreen_provider::BACKEND_EGL) {
+    // The display is shared with every other EGL user in the process, it stays initialized
+    egl.MakeCurrent(display, nullptr, nullptr, nullptr);
+    egl.DestroyContext(display, egl_context);
+  } else {
+    osmesa.DestroyContext(osmesa_context);
+  }
+}
+
+gl_offscreen_provider::gl_offscreen_provider(create_t,
+                                             std::unique_ptr<gl_offscreen_state>&& state) noexcept
+    :
+    _state(std::move(state)) {}
+
+gl_offscreen_provider::gl_offscreen_provider(const create_args& args) :
+    gl_offscreen_provider(::shogle::gl_offscreen_provider::create(args).value()) {}
+
+sv_expect<gl_offscreen_provider>
+gl_offscreen_provider::create(const create_args& args) noexcept {
+  if (!args.extent.width || !args.extent.height) {
+    return {unexpect, "Invalid offscreen extent"};
+  }
+#if !SHOGLE_OFFSCREEN_HAS_DLOPEN
+  return {unexpect, "Offscreen contexts are not supported on this platform"};
+#else
+  auto state = std::make_unique<gl_offscreen_state>();
+  const char* err = nullptr;
+  if (args.backend != BACKEND_OSMESA) {
+    err = init_egl(*state, args);
+  }
+  if (args.backend == BACKEND_OSMESA || (err && args.backend == BACKEND_AUTO)) {
+    if (err) {
+      SHOGLE_GL_LOG(DEBUG, "EGL offscreen context unavailable, trying OSMesa: {}", err);
+    }
+    err = init_osmesa(*state, args);
+  }
+  if (!err) {
+    err = load_functions(*state);
+  }
+  if (err) {
+    return {unexpect, err};
+  }
+  state->gl_loaded = true;
+
+  const auto& gl = state->gl;
+  gl.glGenFramebuffers(1, &state->fbo);
+  GLuint rbos[2];
+  gl.glGenRenderbuffers(2, rbos);
+  state->color_rbo = rbos[0];
+  state->depth_rbo = rbos[1];
+  if ((err = allocate_attachments(*state, args.extent))) {
+    return {unexpect, err};
+  }
+  SHOGLE_GL_LOG(DEBUG, "Offscreen {} context created ({}x{})",
+                state->backend == BACKEND_EGL ? "EGL" : "OSMesa", args.extent.width,
+                args.extent.height);
+  return {in_place, create_t{}, std::move(state)};
+#endif
+}
+
+gl_offscreen_provider::gl_offscreen_provider(gl_offscreen_provider&&) noexcept = default;
+
+gl_offscreen_provider&
+gl_offscreen_provider::operator=(gl_offscreen_provider&&) noexcept = default;
+
+gl_offscreen_provider::~gl_offscreen_provider() noexcept = default;
+
+void* gl_offscreen_provider::gl_get_proc(const char* name) noexcept {
+  SHOGLE_ASSERT(_state, "gl_offscreen_provider use after free");
+  return _state->get_proc(name);
+}
+
+extent2d gl_offscreen_provider::surface_extent() const noexcept {
+  SHOGLE_ASSERT(_state, "gl_offscreen_provider use after free");
+  return _state->extent;
+}
+
+gldefs::GLhandle gl_offscreen_provider::default_framebuffer() const noexcept {
+  SHOGLE_ASSERT(_state, "gl_offscreen_provider use after free");
+  return _state->fbo;
+}
+
+void gl_offscreen_provider::make_current() noexcept {
+  SHOGLE_ASSERT(_state, "gl_offscreen_provider use after free");
+  _state->make_current();
+}
+
+sv_expect<void> gl_offscreen_provider::set_surface_extent(extent2d extent) noexcept {
+  SHOGLE_ASSERT(_state, "gl_offscreen_provider use after free");
+  if (!extent.width || !extent.height) {
+    return {unexpect, "Invalid offscreen extent"};
+  }
+  if (extent.width == _state->extent.width && extent.height == _state->extent.height) {
+    return {};
+  }
+  _state->drop_readbacks();
+  if (const char* err = allocate_attachments(*_state, extent)) {
+    return {unexpect, err};
+  }
+  return {};
+}
+
+sv_expect<void> gl_offscreen_provider::read_pixels(span<u8> out) noexcept {
+  SHOGLE_ASSERT(_state, "gl_offscreen_provider use after free");
+  if (out.size() < _state->frame_size()) {
+    return {unexpect, "Pixel buffer too small"};
+  }
+  const auto& gl = _state->gl;
+  offscreen_bindings bindings{gl};
+  gl.glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  read_framebuffer(*_state, out.data());
+  if (gl.glGetError() != GL_NO_ERROR) {
+    return {unexpect, "Failed to read offscreen pixels"};
+  }
+  return {};
+}
+
+sv_expect<void> gl_offscreen_provider::request_readback() noexcept {
+  SHOGLE_ASSERT(_state, "gl_offscreen_provider use after free");
+  auto& state = *_state;
+  if (state.slot_count == READBACK_SLOTS) {
+    return {unexpect, "Every readback slot is pending"};
+  }
+  const auto& gl = state.gl;
+  auto& slot = state.slots[(state.slot_head + state.slot_count) % READBACK_SLOTS];
+  const size_t size = state.frame_size();
+  offscreen_bindings bindings{gl};
+  if (!slot.pbo) {
+    gl.glGenBuffers(1, &slot.pbo);
+  }
+  gl.glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+  if (slot.size != size) {
+    gl.glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(size), nullptr,
+                    GL_STREAM_READ);
+    slot.size = size;
+  }
+  read_framebuffer(state, nullptr);
+  slot.fence = gl.glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  if (gl.glGetError() != GL_NO_ERROR || !slot.fence) {
+    if (slot.fence) {
+      gl.glDeleteSync(slot.fence);
+      slot.fence = nullptr;
+    }
+    return {unexpect, "Failed to start offscreen readback"};
+  }
+  ++state.slot_count;
+  return {};
+}
+
+sv_expect<void> gl_offscreen_provider::resolve_readback(span<u8> out) noexcept {
+  SHOGLE_ASSERT(_state, "gl_offscreen_provider use after free");
+  auto& state = *_state;
+  if (!state.slot_count) {
+    return {unexpect, "No readback requested"};
+  }
+  auto& slot = state.slots[state.slot_head];
+  if (out.size() < slot.size) {
+    return {unexpect, "Pixel buffer too small"};
+  }
+  const auto& gl = state.gl;
+  const GLenum wait = gl.glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                          std::numeric_limits<GLuint64>::max());
+  gl.glDeleteSync(slot.fence);
+  slot.fence = nullptr;
+  state.slot_head = (state.slot_head + 1) % READBACK_SLOTS;
+  --state.slot_count;
+  if (wait == GL_WAIT_FAILED) {
+    return {unexpect, "Failed to wait for offscreen readback"};
+  }
+
+  offscreen_bindings bindings{gl};
+  gl.glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+  const void* pixels = gl.glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+                                           static_cast<GLsizeiptr>(slot.size), GL_MAP_READ_BIT);
+  if (!pixels) {
+    return {unexpect, "Failed to map offscreen readback"};
+  }
+  std::memcpy(out.data(), pixels, slot.size);
+  gl.glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  return {};
+}
+
+void gl_offscreen_provider::destroy() noexcept {
+  _state.reset();
+}
+
+auto gl_offscreen_provider::backend() const noexcept -> platform_backend {
+  SHOGLE_ASSERT(_state, "gl_offscreen_provider use after free");
+  return _state->backend;
+}
+
+u32 gl_offscreen_provider::pending_readbacks() const noexcept {
+  SHOGLE_ASSERT(_state, "gl_offscreen_provider use after free");
+  return _state->slot_count;
+}
+
+size_t gl_offscreen_provider::frame_size() const noexcept {
+  SHOGLE_ASSERT(_state, "gl_offscreen_provider use after free");
+  return _state->frame_size();
+}
+
+} // namespace shogle
+
+#endif
@@ -0,0 +1,657 @@
+#include "./context_private.hpp"
+#include <shogle/render/gl/particle_system.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace shogle {
+
+namespace {
+
+constexpr size_t ARRAY_ALIGNMENT = 64;
+constexpr u32 ARRAY_COUNT = 8; // Position and velocity per axis, age and life
+constexpr size_t MAX_PARAM_ALIGNMENT = 256;
+
+constexpr gl_particle_system::billboard_vertex CORNERS[] = {
+  {{-.5f, -.5f}}, {{.5f, -.5f}}, {{.5f, .5f}}, {{-.5f, .5f}}};
+constexpr u32 QUAD_INDICES[] = {0, 1, 2, 2, 3, 0};
+
+constexpr u32 SRC_BINDING = 0;
+constexpr u32 DST_BINDING = 1;
+constexpr u32 PARAM_BINDING = 2;
+
+// std430 mirrors of the sim_params block
+struct sim_emitter {
+  vec4 position;
+  vec4 position_spread;
+  vec4 velocity;
+  vec4 velocity_spread;
+  f32 min_life;
+  f32 max_life;
+  u32 first; // Relative to the spawn cursor
+  u32 count;
+};
+
+struct sim_header {
+  vec4 gravity_drag;
+  f32 dt;
+  u32 capacity;
+  u32 cursor;
+  u32 seed;
+  u32 emitter_count;
+  u32 padding[3];
+};
+
+static_assert(sizeof(sim_emitter) == 80);
+static_assert(sizeof(sim_header) == 48);
+
+// Slots in [cursor, cursor + spawns) respawn, the rest integrate while alive
+constexpr std::string_view SIM_SHADER_SRC = R"glsl(
+#version 430 core
+
+layout(local_size_x = 256) in;
+
+struct particle {
+  vec4 pos_age;
+  vec4 vel_life;
+};
+
+struct emitter {
+  vec4 position;
+  vec4 position_spread;
+  vec4 velocity;
+  vec4 velocity_spread;
+  float min_life;
+  float max_life;
+  uint first;
+  uint count;
+};
+
+layout(std430, binding = 0) readonly buffer src_particles {
+  particle src[];
+};
+
+layout(std430, binding = 1) writeonly buffer dst_particles {
+  particle dst[];
+};
+
+layout(std430, binding = 2) readonly buffer sim_params {
+  vec4 gravity_drag;
+  float dt;
+  uint capacity;
+  uint cursor;
+  uint seed;
+  uint emitter_count;
+  emitter emitters[];
+};
+
+uint hash(uint x) {
+  x ^= x >> 16;
+  x *= 0x7feb352du;
+  x ^= x >> 15;
+  x *= 0x846ca68bu;
+  x ^= x >> 16;
+  return x;
+}
+
+float rand(inout uint state) {
+  state = hash(state);
+  return float(state >> 8) * (1.0 / 16777216.0);
+}
+
+vec3 rand_signed3(inout uint state) {
+  return vec3(rand(state), rand(state), rand(state)) * 2.0 - 1.0;
+}
+
+void main() {
+  uint i = gl_GlobalInvocationID.x;
+  if (i >= capacity) {
+    return;
+  }
+  uint slot = (i + capacity - cursor) % capacity;
+  for (uint e = 0; e < emitter_count; ++e) {
+    if (slot - emitters[e].first < emitters[e].count) {
+      uint state = seed ^ (i * 0x9e3779b9u);
+      vec3 pos = emitters[e].position.xyz + emitters[e].position_spread.xyz * rand_signed3(state);
+      vec3 vel = emitters[e].velocity.xyz + emitters[e].velocity_spread.xyz * rand_signed3(state);
+      float life = mix(emitters[e].min_life, emitters[e].max_life, rand(state));
+      dst[i] = particle(vec4(pos, 0.0), vec4(vel, life));
+      return;
+    }
+  }
+
+  particle p = src[i];
+  if (p.pos_age.w < p.vel_life.w) {
+    vec3 vel = p.vel_life.xyz * max(1.0 - gravity_drag.w * dt, 0.0) + gravity_drag.xyz * dt;
+    p.pos_age += vec4(vel * dt, dt);
+    p.vel_life.xyz = vel;
+  }
+  dst[i] = p;
+}
+)glsl";
+
+size_t align_size(size_t size, size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+gl_s_expect<gldefs::GLhandle> link_simulation(gl_context& gl) {
+  auto shader = gl_shader::create(gl, SIM_SHADER_SRC, gl_shader::STAGE_COMPUTE);
+  if (!shader) {
+    return {unexpect, shader.error()};
+  }
+  gldefs::GLhandle program = GL_ASSERT_RET(glCreateProgram());
+  GL_ASSERT(glAttachShader(program, shader->id()));
+  GL_CALL(glLinkProgram(program));
+
+  int succ;
+  GL_ASSERT(glGetProgramiv(program, GL_LINK_STATUS, &succ));
+  GL_ASSERT(glDetachShader(program, shader->id()));
+  gl_shader::destroy(gl, *shader);
+  if (!succ) {
+    GLint err_len = 0;
+    char log_buffer[1024] = {0};
+    GL_ASSERT(glGetProgramInfoLog(program, 1024, &err_len, &log_buffer[0]));
+    GL_ASSERT(glDeleteProgram(program));
+    std::string_view buffer_view(log_buffer, std::min(err_len, 1024));
+    SHOGLE_GL_LOG(ERROR, "PARTICLE_LINKER ({}) {}", program, buffer_view);
+    return {unexpect, fmt::format("Particle simulation linking failed: {}", buffer_view)};
+  }
+  return program;
+}
+
+// Keeps the state cache in sync, draws bind through it
+void bind_storage(gl_context& gl, gl_state_cache& state, u32 location, gldefs::GLhandle buffer,
+                  size_t offset, size_t size) {
+  GL_ASSERT(glBindBufferRange(gl_buffer::TYPE_SHADER, location, buffer, offset, size));
+  auto& range = state.storage_buffers[location];
+  range.buffer = buffer;
+  range.offset = offset;
+  range.size = size;
+}
+
+// Returns the number of particles integrated
+u32 integrate_simd(const gl_particle_system::particle_arrays& particles, u32 count, f32 damp,
+                   f32 dt, const f32* gravity_dt) noexcept {
+  u32 i = 0;
+#if defined(__AVX2__)
+  {
+    const __m256 vdamp = _mm256_set1_ps(damp);
+    const __m256 vdt = _mm256_set1_ps(dt);
+    const __m256 vgrav[] = {_mm256_set1_ps(gravity_dt[0]), _mm256_set1_ps(gravity_dt[1]),
+                            _mm256_set1_ps(gravity_dt[2])};
+    for (; i + 8 <= count; i += 8) {
+      for (u32 axis = 0; axis < 3; ++axis) {
+        f32* vel = particles.vel[axis] + i;
+        f32* pos = particles.pos[axis] + i;
+        const __m256 v = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(vel), vdamp), vgrav[axis]);
+        _mm256_storeu_ps(vel, v);
+        _mm256_storeu_ps(pos, _mm256_add_ps(_mm256_loadu_ps(pos), _mm256_mul_ps(v, vdt)));
+      }
+      _mm256_storeu_ps(particles.age + i, _mm256_add_ps(_mm256_loadu_ps(particles.age + i), vdt));
+    }
+  }
+#endif
+#if defined(__SSE2__)
+  const __m128 vdamp = _mm_set1_ps(damp);
+  const __m128 vdt = _mm_set1_ps(dt);
+  const __m128 vgrav[] = {_mm_set1_ps(gravity_dt[0]), _mm_set1_ps(gravity_dt[1]),
+                          _mm_set1_ps(gravity_dt[2])};
+  for (; i + 4 <= count; i += 4) {
+    for (u32 axis = 0; axis < 3; ++axis) {
+      f32* vel = particles.vel[axis] + i;
+      f32* pos = particles.pos[axis] + i;
+      const __m128 v = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(vel), vdamp), vgrav[axis]);
+      _mm_storeu_ps(vel, v);
+      _mm_storeu_ps(pos, _mm_add_ps(_mm_loadu_ps(pos), _mm_mul_ps(v, vdt)));
+    }
+    _mm_storeu_ps(particles.age + i, _mm_add_ps(_mm_loadu_ps(particles.age + i), vdt));
+  }
+#elif defined(__ARM_NEON)
+  const float32x4_t vdt = vdupq_n_f32(dt);
+  for (; i + 4 <= count; i += 4) {
+    for (u32 axis = 0; axis < 3; ++axis) {
+      f32* vel = particles.vel[axis] + i;
+      f32* pos = particles.pos[axis] + i;
+      const float32x4_t v = vaddq_f32(vmulq_n_f32(vld1q_f32(vel), damp),
+                                      vdupq_n_f32(gravity_dt[axis]));
+      vst1q_f32(vel, v);
+      vst1q_f32(pos, vaddq_f32(vld1q_f32(pos), vmulq_f32(v, vdt)));
+    }
+    vst1q_f32(particles.age + i, vaddq_f32(vld1q_f32(particles.age + i), vdt));
+  }
+#else
+  SHOGLE_UNUSED(particles);
+  SHOGLE_UNUSED(count);
+  SHOGLE_UNUSED(damp);
+  SHOGLE_UNUSED(dt);
+  SHOGLE_UNUSED(gravity_dt);
+#endif
+  return i;
+}
+
+void integrate_range(const gl_particle_system::particle_arrays& particles, u32 first, u32 count,
+                     f32 damp, f32 dt, const f32* gravity_dt) noexcept {
+  for (u32 i = first; i < count; ++i) {
+    for (u32 axis = 0; axis < 3; ++axis) {
+      const f32 vel = particles.vel[axis][i] * damp + gravity_dt[axis];
+      particles.vel[axis][i] = vel;
+      particles.pos[axis][i] += vel * dt;
+    }
+    particles.age[i] += dt;
+  }
+}
+
+} // namespace
+
+gl_particle_system::gl_particle_system(create_t, mem::scratch_arena&& arena,
+                                       const particle_arrays& particles,
+                                       std::vector<gl_buffer>&& particle_buffers,
+                                       gldefs::GLhandle program, gl_ring_buffer&& ring,
+                                       gl_buffer corners, gl_buffer indices,
+                                       gl_vertex_layout layout, const create_args& args) :
+    _arena(std::move(arena)), _cpu(particles), _gpu(std::move(particle_buffers)),
+    _program(program), _ring(std::move(ring)), _corners(std::move(corners)),
+    _indices(std::move(indices)), _layout(std::move(layout)), _gravity(args.gravity),
+    _drag(args.drag), _path(_gpu.empty() ? SIM_PATH_CPU : SIM_PATH_GPU),
+    _capacity(args.capacity), _particle_binding(args.particle_binding), _alive(0), _cursor(0),
+    _current(0), _rng(args.seed ? args.seed : 1u) {}
+
+gl_particle_system::gl_particle_system(gl_context& gl, const create_args& args) :
+    gl_particle_system(::shogle::gl_particle_system::create(gl, args).value()) {}
+
+gl_s_expect<gl_particle_system> gl_particle_system::create(gl_context& gl,
+                                                           const create_args& args) {
+  if (!args.capacity || args.particle_binding >= gl_state_cache::MAX_BUFFER_BINDINGS) {
+    return {unexpect, "Invalid particle system arguments", GL_INVALID_VALUE};
+  }
+  const auto version = gl.version();
+  const bool has_compute = version.major > 4 || (version.major == 4 && version.minor >= 3);
+  const sim_path path = args.path == SIM_PATH_GPU && has_compute ? SIM_PATH_GPU : SIM_PATH_CPU;
+  if (path != args.path) {
+    SHOGLE_GL_LOG(DEBUG, "PARTICLE_SYSTEM_CREATE No compute shaders in GL {}.{}, using the CPU",
+                  version.major, version.minor);
+  }
+
+  // Only the CPU path keeps particles in host memory
+  const size_t array_size = align_size(size_t{args.capacity} * sizeof(f32), ARRAY_ALIGNMENT);
+  const size_t arena_size = path == SIM_PATH_CPU
+                            ? ARRAY_COUNT * array_size + ARRAY_ALIGNMENT
+                            : mem::system_page_size();
+  auto arena = mem::scratch_arena::with_initial_size(arena_size);
+  if (!arena) {
+    return {unexpect, "Failed to allocate particle arena", GL_OUT_OF_MEMORY};
+  }
+  particle_arrays particles{};
+  if (path == SIM_PATH_CPU) {
+    f32** arrays[] = {&particles.pos[0], &particles.pos[1], &particles.pos[2],
+                      &particles.vel[0], &particles.vel[1], &particles.vel[2],
+                      &particles.age,    &particles.life};
+    for (f32** array : arrays) {
+      *array = static_cast<f32*>(arena->allocate(array_size, ARRAY_ALIGNMENT));
+      if (!*array) {
+        return {unexpect, "Failed to allocate particle arrays", GL_OUT_OF_MEMORY};
+      }
+    }
+  }
+
+  std::vector<gl_buffer> buffers;
+  gldefs::GLhandle program = GL_NULL_HANDLE;
+  optional<gl_ring_buffer> ring;
+  optional<gl_buffer> corners;
+  optional<gl_buffer> indices;
+  const auto fail = [&](std::string msg, gldefs::GLenum err) -> gl_s_expect<gl_particle_system> {
+    if (indices) {
+      gl_buffer::deallocate(gl, *indices);
+    }
+    if (corners) {
+      gl_buffer::deallocate(gl, *corners);
+    }
+    if (ring) {
+      gl_ring_buffer::destroy(gl, *ring);
+    }
+    gl_buffer::deallocate_n(gl, buffers.data(), buffers.size());
+    if (program != GL_NULL_HANDLE) {
+      GL_CALL(glDeleteProgram(program));
+    }
+    return {unexpect, std::move(msg), err};
+  };
+
+  size_t region_size;
+  if (path == SIM_PATH_GPU) {
+    auto linked = link_simulation(gl);
+    if (!linked) {
+      return {unexpect, linked.error()};
+    }
+    program = *linked;
+    // Dead particles are all zeros, age and life included
+    const std::vector<u8> zeros(size_t{args.capacity} * sizeof(gpu_particle), 0);
+    for (u32 i = 0; i < 2; ++i) {
+      auto buffer = gl_buffer::allocate(gl, gl_buffer::TYPE_SHADER, zeros.size(),
+                                        gl_buffer::DEFAULT_INMUTABLE_USAGE, zeros.data());
+      if (!buffer) {
+        return fail("Failed to allocate particle buffer", buffer.error().code());
+      }
+      buffers.emplace_back(*buffer);
+    }
+    const size_t params_size = sizeof(sim_header) + MAX_EMITTERS * sizeof(sim_emitter);
+    region_size = MAX_UPDATES_PER_FRAME * align_size(params_size, MAX_PARAM_ALIGNMENT);
+  } else {
+    region_size = size_t{args.capacity} * sizeof(gpu_particle);
+  }
+
+  auto ring_ret =
+    gl_ring_buffer::create(gl, gl_buffer::TYPE_SHADER, region_size, args.frame_regions);
+  if (!ring_ret) {
+    return fail("Failed to allocate particle ring", ring_ret.error().code());
+  }
+  ring.emplace(std::move(*ring_ret));
+
+  auto corners_ret = gl_buffer::allocate(gl, gl_buffer::TYPE_VERTEX, sizeof(CORNERS),
+                                         gl_buffer::DEFAULT_INMUTABLE_USAGE, CORNERS);
+  if (!corners_ret) {
+    return fail("Failed to allocate billboard vertices", corners_ret.error().code());
+  }
+  corners.emplace(*corners_ret);
+
+  auto indices_ret = gl_buffer::allocate(gl, gl_buffer::TYPE_INDEX, sizeof(QUAD_INDICES),
+                                         gl_buffer::DEFAULT_INMUTABLE_USAGE, QUAD_INDICES);
+  if (!indices_ret) {
+    return fail("Failed to allocate billboard indices", indices_ret.error().code());
+  }
+  indices.emplace(*indices_ret);
+
+  auto layout = gl_vertex_layout::from_aos_vertex<billboard_vertex>(gl);
+  if (!layout) {
+    return fail("Failed to create billboard vertex layout", layout.error().code());
+  }
+  SHOGLE_GL_LOG(VERBOSE, "PARTICLE_SYSTEM_CREATE ({}) [capacity: {}, path: {}]",
+                ring->buffer().id(), args.capacity, path == SIM_PATH_GPU ? "gpu" : "cpu");
+  return {in_place,   create_t{}, std::move(*arena), particles, std::move(buffers), program,
+          std::move(*ring), *corners, *indices, *layout, args};
+}
+
+void gl_particle_system::destroy(gl_context& gl, gl_particle_system& particles) noexcept {
+  if (SHOGLE_UNLIKELY(particles.invalidated())) {
+    return;
+  }
+  gl_vertex_layout::destroy(gl, particles._layout);
+  gl_buffer::deallocate(gl, particles._indices);
+  gl_buffer::deallocate(gl, particles._corners);
+  gl_ring_buffer::destroy(gl, particles._ring);
+  gl_buffer::deallocate_n(gl, particles._gpu.data(), particles._gpu.size());
+  particles._gpu.clear();
+  if (particles._program != GL_NULL_HANDLE) {
+    GL_CALL(glDeleteProgram(particles._program));
+    gl_get_state(gl).forget_program(particles._program);
+    particles._program = GL_NULL_HANDLE;
+  }
+  particles._arena.clear();
+  particles._cpu = {};
+  particles._alive = 0;
+  particles._emitters.clear();
+  particles._shader_binds.clear();
+  particles._vertex_binds.clear();
+}
+
+void gl_particle_system::integrate(const particle_arrays& particles, u32 count,
+                                   const step_args& args) noexcept {
+  const f32 damp = std::max(1.f - args.drag * args.dt, 0.f);
+  const f32 gravity_dt[] = {args.gravity.x * args.dt, args.gravity.y * args.dt,
+                            args.gravity.z * args.dt};
+  const u32 done = integrate_simd(particles, count, damp, args.dt, gravity_dt);
+  integrate_range(particles, done, count, damp, args.dt, gravity_dt);
+}
+
+void gl_particle_system::integrate_scalar(const particle_arrays& particles, u32 count,
+                                          const step_args& args) noexcept {
+  const f32 damp = std::max(1.f - args.drag * args.dt, 0.f);
+  const f32 gravity_dt[] = {args.gravity.x * args.dt, args.gravity.y * args.dt,
+                            args.gravity.z * args.dt};
+  integrate_range(particles, 0, count, damp, args.dt, gravity_dt);
+}
+
+optional<u32> gl_particle_system::add_emitter(const emitter_desc& desc) {
+  SHOGLE_ASSERT(!invalidated(), "gl_particle_system use after free");
+  if (_emitters.size() >= MAX_EMITTERS) {
+    return nullopt;
+  }
+  _emitters.emplace_back(desc, 0.f, 0u);
+  _spawns.resize(_emitters.size());
+  return static_cast<u32>(_emitters.size() - 1);
+}
+
+auto gl_particle_system::emitter(u32 index) -> emitter_desc& {
+  SHOGLE_ASSERT(index < _emitters.size(), "Emitter index out of range");
+  return _emitters[index].desc;
+}
+
+void gl_particle_system::burst(u32 index, u32 count) {
+  SHOGLE_ASSERT(index < _emitters.size(), "Emitter index out of range");
+  _emitters[index].burst += count;
+}
+
+u32 gl_particle_system::_take_spawns(f32 dt, u32 budget) {
+  u32 total = 0;
+  for (u32 i = 0; i < _emitters.size(); ++i) {
+    auto& emitter = _emitters[i];
+    emitter.accum += std::max(emitter.desc.rate, 0.f) * dt;
+    const f32 whole = std::floor(emitter.accum);
+    emitter.accum -= whole;
+    // Spawns past the budget are lost, not delayed
+    const u64 wanted = static_cast<u64>(whole) + emitter.burst;
+    emitter.burst = 0;
+    _spawns[i] = static_cast<u32>(std::min<u64>(wanted, budget - total));
+    total += _spawns[i];
+  }
+  return total;
+}
+
+f32 gl_particle_system::_random() noexcept {
+  // xorshift32
+  _rng ^= _rng << 13;
+  _rng ^= _rng >> 17;
+  _rng ^= _rng << 5;
+  return static_cast<f32>(_rng >> 8) * (1.f / 16777216.f);
+}
+
+gl_sv_expect<void> gl_particle_system::update(gl_context& gl, f32 dt) {
+  SHOGLE_ASSERT(!invalidated(), "gl_particle_system use after free");
+  if (_path == SIM_PATH_GPU) {
+    return _update_gpu(gl, dt);
+  }
+  _update_cpu(dt);
+  return {};
+}
+
+void gl_particle_system::_update_cpu(f32 dt) {
+  integrate(_cpu, _alive, {_gravity, _drag, dt});
+
+  // Swap with the last live particle, draw order doesn't matter for billboards
+  f32* arrays[] = {_cpu.pos[0], _cpu.pos[1], _cpu.pos[2], _cpu.vel[0],
+                   _cpu.vel[1], _cpu.vel[2], _cpu.age,    _cpu.life};
+  for (u32 i = 0; i < _alive;) {
+    if (_cpu.age[i] < _cpu.life[i]) {
+      ++i;
+      continue;
+    }
+    --_alive;
+    for (f32* array : arrays) {
+      array[i] = array[_alive];
+    }
+  }
+
+  _take_spawns(dt, _capacity - _alive);
+  for (u32 e = 0; e < _emitters.size(); ++e) {
+    const auto& desc = _emitters[e].desc;
+    for (u32 n = 0; n < _spawns[e]; ++n, ++_alive) {
+      const f32 pos[] = {desc.position.x, desc.position.y, desc.position.z};
+      const f32 pos_spread[] = {desc.position_spread.x, desc.position_spread.y,
+                                desc.position_spread.z};
+      const f32 vel[] = {desc.velocity.x, desc.velocity.y, desc.velocity.z};
+      const f32 vel_spread[] = {desc.velocity_spread.x, desc.velocity_spread.y,
+                                desc.velocity_spread.z};
+      for (u32 axis = 0; axis < 3; ++axis) {
+        _cpu.pos[axis][_alive] = pos[axis] + pos_spread[axis] * (_random() * 2.f - 1.f);
+      }
+      for (u32 axis = 0; axis < 3; ++axis) {
+        _cpu.vel[axis][_alive] = vel[axis] + vel_spread[axis] * (_random() * 2.f - 1.f);
+      }
+      _cpu.age[_alive] = 0.f;
+      _cpu.life[_alive] = desc.min_life + (desc.max_life - desc.min_life) * _random();
+    }
+  }
+}
+
+gl_sv_expect<void> gl_particle_system::_update_gpu(gl_context& gl, f32 dt) {
+  // Sized for every emitter, so the updates that fit in a frame don't depend on them
+  auto alloc = _ring.allocate(sizeof(sim_header) + MAX_EMITTERS * sizeof(sim_emitter));
+  if (!alloc) {
+    return {unexpect, "Particle parameter ring out of space", GL_OUT_OF_MEMORY};
+  }
+  const u32 spawns = _take_spawns(dt, _capacity);
+  _random();
+
+  auto* header = static_cast<sim_header*>(alloc->ptr);
+  header->gravity_drag = {_gravity.x, _gravity.y, _gravity.z, _drag};
+  header->dt = dt;
+  header->capacity = _capacity;
+  header->cursor = _cursor;
+  header->seed = _rng;
+  header->emitter_count = static_cast<u32>(_emitters.size());
+  auto* emitters = reinterpret_cast<sim_emitter*>(header + 1);
+  u32 first = 0;
+  for (u32 i = 0; i < _emitters.size(); ++i) {
+    const auto& desc = _emitters[i].desc;
+    emitters[i] = {
+      .position = {desc.position.x, desc.position.y, desc.position.z, 0.f},
+      .position_spread = {desc.position_spread.x, desc.position_spread.y,
+                          desc.position_spread.z, 0.f},
+      .velocity = {desc.velocity.x, desc.velocity.y, desc.velocity.z, 0.f},
+      .velocity_spread = {desc.velocity_spread.x, desc.velocity_spread.y,
+                          desc.velocity_spread.z, 0.f},
+      .min_life = desc.min_life,
+      .max_life = desc.max_life,
+      .first = first,
+      .count = _spawns[i],
+    };
+    first += _spawns[i];
+  }
+
+  auto& state = gl_get_state(gl);
+  if (state.program != _program) {
+    GL_ASSERT(glUseProgram(_program));
+    state.program = _program;
+  }
+  const u32 dst = _current ^ 1u;
+  const size_t buffer_size = size_t{_capacity} * sizeof(gpu_particle);
+  bind_storage(gl, state, SRC_BINDING, _gpu[_current].id(), 0, buffer_size);
+  bind_storage(gl, state, DST_BINDING, _gpu[dst].id(), 0, buffer_size);
+  bind_storage(gl, state, PARAM_BINDING, _ring.buffer().id(), alloc->offset, alloc->size);
+  GL_ASSERT(glDispatchCompute((_capacity + COMPUTE_GROUP_SIZE - 1) / COMPUTE_GROUP_SIZE, 1, 1));
+  // Draws pull the particles from the vertex shader
+  GL_ASSERT(glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT));
+
+  _current = dst;
+  _cursor = static_cast<u32>((u64{_cursor} + spawns) % _capacity);
+  return {};
+}
+
+gl_expect<void> gl_particle_system::begin_frame(gl_context& gl) {
+  SHOGLE_ASSERT(!invalidated(), "gl_particle_system use after free");
+  auto ret = _ring.begin_frame(gl);
+  _shader_binds.clear();
+  _vertex_binds.clear();
+  return ret;
+}
+
+void gl_particle_system::end_frame(gl_context& gl) {
+  SHOGLE_ASSERT(!invalidated(), "gl_particle_system use after free");
+  _ring.end_frame(gl);
+}
+
+gl_sv_expect<void> gl_particle_system::draw(gl_context& gl, const gl_graphics_pipeline& pipeline,
+                                            ptr_view<const gl_framebuffer> target,
+                                            span<const gl_draw_command::push_uniform> uniforms) {
+  SHOGLE_ASSERT(!invalidated(), "gl_particle_system use after free");
+  u32 instances;
+  const gl_draw_command::shader_binding* particle_bind;
+  if (_path == SIM_PATH_GPU) {
+    instances = _capacity;
+    particle_bind = &_shader_binds.emplace_back(_gpu[_current].id(), gl_buffer::TYPE_SHADER,
+                                                size_t{_capacity} * sizeof(gpu_particle), 0u,
+                                                _particle_binding);
+  } else {
+    if (!_alive) {
+      return {};
+    }
+    auto alloc = _ring.allocate(size_t{_alive} * sizeof(gpu_particle));
+    if (!alloc) {
+      return {unexpect, "Particle ring out of space", GL_OUT_OF_MEMORY};
+    }
+    auto* out = static_cast<gpu_particle*>(alloc->ptr);
+    for (u32 i = 0; i < _alive; ++i) {
+      out[i].pos_age = {_cpu.pos[0][i], _cpu.pos[1][i], _cpu.pos[2][i], _cpu.age[i]};
+      out[i].vel_life = {_cpu.vel[0][i], _cpu.vel[1][i], _cpu.vel[2][i], _cpu.life[i]};
+    }
+    instances = _alive;
+    particle_bind = &_shader_binds.emplace_back(_ring.buffer().id(), gl_buffer::TYPE_SHADER,
+                                                alloc->size, alloc->offset, _particle_binding);
+  }
+
+  const auto& vertex_bind = _vertex_binds.emplace_back(_corners.id(), 0u, 0u);
+  const gl_draw_command cmd{
+    .vertex_layout = _layout,
+    .pipeline = pipeline,
+    .vertex_bindings = {&vertex_bind, 1},
+    .shader_bindings = {particle_bind, 1},
+    .texture_bindings = {},
+    .uniforms = uniforms,
+    .index_bind = gl_draw_command::index_binding{_indices.id(), gl_draw_command::INDEX_FORMAT_U32,
+                                                 0u},
+    .viewport = {},
+    .scissor = {},
+    .vertex_offset = 0,
+    .draw_count = INDICES_PER_PARTICLE,
+    .instances = instances,
+  };
+  gl.submit_command(cmd, target);
+  return {};
+}
+
+const gl_vertex_layout& gl_particle_system::layout() const {
+  SHOGLE_ASSERT(!invalidated(), "gl_particle_system use after free");
+  return _layout;
+}
+
+auto gl_particle_system::path() const -> sim_path {
+  return _path;
+}
+
+u32 gl_particle_system::capacity() const {
+  return _capacity;
+}
+
+u32 gl_particle_system::size() const {
+  return _path == SIM_PATH_GPU ? _capacity : _alive;
+}
+
+auto gl_particle_system::cpu_particles() const -> const particle_arrays& {
+  return _cpu;
+}
+
+const gl_buffer& gl_particle_system::particle_buffer() const {
+  SHOGLE_ASSERT(_path == SIM_PATH_GPU, "No particle buffer on the CPU path");
+  return _gpu[_current];
+}
+
+bool gl_particle_system::invalidated() const noexcept {
+  return _ring.invalidated();
+}
+
+} // namespace shogle
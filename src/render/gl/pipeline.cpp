@@ -176,7 +176,8 @@ gl_graphics_pipeline::gl_graphics_pipeline(gl_context& gl,
     gl_graphics_pipeline(::shogle::gl_graphics_pipeline::create(gl, shaders).value()) {}
 
 gl_s_expect<gl_graphics_pipeline>
-gl_graphics_pipeline::create(gl_context& gl, const gl_shader::graphics_set& shaders) {
+gl_graphics_pipeline::create(gl_context& gl, const gl_shader::graphics_set& shaders,
+                             bool retrievable_binary) {
   const auto shader_span = shaders.stages();
   SHOGLE_ASSERT(!shader_span.empty(), "No shaders in set");
   SHOGLE_ASSERT(shader_span.size() >= 2 && shader_span.size() <= 5, "Invalid shader set");
@@ -188,15 +189,18 @@ gl_graphics_pipeline::create(gl_context& gl, const gl_shader::graphics_set& shad
   for (const gldefs::GLhandle shader : shader_span) {
     GL_ASSERT(glAttachShader(program, shader));
   }
+  if (retrievable_binary) {
+    GL_ASSERT(glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+  }
   GL_CALL(glLinkProgram(program));
 
   int succ;
   GL_ASSERT(glGetProgramiv(program, GL_LINK_STATUS, &succ));
   if (!succ) {
     GLint err_len = 0; // includes null terminator
-    GL_ASSERT(glGetShaderiv(shader_span[0], GL_INFO_LOG_LENGTH, &err_len));
+    GL_ASSERT(glGetProgramiv(program, GL_INFO_LOG_LENGTH, &err_len));
     char log_buffer[1024] = {0};
-    GL_ASSERT(glGetShaderInfoLog(shader_span[0], 1024, &err_len, &log_buffer[0]));
+    GL_ASSERT(glGetProgramInfoLog(program, 1024, &err_len, &log_buffer[0]));
     GL_ASSERT(glDeleteProgram(program));
     std::string_view buffer_view(log_buffer, std::min(err_len, 1024));
     SHOGLE_GL_LOG(ERROR, "PIPELINE_LINKER ({}) {}", program, buffer_view);
@@ -204,17 +208,41 @@ gl_graphics_pipeline::create(gl_context& gl, const gl_shader::graphics_set& shad
   }
 
   for (const gldefs::GLhandle shader : shader_span) {
-    GL_ASSERT(glDettachShader(program, shader));
+    GL_ASSERT(glDetachShader(program, shader));
   }
   SHOGLE_GL_LOG(VERBOSE, "PIPELINE_CREATE ({})", program);
   return {in_place, create_t{}, program, shaders.active_stages()};
 }
 
+gl_expect<gl_graphics_pipeline>
+gl_graphics_pipeline::create_from_binary(gl_context& gl, gldefs::GLenum binary_format,
+                                         span<const u8> binary, gldefs::GLbitfield stages) {
+  SHOGLE_ASSERT(!binary.empty(), "Empty program binary");
+  gldefs::GLhandle program = GL_ASSERT_RET(glCreateProgram());
+  // Drivers report unsupported formats as GL_INVALID_ENUM
+  const auto err = GL_RET_ERR(glProgramBinary(program, binary_format, binary.data(),
+                                              static_cast<GLsizei>(binary.size())));
+  int succ = 0;
+  if (!err) {
+    GL_ASSERT(glGetProgramiv(program, GL_LINK_STATUS, &succ));
+  }
+  if (!succ) {
+    GL_ASSERT(glDeleteProgram(program));
+    SHOGLE_GL_LOG(DEBUG, "PIPELINE_BINARY_REJECTED (fmt: {}, sz: {}B)", binary_format,
+                  binary.size());
+    return {unexpect, err ? err : GL_INVALID_OPERATION};
+  }
+  SHOGLE_GL_LOG(VERBOSE, "PIPELINE_CREATE_BINARY ({}) (fmt: {}, sz: {}B)", program, binary_format,
+                binary.size());
+  return {in_place, create_t{}, program, stages};
+}
+
 void gl_graphics_pipeline::destroy(gl_context& gl, gl_graphics_pipeline& pipeline) noexcept {
   if (SHOGLE_UNLIKELY(pipeline.invalidated())) {
     return;
   }
   GL_CALL(glDeleteProgram(pipeline._program));
+  gl_get_state(gl).forget_program(pipeline._program);
   SHOGLE_GL_LOG(VERBOSE, "PIPELINE_DESTROY ({})", pipeline._program);
   pipeline._program = GL_NULL_HANDLE;
 }
@@ -230,6 +258,7 @@ void gl_graphics_pipeline::destroy_n(gl_context& gl, gl_graphics_pipeline* pipel
     }
     SHOGLE_GL_LOG(VERBOSE, "PIPELINE_DESTROY ({})", pipelines[i]._program);
     GL_CALL(glDeleteProgram(pipelines[i]._program));
+    gl_get_state(gl).forget_program(pipelines[i]._program);
     pipelines[i]._program = GL_NULL_HANDLE;
   }
 }
@@ -307,6 +336,90 @@ auto gl_graphics_pipeline::query_attribute_index(gl_context& gl, shader_attrib_p
   return props.type;
 }
 
+optional<u32> gl_graphics_pipeline::uniform_block_index(gl_context& gl, const char* name) const {
+  SHOGLE_ASSERT(!invalidated(), "gl_graphics_pipeline use after free");
+  const GLuint idx = GL_ASSERT_RET(glGetUniformBlockIndex(_program, name));
+  if (idx == GL_INVALID_INDEX) {
+    return {nullopt};
+  } else {
+    return {in_place, static_cast<u32>(idx)};
+  }
+}
+
+u32 gl_graphics_pipeline::uniform_block_count(gl_context& gl) const {
+  SHOGLE_ASSERT(!invalidated(), "gl_graphics_pipeline use after free");
+  gldefs::GLint count;
+  GL_ASSERT(glGetProgramiv(_program, GL_ACTIVE_UNIFORM_BLOCKS, &count));
+  return static_cast<u32>(count);
+}
+
+bool gl_graphics_pipeline::query_uniform_block(gl_context& gl, uniform_block_props& props,
+                                               u32 block) const {
+  SHOGLE_ASSERT(!invalidated(), "gl_graphics_pipeline use after free");
+  gldefs::GLsizei len;
+  const auto err = GL_RET_ERR(
+    glGetActiveUniformBlockName(_program, static_cast<GLuint>(block), MAX_NAME_SIZE, &len,
+                                props.name));
+  if (err) {
+    return false;
+  }
+  GLint data_size, binding, members;
+  GL_ASSERT(glGetActiveUniformBlockiv(_program, block, GL_UNIFORM_BLOCK_DATA_SIZE, &data_size));
+  GL_ASSERT(glGetActiveUniformBlockiv(_program, block, GL_UNIFORM_BLOCK_BINDING, &binding));
+  GL_ASSERT(glGetActiveUniformBlockiv(_program, block, GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &members));
+  props.name_len = std::min(static_cast<size_t>(len), MAX_NAME_SIZE);
+  props.data_size = static_cast<size_t>(data_size);
+  props.binding = static_cast<u32>(binding);
+  props.member_count = static_cast<u32>(members);
+  return true;
+}
+
+u32 gl_graphics_pipeline::query_uniform_block_members(gl_context& gl, u32 block,
+                                                      span<uniform_member_props> members) const {
+  SHOGLE_ASSERT(!invalidated(), "gl_graphics_pipeline use after free");
+  GLint count = 0;
+  GL_ASSERT(glGetActiveUniformBlockiv(_program, block, GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &count));
+  if (count <= 0) {
+    return 0;
+  }
+  std::vector<GLint> indices(static_cast<size_t>(count));
+  const auto err = GL_RET_ERR(glGetActiveUniformBlockiv(
+    _program, block, GL_UNIFORM_BLOCK_ACTIVE_UNIFORM_INDICES, indices.data()));
+  if (err) {
+    return 0;
+  }
+
+  // One query per property for the whole block, instead of one per member
+  const u32 written = std::min(static_cast<u32>(count), static_cast<u32>(members.size()));
+  const GLuint* uniforms = reinterpret_cast<const GLuint*>(indices.data());
+  const GLenum pnames[] = {GL_UNIFORM_OFFSET, GL_UNIFORM_ARRAY_STRIDE, GL_UNIFORM_MATRIX_STRIDE,
+                           GL_UNIFORM_SIZE, GL_UNIFORM_TYPE};
+  std::array<std::vector<GLint>, std::size(pnames)> params;
+  for (size_t i = 0; i < std::size(pnames); ++i) {
+    params[i].resize(written);
+    GL_ASSERT(glGetActiveUniformsiv(_program, static_cast<GLsizei>(written), uniforms, pnames[i],
+                                    params[i].data()));
+  }
+  for (u32 i = 0; i < written; ++i) {
+    auto& member = members[i];
+    GLsizei len = 0;
+    GL_ASSERT(glGetActiveUniformName(_program, uniforms[i], MAX_NAME_SIZE, &len, member.name));
+    member.name_len = std::min(static_cast<size_t>(len), MAX_NAME_SIZE);
+    member.offset = static_cast<size_t>(params[0][i]);
+    member.array_stride = static_cast<size_t>(params[1][i]);
+    member.matrix_stride = static_cast<size_t>(params[2][i]);
+    member.size = static_cast<size_t>(params[3][i]);
+    member.type = static_cast<shader_attrib_type>(params[4][i]);
+  }
+  return written;
+}
+
+void gl_graphics_pipeline::set_uniform_block_binding(gl_context& gl, u32 block,
+                                                     u32 binding) const {
+  SHOGLE_ASSERT(!invalidated(), "gl_graphics_pipeline use after free");
+  GL_ASSERT(glUniformBlockBinding(_program, block, binding));
+}
+
 gl_graphics_pipeline& gl_graphics_pipeline::reset_props() {
   SHOGLE_ASSERT(!invalidated(), "gl_graphics_pipeline use after free");
   _primitive = PRIMITIVE_TRIANGLES;
@@ -362,6 +475,32 @@ gl_graphics_pipeline& gl_graphics_pipeline::set_culling(const gl_culling_props&
   return *this;
 }
 
+gl_expect<gldefs::GLenum> gl_graphics_pipeline::program_binary(gl_context& gl,
+                                                               std::vector<u8>& out) const {
+  SHOGLE_ASSERT(!invalidated(), "gl_graphics_pipeline use after free");
+  GLint length = 0;
+  GL_ASSERT(glGetProgramiv(_program, GL_PROGRAM_BINARY_LENGTH, &length));
+  if (length <= 0) {
+    return {unexpect, GL_INVALID_OPERATION};
+  }
+  out.resize(static_cast<size_t>(length));
+  GLenum format = 0;
+  GLsizei written = 0;
+  const auto err =
+    GL_RET_ERR(glGetProgramBinary(_program, length, &written, &format, out.data()));
+  if (err) {
+    out.clear();
+    return {unexpect, err};
+  }
+  out.resize(static_cast<size_t>(written));
+  return {in_place, format};
+}
+
+void gl_graphics_pipeline::swap_program(gl_graphics_pipeline& other) noexcept {
+  std::swap(_program, other._program);
+  std::swap(_stages, other._stages);
+}
+
 gldefs::GLhandle gl_graphics_pipeline::program() const {
   SHOGLE_ASSERT(!invalidated(), "gl_graphics_pipeline use after free");
   return _program;
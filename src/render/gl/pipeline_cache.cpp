@@ -0,0 +1,206 @@
+#include "./context_private.hpp"
+#include <shogle/render/gl/pipeline_cache.hpp>
+
+#include <shogle/util/filesystem.hpp>
+
+#include <filesystem>
+
+namespace shogle {
+
+namespace stdfs = std::filesystem;
+
+namespace {
+
+constexpr u64 FNV_OFFSET = 0xcbf29ce484222325;
+constexpr u64 FNV_PRIME = 0x100000001b3;
+
+u64 fnv_hash(u64 hash, span<const u8> data) noexcept {
+  for (const u8 byte : data) {
+    hash = (hash ^ byte) * FNV_PRIME;
+  }
+  return hash;
+}
+
+u64 fnv_hash(u64 hash, std::string_view str) noexcept {
+  // Length first, so that ("ab", "c") and ("a", "bc") don't collide
+  const u64 len = str.size();
+  hash = fnv_hash(hash, {reinterpret_cast<const u8*>(&len), sizeof(len)});
+  return fnv_hash(hash, {reinterpret_cast<const u8*>(str.data()), str.size()});
+}
+
+struct cache_entry_header {
+  char magic[4];
+  u32 version;
+  u64 driver_hash;
+  u64 source_hash;
+  u32 binary_format;
+  u32 stages;
+  u64 binary_size;
+  u64 checksum;
+};
+
+constexpr char ENTRY_MAGIC[4] = {'S', 'H', 'P', 'B'};
+
+} // namespace
+
+gl_pipeline_cache::gl_pipeline_cache(gl_context& gl, std::string_view dir) :
+    _dir(dir), _driver_hash(FNV_OFFSET), _stats() {
+  _driver_hash = fnv_hash(_driver_hash, gl.vendor_string());
+  _driver_hash = fnv_hash(_driver_hash, gl.renderer_string());
+  _driver_hash = fnv_hash(_driver_hash, gl.version_string());
+}
+
+u64 gl_pipeline_cache::hash_sources(const gl_pipeline_sources& sources) noexcept {
+  u64 hash = FNV_OFFSET;
+  hash = fnv_hash(hash, sources.vertex);
+  hash = fnv_hash(hash, sources.fragment);
+  hash = fnv_hash(hash, sources.geometry);
+  hash = fnv_hash(hash, sources.tess_ctrl);
+  hash = fnv_hash(hash, sources.tess_eval);
+  return hash;
+}
+
+std::string gl_pipeline_cache::entry_path(u64 source_hash) const {
+  return fmt::format("{}/v{}/{:016x}/{:016x}.bin", _dir, FORMAT_VERSION, _driver_hash,
+                     source_hash);
+}
+
+optional<gl_graphics_pipeline> gl_pipeline_cache::_load(gl_context& gl, u64 source_hash) {
+  const auto path = entry_path(source_hash);
+  auto file = read_entire_file(path.c_str());
+  if (!file) {
+    return nullopt;
+  }
+
+  const auto reject = [&]() -> optional<gl_graphics_pipeline> {
+    ++_stats.rejected;
+    std::error_code ec;
+    stdfs::remove(path, ec);
+    SHOGLE_GL_LOG(DEBUG, "PIPELINE_CACHE_REJECT ({:016x})", source_hash);
+    return nullopt;
+  };
+
+  const auto& data = *file;
+  cache_entry_header header;
+  if (data.size() < sizeof(header)) {
+    return reject();
+  }
+  std::memcpy(&header, data.data(), sizeof(header));
+  const span<const u8> binary{data.data() + sizeof(header), data.size() - sizeof(header)};
+  if (std::memcmp(header.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC)) != 0 ||
+      header.version != FORMAT_VERSION || header.driver_hash != _driver_hash ||
+      header.source_hash != source_hash || header.binary_size != binary.size() ||
+      header.checksum != fnv_hash(FNV_OFFSET, binary)) {
+    return reject();
+  }
+
+  auto pipeline =
+    gl_graphics_pipeline::create_from_binary(gl, header.binary_format, binary, header.stages);
+  if (!pipeline) {
+    return reject();
+  }
+  return *pipeline;
+}
+
+void gl_pipeline_cache::_store(gl_context& gl, const gl_graphics_pipeline& pipeline,
+                               u64 source_hash) {
+  std::vector<u8> binary;
+  const auto format = pipeline.program_binary(gl, binary);
+  if (!format) {
+    return;
+  }
+
+  const cache_entry_header header{
+    .magic = {ENTRY_MAGIC[0], ENTRY_MAGIC[1], ENTRY_MAGIC[2], ENTRY_MAGIC[3]},
+    .version = FORMAT_VERSION,
+    .driver_hash = _driver_hash,
+    .source_hash = source_hash,
+    .binary_format = *format,
+    .stages = pipeline.stages(),
+    .binary_size = binary.size(),
+    .checksum = fnv_hash(FNV_OFFSET, {binary.data(), binary.size()}),
+  };
+
+  const stdfs::path path = entry_path(source_hash);
+  std::error_code ec;
+  stdfs::create_directories(path.parent_path(), ec);
+  if (ec) {
+    SHOGLE_GL_LOG(ERROR, "Failed to create pipeline cache directory '{}': {}",
+                  path.parent_path().string(), ec.message());
+    return;
+  }
+
+  // Write and rename, a crash halfway through can't leave a truncated entry behind
+  stdfs::path tmp_path = path;
+  tmp_path += ".tmp";
+  {
+    file_close_t file{std::fopen(tmp_path.c_str(), "wb")};
+    if (!file) {
+      return;
+    }
+    if (std::fwrite(&header, sizeof(header), 1, file.get()) != 1 ||
+        std::fwrite(binary.data(), 1, binary.size(), file.get()) != binary.size()) {
+      file.reset();
+      stdfs::remove(tmp_path, ec);
+      return;
+    }
+  }
+  stdfs::rename(tmp_path, path, ec);
+  if (ec) {
+    stdfs::remove(tmp_path, ec);
+    return;
+  }
+  SHOGLE_GL_LOG(VERBOSE, "PIPELINE_CACHE_STORE ({:016x}) (sz: {}B)", source_hash, binary.size());
+}
+
+gl_s_expect<gl_graphics_pipeline>
+gl_pipeline_cache::create_pipeline(gl_context& gl, const gl_pipeline_sources& sources) {
+  SHOGLE_ASSERT(!sources.vertex.empty(), "No vertex shader source");
+  SHOGLE_ASSERT(!sources.fragment.empty(), "No fragment shader source");
+  const u64 source_hash = hash_sources(sources);
+  if (auto pipeline = _load(gl, source_hash)) {
+    ++_stats.hits;
+    return {in_place, *pipeline};
+  }
+  ++_stats.misses;
+
+  const std::pair<std::string_view, gl_shader::shader_stage> stages[] = {
+    {sources.vertex, gl_shader::STAGE_VERTEX},
+    {sources.fragment, gl_shader::STAGE_FRAGMENT},
+    {sources.geometry, gl_shader::STAGE_GEOMETRY},
+    {sources.tess_ctrl, gl_shader::STAGE_TESS_CTRL},
+    {sources.tess_eval, gl_shader::STAGE_TESS_EVAL},
+  };
+
+  std::array<optional<gl_shader>, std::size(stages)> shaders;
+  const auto destroy_shaders = [&]() {
+    for (auto& shader : shaders) {
+      if (shader) {
+        gl_shader::destroy(gl, *shader);
+      }
+    }
+  };
+  gl_shader_builder builder;
+  for (size_t i = 0; i < std::size(stages); ++i) {
+    const auto [src, stage] = stages[i];
+    if (src.empty()) {
+      continue;
+    }
+    auto shader = gl_shader::create(gl, src, stage);
+    if (!shader) {
+      destroy_shaders();
+      return {unexpect, std::move(shader.error())};
+    }
+    shaders[i].emplace(*shader);
+    builder.add_shader(*shaders[i]);
+  }
+
+  auto pipeline = gl_graphics_pipeline::create(gl, builder.build(), true);
+  destroy_shaders();
+  if (pipeline) {
+    _store(gl, *pipeline, source_hash);
+  }
+  return pipeline;
+}
+
+} // namespace shogle
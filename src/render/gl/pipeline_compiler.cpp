@@ -0,0 +1,256 @@
+#include "./context_private.hpp"
+#include <shogle/render/gl/pipeline_compiler.hpp>
+
+namespace shogle {
+
+namespace {
+
+// Same order as the fields in gl_pipeline_sources
+constexpr std::array<gl_shader::shader_stage, 5> job_stages{
+  gl_shader::STAGE_VERTEX,    gl_shader::STAGE_FRAGMENT,  gl_shader::STAGE_GEOMETRY,
+  gl_shader::STAGE_TESS_CTRL, gl_shader::STAGE_TESS_EVAL,
+};
+
+constexpr std::array<gl_shader::stages_bits, 5> job_stage_bits{
+  gl_shader::STAGE_VERTEX_BIT,    gl_shader::STAGE_FRAGMENT_BIT,  gl_shader::STAGE_GEOMETRY_BIT,
+  gl_shader::STAGE_TESS_CTRL_BIT, gl_shader::STAGE_TESS_EVAL_BIT,
+};
+
+std::string shader_log(gl_context& gl, GLuint shader) {
+  GLint err_len = 0; // includes null terminator
+  GL_ASSERT(glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &err_len));
+  char log_buffer[1024] = {0};
+  GL_ASSERT(glGetShaderInfoLog(shader, 1024, &err_len, &log_buffer[0]));
+  return {log_buffer, static_cast<size_t>(std::clamp(err_len, 0, 1024))};
+}
+
+std::string program_log(gl_context& gl, GLuint program) {
+  GLint err_len = 0;
+  GL_ASSERT(glGetProgramiv(program, GL_INFO_LOG_LENGTH, &err_len));
+  char log_buffer[1024] = {0};
+  GL_ASSERT(glGetProgramInfoLog(program, 1024, &err_len, &log_buffer[0]));
+  return {log_buffer, static_cast<size_t>(std::clamp(err_len, 0, 1024))};
+}
+
+} // namespace
+
+gl_pipeline_compiler::gl_pipeline_compiler(gl_context& gl, u32 sync_budget) :
+    _sync_budget(sync_budget), _parallel(impl::gl_get_private(gl).parallel_shader_compile) {
+  SHOGLE_ASSERT(sync_budget > 0, "Pipeline compiler needs a non zero budget");
+  SHOGLE_GL_LOG(DEBUG, "PIPELINE_COMPILER (parallel: {}, budget: {})", _parallel, _sync_budget);
+}
+
+auto gl_pipeline_compiler::submit(gl_context& gl, const gl_pipeline_sources& sources,
+                                  bool retrievable_binary) -> ticket {
+  SHOGLE_ASSERT(!invalidated(), "gl_pipeline_compiler use after free");
+  SHOGLE_ASSERT(!sources.vertex.empty(), "No vertex shader source");
+  SHOGLE_ASSERT(!sources.fragment.empty(), "No fragment shader source");
+
+  ticket id;
+  if (!_free_jobs.empty()) {
+    id = _free_jobs.back();
+    _free_jobs.pop_back();
+  } else {
+    id = static_cast<ticket>(_jobs.size());
+    _jobs.emplace_back();
+  }
+  auto& job = _jobs[id];
+  job.shaders.fill(GL_NULL_HANDLE);
+  job.program = GL_NULL_HANDLE;
+  job.stages = gl_shader::STAGE_NO_BITS;
+  job.result.reset();
+  job.retrievable_binary = retrievable_binary;
+  job.submitted = false;
+  job.active = true;
+
+  const std::array<std::string_view, MAX_STAGES> views{
+    sources.vertex, sources.fragment, sources.geometry, sources.tess_ctrl, sources.tess_eval,
+  };
+  if (_parallel) {
+    _submit_job(gl, job, views);
+  } else {
+    for (u32 i = 0; i < MAX_STAGES; ++i) {
+      job.sources[i].assign(views[i]);
+    }
+  }
+  _pending.emplace_back(id);
+  return id;
+}
+
+void gl_pipeline_compiler::_submit_job(gl_context& gl, compile_job& job,
+                                       const std::array<std::string_view, MAX_STAGES>& sources) {
+  // Nothing here waits on the compiler, status is only queried when resolving
+  for (u32 i = 0; i < MAX_STAGES; ++i) {
+    if (sources[i].empty()) {
+      continue;
+    }
+    const GLuint shader = GL_ASSERT_RET(glCreateShader(job_stages[i]));
+    const char* src_data = sources[i].data();
+    const GLint len = static_cast<GLint>(sources[i].size());
+    GL_ASSERT(glShaderSource(shader, 1, &src_data, &len));
+    GL_CALL(glCompileShader(shader));
+    job.shaders[i] = shader;
+    job.stages |= job_stage_bits[i];
+  }
+
+  job.program = GL_ASSERT_RET(glCreateProgram());
+  for (const GLuint shader : job.shaders) {
+    if (shader != GL_NULL_HANDLE) {
+      GL_ASSERT(glAttachShader(job.program, shader));
+    }
+  }
+  if (job.retrievable_binary) {
+    GL_ASSERT(glProgramParameteri(job.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+  }
+  GL_CALL(glLinkProgram(job.program));
+  job.submitted = true;
+}
+
+void gl_pipeline_compiler::_submit_queued(gl_context& gl, compile_job& job) {
+  std::array<std::string_view, MAX_STAGES> views;
+  for (u32 i = 0; i < MAX_STAGES; ++i) {
+    views[i] = job.sources[i];
+  }
+  _submit_job(gl, job, views);
+}
+
+void gl_pipeline_compiler::_resolve_job(gl_context& gl, compile_job& job) {
+  SHOGLE_ASSERT(job.submitted && !job.result);
+  int linked;
+  GL_ASSERT(glGetProgramiv(job.program, GL_LINK_STATUS, &linked));
+  if (linked) {
+    for (const GLuint shader : job.shaders) {
+      if (shader != GL_NULL_HANDLE) {
+        GL_ASSERT(glDetachShader(job.program, shader));
+      }
+    }
+    SHOGLE_GL_LOG(VERBOSE, "PIPELINE_CREATE ({})", job.program);
+    job.result.emplace(in_place, gl_graphics_pipeline::create_t{}, job.program, job.stages);
+  } else {
+    // Report the shader that broke the link when there is one
+    optional<std::string> compile_err;
+    for (const GLuint shader : job.shaders) {
+      int compiled = GL_TRUE;
+      if (shader != GL_NULL_HANDLE) {
+        GL_ASSERT(glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled));
+      }
+      if (!compiled) {
+        compile_err.emplace(shader_log(gl, shader));
+        SHOGLE_GL_LOG(ERROR, "SHADER_COMPILER ({}) {}", shader, *compile_err);
+        break;
+      }
+    }
+    if (compile_err) {
+      job.result.emplace(unexpect, fmt::format("Shader compilation failed: {}", *compile_err));
+    } else {
+      const auto log = program_log(gl, job.program);
+      SHOGLE_GL_LOG(ERROR, "PIPELINE_LINKER ({}) {}", job.program, log);
+      job.result.emplace(unexpect, fmt::format("Program linking failed: {}", log));
+    }
+    GL_ASSERT(glDeleteProgram(job.program));
+  }
+
+  for (GLuint& shader : job.shaders) {
+    if (shader != GL_NULL_HANDLE) {
+      GL_ASSERT(glDeleteShader(shader));
+      shader = GL_NULL_HANDLE;
+    }
+  }
+  job.program = GL_NULL_HANDLE;
+}
+
+u32 gl_pipeline_compiler::poll(gl_context& gl) {
+  SHOGLE_ASSERT(!invalidated(), "gl_pipeline_compiler use after free");
+  u32 done = 0;
+  u32 budget = _sync_budget;
+  const auto resolved = std::remove_if(_pending.begin(), _pending.end(), [&](ticket id) {
+    auto& job = _jobs[id];
+    if (!job.submitted) {
+      if (!budget) {
+        return false;
+      }
+      --budget;
+      _submit_queued(gl, job);
+    } else {
+      int complete;
+      GL_ASSERT(glGetProgramiv(job.program, GL_COMPLETION_STATUS_KHR, &complete));
+      if (!complete) {
+        return false;
+      }
+    }
+    _resolve_job(gl, job);
+    ++done;
+    return true;
+  });
+  _pending.erase(resolved, _pending.end());
+  return done;
+}
+
+void gl_pipeline_compiler::finish(gl_context& gl) {
+  SHOGLE_ASSERT(!invalidated(), "gl_pipeline_compiler use after free");
+  // Queued jobs ignore the budget, submit everything before blocking on the first one
+  for (const ticket id : _pending) {
+    if (!_jobs[id].submitted) {
+      _submit_queued(gl, _jobs[id]);
+    }
+  }
+  for (const ticket id : _pending) {
+    _resolve_job(gl, _jobs[id]);
+  }
+  _pending.clear();
+}
+
+bool gl_pipeline_compiler::is_ready(ticket job) const {
+  SHOGLE_ASSERT(job < _jobs.size() && _jobs[job].active, "Invalid pipeline ticket");
+  return _jobs[job].result.has_value();
+}
+
+gl_s_expect<gl_graphics_pipeline> gl_pipeline_compiler::take(ticket job) {
+  SHOGLE_ASSERT(is_ready(job), "Pipeline is not ready");
+  auto& entry = _jobs[job];
+  auto result = std::move(*entry.result);
+  entry.result.reset();
+  for (auto& src : entry.sources) {
+    src.clear();
+  }
+  entry.active = false;
+  _free_jobs.emplace_back(job);
+  return result;
+}
+
+void gl_pipeline_compiler::_release_job(gl_context& gl, compile_job& job) noexcept {
+  if (job.result) {
+    if (*job.result) {
+      gl_graphics_pipeline::destroy(gl, **job.result);
+    }
+    job.result.reset();
+  }
+  if (job.program != GL_NULL_HANDLE) {
+    GL_CALL(glDeleteProgram(job.program));
+    job.program = GL_NULL_HANDLE;
+  }
+  for (GLuint& shader : job.shaders) {
+    if (shader != GL_NULL_HANDLE) {
+      GL_CALL(glDeleteShader(shader));
+      shader = GL_NULL_HANDLE;
+    }
+  }
+  job.active = false;
+}
+
+void gl_pipeline_compiler::destroy(gl_context& gl, gl_pipeline_compiler& compiler) noexcept {
+  if (SHOGLE_UNLIKELY(compiler.invalidated())) {
+    return;
+  }
+  for (auto& job : compiler._jobs) {
+    if (job.active) {
+      compiler._release_job(gl, job);
+    }
+  }
+  compiler._jobs.clear();
+  compiler._free_jobs.clear();
+  compiler._pending.clear();
+  compiler._sync_budget = 0;
+}
+
+} // namespace shogle
@@ -0,0 +1,546 @@
+#include "./context_private.hpp"
+#include <shogle/render/gl/gpu_profiler.hpp>
+#include <shogle/render/gl/render_graph.hpp>
+
+#include <algorithm>
+
+namespace shogle {
+
+namespace {
+
+constexpr GLbitfield IMAGE_STORE_BARRIERS = gl_render_graph::BARRIER_TEXTURE_FETCH |
+                                            gl_render_graph::BARRIER_IMAGE_ACCESS |
+                                            gl_render_graph::BARRIER_FRAMEBUFFER;
+
+// Barrier that makes earlier image stores visible to the access
+GLbitfield access_barrier(gl_render_graph::texture_access access) {
+  switch (access) {
+    case gl_render_graph::ACCESS_SAMPLED:
+      return gl_render_graph::BARRIER_TEXTURE_FETCH;
+    case gl_render_graph::ACCESS_IMAGE_READ:
+      [[fallthrough]];
+    case gl_render_graph::ACCESS_IMAGE_WRITE:
+      return gl_render_graph::BARRIER_IMAGE_ACCESS;
+    case gl_render_graph::ACCESS_COLOR:
+      [[fallthrough]];
+    case gl_render_graph::ACCESS_DEPTH:
+      return gl_render_graph::BARRIER_FRAMEBUFFER;
+  }
+  SHOGLE_UNREACHABLE();
+}
+
+bool has_stencil(gl_texture::texture_format format) {
+  return format == gl_texture::TEX_FORMAT_DEPTH_STENCIL ||
+         format == gl_texture::TEX_FORMAT_D24_S8 || format == gl_texture::TEX_FORMAT_D32F_S8;
+}
+
+bool same_extent(const extent2d& a, const extent2d& b) {
+  return a.width == b.width && a.height == b.height;
+}
+
+bool same_desc(const gl_render_graph::texture_desc& a, const gl_render_graph::texture_desc& b) {
+  return a.format == b.format && same_extent(a.extent, b.extent);
+}
+
+} // namespace
+
+gl_render_graph::gl_render_graph() noexcept : _dirty(true) {}
+
+auto gl_render_graph::create_texture(std::string_view name, const texture_desc& desc)
+  -> resource_id {
+  SHOGLE_ASSERT(desc.extent.width && desc.extent.height, "Empty transient texture");
+  _resources.push_back({.name = std::string{name},
+                        .desc = desc,
+                        .imported = nullptr,
+                        .output = false,
+                        .first_use = NULL_RESOURCE,
+                        .last_use = 0,
+                        .physical = NULL_RESOURCE});
+  return static_cast<resource_id>(_resources.size() - 1);
+}
+
+auto gl_render_graph::import_texture(std::string_view name, const gl_texture& texture)
+  -> resource_id {
+  const auto extent = texture.extent();
+  _resources.push_back({.name = std::string{name},
+                        .desc = {texture.format(), {extent.width, extent.height}},
+                        .imported = texture,
+                        .output = true,
+                        .first_use = NULL_RESOURCE,
+                        .last_use = 0,
+                        .physical = NULL_RESOURCE});
+  return static_cast<resource_id>(_resources.size() - 1);
+}
+
+void gl_render_graph::set_output(resource_id res) {
+  SHOGLE_ASSERT(res < _resources.size(), "Unknown render graph resource");
+  _resources[res].output = true;
+}
+
+auto gl_render_graph::add_pass(std::string_view name, pass_callback callback) -> pass_id {
+  _passes.push_back({.name = std::string{name},
+                     .callback = std::move(callback),
+                     .reads = {},
+                     .writes = {},
+                     .side_effect = false});
+  return static_cast<pass_id>(_passes.size() - 1);
+}
+
+gl_render_graph& gl_render_graph::read(pass_id pass, resource_id res, texture_access access) {
+  SHOGLE_ASSERT(pass < _passes.size(), "Unknown render graph pass");
+  SHOGLE_ASSERT(res < _resources.size(), "Unknown render graph resource");
+  SHOGLE_ASSERT(access == ACCESS_SAMPLED || access == ACCESS_IMAGE_READ,
+                "Invalid render graph read access");
+  _passes[pass].reads.push_back({res, access});
+  return *this;
+}
+
+gl_render_graph& gl_render_graph::write(pass_id pass, resource_id res, texture_access access) {
+  SHOGLE_ASSERT(pass < _passes.size(), "Unknown render graph pass");
+  SHOGLE_ASSERT(res < _resources.size(), "Unknown render graph resource");
+  SHOGLE_ASSERT(access == ACCESS_IMAGE_WRITE || access == ACCESS_COLOR || access == ACCESS_DEPTH,
+                "Invalid render graph write access");
+  _passes[pass].writes.push_back({res, access});
+  return *this;
+}
+
+void gl_render_graph::set_side_effect(pass_id pass) {
+  SHOGLE_ASSERT(pass < _passes.size(), "Unknown render graph pass");
+  _passes[pass].side_effect = true;
+}
+
+void gl_render_graph::reset() {
+  _resources.clear();
+  _passes.clear();
+  _schedule.clear();
+  _physical.clear();
+  _dirty = true;
+}
+
+gl_sv_expect<void> gl_render_graph::compile() {
+  _schedule.clear();
+  _physical.clear();
+  _dirty = true;
+  const u32 pass_count = static_cast<u32>(_passes.size());
+  const u32 res_count = static_cast<u32>(_resources.size());
+  for (auto& res : _resources) {
+    res.first_use = NULL_RESOURCE;
+    res.last_use = 0;
+    res.physical = NULL_RESOURCE;
+  }
+
+  std::vector<std::vector<pass_id>> writers(res_count);
+  for (pass_id p = 0; p < pass_count; ++p) {
+    for (const auto& w : _passes[p].writes) {
+      auto& list = writers[w.res];
+      if (list.empty() || list.back() != p) {
+        list.push_back(p);
+      }
+    }
+  }
+
+  // Readers wait for every writer, writers of the same texture wait for the previous one.
+  // A pass that reads what it writes only waits for earlier writers.
+  std::vector<std::vector<pass_id>> deps(pass_count);
+  for (pass_id p = 0; p < pass_count; ++p) {
+    const auto& pass = _passes[p];
+    const auto writes_res = [&](resource_id res) {
+      return std::any_of(pass.writes.begin(), pass.writes.end(),
+                         [res](const auto& w) { return w.res == res; });
+    };
+    for (const auto& r : pass.reads) {
+      if (writes_res(r.res)) {
+        continue;
+      }
+      deps[p].insert(deps[p].end(), writers[r.res].begin(), writers[r.res].end());
+    }
+    for (const auto& w : pass.writes) {
+      const auto& list = writers[w.res];
+      const auto it = std::find(list.begin(), list.end(), p);
+      if (it != list.begin()) {
+        deps[p].push_back(*std::prev(it));
+      }
+    }
+    std::sort(deps[p].begin(), deps[p].end());
+    deps[p].erase(std::unique(deps[p].begin(), deps[p].end()), deps[p].end());
+  }
+
+  // Keep what an output or a side effect depends on
+  std::vector<u8> alive(pass_count, 0);
+  std::vector<pass_id> stack;
+  for (pass_id p = 0; p < pass_count; ++p) {
+    const auto& pass = _passes[p];
+    const bool has_output = std::any_of(pass.writes.begin(), pass.writes.end(),
+                                        [&](const auto& w) { return _resources[w.res].output; });
+    if (pass.side_effect || has_output) {
+      alive[p] = 1;
+      stack.push_back(p);
+    }
+  }
+  while (!stack.empty()) {
+    const pass_id p = stack.back();
+    stack.pop_back();
+    for (const pass_id d : deps[p]) {
+      if (!alive[d]) {
+        alive[d] = 1;
+        stack.push_back(d);
+      }
+    }
+  }
+
+  // Topological order, ties go to the pass declared first
+  std::vector<u32> pending(pass_count, 0);
+  u32 alive_count = 0;
+  for (pass_id p = 0; p < pass_count; ++p) {
+    if (alive[p]) {
+      pending[p] = static_cast<u32>(deps[p].size());
+      ++alive_count;
+    }
+  }
+  std::vector<u8> scheduled(pass_count, 0);
+  while (_schedule.size() < alive_count) {
+    pass_id next = pass_count;
+    for (pass_id p = 0; p < pass_count; ++p) {
+      if (alive[p] && !scheduled[p] && !pending[p]) {
+        next = p;
+        break;
+      }
+    }
+    if (next == pass_count) {
+      _schedule.clear();
+      return {unexpect, "Render graph has a dependency cycle", GL_INVALID_OPERATION};
+    }
+    scheduled[next] = 1;
+    _schedule.push_back({.pass = next,
+                         .barriers = BARRIER_NONE,
+                         .invalidate_colors = 0,
+                         .invalidate_depth = false});
+    for (pass_id p = 0; p < pass_count; ++p) {
+      if (alive[p] && std::binary_search(deps[p].begin(), deps[p].end(), next)) {
+        --pending[p];
+      }
+    }
+  }
+
+  const auto fail = [this](const char* msg) -> gl_sv_expect<void> {
+    _schedule.clear();
+    return {unexpect, msg, GL_INVALID_OPERATION};
+  };
+  const u32 end = static_cast<u32>(_schedule.size());
+  for (u32 i = 0; i < end; ++i) {
+    const auto& pass = _passes[_schedule[i].pass];
+    u32 colors = 0;
+    u32 depths = 0;
+    optional<extent2d> extent;
+    for (const auto& w : pass.writes) {
+      if (w.access != ACCESS_COLOR && w.access != ACCESS_DEPTH) {
+        continue;
+      }
+      ++(w.access == ACCESS_COLOR ? colors : depths);
+      const auto& res_extent = _resources[w.res].desc.extent;
+      if (extent && !same_extent(*extent, res_extent)) {
+        return fail("Render graph pass attachments differ in extent");
+      }
+      extent.emplace(res_extent);
+    }
+    if (colors > MAX_COLOR_ATTACHMENTS || depths > 1) {
+      return fail("Too many render graph pass attachments");
+    }
+    for (const auto& r : pass.reads) {
+      if (!_resources[r.res].imported && writers[r.res].empty()) {
+        return fail("Transient texture read without being written");
+      }
+    }
+
+    const auto use = [&](resource_id res) {
+      auto& node = _resources[res];
+      node.first_use = std::min(node.first_use, i);
+      node.last_use = std::max(node.last_use, i);
+    };
+    for (const auto& r : pass.reads) {
+      use(r.res);
+    }
+    for (const auto& w : pass.writes) {
+      use(w.res);
+    }
+  }
+  for (auto& res : _resources) {
+    if (res.output && res.first_use != NULL_RESOURCE) {
+      res.last_use = end;
+    }
+  }
+
+  // First fit aliasing of transient textures, by first use
+  std::vector<resource_id> transients;
+  for (resource_id r = 0; r < res_count; ++r) {
+    if (!_resources[r].imported && _resources[r].first_use != NULL_RESOURCE) {
+      transients.push_back(r);
+    }
+  }
+  std::stable_sort(transients.begin(), transients.end(), [this](resource_id a, resource_id b) {
+    return _resources[a].first_use < _resources[b].first_use;
+  });
+  std::vector<u32> physical_last;
+  for (const resource_id r : transients) {
+    auto& res = _resources[r];
+    for (u32 j = 0; j < _physical.size(); ++j) {
+      if (same_desc(_physical[j], res.desc) && physical_last[j] < res.first_use) {
+        res.physical = j;
+        break;
+      }
+    }
+    if (res.physical == NULL_RESOURCE) {
+      res.physical = static_cast<u32>(_physical.size());
+      _physical.push_back(res.desc);
+      physical_last.push_back(0);
+    }
+    physical_last[res.physical] = res.last_use;
+  }
+
+  // Barriers after image stores, invalidations for attachments nobody reads afterwards
+  std::vector<GLbitfield> pending_barriers(res_count, BARRIER_NONE);
+  for (u32 i = 0; i < end; ++i) {
+    auto& cp = _schedule[i];
+    const auto& pass = _passes[cp.pass];
+    for (const auto& r : pass.reads) {
+      cp.barriers |= pending_barriers[r.res] & access_barrier(r.access);
+    }
+    for (const auto& w : pass.writes) {
+      cp.barriers |= pending_barriers[w.res] & access_barrier(w.access);
+    }
+    for (auto& bits : pending_barriers) {
+      bits &= ~cp.barriers;
+    }
+
+    u32 color = 0;
+    for (const auto& w : pass.writes) {
+      const auto& res = _resources[w.res];
+      const bool dead = !res.imported && !res.output && res.last_use == i;
+      switch (w.access) {
+        case ACCESS_IMAGE_WRITE: {
+          pending_barriers[w.res] = IMAGE_STORE_BARRIERS;
+        } break;
+        case ACCESS_COLOR: {
+          if (dead) {
+            cp.invalidate_colors |= 1u << color;
+          }
+          ++color;
+        } break;
+        case ACCESS_DEPTH: {
+          cp.invalidate_depth = dead;
+        } break;
+        default:
+          break;
+      }
+    }
+  }
+
+  SHOGLE_GL_LOG(VERBOSE, "RENDER_GRAPH_COMPILE [passes: {}/{}, textures: {} -> {}]", end,
+                pass_count, transients.size(), _physical.size());
+  return {};
+}
+
+gl_sv_expect<void> gl_render_graph::_allocate_textures(gl_context& gl) {
+  // Pooled textures go to any slot with the same description
+  std::vector<optional<gl_texture>> pool;
+  pool.reserve(_textures.size());
+  for (auto& tex : _textures) {
+    pool.emplace_back(std::move(tex));
+  }
+  _textures.clear();
+
+  const auto release_pool = [&]() {
+    for (auto& tex : pool) {
+      if (tex) {
+        gl_texture::deallocate(gl, *tex);
+      }
+    }
+  };
+  for (const auto& desc : _physical) {
+    auto it = std::find_if(pool.begin(), pool.end(), [&](const optional<gl_texture>& tex) {
+      if (!tex) {
+        return false;
+      }
+      const auto extent = tex->extent();
+      return same_desc(desc, {tex->format(), {extent.width, extent.height}});
+    });
+    if (it != pool.end()) {
+      _textures.emplace_back(std::move(**it));
+      it->reset();
+      continue;
+    }
+    auto tex = gl_texture::allocate2d(gl, desc.format, desc.extent, 1);
+    if (!tex) {
+      release_pool();
+      return {unexpect, "Failed to allocate transient texture", tex.error().code()};
+    }
+    _textures.emplace_back(std::move(*tex));
+  }
+  release_pool();
+  return {};
+}
+
+gl_sv_expect<void> gl_render_graph::_create_framebuffers(gl_context& gl) {
+  _framebuffers.resize(_schedule.size());
+  for (u32 i = 0; i < _schedule.size(); ++i) {
+    const auto& pass = _passes[_schedule[i].pass];
+    std::vector<gl_framebuffer::texture_attachment> colors;
+    optional<gl_framebuffer::texture_attachment> depth;
+    optional<extent2d> extent;
+    for (const auto& w : pass.writes) {
+      if (w.access != ACCESS_COLOR && w.access != ACCESS_DEPTH) {
+        continue;
+      }
+      const gl_framebuffer::texture_attachment att{texture(w.res), 0, 0};
+      if (w.access == ACCESS_COLOR) {
+        colors.push_back(att);
+      } else {
+        depth.emplace(att);
+      }
+      extent.emplace(_resources[w.res].desc.extent);
+    }
+    if (!extent) {
+      continue;
+    }
+
+    const span<const gl_framebuffer::texture_attachment> color_span{colors.data(), colors.size()};
+    auto fbo = depth ? gl_framebuffer::with_textures(gl, *extent, color_span, *depth)
+                     : gl_framebuffer::with_textures(gl, *extent, color_span);
+    if (!fbo) {
+      return {unexpect, fbo.error()};
+    }
+    _framebuffers[i].emplace(std::move(*fbo));
+  }
+  return {};
+}
+
+void gl_render_graph::_release_framebuffers(gl_context& gl) noexcept {
+  for (auto& fbo : _framebuffers) {
+    if (fbo) {
+      gl_framebuffer::destroy(gl, *fbo);
+    }
+  }
+  _framebuffers.clear();
+}
+
+void gl_render_graph::_invalidate_attachments(gl_context& gl, u32 position) const {
+  const auto& cp = _schedule[position];
+  const auto& fbo = _framebuffers[position];
+  SHOGLE_ASSERT(fbo.has_value(), "Invalidating a pass without attachments");
+
+  std::array<GLenum, MAX_COLOR_ATTACHMENTS + 1> attachments;
+  u32 count = 0;
+  for (u32 i = 0; i < MAX_COLOR_ATTACHMENTS; ++i) {
+    if (cp.invalidate_colors & (1u << i)) {
+      attachments[count++] = GL_COLOR_ATTACHMENT0 + i;
+    }
+  }
+  if (cp.invalidate_depth) {
+    const auto& pass = _passes[cp.pass];
+    const auto it = std::find_if(pass.writes.begin(), pass.writes.end(),
+                                 [](const auto& w) { return w.access == ACCESS_DEPTH; });
+    attachments[count++] = has_stencil(_resources[it->res].desc.format)
+                           ? GL_DEPTH_STENCIL_ATTACHMENT
+                           : GL_DEPTH_ATTACHMENT;
+  }
+
+  if (impl::gl_get_private(gl).direct_state_access) {
+    GL_ASSERT(glInvalidateNamedFramebufferData(fbo->id(), count, attachments.data()));
+    return;
+  }
+  auto& state = gl_get_state(gl);
+  if (state.draw_fbo != fbo->id()) {
+    GL_ASSERT(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo->id()));
+    GL_FRAME_STAT(fbo_binds, 1);
+    state.draw_fbo = fbo->id();
+  }
+  GL_ASSERT(glInvalidateFramebuffer(GL_DRAW_FRAMEBUFFER, count, attachments.data()));
+}
+
+gl_sv_expect<void> gl_render_graph::execute(gl_context& gl) {
+  SHOGLE_ASSERT(impl::gl_get_private(gl).queue.mode == gl_context::SUBMIT_IMMEDIATE,
+                "Render graphs need immediate submission");
+  if (_dirty) {
+    _release_framebuffers(gl);
+    if (auto ret = _allocate_textures(gl); !ret) {
+      return ret;
+    }
+    if (auto ret = _create_framebuffers(gl); !ret) {
+      _release_framebuffers(gl);
+      return ret;
+    }
+    _dirty = false;
+  }
+
+  // Each pass gets its own zone when the frame is being profiled
+  auto* profiler = impl::gl_get_private(gl).profiler;
+  if (profiler && !profiler->in_frame()) {
+    profiler = nullptr;
+  }
+  for (u32 i = 0; i < _schedule.size(); ++i) {
+    const auto& cp = _schedule[i];
+    const auto& pass = _passes[cp.pass];
+    if (profiler) {
+      profiler->begin_zone(gl, pass.name);
+    }
+    if (cp.barriers) {
+      GL_ASSERT(glMemoryBarrier(cp.barriers));
+    }
+    const auto& fbo = _framebuffers[i];
+    const pass_context ctx{
+      .target = fbo ? ptr_view<const gl_framebuffer>{*fbo} : nullptr,
+      .extent = fbo ? fbo->extent() : extent2d{0, 0},
+    };
+    if (pass.callback) {
+      pass.callback(gl, ctx);
+    }
+    if (cp.invalidate_colors || cp.invalidate_depth) {
+      _invalidate_attachments(gl, i);
+    }
+    if (profiler) {
+      profiler->end_zone(gl);
+    }
+  }
+  return {};
+}
+
+void gl_render_graph::destroy(gl_context& gl, gl_render_graph& graph) noexcept {
+  if (SHOGLE_UNLIKELY(graph.invalidated())) {
+    return;
+  }
+  graph._release_framebuffers(gl);
+  for (auto& tex : graph._textures) {
+    gl_texture::deallocate(gl, tex);
+  }
+  graph._textures.clear();
+  graph._dirty = true;
+}
+
+const gl_texture& gl_render_graph::texture(resource_id res) const {
+  SHOGLE_ASSERT(res < _resources.size(), "Unknown render graph resource");
+  const auto& node = _resources[res];
+  if (node.imported) {
+    return node.imported.get();
+  }
+  SHOGLE_ASSERT(node.physical < _textures.size(), "Render graph texture not allocated");
+  return _textures[node.physical];
+}
+
+bool gl_render_graph::culled(pass_id pass) const {
+  SHOGLE_ASSERT(pass < _passes.size(), "Unknown render graph pass");
+  return std::none_of(_schedule.begin(), _schedule.end(),
+                      [pass](const compiled_pass& cp) { return cp.pass == pass; });
+}
+
+u32 gl_render_graph::physical_index(resource_id res) const {
+  SHOGLE_ASSERT(res < _resources.size(), "Unknown render graph resource");
+  return _resources[res].physical;
+}
+
+u32 gl_render_graph::transient_count() const noexcept {
+  return static_cast<u32>(std::count_if(_resources.begin(), _resources.end(), [](const auto& res) {
+    return !res.imported && res.first_use != NULL_RESOURCE;
+  }));
+}
+
+} // namespace shogle
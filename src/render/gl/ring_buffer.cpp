@@ -0,0 +1,184 @@
+#include "./context_private.hpp"
+#include <shogle/render/gl/ring_buffer.hpp>
+
+#include <numeric>
+
+namespace shogle {
+
+namespace {
+
+constexpr gldefs::GLbitfield RING_STORAGE_FLAGS = gl_buffer::USAGE_MAP_WRITE_BIT |
+                                                  gl_buffer::USAGE_MAP_PERSISTENT_BIT |
+                                                  gl_buffer::USAGE_MAP_COHERENT_BIT;
+
+constexpr size_t MIN_RING_ALIGNMENT = 16;
+
+size_t align_size(size_t size, size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+size_t query_offset_alignment(gl_context& gl, gl_buffer::buffer_type type) {
+  GLint alignment = 0;
+  switch (type) {
+    case gl_buffer::TYPE_UNIFORM: {
+      GL_ASSERT(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment));
+    } break;
+    case gl_buffer::TYPE_SHADER: {
+      GL_ASSERT(glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment));
+    } break;
+    default:
+      break;
+  }
+  return std::max(static_cast<size_t>(alignment), MIN_RING_ALIGNMENT);
+}
+
+} // namespace
+
+gl_ring_buffer::gl_ring_buffer(create_t, gl_buffer buffer, void* mapping, size_t region_size,
+                               u32 region_count, size_t alignment) :
+    _buffer(buffer), _mapping(static_cast<u8*>(mapping)), _region_size(region_size),
+    _alignment(alignment), _offset(0), _region_count(region_count), _region(region_count - 1),
+    _stalls(0) {
+  _fences.fill(nullptr);
+}
+
+gl_ring_buffer::gl_ring_buffer(gl_context& gl, gl_buffer::buffer_type type, size_t region_size,
+                               u32 region_count) :
+    gl_ring_buffer(::shogle::gl_ring_buffer::create(gl, type, region_size, region_count).value()) {}
+
+gl_expect<gl_ring_buffer> gl_ring_buffer::create(gl_context& gl, gl_buffer::buffer_type type,
+                                                 size_t region_size, u32 region_count) {
+  SHOGLE_ASSERT(region_size, "Ring buffer with no region size");
+  SHOGLE_ASSERT(region_count > 0 && region_count <= MAX_FRAME_REGIONS,
+                "Invalid ring buffer region count");
+  const size_t alignment = query_offset_alignment(gl, type);
+  const size_t aligned_region = align_size(region_size, alignment);
+  const size_t total_size = aligned_region * region_count;
+
+  auto buffer = gl_buffer::allocate(gl, type, total_size, RING_STORAGE_FLAGS);
+  if (!buffer) {
+    return {unexpect, buffer.error()};
+  }
+  auto mapping = buffer->map_range(gl, total_size, 0, RING_STORAGE_FLAGS);
+  if (!mapping) {
+    gl_buffer::deallocate(gl, *buffer);
+    return {unexpect, mapping.error()};
+  }
+  SHOGLE_GL_LOG(VERBOSE, "RING_BUFFER_ALLOC ({}) (regions: {}x{}B, align: {}B)", buffer->id(),
+                region_count, aligned_region, alignment);
+  return {in_place, create_t{}, *buffer, *mapping, aligned_region, region_count, alignment};
+}
+
+void gl_ring_buffer::destroy(gl_context& gl, gl_ring_buffer& ring) noexcept {
+  if (SHOGLE_UNLIKELY(ring.invalidated())) {
+    return;
+  }
+  for (auto& fence : ring._fences) {
+    if (fence) {
+      GL_CALL(glDeleteSync(fence));
+      fence = nullptr;
+    }
+  }
+  // Deleting the buffer also releases the persistent mapping
+  gl_buffer::deallocate(gl, ring._buffer);
+  ring._mapping = nullptr;
+}
+
+gl_expect<void> gl_ring_buffer::begin_frame(gl_context& gl, u64 timeout) {
+  SHOGLE_ASSERT(!invalidated(), "gl_ring_buffer use after free");
+  const u32 next = (_region + 1) % _region_count;
+  auto& fence = _fences[next];
+  if (fence) {
+    GLenum status = GL_CALL(glClientWaitSync(fence, 0, 0));
+    if (status == GL_TIMEOUT_EXPIRED) {
+      ++_stalls;
+      status = GL_CALL(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout));
+    }
+    if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED) {
+      // Keep the region full, allocations fail until the fence gets signaled
+      _offset = _region_size;
+      const GLenum err = status == GL_WAIT_FAILED ? gl.get_error() : status;
+      SHOGLE_GL_LOG(DEBUG, "RING_BUFFER_STALL ({}) (region: {}, err: {})", _buffer.id(), next,
+                    err);
+      return {unexpect, err};
+    }
+    GL_CALL(glDeleteSync(fence));
+    fence = nullptr;
+  }
+  _region = next;
+  _offset = 0;
+  return {};
+}
+
+void gl_ring_buffer::end_frame(gl_context& gl) {
+  SHOGLE_ASSERT(!invalidated(), "gl_ring_buffer use after free");
+  auto& fence = _fences[_region];
+  if (fence) {
+    GL_CALL(glDeleteSync(fence));
+  }
+  fence = GL_CALL(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+}
+
+auto gl_ring_buffer::allocate(size_t size, size_t alignment) -> optional<allocation> {
+  SHOGLE_ASSERT(!invalidated(), "gl_ring_buffer use after free");
+  SHOGLE_ASSERT(size, "Ring buffer allocation with no size");
+  // Vertex strides aren't always powers of two, round to a multiple of both alignments
+  const size_t align = alignment ? std::lcm(alignment, _alignment) : _alignment;
+  const size_t region_start = _region * _region_size;
+  const size_t buffer_offset = align_size(region_start + _offset, align);
+  if (buffer_offset + size > region_start + _region_size) {
+    return nullopt;
+  }
+  _offset = buffer_offset - region_start + size;
+  return allocation{_mapping + buffer_offset, buffer_offset, size};
+}
+
+auto gl_ring_buffer::push(const void* data, size_t size) -> optional<allocation> {
+  SHOGLE_ASSERT(data, "Ring buffer push with null pointer");
+  auto alloc = allocate(size);
+  if (alloc) {
+    std::memcpy(alloc->ptr, data, size);
+  }
+  return alloc;
+}
+
+const gl_buffer& gl_ring_buffer::buffer() const {
+  SHOGLE_ASSERT(!invalidated(), "gl_ring_buffer use after free");
+  return _buffer;
+}
+
+size_t gl_ring_buffer::region_size() const {
+  SHOGLE_ASSERT(!invalidated(), "gl_ring_buffer use after free");
+  return _region_size;
+}
+
+u32 gl_ring_buffer::region_count() const {
+  SHOGLE_ASSERT(!invalidated(), "gl_ring_buffer use after free");
+  return _region_count;
+}
+
+u32 gl_ring_buffer::current_region() const {
+  SHOGLE_ASSERT(!invalidated(), "gl_ring_buffer use after free");
+  return _region;
+}
+
+size_t gl_ring_buffer::region_used() const {
+  SHOGLE_ASSERT(!invalidated(), "gl_ring_buffer use after free");
+  return _offset;
+}
+
+size_t gl_ring_buffer::alignment() const {
+  SHOGLE_ASSERT(!invalidated(), "gl_ring_buffer use after free");
+  return _alignment;
+}
+
+u64 gl_ring_buffer::stall_count() const {
+  SHOGLE_ASSERT(!invalidated(), "gl_ring_buffer use after free");
+  return _stalls;
+}
+
+bool gl_ring_buffer::invalidated() const noexcept {
+  return _buffer.invalidated();
+}
+
+} // namespace shogle
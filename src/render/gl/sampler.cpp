@@ -0,0 +1,107 @@
+#include "./context_private.hpp"
+#include <shogle/render/gl/sampler.hpp>
+
+#include <bit>
+
+namespace shogle {
+
+gl_sampler::gl_sampler(create_t, gldefs::GLhandle id, const gl_sampler_desc& desc) :
+    _desc(desc), _id(id) {}
+
+gl_sampler::gl_sampler(gl_context& gl, const gl_sampler_desc& desc) :
+    gl_sampler(::shogle::gl_sampler::create(gl, desc).value()) {}
+
+gl_sv_expect<gl_sampler> gl_sampler::create(gl_context& gl, const gl_sampler_desc& desc) {
+  SHOGLE_ASSERT(desc.mag_filter == gl_texture::SAMPLER_NEAREST ||
+                  desc.mag_filter == gl_texture::SAMPLER_LINEAR,
+                "Invalid sampler mag filter");
+  GLuint sampler;
+  GL_ASSERT(glGenSamplers(1, &sampler));
+  GL_ASSERT(glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, desc.min_filter));
+  GL_ASSERT(glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, desc.mag_filter));
+  GL_ASSERT(glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, desc.wrap_s));
+  GL_ASSERT(glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, desc.wrap_t));
+  GL_ASSERT(glSamplerParameteri(sampler, GL_TEXTURE_WRAP_R, desc.wrap_r));
+  GL_ASSERT(glSamplerParameterf(sampler, GL_TEXTURE_LOD_BIAS, desc.lod_bias));
+  if (desc.compare != gl_sampler_desc::COMPARE_NONE) {
+    GL_ASSERT(glSamplerParameteri(sampler, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE));
+    GL_ASSERT(glSamplerParameteri(sampler, GL_TEXTURE_COMPARE_FUNC, desc.compare));
+  }
+  const f32 max_anisotropy = impl::gl_get_private(gl).max_anisotropy;
+  if (desc.max_anisotropy > 1.f && max_anisotropy > 1.f) {
+    GL_ASSERT(glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY,
+                                  std::min(desc.max_anisotropy, max_anisotropy)));
+  }
+  const auto err = gl_call_error(gl);
+  if (err) {
+    GL_ASSERT(glDeleteSamplers(1, &sampler));
+    return {unexpect, "Failed to create sampler", err};
+  }
+  SHOGLE_GL_LOG(VERBOSE, "SAMPLER_CREATE ({}) [min: {}, mag: {}, anisotropy: {}]", sampler,
+                static_cast<GLenum>(desc.min_filter), static_cast<GLenum>(desc.mag_filter),
+                desc.max_anisotropy);
+  return {in_place, create_t{}, sampler, desc};
+}
+
+void gl_sampler::destroy(gl_context& gl, gl_sampler& sampler) noexcept {
+  if (SHOGLE_UNLIKELY(sampler.invalidated())) {
+    return;
+  }
+  GL_ASSERT(glDeleteSamplers(1, &sampler._id));
+  gl_get_state(gl).forget_sampler(sampler._id);
+  sampler._id = GL_NULL_HANDLE;
+}
+
+gldefs::GLhandle gl_sampler::id() const {
+  SHOGLE_ASSERT(!invalidated(), "gl_sampler use after free");
+  return _id;
+}
+
+const gl_sampler_desc& gl_sampler::desc() const {
+  SHOGLE_ASSERT(!invalidated(), "gl_sampler use after free");
+  return _desc;
+}
+
+bool gl_sampler::invalidated() const noexcept {
+  return _id == GL_NULL_HANDLE;
+}
+
+size_t gl_sampler_cache::desc_hash::operator()(const gl_sampler_desc& desc) const noexcept {
+  const auto mix = [](u64 hash, u64 value) { return (hash ^ value) * 0x100000001b3; };
+  // -0.f compares equal to 0.f, both need the same bits to keep the hash consistent with ==
+  const auto float_bits = [](f32 value) -> u64 {
+    return std::bit_cast<u32>(value == 0.f ? 0.f : value);
+  };
+  u64 hash = 0xcbf29ce484222325;
+  hash = mix(hash, (u64{desc.min_filter} << 32) | desc.mag_filter);
+  hash = mix(hash, (u64{desc.wrap_s} << 32) | desc.wrap_t);
+  hash = mix(hash, (u64{desc.wrap_r} << 32) | desc.compare);
+  hash = mix(hash, (float_bits(desc.max_anisotropy) << 32) | float_bits(desc.lod_bias));
+  return static_cast<size_t>(hash);
+}
+
+gl_sv_expect<ref_view<const gl_sampler>> gl_sampler_cache::get(gl_context& gl,
+                                                               const gl_sampler_desc& desc) {
+  if (auto it = _samplers.find(desc); it != _samplers.end()) {
+    return {in_place, it->second};
+  }
+  auto sampler = gl_sampler::create(gl, desc);
+  if (!sampler) {
+    return {unexpect, sampler.error()};
+  }
+  // Map nodes are stable, the reference stays valid as the cache grows
+  auto [it, _] = _samplers.emplace(desc, std::move(*sampler));
+  return {in_place, it->second};
+}
+
+void gl_sampler_cache::destroy(gl_context& gl, gl_sampler_cache& cache) noexcept {
+  if (SHOGLE_UNLIKELY(cache.invalidated())) {
+    return;
+  }
+  for (auto& [_, sampler] : cache._samplers) {
+    gl_sampler::destroy(gl, sampler);
+  }
+  cache._samplers.clear();
+}
+
+} // namespace shogle
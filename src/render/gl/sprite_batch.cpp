@@ -0,0 +1,271 @@
+#include "./context_private.hpp"
+#include <shogle/render/gl/sprite_batch.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace shogle {
+
+namespace {
+
+constexpr u32 LAYER_SHIFT = 48;
+constexpr u32 PIPELINE_SHIFT = 32;
+constexpr u32 MAX_PIPELINES = 1u << (LAYER_SHIFT - PIPELINE_SHIFT);
+
+// Unit quad corners, same winding as the index pattern below
+constexpr f32 CORNER_X[] = {-.5f, .5f, .5f, -.5f};
+constexpr f32 CORNER_Y[] = {-.5f, -.5f, .5f, .5f};
+constexpr u32 QUAD_INDICES[] = {0, 1, 2, 2, 3, 0};
+
+// Same result as trs_transform2d_roll, without building the matrix:
+// pos + pivot + R(rot) * (offset - pivot + scale * (corner - offset))
+void expand_quad(const gl_sprite_batch::sprite_quad& quad,
+                 gl_sprite_batch::sprite_vertex* out) noexcept {
+  const auto& tr = quad.transform;
+  const f32 c = std::cos(tr.rot);
+  const f32 s = std::sin(tr.rot);
+  const f32 base_x = tr.offset.x - tr.pivot.x - tr.scale.x * tr.offset.x;
+  const f32 base_y = tr.offset.y - tr.pivot.y - tr.scale.y * tr.offset.y;
+  const f32 origin_x = tr.pos.x + tr.pivot.x;
+  const f32 origin_y = tr.pos.y + tr.pivot.y;
+  const f32 uv_x[] = {quad.uvs.x, quad.uvs.z, quad.uvs.z, quad.uvs.x};
+  const f32 uv_y[] = {quad.uvs.w, quad.uvs.w, quad.uvs.y, quad.uvs.y};
+  for (u32 i = 0; i < gl_sprite_batch::VERTICES_PER_SPRITE; ++i) {
+    const f32 x = base_x + tr.scale.x * CORNER_X[i];
+    const f32 y = base_y + tr.scale.y * CORNER_Y[i];
+    out[i].pos.x = origin_x + c * x - s * y;
+    out[i].pos.y = origin_y + s * x + c * y;
+    out[i].uvs.x = uv_x[i];
+    out[i].uvs.y = uv_y[i];
+    out[i].color = quad.color;
+  }
+}
+
+} // namespace
+
+gl_sprite_batch::gl_sprite_batch(create_t, gl_ring_buffer&& vertices, gl_buffer indices,
+                                 gl_vertex_layout layout, const create_args& args) :
+    _vertices(std::move(vertices)), _indices(std::move(indices)), _layout(std::move(layout)),
+    _last_key(std::numeric_limits<u64>::max()), _last_group(0), _max_sprites(args.max_sprites),
+    _texture_unit(args.texture_unit), _pipeline(0), _frame_sprites(0), _draw_count(0) {
+  _quads.reserve(args.max_sprites);
+  _quad_groups.reserve(args.max_sprites);
+}
+
+gl_sprite_batch::gl_sprite_batch(gl_context& gl, const create_args& args) :
+    gl_sprite_batch(::shogle::gl_sprite_batch::create(gl, args).value()) {}
+
+gl_sv_expect<gl_sprite_batch> gl_sprite_batch::create(gl_context& gl, const create_args& args) {
+  if (!args.max_sprites ||
+      u64{args.max_sprites} * VERTICES_PER_SPRITE > std::numeric_limits<u32>::max()) {
+    return {unexpect, "Invalid sprite count", GL_INVALID_VALUE};
+  }
+
+  const size_t sprite_size = VERTICES_PER_SPRITE * sizeof(sprite_vertex);
+  const size_t region_size = size_t{args.max_sprites} * sprite_size;
+  auto vertices =
+    gl_ring_buffer::create(gl, gl_buffer::TYPE_VERTEX, region_size, args.frame_regions);
+  if (!vertices) {
+    return {unexpect, "Failed to allocate sprite vertex ring", vertices.error().code()};
+  }
+
+  // Every sprite uses the same pattern, shifted by four vertices
+  std::vector<u32> index_data(size_t{args.max_sprites} * INDICES_PER_SPRITE);
+  for (u32 i = 0; i < args.max_sprites; ++i) {
+    for (u32 j = 0; j < INDICES_PER_SPRITE; ++j) {
+      index_data[i * INDICES_PER_SPRITE + j] = i * VERTICES_PER_SPRITE + QUAD_INDICES[j];
+    }
+  }
+  auto indices = gl_buffer::allocate(gl, gl_buffer::TYPE_INDEX, index_data.size() * sizeof(u32),
+                                     gl_buffer::DEFAULT_INMUTABLE_USAGE, index_data.data());
+  if (!indices) {
+    gl_ring_buffer::destroy(gl, *vertices);
+    return {unexpect, "Failed to allocate sprite index buffer", indices.error().code()};
+  }
+
+  auto layout = gl_vertex_layout::from_aos_vertex<sprite_vertex>(gl);
+  if (!layout) {
+    gl_buffer::deallocate(gl, *indices);
+    gl_ring_buffer::destroy(gl, *vertices);
+    return {unexpect, "Failed to create sprite vertex layout", layout.error().code()};
+  }
+  SHOGLE_GL_LOG(VERBOSE, "SPRITE_BATCH_CREATE ({}) [sprites: {}, regions: {}]",
+                vertices->buffer().id(), args.max_sprites, args.frame_regions);
+  return {in_place, create_t{}, std::move(*vertices), *indices, *layout, args};
+}
+
+void gl_sprite_batch::destroy(gl_context& gl, gl_sprite_batch& batch) noexcept {
+  if (SHOGLE_UNLIKELY(batch.invalidated())) {
+    return;
+  }
+  gl_vertex_layout::destroy(gl, batch._layout);
+  gl_buffer::deallocate(gl, batch._indices);
+  gl_ring_buffer::destroy(gl, batch._vertices);
+  batch._quads.clear();
+  batch._quad_groups.clear();
+  batch._groups.clear();
+  batch._group_lookup.clear();
+  batch._pipelines.clear();
+  batch._vertex_binds.clear();
+  batch._texture_binds.clear();
+}
+
+void gl_sprite_batch::expand_quads(span<const sprite_quad> quads, sprite_vertex* out) noexcept {
+  for (const auto& quad : quads) {
+    expand_quad(quad, out);
+    out += VERTICES_PER_SPRITE;
+  }
+}
+
+gl_expect<void> gl_sprite_batch::begin_frame(gl_context& gl) {
+  SHOGLE_ASSERT(!invalidated(), "gl_sprite_batch use after free");
+  auto ret = _vertices.begin_frame(gl);
+  _frame_sprites = 0;
+  _vertex_binds.clear();
+  _texture_binds.clear();
+  return ret;
+}
+
+void gl_sprite_batch::end_frame(gl_context& gl) {
+  SHOGLE_ASSERT(!invalidated(), "gl_sprite_batch use after free");
+  _vertices.end_frame(gl);
+}
+
+void gl_sprite_batch::set_pipeline(const gl_graphics_pipeline& pipeline) {
+  const auto it = std::find_if(_pipelines.begin(), _pipelines.end(),
+                               [&](const auto& ptr) { return ptr.data() == &pipeline; });
+  if (it != _pipelines.end()) {
+    _pipeline = static_cast<u32>(it - _pipelines.begin());
+    return;
+  }
+  SHOGLE_ASSERT(_pipelines.size() < MAX_PIPELINES, "Too many sprite pipelines");
+  _pipeline = static_cast<u32>(_pipelines.size());
+  _pipelines.emplace_back(pipeline);
+}
+
+bool gl_sprite_batch::draw(const gl_texture& texture, const rectangle_pos<u32>& source,
+                           const math::transform2d<f32>& transform, const color4& color,
+                           u32 layer) {
+  SHOGLE_ASSERT(!_pipelines.empty(), "No pipeline set in sprite batch");
+  SHOGLE_ASSERT(layer < MAX_LAYERS, "Sprite layer out of range");
+  if (_frame_sprites + _quads.size() >= _max_sprites) {
+    return false;
+  }
+
+  const u64 key = (u64{layer} << LAYER_SHIFT) | (u64{_pipeline} << PIPELINE_SHIFT) | texture.id();
+  _quad_groups.emplace_back(_find_group(key, texture));
+  ++_groups[_quad_groups.back()].count;
+
+  const auto extent = texture.extent();
+  const f32 inv_w = 1.f / static_cast<f32>(extent.width);
+  const f32 inv_h = 1.f / static_cast<f32>(extent.height);
+  const vec4 uvs{static_cast<f32>(source.x) * inv_w, static_cast<f32>(source.y) * inv_h,
+                 static_cast<f32>(source.x + source.width) * inv_w,
+                 static_cast<f32>(source.y + source.height) * inv_h};
+  _quads.emplace_back(transform, uvs, color);
+  return true;
+}
+
+u32 gl_sprite_batch::_find_group(u64 key, const gl_texture& texture) {
+  // Consecutive sprites tend to share everything, skip the lookup for them
+  if (key == _last_key) {
+    return _last_group;
+  }
+  auto [it, inserted] = _group_lookup.try_emplace(key, static_cast<u32>(_groups.size()));
+  if (inserted) {
+    _groups.emplace_back(key, texture.id(), static_cast<gldefs::GLenum>(texture.type()), 0u, 0u);
+  }
+  _last_key = key;
+  _last_group = it->second;
+  return it->second;
+}
+
+gl_sv_expect<void> gl_sprite_batch::flush(gl_context& gl, ptr_view<const gl_framebuffer> target,
+                                          span<const gl_draw_command::push_uniform> uniforms) {
+  SHOGLE_ASSERT(!invalidated(), "gl_sprite_batch use after free");
+  _draw_count = 0;
+  if (_quads.empty()) {
+    return {};
+  }
+
+  const u32 quad_count = static_cast<u32>(_quads.size());
+  // Indices are relative to the binding offset, so the allocation needs no vertex alignment
+  const size_t sprite_size = VERTICES_PER_SPRITE * sizeof(sprite_vertex);
+  auto alloc = _vertices.allocate(size_t{quad_count} * sprite_size);
+  if (!alloc) {
+    return {unexpect, "Sprite vertex ring out of space", GL_OUT_OF_MEMORY};
+  }
+
+  // Few groups compared to sprites, sort the groups and scatter the sprites in one pass
+  std::sort(_groups.begin(), _groups.end(),
+            [](const sprite_group& a, const sprite_group& b) { return a.key < b.key; });
+  _cursors.resize(_groups.size());
+  u32 first = 0;
+  for (auto& group : _groups) {
+    group.first = first;
+    first += group.count;
+    _cursors[_group_lookup.find(group.key)->second] = group.first;
+  }
+  auto* out = static_cast<sprite_vertex*>(alloc->ptr);
+  for (u32 i = 0; i < quad_count; ++i) {
+    const u32 pos = _cursors[_quad_groups[i]]++;
+    expand_quad(_quads[i], out + size_t{pos} * VERTICES_PER_SPRITE);
+  }
+
+  const auto& vertex_bind = _vertex_binds.emplace_back(_vertices.buffer().id(), 0u, alloc->offset);
+  for (const auto& group : _groups) {
+    const auto& texture_bind =
+      _texture_binds.emplace_back(group.texture, group.texture_type, _texture_unit,
+                                  GL_DEFAULT_BINDING);
+    const u32 pipeline = static_cast<u32>(group.key >> PIPELINE_SHIFT) & (MAX_PIPELINES - 1);
+    const gl_draw_command cmd{
+      .vertex_layout = _layout,
+      .pipeline = *_pipelines[pipeline],
+      .vertex_bindings = {&vertex_bind, 1},
+      .shader_bindings = {},
+      .texture_bindings = {&texture_bind, 1},
+      .uniforms = uniforms,
+      .index_bind = gl_draw_command::index_binding{_indices.id(),
+                                                   gl_draw_command::INDEX_FORMAT_U32,
+                                                   size_t{group.first} * INDICES_PER_SPRITE},
+      .viewport = {},
+      .scissor = {},
+      .vertex_offset = 0,
+      .draw_count = group.count * INDICES_PER_SPRITE,
+      .instances = 1,
+    };
+    gl.submit_command(cmd, target);
+    ++_draw_count;
+  }
+
+  _frame_sprites += quad_count;
+  _quads.clear();
+  _quad_groups.clear();
+  _groups.clear();
+  _group_lookup.clear();
+  _last_key = std::numeric_limits<u64>::max();
+  return {};
+}
+
+const gl_vertex_layout& gl_sprite_batch::layout() const {
+  SHOGLE_ASSERT(!invalidated(), "gl_sprite_batch use after free");
+  return _layout;
+}
+
+u32 gl_sprite_batch::size() const {
+  return static_cast<u32>(_quads.size());
+}
+
+u32 gl_sprite_batch::capacity() const {
+  return _max_sprites - _frame_sprites;
+}
+
+u32 gl_sprite_batch::draw_count() const {
+  return _draw_count;
+}
+
+bool gl_sprite_batch::invalidated() const noexcept {
+  return _vertices.invalidated();
+}
+
+} // namespace shogle
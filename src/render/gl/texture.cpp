@@ -49,14 +49,19 @@ auto allocate_textures(gl_context& gl, const gldefs::GLenum* texes, u32 count,
   SHOGLE_ASSERT(texes != nullptr && count > 0);
   SHOGLE_ASSERT(args.levels <= gl_texture::MAX_MIPMAP_LEVEL);
 
+  const bool dsa = impl::gl_get_private(gl).direct_state_access;
   gldefs::GLenum err = 0;
   const auto allocate1d = [&](u32 width) -> u32 {
     SHOGLE_ASSERT(width);
     constexpr auto type = gl_texture::TEX_TYPE_1D;
     u32 i = 0;
     for (; i < count; ++i) {
-      GL_ASSERT(glBindTexture(type, texes[i]));
-      err = GL_RET_ERR(glTexStorage1D(type, args.levels, args.format, width));
+      if (dsa) {
+        err = GL_RET_ERR(glTextureStorage1D(texes[i], args.levels, args.format, width));
+      } else {
+        GL_ASSERT(glBindTexture(type, texes[i]));
+        err = GL_RET_ERR(glTexStorage1D(type, args.levels, args.format, width));
+      }
       if (err) {
         return i;
       }
@@ -68,22 +73,20 @@ auto allocate_textures(gl_context& gl, const gldefs::GLenum* texes, u32 count,
     SHOGLE_ASSERT(width);
     SHOGLE_ASSERT(height);
     u32 i = 0;
-    if (!ms) {
-      for (; i < count; ++i) {
+    for (; i < count; ++i) {
+      if (dsa) {
+        err = ms ? GL_RET_ERR(glTextureStorage2DMultisample(texes[i], args.levels, args.format,
+                                                             width, height, ms - 1))
+                 : GL_RET_ERR(glTextureStorage2D(texes[i], args.levels, args.format, width,
+                                                 height));
+      } else {
         GL_ASSERT(glBindTexture(type, texes[i]));
-        err = GL_RET_ERR(glTexStorage2D(type, args.levels, args.format, width, height));
-        if (err) {
-          return i;
-        }
+        err = ms ? GL_RET_ERR(glTexStorage2DMultisample(type, args.levels, args.format, width,
+                                                         height, ms - 1))
+                 : GL_RET_ERR(glTexStorage2D(type, args.levels, args.format, width, height));
       }
-    } else {
-      for (; i < count; ++i) {
-        GL_ASSERT(glBindTexture(type, texes[i]));
-        err = GL_RET_ERR(
-          glTexStorage2DMultisample(type, args.levels, args.format, width, height, ms - 1));
-        if (err) {
-          return i;
-        }
+      if (err) {
+        return i;
       }
     }
     return i;
@@ -94,22 +97,21 @@ auto allocate_textures(gl_context& gl, const gldefs::GLenum* texes, u32 count,
     SHOGLE_ASSERT(height);
     SHOGLE_ASSERT(depth);
     u32 i = 0;
-    if (ms) {
-      for (; i < count; ++i) {
+    for (; i < count; ++i) {
+      if (dsa) {
+        err = ms ? GL_RET_ERR(glTextureStorage3DMultisample(texes[i], args.levels, args.format,
+                                                             width, height, depth, ms - 1))
+                 : GL_RET_ERR(glTextureStorage3D(texes[i], args.levels, args.format, width,
+                                                 height, depth));
+      } else {
         GL_ASSERT(glBindTexture(type, texes[i]));
-        err = GL_RET_ERR(glTexStorage3D(type, args.levels, args.format, width, height, depth));
-        if (err) {
-          return i;
-        }
+        err = ms ? GL_RET_ERR(glTexStorage3DMultisample(type, args.levels, args.format, width,
+                                                         height, depth, ms - 1))
+                 : GL_RET_ERR(glTexStorage3D(type, args.levels, args.format, width, height,
+                                             depth));
       }
-    } else {
-      for (; i < count; ++i) {
-        GL_ASSERT(glBindTexture(type, texes[i]));
-        err = GL_RET_ERR(
-          glTexStorage3DMultisample(type, args.levels, args.format, width, height, depth, ms - 1));
-        if (err) {
-          return i;
-        }
+      if (err) {
+        return i;
       }
     }
     return i;
@@ -156,10 +158,23 @@ auto allocate_textures(gl_context& gl, const gldefs::GLenum* texes, u32 count,
     };
   }
 
-  GL_ASSERT(glBindTexture(args.type, GL_DEFAULT_BINDING));
+  if (!dsa) {
+    GL_ASSERT(glBindTexture(args.type, GL_DEFAULT_BINDING));
+    gl_get_state(gl).forget_bound_texture();
+  }
   return {allocated, err};
 }
 
+// Named functions need the target fixed at creation, glGenTextures leaves it to the first bind
+void gen_textures(gl_context& gl, gl_texture::texture_type type, u32 count,
+                  gldefs::GLhandle* texes) {
+  if (impl::gl_get_private(gl).direct_state_access) {
+    GL_ASSERT(glCreateTextures(type, count, texes));
+  } else {
+    GL_ASSERT(glGenTextures(count, texes));
+  }
+}
+
 #ifndef SHOGLE_DISABLE_INTERNAL_LOGS
 std::string_view tex_format_string(gl_texture::texture_format format) {
 #define STR(enum_)                     \
@@ -238,6 +253,20 @@ std::string_view tex_format_string(gl_texture::texture_format format) {
     STR(SRGB8);
     STR(SRGB8_AL8);
 
+    STR(BC1_RGB);
+    STR(BC1_RGBA);
+    STR(BC3_RGBA);
+    STR(BC1_SRGB);
+    STR(BC3_SRGB_AL);
+    STR(BC4_R);
+    STR(BC5_RG);
+    STR(BC7_RGBA);
+    STR(BC7_SRGB_AL);
+    STR(ETC2_RGB8);
+    STR(ETC2_SRGB8);
+    STR(ETC2_RGBA8);
+    STR(ETC2_SRGB8_AL8);
+
     default:
       SHOGLE_UNREACHABLE();
   }
@@ -375,12 +404,58 @@ void log_destroy([[maybe_unused]] gl_context& gl, const gl_texture& tex) {
 }
 #endif
 
+size_t pixel_size(gl_texture::pixel_format format, gl_texture::pixel_data_type datatype) {
+  size_t components = 1;
+  switch (format) {
+    case gl_texture::PIXEL_FORMAT_RG: {
+      components = 2;
+    } break;
+    case gl_texture::PIXEL_FORMAT_RGB:
+      [[fallthrough]];
+    case gl_texture::PIXEL_FORMAT_BGR: {
+      components = 3;
+    } break;
+    case gl_texture::PIXEL_FORMAT_RGBA:
+      [[fallthrough]];
+    case gl_texture::PIXEL_FORMAT_BGRA: {
+      components = 4;
+    } break;
+    default:
+      break;
+  }
+
+  switch (datatype) {
+    case gl_texture::PIXEL_TYPE_I8:
+      [[fallthrough]];
+    case gl_texture::PIXEL_TYPE_U8:
+      return components;
+    case gl_texture::PIXEL_TYPE_I16:
+      [[fallthrough]];
+    case gl_texture::PIXEL_TYPE_U16:
+      [[fallthrough]];
+    case gl_texture::PIXEL_TYPE_F16:
+      return components * 2;
+    case gl_texture::PIXEL_TYPE_U32D24S8:
+      // Packed depth stencil, always a single component
+      return 4;
+    default:
+      return components * 4;
+  }
+}
+
 } // namespace
 
+size_t gl_image_size(const extent3d& extent, gl_texture::pixel_format format,
+                     gl_texture::pixel_data_type datatype, gl_texture::pixel_alignment alignment) {
+  const size_t align = static_cast<size_t>(alignment);
+  const size_t row = (extent.width * pixel_size(format, datatype) + align - 1) / align * align;
+  return row * std::max(extent.height, 1u) * std::max(extent.depth, 1u);
+}
+
 auto gl_texture::_allocate_span(gl_context& gl, span<gldefs::GLenum> texes,
                                 const allocate_args& args) -> n_err_return {
   SHOGLE_ASSERT(!texes.empty());
-  GL_ASSERT(glGenTextures(texes.size(), texes.data()));
+  gen_textures(gl, args.type, texes.size(), texes.data());
   const auto allocated = allocate_textures(gl, texes.data(), texes.size(), args);
 #ifndef SHOGLE_DISABLE_INTERNAL_LOGS
   for (u32 i = 0; i < allocated.first; ++i) {
@@ -396,7 +471,6 @@ auto gl_texture::_allocate_span(gl_context& gl, span<gldefs::GLenum> texes,
 gl_expect<gl_texture> gl_texture::allocate1d(gl_context& gl, texture_format format, u32 extent,
                                              u32 levels, u32 layers) {
   gldefs::GLenum tex;
-  GL_ASSERT(glGenTextures(1, &tex));
   const allocate_args args{
     .extent = ::shogle::meta::extent_traits<u32>::extent_clamp3d(extent),
     .type = layers > 1 ? TEX_TYPE_1D_ARRAY : TEX_TYPE_1D,
@@ -405,6 +479,7 @@ gl_expect<gl_texture> gl_texture::allocate1d(gl_context& gl, texture_format form
     .layers = std::max(layers, 1u),
     .multisampling = MULTISAMPLE_NONE,
   };
+  gen_textures(gl, args.type, 1, &tex);
   const auto [allocated, err] = allocate_textures(gl, &tex, 1, args);
   SHOGLE_UNUSED(allocated);
   if (err) {
@@ -423,7 +498,6 @@ gl_expect<gl_texture> gl_texture::allocate2d(gl_context& gl, texture_format form
                                              const extent2d& extent, u32 levels, u32 layers,
                                              multisample_opt multisampling) {
   gldefs::GLenum tex;
-  GL_ASSERT(glGenTextures(1, &tex));
   const allocate_args args{
     .extent = ::shogle::meta::extent_traits<extent2d>::extent_clamp3d(extent),
     .type = multisampling ? (layers > 1 ? TEX_TYPE_2D_MULTISAMPLE_ARRAY : TEX_TYPE_2D_MULTISAMPLE)
@@ -433,6 +507,7 @@ gl_expect<gl_texture> gl_texture::allocate2d(gl_context& gl, texture_format form
     .layers = std::max(layers, 1u),
     .multisampling = multisampling,
   };
+  gen_textures(gl, args.type, 1, &tex);
   const auto [allocated, err] = allocate_textures(gl, &tex, 1, args);
   SHOGLE_UNUSED(allocated);
   if (err) {
@@ -450,7 +525,6 @@ gl_expect<gl_texture> gl_texture::allocate2d(gl_context& gl, texture_format form
 gl_expect<gl_texture> gl_texture::allocate_cubemap(gl_context& gl, texture_format format,
                                                    u32 extent, u32 levels) {
   gldefs::GLenum tex;
-  GL_ASSERT(glGenTextures(1, &tex));
   const allocate_args args{
     .extent = ::shogle::meta::extent_traits<extent2d>::extent_clamp3d(extent2d{extent, extent}),
     .type = TEX_TYPE_CUBEMAP,
@@ -459,6 +533,7 @@ gl_expect<gl_texture> gl_texture::allocate_cubemap(gl_context& gl, texture_forma
     .layers = 1u,
     .multisampling = MULTISAMPLE_NONE,
   };
+  gen_textures(gl, args.type, 1, &tex);
   const auto [allocated, err] = allocate_textures(gl, &tex, 1, args);
   SHOGLE_UNUSED(allocated);
   if (err) {
@@ -476,7 +551,6 @@ gl_expect<gl_texture> gl_texture::allocate_cubemap(gl_context& gl, texture_forma
 gl_expect<gl_texture> gl_texture::allocate3d(gl_context& gl, texture_format format,
                                              const extent3d& extent, u32 levels) {
   gldefs::GLenum tex;
-  GL_ASSERT(glGenTextures(1, &tex));
   const allocate_args args{
     .extent = ::shogle::meta::extent_traits<extent3d>::extent_clamp3d(extent),
     .type = TEX_TYPE_3D,
@@ -485,6 +559,7 @@ gl_expect<gl_texture> gl_texture::allocate3d(gl_context& gl, texture_format form
     .layers = 1u,
     .multisampling = MULTISAMPLE_NONE,
   };
+  gen_textures(gl, args.type, 1, &tex);
   const auto [allocated, err] = allocate_textures(gl, &tex, 1, args);
   SHOGLE_UNUSED(allocated);
   if (err) {
@@ -503,11 +578,18 @@ gl_expect<gl_texture> gl_texture::bind_to_buffer(gl_context& gl, const gl_buffer
                                                  texture_format format, size_t size,
                                                  size_t offset) {
   gldefs::GLenum tex;
-  GL_ASSERT(glGenTextures(1, &tex));
-  GL_ASSERT(glBindTexture(TEX_TYPE_BUFFER, tex));
-  auto err = GL_RET_ERR(
-    glTexBufferRange(TEX_TYPE_BUFFER, format, buffer.id(), (GLintptr)offset, (GLsizeiptr)size));
-  GL_ASSERT(glBindTexture(TEX_TYPE_BUFFER, GL_DEFAULT_BINDING));
+  gen_textures(gl, TEX_TYPE_BUFFER, 1, &tex);
+  GLenum err;
+  if (impl::gl_get_private(gl).direct_state_access) {
+    err = GL_RET_ERR(
+      glTextureBufferRange(tex, format, buffer.id(), (GLintptr)offset, (GLsizeiptr)size));
+  } else {
+    GL_ASSERT(glBindTexture(TEX_TYPE_BUFFER, tex));
+    err = GL_RET_ERR(
+      glTexBufferRange(TEX_TYPE_BUFFER, format, buffer.id(), (GLintptr)offset, (GLsizeiptr)size));
+    GL_ASSERT(glBindTexture(TEX_TYPE_BUFFER, GL_DEFAULT_BINDING));
+    gl_get_state(gl).forget_bound_texture();
+  }
   if (err) {
     GL_ASSERT(glDeleteTextures(1, &tex));
     return {unexpect, err};
@@ -521,6 +603,7 @@ void gl_texture::deallocate(gl_context& gl, gl_texture& tex) {
     return;
   }
   GL_ASSERT(glDeleteTextures(1, &id));
+  gl_get_state(gl).forget_texture(id);
 #ifndef SHOGLE_DISABLE_INTERNAL_LOGS
   log_destroy(gl, tex);
 #endif
@@ -535,6 +618,7 @@ void gl_texture::deallocate_n(gl_context& gl, gl_texture* texes, u32 tex_count)
     auto id = texes[i]._id;
     if (id != GL_NULL_HANDLE) {
       GL_ASSERT(glDeleteTextures(1, &id));
+      gl_get_state(gl).forget_texture(id);
 #ifndef SHOGLE_DISABLE_INTERNAL_LOGS
       log_destroy(gl, texes[i]);
 #endif
@@ -548,6 +632,7 @@ void gl_texture::deallocate_n(gl_context& gl, span<gl_texture> texes) {
     auto id = tex._id;
     if (id != GL_NULL_HANDLE) {
       GL_ASSERT(glDeleteTextures(1, &id));
+      gl_get_state(gl).forget_texture(id);
 #ifndef SHOGLE_DISABLE_INTERNAL_LOGS
       log_destroy(gl, tex);
 #endif
@@ -558,83 +643,109 @@ void gl_texture::deallocate_n(gl_context& gl, span<gl_texture> texes) {
 
 namespace {
 
+// Array textures take one image per layer starting at first_layer
 auto do_upload_images(gl_context& gl, gldefs::GLhandle tex, gl_texture::texture_type type,
                       const gl_texture::image_data* images, u32 image_count,
-                      const extent3d& offset, u32 level) -> gl_texture::n_err_return {
+                      const extent3d& offset, u32 first_layer,
+                      u32 level) -> gl_texture::n_err_return {
   if (type == gl_texture::TEX_TYPE_BUFFER) {
     return {0, GL_INVALID_VALUE};
   }
   SHOGLE_ASSERT(images != nullptr && image_count);
 
+  const bool dsa = impl::gl_get_private(gl).direct_state_access;
   gldefs::GLenum err = 0;
   const auto upload1d = [&](u32 xoff) {
     u32 i = 0;
     for (; i < image_count; ++i) {
       const auto& image = images[i];
       GL_ASSERT(glPixelStorei(GL_UNPACK_ALIGNMENT, image.alignment));
-      err = GL_RET_ERR(glTexSubImage1D(type, level, xoff, image.extent.width, image.format,
-                                       image.datatype, image.data));
+      err = dsa ? GL_RET_ERR(glTextureSubImage1D(tex, level, xoff, image.extent.width,
+                                                 image.format, image.datatype, image.data))
+                : GL_RET_ERR(glTexSubImage1D(type, level, xoff, image.extent.width, image.format,
+                                             image.datatype, image.data));
       if (err) {
         return i;
       }
+      GL_FRAME_STAT(texture_upload_bytes,
+                    gl_image_size(image.extent, image.format, image.datatype, image.alignment));
     }
     return i;
   };
-  const auto upload2d = [&](u32 yoff) {
+  const auto upload2d = [&](u32 yoff, bool layered) {
     u32 i = 0;
     for (; i < image_count; ++i) {
       const auto& image = images[i];
+      const u32 y = layered ? yoff + i : yoff;
       GL_ASSERT(glPixelStorei(GL_UNPACK_ALIGNMENT, image.alignment));
-      err =
-        GL_RET_ERR(glTexSubImage2D(type, level, offset.width, yoff ? yoff : i, image.extent.width,
-                                   image.extent.height, image.format, image.datatype, image.data));
+      err = dsa ? GL_RET_ERR(glTextureSubImage2D(tex, level, offset.width, y,
+                                                 image.extent.width, image.extent.height,
+                                                 image.format, image.datatype, image.data))
+                : GL_RET_ERR(glTexSubImage2D(type, level, offset.width, y,
+                                             image.extent.width, image.extent.height,
+                                             image.format, image.datatype, image.data));
       if (err) {
         return i;
       }
+      GL_FRAME_STAT(texture_upload_bytes,
+                    gl_image_size(image.extent, image.format, image.datatype, image.alignment));
     }
     return i;
   };
-  const auto upload3d = [&](u32 zoff) {
+  const auto upload3d = [&](u32 zoff, bool layered) {
     u32 i = 0;
     for (; i < image_count; ++i) {
       const auto image = images[i];
+      const u32 z = layered ? zoff + i : zoff;
       GL_ASSERT(glPixelStorei(GL_UNPACK_ALIGNMENT, image.alignment));
-      err = GL_RET_ERR(glTexSubImage3D(type, level, offset.width, offset.height, zoff ? zoff : i,
-                                       image.extent.width, image.extent.height, image.extent.depth,
-                                       image.format, image.datatype, image.data));
+      err = dsa ? GL_RET_ERR(glTextureSubImage3D(tex, level, offset.width, offset.height,
+                                                 z, image.extent.width,
+                                                 image.extent.height, image.extent.depth,
+                                                 image.format, image.datatype, image.data))
+                : GL_RET_ERR(glTexSubImage3D(type, level, offset.width, offset.height,
+                                             z, image.extent.width,
+                                             image.extent.height, image.extent.depth,
+                                             image.format, image.datatype, image.data));
       if (err) {
         return i;
       }
+      GL_FRAME_STAT(texture_upload_bytes,
+                    gl_image_size(image.extent, image.format, image.datatype, image.alignment));
     }
     return i;
   };
 
-  GL_ASSERT(glBindTexture(type, tex));
+  if (!dsa) {
+    GL_ASSERT(glBindTexture(type, tex));
+  }
   u32 uploaded = 0;
   switch (type) {
     case gl_texture::TEX_TYPE_1D: {
       uploaded = upload1d(offset.width);
     } break;
     case gl_texture::TEX_TYPE_1D_ARRAY: {
-      uploaded = upload2d(0);
+      uploaded = upload2d(first_layer, true);
     } break;
     case gl_texture::TEX_TYPE_2D_MULTISAMPLE:
       [[fallthrough]];
     case gl_texture::TEX_TYPE_2D: {
-      uploaded = upload2d(offset.height);
+      uploaded = upload2d(offset.height, false);
     } break;
     case gl_texture::TEX_TYPE_2D_MULTISAMPLE_ARRAY:
       [[fallthrough]];
     case gl_texture::TEX_TYPE_2D_ARRAY: {
-      uploaded = upload3d(0);
+      uploaded = upload3d(first_layer, true);
     } break;
     case gl_texture::TEX_TYPE_3D: {
-      uploaded = upload3d(offset.depth);
+      uploaded = upload3d(offset.depth, false);
     }; break;
     default:
       SHOGLE_UNREACHABLE();
   }
-  GL_ASSERT(glBindTexture(type, GL_DEFAULT_BINDING));
+  if (!dsa) {
+    GL_ASSERT(glBindTexture(type, GL_DEFAULT_BINDING));
+    gl_get_state(gl).forget_bound_texture();
+  }
   return {uploaded, err};
 }
 
@@ -646,7 +757,7 @@ gl_expect<void> gl_texture::upload_image(gl_context& gl, const image_data& image
     return {unexpect, GL_INVALID_VALUE};
   }
 
-  const auto [count, err] = do_upload_images(gl, id(), type(), &image, 1, offset, level);
+  const auto [count, err] = do_upload_images(gl, id(), type(), &image, 1, offset, layer, level);
   if (err) {
     SHOGLE_GL_LOG(ERROR, "Texture upload failed ({}) [type: {}, ptr: {}, err: {}]", id(),
                   tex_type_string(type()), fmt::ptr(&image), ::shogle::gl_error_string(err));
@@ -661,12 +772,14 @@ gl_expect<void> gl_texture::upload_image(gl_context& gl, const image_data& image
 }
 
 auto gl_texture::upload_image_layers(gl_context& gl, const image_data* layers, u32 layer_count,
-                                     const extent3d& offset, u32 level) -> n_err_return {
-  if (!layers || !layer_count) {
+                                     const extent3d& offset, u32 level,
+                                     u32 first_layer) -> n_err_return {
+  if (!layers || !layer_count || first_layer >= _layers) {
     return {0, GL_INVALID_VALUE};
   }
-  layer_count = std::max(layer_count, _layers);
-  const auto [count, err] = do_upload_images(gl, id(), type(), layers, layer_count, offset, level);
+  layer_count = std::min(layer_count, _layers - first_layer);
+  const auto [count, err] =
+    do_upload_images(gl, id(), type(), layers, layer_count, offset, first_layer, level);
   SHOGLE_UNUSED(err);
 #ifndef SHOGLE_DISABLE_INTERNAL_LOGS
   if (err) {
@@ -676,31 +789,74 @@ auto gl_texture::upload_image_layers(gl_context& gl, const image_data* layers, u
       ::shogle::gl_error_string(err));
   }
   for (u32 i = 0; i < count; ++i) {
-    log_upload(gl, *this, layers[i], offset, i, level);
+    log_upload(gl, *this, layers[i], offset, first_layer + i, level);
   }
 #endif
   return {count, err};
 }
 
 auto gl_texture::upload_image_layers(gl_context& gl, span<const image_data> layers,
-                                     const extent3d& offset, u32 level) -> n_err_return {
-  if (layers.empty()) {
-    return {0, GL_INVALID_VALUE};
+                                     const extent3d& offset, u32 level,
+                                     u32 first_layer) -> n_err_return {
+  return upload_image_layers(gl, layers.data(), static_cast<u32>(layers.size()), offset, level,
+                             first_layer);
+}
+
+gl_expect<void> gl_texture::upload_compressed(gl_context& gl, const compressed_image_data& image,
+                                              const extent3d& offset, u32 level) {
+  SHOGLE_ASSERT(!invalidated(), "gl_texture use after free");
+  if (!is_compressed(_format)) {
+    return {unexpect, GL_INVALID_OPERATION};
   }
-  u32 layer_count = std::max((u32)layers.size(), _layers);
-  const auto [count, err] =
-    do_upload_images(gl, id(), type(), layers.data(), layer_count, offset, level);
-  SHOGLE_UNUSED(err);
-#ifndef SHOGLE_DISABLE_INTERNAL_LOGS
-  SHOGLE_GL_LOG(ERROR,
-                "Texture layer upload failure ({}) [type: {}, ptr:{}, uploaded: {}/{}, err: {}]",
-                id(), tex_type_string(type()), count, fmt::ptr(layers.data()), layer_count,
-                ::shogle::gl_error_string(err));
-  for (u32 i = 0; i < count; ++i) {
-    log_upload(gl, *this, layers[i], offset, i, level);
+  if (!image.data || image.size != compressed_image_size(image.extent, _format)) {
+    return {unexpect, GL_INVALID_VALUE};
   }
-#endif
-  return {count, err};
+
+  const auto [w, h, d] = image.extent;
+  const bool dsa = impl::gl_get_private(gl).direct_state_access;
+  GLenum err = GL_NO_ERROR;
+  if (!dsa) {
+    GL_ASSERT(glBindTexture(_type, _id));
+  }
+  switch (_type) {
+    case TEX_TYPE_2D: {
+      err = dsa ? GL_RET_ERR(glCompressedTextureSubImage2D(_id, level, offset.width,
+                                                           offset.height, w, std::max(h, 1u),
+                                                           _format, image.size, image.data))
+                : GL_RET_ERR(glCompressedTexSubImage2D(_type, level, offset.width, offset.height,
+                                                       w, std::max(h, 1u), _format, image.size,
+                                                       image.data));
+    } break;
+    case TEX_TYPE_2D_ARRAY:
+      [[fallthrough]];
+    case TEX_TYPE_3D: {
+      err = dsa ? GL_RET_ERR(glCompressedTextureSubImage3D(
+                    _id, level, offset.width, offset.height, offset.depth, w, std::max(h, 1u),
+                    std::max(d, 1u), _format, image.size, image.data))
+                : GL_RET_ERR(glCompressedTexSubImage3D(
+                    _type, level, offset.width, offset.height, offset.depth, w, std::max(h, 1u),
+                    std::max(d, 1u), _format, image.size, image.data));
+    } break;
+    default: {
+      // Block formats can't be used with 1D, buffer or multisample textures
+      err = GL_INVALID_OPERATION;
+    } break;
+  }
+  if (!dsa) {
+    GL_ASSERT(glBindTexture(_type, GL_DEFAULT_BINDING));
+    gl_get_state(gl).forget_bound_texture();
+  }
+  if (err) {
+    SHOGLE_GL_LOG(ERROR, "Compressed texture upload failed ({}) [type: {}, format: {}, err: {}]",
+                  _id, tex_type_string(_type), tex_format_string(_format),
+                  ::shogle::gl_error_string(err));
+    return {unexpect, err};
+  }
+  GL_FRAME_STAT(texture_upload_bytes, image.size);
+  SHOGLE_GL_LOG(VERBOSE,
+                "TEXTURE_WRITE_COMPRESSED ({}) [format: {}, sz: {}x{}x{}, bytes: {}, lvl: {}]",
+                _id, tex_format_string(_format), w, h, d, image.size, level);
+  return {};
 }
 
 void gl_texture::generate_mipmaps(gl_context& gl) {
@@ -708,18 +864,77 @@ void gl_texture::generate_mipmaps(gl_context& gl) {
     return;
   }
   SHOGLE_ASSERT(!invalidated(), "gl_texture use after free");
-  GL_ASSERT(glBindTexture(type(), id()));
-  GL_ASSERT(glGenerateMipmap(type()));
-  GL_ASSERT(glBindTexture(type(), GL_DEFAULT_BINDING));
+  if (impl::gl_get_private(gl).direct_state_access) {
+    GL_ASSERT(glGenerateTextureMipmap(_id));
+  } else {
+    GL_ASSERT(glBindTexture(type(), id()));
+    GL_ASSERT(glGenerateMipmap(type()));
+    GL_ASSERT(glBindTexture(type(), GL_DEFAULT_BINDING));
+    gl_get_state(gl).forget_bound_texture();
+  }
   SHOGLE_GL_LOG(VERBOSE, "TEXTURE_GENMIPS ({}) [type: {}, lvls: {}, lyrs: {}]", _id,
                 tex_type_string(_type), _levels, _layers);
 }
 
+u32 gl_texture::compressed_block_size(texture_format format) noexcept {
+  switch (format) {
+    case TEX_FORMAT_BC1_RGB:
+      [[fallthrough]];
+    case TEX_FORMAT_BC1_RGBA:
+      [[fallthrough]];
+    case TEX_FORMAT_BC1_SRGB:
+      [[fallthrough]];
+    case TEX_FORMAT_BC4_R:
+      [[fallthrough]];
+    case TEX_FORMAT_ETC2_RGB8:
+      [[fallthrough]];
+    case TEX_FORMAT_ETC2_SRGB8:
+      return 8;
+    case TEX_FORMAT_BC3_RGBA:
+      [[fallthrough]];
+    case TEX_FORMAT_BC3_SRGB_AL:
+      [[fallthrough]];
+    case TEX_FORMAT_BC5_RG:
+      [[fallthrough]];
+    case TEX_FORMAT_BC7_RGBA:
+      [[fallthrough]];
+    case TEX_FORMAT_BC7_SRGB_AL:
+      [[fallthrough]];
+    case TEX_FORMAT_ETC2_RGBA8:
+      [[fallthrough]];
+    case TEX_FORMAT_ETC2_SRGB8_AL8:
+      return 16;
+    default:
+      return 0;
+  }
+}
+
+size_t gl_texture::compressed_image_size(const extent3d& extent, texture_format format) noexcept {
+  constexpr u32 block = COMPRESSED_BLOCK_EXTENT;
+  const size_t blocks_x = (extent.width + block - 1) / block;
+  const size_t blocks_y = (std::max(extent.height, 1u) + block - 1) / block;
+  return blocks_x * blocks_y * std::max(extent.depth, 1u) * compressed_block_size(format);
+}
+
+namespace {
+
+void set_parameter(gl_context& gl, gldefs::GLhandle tex, gl_texture::texture_type type,
+                   gldefs::GLenum pname, gldefs::GLint param) {
+  if (impl::gl_get_private(gl).direct_state_access) {
+    GL_ASSERT(glTextureParameteri(tex, pname, param));
+    return;
+  }
+  GL_ASSERT(glBindTexture(type, tex));
+  GL_ASSERT(glTexParameteri(type, pname, param));
+  GL_ASSERT(glBindTexture(type, GL_DEFAULT_BINDING));
+  gl_get_state(gl).forget_bound_texture();
+}
+
+} // namespace
+
 gl_texture& gl_texture::set_swizzle(gl_context& gl, swizzle_target target, swizzle_mask mask) {
   SHOGLE_ASSERT(!invalidated(), "gl_texture use after free");
-  GL_ASSERT(glBindTexture(_type, _id));
-  GL_ASSERT(glTexParameteri(_type, target, mask));
-  GL_ASSERT(glBindTexture(_type, GL_DEFAULT_BINDING));
+  set_parameter(gl, _id, _type, target, mask);
   // TODO: Add logger here
   return *this;
 }
@@ -736,10 +951,8 @@ gl_texture& gl_texture::set_sampler(gl_context& gl, texture_sampler sampler) {
         return SAMPLER_LINEAR;
     }
   }(sampler);
-  GL_ASSERT(glBindTexture(_type, _id));
-  GL_ASSERT(glTexParameteri(_type, GL_TEXTURE_MIN_FILTER, sampler));
-  GL_ASSERT(glTexParameteri(_type, GL_TEXTURE_MAG_FILTER, magsampler));
-  GL_ASSERT(glBindTexture(_type, GL_DEFAULT_BINDING));
+  set_parameter(gl, _id, _type, GL_TEXTURE_MIN_FILTER, sampler);
+  set_parameter(gl, _id, _type, GL_TEXTURE_MAG_FILTER, magsampler);
   SHOGLE_GL_LOG(VERBOSE, "TEXTURE_SAMPLER ({}) [type: {}, sampler: {}]", _id,
                 tex_type_string(_type), tex_sampler_string(sampler));
   return *this;
@@ -747,9 +960,7 @@ gl_texture& gl_texture::set_sampler(gl_context& gl, texture_sampler sampler) {
 
 gl_texture& gl_texture::set_wrap(gl_context& gl, wrap_direction dir, texture_wrap wrap) {
   SHOGLE_ASSERT(!invalidated(), "gl_texture use after free");
-  GL_ASSERT(glBindTexture(_type, _id));
-  GL_ASSERT(glTexParameteri(_type, dir, wrap));
-  GL_ASSERT(glBindTexture(_type, GL_DEFAULT_BINDING));
+  set_parameter(gl, _id, _type, dir, wrap);
   // TODO: Add logger here
   return *this;
 }
@@ -0,0 +1,277 @@
+#include "./context_private.hpp"
+#include <shogle/render/gl/texture_residency.hpp>
+
+namespace shogle {
+
+gl_texture_residency::gl_texture_residency(create_t, gl_buffer buffer, residency_mode mode,
+                                           const create_args& args) :
+    _buffer(std::move(buffer)), _mode(mode), _page_layers(args.page_layers),
+    _levels(args.levels), _dirty_first(args.max_materials), _dirty_last(0), _size(0) {
+  _materials.reserve(args.max_materials);
+}
+
+gl_texture_residency::gl_texture_residency(gl_context& gl, const create_args& args) :
+    gl_texture_residency(::shogle::gl_texture_residency::create(gl, args).value()) {}
+
+gl_sv_expect<gl_texture_residency> gl_texture_residency::create(gl_context& gl,
+                                                                const create_args& args) {
+  if (!args.max_materials || !args.levels) {
+    return {unexpect, "Invalid material count or mipmap levels", GL_INVALID_VALUE};
+  }
+  const residency_mode mode = args.allow_bindless && impl::gl_get_private(gl).bindless_texture
+                                ? MODE_BINDLESS
+                                : MODE_TEXTURE_ARRAY;
+  if (mode == MODE_TEXTURE_ARRAY && args.page_layers < 2) {
+    return {unexpect, "Texture array pages need at least two layers", GL_INVALID_VALUE};
+  }
+
+  const size_t size = args.max_materials * sizeof(material_entry);
+  auto buffer = gl_buffer::allocate(gl, gl_buffer::TYPE_SHADER, size);
+  if (!buffer) {
+    return {unexpect, "Failed to allocate material buffer", buffer.error().code()};
+  }
+  SHOGLE_GL_LOG(VERBOSE, "TEXTURE_RESIDENCY_CREATE ({}) [mode: {}, materials: {}]", buffer->id(),
+                mode == MODE_BINDLESS ? "bindless" : "array", args.max_materials);
+  return {in_place, create_t{}, std::move(*buffer), mode, args};
+}
+
+void gl_texture_residency::destroy(gl_context& gl, gl_texture_residency& residency) noexcept {
+  if (SHOGLE_UNLIKELY(residency.invalidated())) {
+    return;
+  }
+  for (auto& mat : residency._materials) {
+    if (!mat.used) {
+      continue;
+    }
+    if (residency._mode == MODE_BINDLESS) {
+      GL_CALL(glMakeTextureHandleNonResidentARB(mat.entry.handle));
+    }
+    if (mat.texture) {
+      gl_texture::deallocate(gl, *mat.texture);
+    }
+  }
+  for (auto& pg : residency._pages) {
+    gl_texture::deallocate(gl, pg.texture);
+  }
+  residency._materials.clear();
+  residency._free_materials.clear();
+  residency._pages.clear();
+  residency._size = 0;
+  gl_buffer::deallocate(gl, residency._buffer);
+}
+
+optional<u32> gl_texture_residency::_acquire_material() {
+  if (!_free_materials.empty()) {
+    const u32 idx = _free_materials.back();
+    _free_materials.pop_back();
+    return idx;
+  }
+  const size_t max_materials = _buffer.size() / sizeof(material_entry);
+  if (_materials.size() >= max_materials) {
+    return nullopt;
+  }
+  _materials.push_back({.texture = nullopt, .entry = {}, .used = false});
+  return static_cast<u32>(_materials.size() - 1);
+}
+
+void gl_texture_residency::_mark_dirty(u32 material) {
+  _dirty_first = std::min(_dirty_first, material);
+  _dirty_last = std::max(_dirty_last, material);
+}
+
+gl_sv_expect<std::pair<u32, u32>>
+gl_texture_residency::_acquire_layer(gl_context& gl, gl_texture::texture_format format,
+                                     const extent2d& extent) {
+  for (u32 i = 0; i < _pages.size(); ++i) {
+    auto& pg = _pages[i];
+    const auto page_extent = pg.texture.extent();
+    if (pg.free_layers.empty() || pg.texture.format() != format ||
+        page_extent.width != extent.width || page_extent.height != extent.height) {
+      continue;
+    }
+    const u32 layer = pg.free_layers.back();
+    pg.free_layers.pop_back();
+    return {in_place, i, layer};
+  }
+
+  if (_pages.size() >= MAX_PAGES) {
+    return {unexpect, "No texture array page left for the image", GL_OUT_OF_MEMORY};
+  }
+  auto tex = gl_texture::allocate2d(gl, format, extent, _levels, _page_layers);
+  if (!tex) {
+    return {unexpect, "Failed to allocate texture array page", tex.error().code()};
+  }
+  // Hand out the lowest layers first
+  std::vector<u32> free_layers(_page_layers - 1);
+  for (u32 i = 0; i < free_layers.size(); ++i) {
+    free_layers[i] = _page_layers - 1 - i;
+  }
+  _pages.push_back({.texture = std::move(*tex), .free_layers = std::move(free_layers),
+                    .dirty = false});
+  return {in_place, static_cast<u32>(_pages.size() - 1), 0u};
+}
+
+gl_sv_expect<u32> gl_texture_residency::add_image(gl_context& gl,
+                                                  gl_texture::texture_format format,
+                                                  const gl_texture::image_data& image) {
+  SHOGLE_ASSERT(!invalidated(), "gl_texture_residency use after free");
+  const auto idx = _acquire_material();
+  if (!idx) {
+    return {unexpect, "Material buffer is full", GL_OUT_OF_MEMORY};
+  }
+  const auto release = [&]() { _free_materials.push_back(*idx); };
+  const extent2d extent{image.extent.width, image.extent.height};
+
+  if (_mode == MODE_BINDLESS) {
+    auto tex = gl_texture::allocate2d(gl, format, extent, _levels);
+    if (!tex) {
+      release();
+      return {unexpect, "Failed to allocate material texture", tex.error().code()};
+    }
+    if (auto up = tex->upload_image(gl, image); !up) {
+      gl_texture::deallocate(gl, *tex);
+      release();
+      return {unexpect, "Failed to upload material image", up.error().code()};
+    }
+    if (_levels > 1) {
+      tex->generate_mipmaps(gl);
+    }
+    const GLuint64 handle = GL_ASSERT_RET(glGetTextureHandleARB(tex->id()));
+    GL_ASSERT(glMakeTextureHandleResidentARB(handle));
+    _materials[*idx] = {.texture = std::move(*tex),
+                        .entry = {.handle = handle, .page = 0, .layer = 0},
+                        .used = true};
+  } else {
+    auto slot = _acquire_layer(gl, format, extent);
+    if (!slot) {
+      release();
+      return {unexpect, slot.error()};
+    }
+    const auto [page_idx, layer] = *slot;
+    auto& pg = _pages[page_idx];
+    if (auto up = pg.texture.upload_image(gl, image, {}, layer); !up) {
+      pg.free_layers.push_back(layer);
+      release();
+      return {unexpect, "Failed to upload material image", up.error().code()};
+    }
+    pg.dirty = _levels > 1;
+    _materials[*idx] = {.texture = nullopt,
+                        .entry = {.handle = 0, .page = page_idx, .layer = layer},
+                        .used = true};
+  }
+  _mark_dirty(*idx);
+  ++_size;
+  return {in_place, *idx};
+}
+
+gl_sv_expect<u32> gl_texture_residency::add_texture(gl_context& gl, const gl_texture& texture) {
+  SHOGLE_ASSERT(!invalidated(), "gl_texture_residency use after free");
+  if (_mode != MODE_BINDLESS) {
+    return {unexpect, "Existing textures need bindless support", GL_INVALID_OPERATION};
+  }
+  const auto idx = _acquire_material();
+  if (!idx) {
+    return {unexpect, "Material buffer is full", GL_OUT_OF_MEMORY};
+  }
+  const GLuint64 handle = GL_ASSERT_RET(glGetTextureHandleARB(texture.id()));
+  GL_ASSERT(glMakeTextureHandleResidentARB(handle));
+  _materials[*idx] = {.texture = nullopt,
+                      .entry = {.handle = handle, .page = 0, .layer = 0},
+                      .used = true};
+  _mark_dirty(*idx);
+  ++_size;
+  return {in_place, *idx};
+}
+
+void gl_texture_residency::remove(gl_context& gl, u32 material) {
+  SHOGLE_ASSERT(!invalidated(), "gl_texture_residency use after free");
+  SHOGLE_ASSERT(material < _materials.size() && _materials[material].used,
+                "Removing an unknown material");
+  auto& mat = _materials[material];
+  if (_mode == MODE_BINDLESS) {
+    GL_ASSERT(glMakeTextureHandleNonResidentARB(mat.entry.handle));
+    if (mat.texture) {
+      gl_texture::deallocate(gl, *mat.texture);
+    }
+  } else {
+    _pages[mat.entry.page].free_layers.push_back(mat.entry.layer);
+  }
+  // The entry stays in the buffer until the index gets reused
+  mat = {.texture = nullopt, .entry = {}, .used = false};
+  _free_materials.push_back(material);
+  --_size;
+}
+
+gl_expect<void> gl_texture_residency::flush(gl_context& gl) {
+  SHOGLE_ASSERT(!invalidated(), "gl_texture_residency use after free");
+  for (auto& pg : _pages) {
+    if (pg.dirty) {
+      pg.texture.generate_mipmaps(gl);
+      pg.dirty = false;
+    }
+  }
+  if (_dirty_first > _dirty_last) {
+    return {};
+  }
+
+  std::vector<material_entry> entries(_dirty_last - _dirty_first + 1);
+  for (u32 i = 0; i < entries.size(); ++i) {
+    entries[i] = _materials[_dirty_first + i].entry;
+  }
+  auto ret = _buffer.upload_data(gl, entries.data(), entries.size() * sizeof(material_entry),
+                                 _dirty_first * sizeof(material_entry));
+  if (!ret) {
+    return {unexpect, ret.error()};
+  }
+  _dirty_first = static_cast<u32>(_buffer.size() / sizeof(material_entry));
+  _dirty_last = 0;
+  return {};
+}
+
+void gl_texture_residency::add_bindings(gl_command_builder& builder, u32 buffer_location,
+                                        u32 first_unit) const {
+  SHOGLE_ASSERT(!invalidated(), "gl_texture_residency use after free");
+  builder.add_shader_buffer(buffer_location, _buffer, _buffer.size());
+  for (u32 i = 0; i < _pages.size(); ++i) {
+    builder.add_texture(_pages[i].texture, first_unit + i);
+  }
+}
+
+auto gl_texture_residency::mode() const -> residency_mode {
+  SHOGLE_ASSERT(!invalidated(), "gl_texture_residency use after free");
+  return _mode;
+}
+
+auto gl_texture_residency::entry(u32 material) const -> const material_entry& {
+  SHOGLE_ASSERT(!invalidated(), "gl_texture_residency use after free");
+  SHOGLE_ASSERT(material < _materials.size() && _materials[material].used,
+                "Unknown material");
+  return _materials[material].entry;
+}
+
+const gl_buffer& gl_texture_residency::buffer() const {
+  SHOGLE_ASSERT(!invalidated(), "gl_texture_residency use after free");
+  return _buffer;
+}
+
+const gl_texture& gl_texture_residency::page_texture(u32 page) const {
+  SHOGLE_ASSERT(!invalidated(), "gl_texture_residency use after free");
+  SHOGLE_ASSERT(page < _pages.size(), "Texture array page out of range");
+  return _pages[page].texture;
+}
+
+u32 gl_texture_residency::page_count() const {
+  SHOGLE_ASSERT(!invalidated(), "gl_texture_residency use after free");
+  return static_cast<u32>(_pages.size());
+}
+
+u32 gl_texture_residency::size() const {
+  SHOGLE_ASSERT(!invalidated(), "gl_texture_residency use after free");
+  return _size;
+}
+
+bool gl_texture_residency::invalidated() const noexcept {
+  return _buffer.invalidated();
+}
+
+} // namespace shogle
@@ -0,0 +1,274 @@
+#include "./context_private.hpp"
+#include <shogle/render/gl/texture_stream.hpp>
+
+namespace shogle {
+
+namespace {
+
+constexpr gldefs::GLbitfield READBACK_STORAGE_FLAGS = gl_buffer::USAGE_MAP_READ_BIT |
+                                                      gl_buffer::USAGE_MAP_PERSISTENT_BIT |
+                                                      gl_buffer::USAGE_MAP_COHERENT_BIT;
+
+} // namespace
+
+gl_texture_streamer::gl_texture_streamer(create_t, const gl_ring_buffer& staging,
+                                         optional<gl_buffer> readback, void* readback_mapping,
+                                         size_t readback_size, u32 readback_slots) :
+    _staging(staging), _readback(std::move(readback)),
+    _readback_mapping(static_cast<u8*>(readback_mapping)), _readback_size(readback_size),
+    _readback_slots(readback_slots), _staged_uploads(0), _sync_uploads(0) {
+  _slots.fill({.fence = nullptr, .size = 0, .generation = 0, .state = SLOT_FREE});
+}
+
+gl_texture_streamer::gl_texture_streamer(gl_context& gl, const create_args& args) :
+    gl_texture_streamer(::shogle::gl_texture_streamer::create(gl, args).value()) {}
+
+gl_expect<gl_texture_streamer> gl_texture_streamer::create(gl_context& gl,
+                                                           const create_args& args) {
+  SHOGLE_ASSERT(args.readback_slots <= MAX_READBACK_SLOTS, "Too many readback slots");
+  auto staging = gl_ring_buffer::create(gl, gl_buffer::TYPE_PIXEL_UNPACK, args.staging_size,
+                                        args.staging_regions);
+  if (!staging) {
+    return {unexpect, staging.error()};
+  }
+
+  if (!args.readback_size || !args.readback_slots) {
+    return {in_place, create_t{}, *staging, nullopt, nullptr, 0, 0};
+  }
+
+  const size_t readback_total = args.readback_size * args.readback_slots;
+  auto readback = gl_buffer::allocate(gl, gl_buffer::TYPE_PIXEL_PACK, readback_total,
+                                      READBACK_STORAGE_FLAGS);
+  if (!readback) {
+    gl_ring_buffer::destroy(gl, *staging);
+    return {unexpect, readback.error()};
+  }
+  auto mapping = readback->map_range(gl, readback_total, 0, READBACK_STORAGE_FLAGS);
+  if (!mapping) {
+    gl_buffer::deallocate(gl, *readback);
+    gl_ring_buffer::destroy(gl, *staging);
+    return {unexpect, mapping.error()};
+  }
+  SHOGLE_GL_LOG(VERBOSE, "TEXTURE_STREAMER_ALLOC (staging: {}, readback: {}) (slots: {}x{}B)",
+                staging->buffer().id(), readback->id(), args.readback_slots,
+                args.readback_size);
+  return {in_place, create_t{}, *staging, *readback, *mapping, args.readback_size,
+          args.readback_slots};
+}
+
+void gl_texture_streamer::destroy(gl_context& gl, gl_texture_streamer& streamer) noexcept {
+  if (SHOGLE_UNLIKELY(streamer.invalidated())) {
+    return;
+  }
+  for (auto& slot : streamer._slots) {
+    if (slot.fence) {
+      GL_CALL(glDeleteSync(slot.fence));
+    }
+    slot = {.fence = nullptr, .size = 0, .generation = 0, .state = SLOT_FREE};
+  }
+  if (streamer._readback) {
+    gl_buffer::deallocate(gl, *streamer._readback);
+    streamer._readback.reset();
+  }
+  streamer._readback_mapping = nullptr;
+  gl_ring_buffer::destroy(gl, streamer._staging);
+}
+
+gl_expect<void> gl_texture_streamer::upload_image(gl_context& gl, gl_texture& texture,
+                                                  const gl_texture::image_data& image,
+                                                  const extent3d& offset, u32 layer, u32 level) {
+  SHOGLE_ASSERT(!invalidated(), "gl_texture_streamer use after free");
+  SHOGLE_ASSERT(image.data, "Texture stream upload with null pointer");
+  const size_t size = gl_image_size(image.extent, image.format, image.datatype, image.alignment);
+  optional<gl_ring_buffer::allocation> staged;
+  if (size <= _staging.region_size()) {
+    staged = _staging.push(image.data, size);
+  }
+  if (!staged) {
+    ++_sync_uploads;
+    return texture.upload_image(gl, image, offset, layer, level);
+  }
+
+  // With an unpack buffer bound the pixel pointer is an offset into it
+  auto staged_image = image;
+  staged_image.data = reinterpret_cast<const void*>(staged->offset);
+  GL_ASSERT(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _staging.buffer().id()));
+  auto ret = texture.upload_image(gl, staged_image, offset, layer, level);
+  GL_ASSERT(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, GL_DEFAULT_BINDING));
+  ++_staged_uploads;
+  return ret;
+}
+
+auto gl_texture_streamer::_acquire_slot(size_t size) -> optional<readback_ticket> {
+  SHOGLE_ASSERT(_readback, "Texture streamer created without readback slots");
+  if (size > _readback_size) {
+    return nullopt;
+  }
+  for (u32 i = 0; i < _readback_slots; ++i) {
+    auto& slot = _slots[i];
+    if (slot.state != SLOT_FREE) {
+      continue;
+    }
+    slot.state = SLOT_PENDING;
+    slot.size = size;
+    return readback_ticket{i, ++slot.generation};
+  }
+  return nullopt;
+}
+
+void gl_texture_streamer::_fence_slot(gl_context& gl, u32 slot) {
+  _slots[slot].fence = GL_CALL(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+}
+
+auto gl_texture_streamer::read_pixels(gl_context& gl, gldefs::GLhandle fbo,
+                                      const rectangle_pos<u32>& area,
+                                      gl_texture::pixel_format format,
+                                      gl_texture::pixel_data_type datatype,
+                                      gl_texture::pixel_alignment alignment)
+  -> gl_expect<readback_ticket> {
+  SHOGLE_ASSERT(!invalidated(), "gl_texture_streamer use after free");
+  const auto [x, y, width, height] = area;
+  const size_t size = gl_image_size({width, height, 1}, format, datatype, alignment);
+  if (size > _readback_size) {
+    return {unexpect, GL_INVALID_VALUE};
+  }
+  const auto ticket = _acquire_slot(size);
+  if (!ticket) {
+    return {unexpect, GL_OUT_OF_MEMORY};
+  }
+
+  const size_t slot_offset = ticket->slot * _readback_size;
+  GL_ASSERT(glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo));
+  GL_ASSERT(glBindBuffer(GL_PIXEL_PACK_BUFFER, _readback->id()));
+  GL_ASSERT(glPixelStorei(GL_PACK_ALIGNMENT, alignment));
+  const auto err = GL_RET_ERR(glReadPixels(x, y, width, height, format, datatype,
+                                           reinterpret_cast<void*>(slot_offset)));
+  GL_ASSERT(glBindBuffer(GL_PIXEL_PACK_BUFFER, GL_DEFAULT_BINDING));
+  GL_ASSERT(glBindFramebuffer(GL_READ_FRAMEBUFFER, GL_DEFAULT_BINDING));
+  if (err) {
+    _slots[ticket->slot].state = SLOT_FREE;
+    return {unexpect, err};
+  }
+  _fence_slot(gl, ticket->slot);
+  SHOGLE_GL_LOG(VERBOSE, "TEXTURE_STREAMER_READ_PIXELS ({}) (slot: {}, sz: {}B, fbo: {})",
+                _readback->id(), ticket->slot, size, fbo);
+  return {in_place, *ticket};
+}
+
+auto gl_texture_streamer::read_texture(gl_context& gl, const gl_texture& texture,
+                                       gl_texture::pixel_format format,
+                                       gl_texture::pixel_data_type datatype, u32 level,
+                                       gl_texture::pixel_alignment alignment)
+  -> gl_expect<readback_ticket> {
+  SHOGLE_ASSERT(!invalidated(), "gl_texture_streamer use after free");
+  const auto type = texture.type();
+  if (type == gl_texture::TEX_TYPE_BUFFER || type == gl_texture::TEX_TYPE_CUBEMAP ||
+      type == gl_texture::TEX_TYPE_2D_MULTISAMPLE ||
+      type == gl_texture::TEX_TYPE_2D_MULTISAMPLE_ARRAY) {
+    return {unexpect, GL_INVALID_ENUM};
+  }
+  auto extent = texture.extent();
+  extent.width = std::max(extent.width >> level, 1u);
+  extent.height = std::max(extent.height >> level, 1u);
+  if (type == gl_texture::TEX_TYPE_3D) {
+    extent.depth = std::max(extent.depth >> level, 1u);
+  } else if (type == gl_texture::TEX_TYPE_1D_ARRAY) {
+    extent.height = texture.layers();
+  } else if (type == gl_texture::TEX_TYPE_2D_ARRAY) {
+    extent.depth = texture.layers();
+  }
+  const size_t size = gl_image_size(extent, format, datatype, alignment);
+  if (size > _readback_size) {
+    return {unexpect, GL_INVALID_VALUE};
+  }
+  const auto ticket = _acquire_slot(size);
+  if (!ticket) {
+    return {unexpect, GL_OUT_OF_MEMORY};
+  }
+
+  const size_t slot_offset = ticket->slot * _readback_size;
+  GL_ASSERT(glBindTexture(type, texture.id()));
+  GL_ASSERT(glBindBuffer(GL_PIXEL_PACK_BUFFER, _readback->id()));
+  GL_ASSERT(glPixelStorei(GL_PACK_ALIGNMENT, alignment));
+  const auto err = GL_RET_ERR(
+    glGetTexImage(type, level, format, datatype, reinterpret_cast<void*>(slot_offset)));
+  GL_ASSERT(glBindBuffer(GL_PIXEL_PACK_BUFFER, GL_DEFAULT_BINDING));
+  GL_ASSERT(glBindTexture(type, GL_DEFAULT_BINDING));
+  gl_get_state(gl).forget_bound_texture();
+  if (err) {
+    _slots[ticket->slot].state = SLOT_FREE;
+    return {unexpect, err};
+  }
+  _fence_slot(gl, ticket->slot);
+  SHOGLE_GL_LOG(VERBOSE, "TEXTURE_STREAMER_READ_TEXTURE ({}) (slot: {}, sz: {}B, tex: {})",
+                _readback->id(), ticket->slot, size, texture.id());
+  return {in_place, *ticket};
+}
+
+void gl_texture_streamer::poll(gl_context& gl) {
+  SHOGLE_ASSERT(!invalidated(), "gl_texture_streamer use after free");
+  _staging.end_frame(gl);
+  // Never waits, while the GPU still reads the next region it stays full and uploads fall
+  // back to the synchronous path
+  [[maybe_unused]] const auto ret = _staging.begin_frame(gl, 0);
+
+  for (u32 i = 0; i < _readback_slots; ++i) {
+    auto& slot = _slots[i];
+    if (slot.state != SLOT_PENDING) {
+      continue;
+    }
+    const GLenum status = GL_CALL(glClientWaitSync(slot.fence, 0, 0));
+    if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+      GL_CALL(glDeleteSync(slot.fence));
+      slot.fence = nullptr;
+      slot.state = SLOT_READY;
+    }
+  }
+}
+
+optional<span<const u8>> gl_texture_streamer::readback_data(const readback_ticket& ticket) const {
+  SHOGLE_ASSERT(!invalidated(), "gl_texture_streamer use after free");
+  SHOGLE_ASSERT(ticket.slot < _readback_slots, "Invalid readback ticket");
+  const auto& slot = _slots[ticket.slot];
+  SHOGLE_ASSERT(slot.generation == ticket.generation && slot.state != SLOT_FREE,
+                "Readback ticket used after release");
+  if (slot.state != SLOT_READY) {
+    return nullopt;
+  }
+  return span<const u8>{_readback_mapping + ticket.slot * _readback_size, slot.size};
+}
+
+void gl_texture_streamer::release(gl_context& gl, const readback_ticket& ticket) {
+  SHOGLE_ASSERT(!invalidated(), "gl_texture_streamer use after free");
+  SHOGLE_ASSERT(ticket.slot < _readback_slots, "Invalid readback ticket");
+  auto& slot = _slots[ticket.slot];
+  if (slot.generation != ticket.generation) {
+    return;
+  }
+  if (slot.fence) {
+    GL_CALL(glDeleteSync(slot.fence));
+    slot.fence = nullptr;
+  }
+  slot.state = SLOT_FREE;
+}
+
+const gl_ring_buffer& gl_texture_streamer::staging() const {
+  SHOGLE_ASSERT(!invalidated(), "gl_texture_streamer use after free");
+  return _staging;
+}
+
+u64 gl_texture_streamer::staged_uploads() const {
+  SHOGLE_ASSERT(!invalidated(), "gl_texture_streamer use after free");
+  return _staged_uploads;
+}
+
+u64 gl_texture_streamer::sync_uploads() const {
+  SHOGLE_ASSERT(!invalidated(), "gl_texture_streamer use after free");
+  return _sync_uploads;
+}
+
+bool gl_texture_streamer::invalidated() const noexcept {
+  return _staging.invalidated();
+}
+
+} // namespace shogle
@@ -0,0 +1,184 @@
+#include "./context_private.hpp"
+#include <shogle/render/gl/uniform_arena.hpp>
+
+namespace shogle {
+
+namespace {
+
+constexpr size_t component_size(attribute_type type) {
+  switch (type) {
+    case attribute_type::f64:
+    case attribute_type::dvec2:
+    case attribute_type::dvec3:
+    case attribute_type::dvec4:
+      return sizeof(f64);
+    default:
+      return sizeof(f32);
+  }
+}
+
+constexpr u32 matrix_columns(attribute_type type) {
+  switch (type) {
+    case attribute_type::mat3:
+      return 3;
+    case attribute_type::mat4:
+      return 4;
+    default:
+      return 0;
+  }
+}
+
+} // namespace
+
+gl_uniform_block_layout::gl_uniform_block_layout(create_t, std::vector<member> members,
+                                                 size_t data_size, u32 binding) :
+    _members(std::move(members)), _data_size(data_size), _binding(binding) {}
+
+optional<gl_uniform_block_layout>
+gl_uniform_block_layout::reflect(gl_context& gl, const gl_graphics_pipeline& pipeline,
+                                 const char* block_name) {
+  const auto block = pipeline.uniform_block_index(gl, block_name);
+  if (!block) {
+    return nullopt;
+  }
+  gl_graphics_pipeline::uniform_block_props props;
+  if (!pipeline.query_uniform_block(gl, props, *block)) {
+    return nullopt;
+  }
+
+  std::vector<gl_graphics_pipeline::uniform_member_props> member_props(props.member_count);
+  const u32 count = pipeline.query_uniform_block_members(
+    gl, *block, {member_props.data(), member_props.size()});
+  std::vector<member> members;
+  members.reserve(count);
+  for (u32 i = 0; i < count; ++i) {
+    const auto& prop = member_props[i];
+    members.emplace_back(std::string{prop.name, prop.name_len}, prop.offset, prop.array_stride,
+                         prop.matrix_stride, prop.size, prop.type);
+  }
+  return gl_uniform_block_layout{create_t{}, std::move(members), props.data_size, props.binding};
+}
+
+optional<u32> gl_uniform_block_layout::member_index(std::string_view name) const {
+  for (u32 i = 0; i < _members.size(); ++i) {
+    if (_members[i].name == name) {
+      return i;
+    }
+  }
+  return nullopt;
+}
+
+void gl_uniform_block_layout::write(void* block, const gl_draw_command::push_uniform& uniform,
+                                    u32 array_index) const {
+  SHOGLE_ASSERT(uniform.location < _members.size(), "Uniform block member out of range");
+  const auto& mem = _members[uniform.location];
+  SHOGLE_ASSERT(array_index < std::max(mem.size, size_t{1}), "Uniform array index out of range");
+  u8* dst = static_cast<u8*>(block) + mem.offset + array_index * mem.array_stride;
+  const size_t comp_size = component_size(uniform.type);
+
+  // std140 pads matrix columns, copy them one at a time
+  const u32 columns = matrix_columns(uniform.type);
+  if (columns && mem.matrix_stride) {
+    const size_t column_size = columns * comp_size;
+    SHOGLE_ASSERT(mem.offset + array_index * mem.array_stride +
+                      (columns - 1) * mem.matrix_stride + column_size <=
+                    _data_size,
+                  "Uniform block write out of range");
+    for (u32 col = 0; col < columns; ++col) {
+      std::memcpy(dst + col * mem.matrix_stride, &uniform.data[col * column_size], column_size);
+    }
+    return;
+  }
+  const size_t size = meta::attribute_dim(uniform.type) * comp_size;
+  SHOGLE_ASSERT(mem.offset + array_index * mem.array_stride + size <= _data_size,
+                "Uniform block write out of range");
+  std::memcpy(dst, &uniform.data[0], size);
+}
+
+gl_uniform_arena::gl_uniform_arena(create_t, gl_ring_buffer ring) :
+    _ring(std::move(ring)), _last(), _scratch(), _stats() {}
+
+gl_uniform_arena::gl_uniform_arena(gl_context& gl, size_t region_size, u32 region_count) :
+    gl_uniform_arena(::shogle::gl_uniform_arena::create(gl, region_size, region_count).value()) {}
+
+gl_expect<gl_uniform_arena> gl_uniform_arena::create(gl_context& gl, size_t region_size,
+                                                     u32 region_count) {
+  auto ring = gl_ring_buffer::create(gl, gl_buffer::TYPE_UNIFORM, region_size, region_count);
+  if (!ring) {
+    return {unexpect, ring.error()};
+  }
+  return {in_place, create_t{}, std::move(*ring)};
+}
+
+void gl_uniform_arena::destroy(gl_context& gl, gl_uniform_arena& arena) noexcept {
+  if (SHOGLE_UNLIKELY(arena.invalidated())) {
+    return;
+  }
+  gl_ring_buffer::destroy(gl, arena._ring);
+}
+
+gl_expect<void> gl_uniform_arena::begin_frame(gl_context& gl, u64 timeout) {
+  SHOGLE_ASSERT(!invalidated(), "gl_uniform_arena use after free");
+  // Ranges from the last frame live in another region now
+  for (auto& last : _last) {
+    last.valid = false;
+  }
+  return _ring.begin_frame(gl, timeout);
+}
+
+void gl_uniform_arena::end_frame(gl_context& gl) {
+  SHOGLE_ASSERT(!invalidated(), "gl_uniform_arena use after free");
+  _ring.end_frame(gl);
+}
+
+optional<gl_draw_command::shader_binding> gl_uniform_arena::push(u32 binding, const void* data,
+                                                                 size_t size) {
+  SHOGLE_ASSERT(!invalidated(), "gl_uniform_arena use after free");
+  const auto make_binding = [&](size_t offset) -> gl_draw_command::shader_binding {
+    return {_ring.buffer().id(), gl_buffer::TYPE_UNIFORM, size, offset, binding};
+  };
+
+  ++_stats.pushes;
+  last_block* last = binding < MAX_BLOCK_BINDINGS ? &_last[binding] : nullptr;
+  if (last && last->valid && last->data.size() == size &&
+      std::memcmp(last->data.data(), data, size) == 0) {
+    ++_stats.reused;
+    return make_binding(last->offset);
+  }
+
+  auto alloc = _ring.push(data, size);
+  if (!alloc) {
+    SHOGLE_GL_LOG(DEBUG, "UNIFORM_ARENA_FULL ({}) (binding: {}, sz: {}B)", _ring.buffer().id(),
+                  binding, size);
+    return nullopt;
+  }
+  _stats.bytes += size;
+  if (last) {
+    const u8* bytes = static_cast<const u8*>(data);
+    last->data.assign(bytes, bytes + size);
+    last->offset = alloc->offset;
+    last->valid = true;
+  }
+  return make_binding(alloc->offset);
+}
+
+optional<gl_draw_command::shader_binding>
+gl_uniform_arena::push(const gl_uniform_block_layout& layout,
+                       span<const gl_draw_command::push_uniform> uniforms) {
+  _scratch.assign(layout.data_size(), 0);
+  for (const auto& uniform : uniforms) {
+    layout.write(_scratch.data(), uniform);
+  }
+  return push(layout.binding(), _scratch.data(), _scratch.size());
+}
+
+const gl_ring_buffer& gl_uniform_arena::ring() const {
+  SHOGLE_ASSERT(!invalidated(), "gl_uniform_arena use after free");
+  return _ring;
+}
+
+bool gl_uniform_arena::invalidated() const noexcept {
+  return _ring.invalidated();
+}
+
+} // namespace shogle
@@ -4,6 +4,86 @@
 
 namespace shogle {
 
+GLenum gl_attribute_type(attribute_type type) {
+  static constexpr auto types = std::to_array<GLenum>({
+    GL_FLOAT,        // f32
+    GL_FLOAT,        // vec2
+    GL_FLOAT,        // vec3
+    GL_FLOAT,        // vec4
+    GL_FLOAT,        // mat3
+    GL_FLOAT,        // mat4
+    GL_DOUBLE,       // f64
+    GL_DOUBLE,       // dvec2
+    GL_DOUBLE,       // dvec3
+    GL_DOUBLE,       // dvec4
+    GL_INT,          // i32
+    GL_INT,          // ivec2
+    GL_INT,          // ivec3
+    GL_INT,          // ivec4
+    GL_UNSIGNED_INT, // u32
+    GL_UNSIGNED_INT, // uvec2
+    GL_UNSIGNED_INT, // uvec3
+    GL_UNSIGNED_INT, // uvec4
+  });
+  const u32 idx = static_cast<u32>(type);
+  return idx < types.size() ? types[idx] : 0;
+}
+
+namespace {
+
+// Interleaved attributes share binding 0 at their offset in the vertex, split attributes get the
+// binding of their location and have their offset applied when the buffer is bound.
+// Without direct state access the VAO has to be bound already.
+void set_attribute_format(gl_context& gl, GLuint vao, bool dsa, bool interleaved,
+                          const vertex_attribute& attrib) {
+  const GLuint binding = interleaved ? 0 : attrib.location;
+  const GLuint relative_offset = interleaved ? static_cast<GLuint>(attrib.offset) : 0;
+  const GLint dimension = static_cast<GLint>(::shogle::meta::attribute_dim(attrib.type));
+  const GLenum type = gl_attribute_type(attrib.type);
+  const GLuint loc = attrib.location;
+
+  if (dsa) {
+    GL_ASSERT(glEnableVertexArrayAttrib(vao, loc));
+  } else {
+    GL_ASSERT(glEnableVertexAttribArray(loc));
+  }
+  switch (type) {
+    case GL_FLOAT: {
+      if (dsa) {
+        GL_ASSERT(
+          glVertexArrayAttribFormat(vao, loc, dimension, type, GL_FALSE, relative_offset));
+      } else {
+        GL_ASSERT(glVertexAttribFormat(loc, dimension, type, GL_FALSE, relative_offset));
+      }
+    } break;
+    case GL_DOUBLE: {
+      if (dsa) {
+        GL_ASSERT(glVertexArrayAttribLFormat(vao, loc, dimension, type, relative_offset));
+      } else {
+        GL_ASSERT(glVertexAttribLFormat(loc, dimension, type, relative_offset));
+      }
+    } break;
+    case GL_INT:
+      [[fallthrough]];
+    case GL_UNSIGNED_INT: {
+      if (dsa) {
+        GL_ASSERT(glVertexArrayAttribIFormat(vao, loc, dimension, type, relative_offset));
+      } else {
+        GL_ASSERT(glVertexAttribIFormat(loc, dimension, type, relative_offset));
+      }
+    } break;
+    default:
+      SHOGLE_UNREACHABLE();
+  }
+  if (dsa) {
+    GL_ASSERT(glVertexArrayAttribBinding(vao, loc, binding));
+  } else {
+    GL_ASSERT(glVertexAttribBinding(loc, binding));
+  }
+}
+
+} // namespace
+
 gl_vertex_layout::gl_vertex_layout(create_t, gldefs::GLhandle vao, attribute_array attributes,
                                    u32 attribute_count, size_t stride) :
     _attributes(std::move(attributes)), _stride(stride), _vao(vao),
@@ -12,16 +92,41 @@ gl_vertex_layout::gl_vertex_layout(create_t, gldefs::GLhandle vao, attribute_arr
 gl_expect<gl_vertex_layout> gl_vertex_layout::create(gl_context& gl, size_t stride,
                                                      const ::shogle::vertex_attribute* attribs,
                                                      u32 attrib_count) {
-  if (!attribs || !attrib_count) {
+  if (!attribs || !attrib_count || attrib_count > MAX_ATTRIBUTE_BINDINGS) {
     return {unexpect, GL_INVALID_VALUE};
   }
+  for (u32 i = 0; i < attrib_count; ++i) {
+    if (attribs[i].location >= MAX_ATTRIBUTE_BINDINGS) {
+      return {unexpect, GL_INVALID_VALUE};
+    }
+  }
 
   GLuint vao;
-  const auto err = GL_RET_ERR(glCreateVertexArrays(1, &vao));
+  auto err = GL_RET_ERR(glCreateVertexArrays(1, &vao));
   if (err) {
     return {unexpect, err};
   }
 
+  // Describe the format once, draws only swap the vertex buffers afterwards
+  const auto& ctx = impl::gl_get_private(gl);
+  if (ctx.vertex_attrib_binding) {
+    if (!ctx.direct_state_access) {
+      // Formats are set on the bound VAO, the cache follows so a draw won't bind it again
+      auto& state = gl_get_state(gl);
+      GL_ASSERT(glBindVertexArray(vao));
+      state.forget_vertex_array(state.vao);
+      state.vao = vao;
+    }
+    for (u32 i = 0; i < attrib_count; ++i) {
+      set_attribute_format(gl, vao, ctx.direct_state_access, stride != 0, attribs[i]);
+    }
+    err = gl_call_error(gl);
+    if (err) {
+      GL_CALL(glDeleteVertexArrays(1, &vao));
+      return {unexpect, err};
+    }
+  }
+
   attribute_array attributes;
   std::memcpy(attributes.data(), attribs, attrib_count * sizeof(attributes[0]));
 #ifndef SHOGLE_DISABLE_INTERNAL_LOGS
@@ -49,6 +154,7 @@ void gl_vertex_layout::destroy(gl_context& gl, gl_vertex_layout& layout) noexcep
   }
 #endif
   GL_CALL(glDeleteVertexArrays(1, &layout._vao));
+  gl_get_state(gl).forget_vertex_array(layout._vao);
   layout._vao = GL_NULL_HANDLE;
 }
 
@@ -70,6 +176,7 @@ void gl_vertex_layout::destroy_n(gl_context& gl, gl_vertex_layout* layouts,
     }
 #endif
     GL_CALL(glDeleteVertexArrays(1, &layouts[i]._vao));
+    gl_get_state(gl).forget_vertex_array(layouts[i]._vao);
     layouts[i]._vao = GL_NULL_HANDLE;
   }
 }
@@ -0,0 +1,596 @@
+#include <shogle/render/sw/context.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace shogle {
+
+namespace {
+
+// Vertices are snapped to 1/256 of a pixel before the edge functions are built
+constexpr f64 SUBPIXEL_SCALE = 256.0;
+
+// Triangles are only clipped against the sides once they leave this many viewports
+constexpr f32 GUARD_BAND = 16.f;
+
+constexpr u32 CLIP_PLANE_COUNT = 6;
+constexpr u32 MAX_CLIP_VERTICES = 3 + CLIP_PLANE_COUNT;
+constexpr u32 MAX_CLIP_STORAGE = 2 * CLIP_PLANE_COUNT;
+
+struct raster_triangle {
+  // Edge k is opposite to vertex k, e(x, y) = a * x + b * y + c is positive inside
+  f64 a[3];
+  f64 b[3];
+  f64 c[3];
+  f32 z[3];
+  f32 inv_area;
+  // Pixel bounds, max exclusive
+  i32 min_x, min_y, max_x, max_y;
+  u32 top_left;
+  // Offset of 1/w followed by varyings/w for each vertex
+  u32 attribs;
+};
+
+struct clip_vertex {
+  vec4 pos;
+  const f32* varyings;
+};
+
+f32 clip_distance(const vec4& pos, u32 plane) noexcept {
+  switch (plane) {
+    case 0:
+      return pos.z + pos.w;
+    case 1:
+      return pos.w - pos.z;
+    case 2:
+      return GUARD_BAND * pos.w - pos.x;
+    case 3:
+      return GUARD_BAND * pos.w + pos.x;
+    case 4:
+      return GUARD_BAND * pos.w - pos.y;
+    default:
+      return GUARD_BAND * pos.w + pos.y;
+  }
+}
+
+u32 outcode(const vec4& pos) noexcept {
+  u32 code = 0;
+  for (u32 plane = 0; plane < CLIP_PLANE_COUNT; ++plane) {
+    code |= u32{clip_distance(pos, plane) < 0.f} << plane;
+  }
+  return code;
+}
+
+bool depth_passes(sw_draw_state::depth_test test, f32 z, f32 stored) noexcept {
+  switch (test) {
+    case sw_draw_state::TEST_NEVER:
+      return false;
+    case sw_draw_state::TEST_LESS:
+      return z < stored;
+    case sw_draw_state::TEST_EQUAL:
+      return z == stored;
+    case sw_draw_state::TEST_LEQUAL:
+      return z <= stored;
+    case sw_draw_state::TEST_GREATER:
+      return z > stored;
+    case sw_draw_state::TEST_NOT_EQUAL:
+      return z != stored;
+    case sw_draw_state::TEST_GEQUAL:
+      return z >= stored;
+    default:
+      return true;
+  }
+}
+
+u32 blend_color(sw_draw_state::blending_mode mode, const color4& src, u32 dst) noexcept {
+  if (mode == sw_draw_state::BLEND_NONE) {
+    return sw_pack_color(src);
+  }
+  const color4 prev = sw_unpack_color(dst);
+  if (mode == sw_draw_state::BLEND_ADDITIVE) {
+    return sw_pack_color({src.r + prev.r, src.g + prev.g, src.b + prev.b, src.a + prev.a});
+  }
+  const f32 inv = 1.f - src.a;
+  return sw_pack_color({src.r * src.a + prev.r * inv, src.g * src.a + prev.g * inv,
+                        src.b * src.a + prev.b * inv, src.a + prev.a * inv});
+}
+
+// Evaluates the three edge functions on four consecutive pixels, writes them to `out` and
+// returns the coverage mask. Shared edges evaluate to exact negations in both triangles, the
+// top left rule picks which one owns the pixels sitting on the edge.
+u32 edge_coverage(const f32 (&base)[3], const f32 (&step)[3], u32 top_left,
+                  f32 (&out)[3][4]) noexcept {
+  u32 mask = 0xF;
+#if defined(__AVX2__) || defined(__SSE2__)
+  const __m128 offsets = _mm_set_ps(3.f, 2.f, 1.f, 0.f);
+  const __m128 zero = _mm_setzero_ps();
+  for (u32 k = 0; k < 3; ++k) {
+    const __m128 e =
+      _mm_add_ps(_mm_set1_ps(base[k]), _mm_mul_ps(_mm_set1_ps(step[k]), offsets));
+    _mm_storeu_ps(out[k], e);
+    const __m128 inside = (top_left >> k) & 1u ? _mm_cmpge_ps(e, zero) : _mm_cmpgt_ps(e, zero);
+    mask &= static_cast<u32>(_mm_movemask_ps(inside));
+  }
+#elif defined(__ARM_NEON)
+  static constexpr f32 offset_data[4] = {0.f, 1.f, 2.f, 3.f};
+  static constexpr u32 bit_data[4] = {1u, 2u, 4u, 8u};
+  const float32x4_t offsets = vld1q_f32(offset_data);
+  const uint32x4_t bits = vld1q_u32(bit_data);
+  const float32x4_t zero = vdupq_n_f32(0.f);
+  for (u32 k = 0; k < 3; ++k) {
+    const float32x4_t e =
+      vaddq_f32(vdupq_n_f32(base[k]), vmulq_f32(vdupq_n_f32(step[k]), offsets));
+    vst1q_f32(out[k], e);
+    const uint32x4_t inside = (top_left >> k) & 1u ? vcgeq_f32(e, zero) : vcgtq_f32(e, zero);
+    const uint32x4_t lanes = vandq_u32(inside, bits);
+#if defined(__aarch64__)
+    mask &= vaddvq_u32(lanes);
+#else
+    // No across-vector add on 32-bit ARM, fold the halves with pairwise adds
+    const uint32x2_t pairs = vpadd_u32(vget_low_u32(lanes), vget_high_u32(lanes));
+    mask &= vget_lane_u32(vpadd_u32(pairs, pairs), 0);
+#endif
+  }
+#else
+  for (u32 k = 0; k < 3; ++k) {
+    u32 edge_mask = 0;
+    for (u32 i = 0; i < 4; ++i) {
+      const f32 e = base[k] + step[k] * static_cast<f32>(i);
+      out[k][i] = e;
+      const bool inside = (top_left >> k) & 1u ? e >= 0.f : e > 0.f;
+      edge_mask |= u32{inside} << i;
+    }
+    mask &= edge_mask;
+  }
+#endif
+  return mask;
+}
+
+} // namespace
+
+struct sw_context::pool_t {
+  pool_t(u32 thread_count) {
+    workers.reserve(thread_count - 1);
+    for (u32 i = 1; i < thread_count; ++i) {
+      workers.emplace_back([this]() { work_loop(); });
+    }
+  }
+
+  ~pool_t() noexcept {
+    {
+      std::scoped_lock lock{mtx};
+      stop = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+      worker.join();
+    }
+  }
+
+  void drain() {
+    for (;;) {
+      const u32 begin = next.fetch_add(job_grain, std::memory_order_relaxed);
+      if (begin >= job_count) {
+        break;
+      }
+      (*job)(begin, std::min(begin + job_grain, job_count));
+    }
+  }
+
+  void work_loop() {
+    u64 seen = 0;
+    std::unique_lock lock{mtx};
+    for (;;) {
+      wake.wait(lock, [&]() { return stop || generation != seen; });
+      if (stop) {
+        return;
+      }
+      seen = generation;
+      lock.unlock();
+      drain();
+      lock.lock();
+      if (--busy == 0) {
+        done.notify_one();
+      }
+    }
+  }
+
+  void run(u32 count, u32 grain, const fn_ref<void(u32, u32)>& func) {
+    {
+      std::scoped_lock lock{mtx};
+      job = &func;
+      job_count = count;
+      job_grain = grain;
+      next.store(0, std::memory_order_relaxed);
+      busy = static_cast<u32>(workers.size());
+      ++generation;
+    }
+    wake.notify_all();
+    drain();
+    std::unique_lock lock{mtx};
+    // Every worker has to check in, the next job can't start while one is still reading this one
+    done.wait(lock, [&]() { return busy == 0; });
+    job = nullptr;
+  }
+
+  std::vector<std::thread> workers;
+  std::mutex mtx;
+  std::condition_variable wake;
+  std::condition_variable done;
+  const fn_ref<void(u32, u32)>* job{nullptr};
+  u32 job_count{0};
+  u32 job_grain{1};
+  std::atomic<u32> next{0};
+  u32 busy{0};
+  u64 generation{0};
+  bool stop{false};
+};
+
+struct sw_context::draw_scratch {
+  struct setup_chunk {
+    std::vector<raster_triangle> triangles;
+    std::vector<f32> attribs;
+    // Triangle indices per tile, in submission order
+    std::vector<std::vector<u32>> bins;
+    u32 culled;
+  };
+
+  std::vector<vec4> clip;
+  std::vector<f32> varyings;
+  std::vector<setup_chunk> chunks;
+  u32 varying_count{0};
+};
+
+sw_context::sw_context(const create_args& args) :
+    _scratch(std::make_unique<draw_scratch>()), _tile_size(args.tile_size) {
+  SHOGLE_ASSERT(_tile_size >= 4 && _tile_size % 4 == 0, "Tile size must be a multiple of 4");
+  const u32 threads =
+    args.threads ? args.threads : std::max(std::thread::hardware_concurrency(), 1u);
+  _pool = std::make_unique<pool_t>(threads);
+  SHOGLE_SW_LOG(VERBOSE, "Software context created with {} threads and {}x{} tiles", threads,
+                _tile_size, _tile_size);
+}
+
+sw_context::sw_context(sw_context&&) noexcept = default;
+
+sw_context& sw_context::operator=(sw_context&&) noexcept = default;
+
+sw_context::~sw_context() noexcept = default;
+
+u32 sw_context::thread_count() const noexcept {
+  return static_cast<u32>(_pool->workers.size()) + 1;
+}
+
+void sw_context::parallel_for(u32 count, u32 grain, fn_ref<void(u32, u32)> func) {
+  if (!count) {
+    return;
+  }
+  grain = std::max(grain, 1u);
+  if (_pool->workers.empty() || count <= grain) {
+    func(0, count);
+    return;
+  }
+  _pool->run(count, grain, func);
+}
+
+auto sw_context::_begin_draw(u32 vertex_count, u32 varying_count) -> draw_buffers {
+  auto& scratch = *_scratch;
+  scratch.clip.resize(vertex_count);
+  scratch.varyings.resize(size_t{vertex_count} * varying_count);
+  scratch.varying_count = varying_count;
+  return {scratch.clip.data(), scratch.varyings.data()};
+}
+
+sw_draw_stats sw_context::_rasterize(sw_framebuffer& target, const sw_draw_state& state,
+                                     u32 vertex_count, span<const u32> indices,
+                                     shade_fn shade) {
+  auto& scratch = *_scratch;
+  const u32 varying_count = scratch.varying_count;
+  const u32 attrib_stride = varying_count + 1;
+  const u32 index_count = indices.empty() ? vertex_count : static_cast<u32>(indices.size());
+  const u32 triangle_count = index_count / 3;
+  if (!triangle_count) {
+    return {0, 0, 0};
+  }
+
+  const extent2d extent = target.extent();
+  rectangle_pos<u32> viewport = state.viewport;
+  if (!viewport.width || !viewport.height) {
+    viewport = {0, 0, extent.width, extent.height};
+  }
+  const i32 scissor_x0 = static_cast<i32>(std::min(viewport.x, extent.width));
+  const i32 scissor_y0 = static_cast<i32>(std::min(viewport.y, extent.height));
+  const i32 scissor_x1 = static_cast<i32>(std::min(viewport.x + viewport.width, extent.width));
+  const i32 scissor_y1 = static_cast<i32>(std::min(viewport.y + viewport.height, extent.height));
+  const f32 half_w = static_cast<f32>(viewport.width) * .5f;
+  const f32 half_h = static_cast<f32>(viewport.height) * .5f;
+  const f32 center_x = static_cast<f32>(viewport.x) + half_w;
+  const f32 center_y = static_cast<f32>(viewport.y) + half_h;
+
+  const u32 tile = _tile_size;
+  const u32 tiles_x = (extent.width + tile - 1) / tile;
+  const u32 tiles_y = (extent.height + tile - 1) / tile;
+  const u32 tile_count = tiles_x * tiles_y;
+  const u32 chunk_count = (triangle_count + SETUP_CHUNK_SIZE - 1) / SETUP_CHUNK_SIZE;
+  if (scratch.chunks.size() < chunk_count) {
+    scratch.chunks.resize(chunk_count);
+  }
+
+  const vec4* clip = scratch.clip.data();
+  const f32* varyings = scratch.varyings.data();
+  const auto vertex_index = [&](u32 i) -> u32 {
+    const u32 index = indices.empty() ? i : indices[i];
+    SHOGLE_ASSERT(index < vertex_count, "Vertex index out of range");
+    return index;
+  };
+
+  // Snaps, culls and bins a single clipped triangle
+  const auto setup_triangle = [&](draw_scratch::setup_chunk& chunk,
+                                  const clip_vertex* (&verts)[3]) -> bool {
+    f64 x[3], y[3];
+    f32 z[3], inv_w[3];
+    for (u32 k = 0; k < 3; ++k) {
+      const vec4& pos = verts[k]->pos;
+      if (pos.w <= 0.f) {
+        return false;
+      }
+      inv_w[k] = 1.f / pos.w;
+      const f32 sx = center_x + pos.x * inv_w[k] * half_w;
+      const f32 sy = center_y - pos.y * inv_w[k] * half_h;
+      x[k] = std::round(static_cast<f64>(sx) * SUBPIXEL_SCALE) / SUBPIXEL_SCALE;
+      y[k] = std::round(static_cast<f64>(sy) * SUBPIXEL_SCALE) / SUBPIXEL_SCALE;
+      z[k] = std::clamp(pos.z * inv_w[k] * .5f + .5f, 0.f, 1.f);
+    }
+
+    // Screen space has y pointing down, counter clockwise triangles in NDC come out negative
+    f64 area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+    if (area == 0.0) {
+      return false;
+    }
+    const bool front = area < 0.0;
+    if ((state.cull == sw_draw_state::CULL_BACK && !front) ||
+        (state.cull == sw_draw_state::CULL_FRONT && front)) {
+      return false;
+    }
+    u32 order[3] = {0, 1, 2};
+    if (area < 0.0) {
+      std::swap(order[1], order[2]);
+      area = -area;
+    }
+
+    raster_triangle tri;
+    f64 min_x = x[0], max_x = x[0], min_y = y[0], max_y = y[0];
+    for (u32 k = 1; k < 3; ++k) {
+      min_x = std::min(min_x, x[k]);
+      max_x = std::max(max_x, x[k]);
+      min_y = std::min(min_y, y[k]);
+      max_y = std::max(max_y, y[k]);
+    }
+    tri.min_x = std::max(static_cast<i32>(std::floor(min_x)), scissor_x0);
+    tri.min_y = std::max(static_cast<i32>(std::floor(min_y)), scissor_y0);
+    tri.max_x = std::min(static_cast<i32>(std::ceil(max_x)), scissor_x1);
+    tri.max_y = std::min(static_cast<i32>(std::ceil(max_y)), scissor_y1);
+    if (tri.min_x >= tri.max_x || tri.min_y >= tri.max_y) {
+      return false;
+    }
+
+    tri.top_left = 0;
+    for (u32 k = 0; k < 3; ++k) {
+      const u32 p = order[(k + 1) % 3];
+      const u32 q = order[(k + 2) % 3];
+      tri.a[k] = y[p] - y[q];
+      tri.b[k] = x[q] - x[p];
+      tri.c[k] = x[p] * y[q] - y[p] * x[q];
+      const bool top_left = tri.a[k] > 0.0 || (tri.a[k] == 0.0 && tri.b[k] > 0.0);
+      tri.top_left |= u32{top_left} << k;
+      tri.z[k] = z[order[k]];
+    }
+    tri.inv_area = static_cast<f32>(1.0 / area);
+    tri.attribs = static_cast<u32>(chunk.attribs.size());
+    for (u32 k = 0; k < 3; ++k) {
+      const u32 v = order[k];
+      chunk.attribs.push_back(inv_w[v]);
+      for (u32 i = 0; i < varying_count; ++i) {
+        chunk.attribs.push_back(verts[v]->varyings[i] * inv_w[v]);
+      }
+    }
+
+    const u32 index = static_cast<u32>(chunk.triangles.size());
+    chunk.triangles.push_back(tri);
+    const u32 tile_x0 = static_cast<u32>(tri.min_x) / tile;
+    const u32 tile_y0 = static_cast<u32>(tri.min_y) / tile;
+    const u32 tile_x1 = static_cast<u32>(tri.max_x - 1) / tile;
+    const u32 tile_y1 = static_cast<u32>(tri.max_y - 1) / tile;
+    for (u32 ty = tile_y0; ty <= tile_y1; ++ty) {
+      for (u32 tx = tile_x0; tx <= tile_x1; ++tx) {
+        // Skip tiles fully outside an edge, with a pixel step of slack for rounding
+        const f64 cx0 = tx * tile + .5, cx1 = std::min((tx + 1) * tile, extent.width) - .5;
+        const f64 cy0 = ty * tile + .5, cy1 = std::min((ty + 1) * tile, extent.height) - .5;
+        bool outside = false;
+        for (u32 k = 0; k < 3 && !outside; ++k) {
+          const f64 best = tri.a[k] * (tri.a[k] > 0.0 ? cx1 : cx0) +
+                           tri.b[k] * (tri.b[k] > 0.0 ? cy1 : cy0) + tri.c[k];
+          outside = best < -(std::abs(tri.a[k]) + std::abs(tri.b[k]));
+        }
+        if (!outside) {
+          chunk.bins[ty * tiles_x + tx].push_back(index);
+        }
+      }
+    }
+    return true;
+  };
+
+  auto setup_stage = [&](u32 begin, u32 end) {
+    f32 storage[MAX_CLIP_STORAGE][SW_MAX_VARYINGS];
+    clip_vertex polys[2][MAX_CLIP_VERTICES];
+    for (u32 c = begin; c < end; ++c) {
+      auto& chunk = scratch.chunks[c];
+      chunk.triangles.clear();
+      chunk.attribs.clear();
+      chunk.bins.resize(tile_count);
+      for (auto& bin : chunk.bins) {
+        bin.clear();
+      }
+      chunk.culled = 0;
+
+      const u32 first = c * SETUP_CHUNK_SIZE;
+      const u32 last = std::min(first + SETUP_CHUNK_SIZE, triangle_count);
+      for (u32 t = first; t < last; ++t) {
+        u32 codes[3];
+        for (u32 k = 0; k < 3; ++k) {
+          const u32 v = vertex_index(3 * t + k);
+          polys[0][k] = {clip[v], varyings + size_t{v} * varying_count};
+          codes[k] = outcode(clip[v]);
+        }
+        if (codes[0] & codes[1] & codes[2]) {
+          ++chunk.culled;
+          continue;
+        }
+
+        // Sutherland-Hodgman against the planes some vertex sits behind
+        u32 count = 3;
+        u32 src = 0;
+        u32 used_storage = 0;
+        const u32 crossed = codes[0] | codes[1] | codes[2];
+        for (u32 plane = 0; plane < CLIP_PLANE_COUNT && count >= 3; ++plane) {
+          if (!((crossed >> plane) & 1u)) {
+            continue;
+          }
+          u32 out_count = 0;
+          for (u32 i = 0; i < count; ++i) {
+            const clip_vertex& cur = polys[src][i];
+            const clip_vertex& nxt = polys[src][(i + 1) % count];
+            const f32 d_cur = clip_distance(cur.pos, plane);
+            const f32 d_nxt = clip_distance(nxt.pos, plane);
+            if (d_cur >= 0.f) {
+              polys[src ^ 1][out_count++] = cur;
+            }
+            if ((d_cur >= 0.f) != (d_nxt >= 0.f)) {
+              const f32 t_cross = d_cur / (d_cur - d_nxt);
+              f32* vars = storage[used_storage++];
+              for (u32 k = 0; k < varying_count; ++k) {
+                vars[k] = cur.varyings[k] + (nxt.varyings[k] - cur.varyings[k]) * t_cross;
+              }
+              const vec4 pos{cur.pos.x + (nxt.pos.x - cur.pos.x) * t_cross,
+                             cur.pos.y + (nxt.pos.y - cur.pos.y) * t_cross,
+                             cur.pos.z + (nxt.pos.z - cur.pos.z) * t_cross,
+                             cur.pos.w + (nxt.pos.w - cur.pos.w) * t_cross};
+              polys[src ^ 1][out_count++] = {pos, vars};
+            }
+          }
+          count = out_count;
+          src ^= 1;
+        }
+
+        bool any = false;
+        for (u32 i = 1; i + 1 < count; ++i) {
+          const clip_vertex* verts[3] = {&polys[src][0], &polys[src][i], &polys[src][i + 1]};
+          any |= setup_triangle(chunk, verts);
+        }
+        chunk.culled += u32{!any};
+      }
+    }
+  };
+  parallel_for(chunk_count, 1, setup_stage);
+
+  const u32 width = extent.width;
+  u32* color = target.color().data();
+  f32* depth = target.depth().data();
+  std::atomic<u64> fragments{0};
+  auto raster_stage = [&](u32 begin, u32 end) {
+    f32 inputs[SW_MAX_VARYINGS];
+    f32 edges[3][4];
+    u64 shaded = 0;
+    for (u32 t = begin; t < end; ++t) {
+      const i32 tile_x0 = static_cast<i32>((t % tiles_x) * tile);
+      const i32 tile_y0 = static_cast<i32>((t / tiles_x) * tile);
+      const i32 tile_x1 = std::min(tile_x0 + static_cast<i32>(tile), static_cast<i32>(width));
+      const i32 tile_y1 =
+        std::min(tile_y0 + static_cast<i32>(tile), static_cast<i32>(extent.height));
+      for (u32 c = 0; c < chunk_count; ++c) {
+        const auto& chunk = scratch.chunks[c];
+        for (const u32 index : chunk.bins[t]) {
+          const raster_triangle& tri = chunk.triangles[index];
+          const i32 x0 = std::max(tri.min_x, tile_x0);
+          const i32 x1 = std::min(tri.max_x, tile_x1);
+          const i32 y0 = std::max(tri.min_y, tile_y0);
+          const i32 y1 = std::min(tri.max_y, tile_y1);
+          // Groups start on a multiple of 4 so both sides of a shared edge agree on the bases
+          const i32 group_x0 = x0 & ~3;
+          const f32 step[3] = {static_cast<f32>(tri.a[0]), static_cast<f32>(tri.a[1]),
+                               static_cast<f32>(tri.a[2])};
+          const f32* attr0 = chunk.attribs.data() + tri.attribs;
+          const f32* attr1 = attr0 + attrib_stride;
+          const f32* attr2 = attr1 + attrib_stride;
+
+          for (i32 y = y0; y < y1; ++y) {
+            const f64 py = y + .5;
+            const f64 row[3] = {tri.b[0] * py + tri.c[0], tri.b[1] * py + tri.c[1],
+                                tri.b[2] * py + tri.c[2]};
+            for (i32 gx = group_x0; gx < x1; gx += 4) {
+              const f64 px = gx + .5;
+              const f32 base[3] = {static_cast<f32>(tri.a[0] * px + row[0]),
+                                   static_cast<f32>(tri.a[1] * px + row[1]),
+                                   static_cast<f32>(tri.a[2] * px + row[2])};
+              u32 mask = edge_coverage(base, step, tri.top_left, edges);
+              for (i32 i = 0; i < 4; ++i) {
+                const i32 x = gx + i;
+                if (x < x0 || x >= x1) {
+                  mask &= ~(1u << i);
+                }
+              }
+
+              while (mask) {
+                const u32 i = static_cast<u32>(__builtin_ctz(mask));
+                mask &= mask - 1;
+                const f32 l0 = edges[0][i] * tri.inv_area;
+                const f32 l1 = edges[1][i] * tri.inv_area;
+                const f32 l2 = edges[2][i] * tri.inv_area;
+                const size_t pixel = size_t{static_cast<u32>(y)} * width + static_cast<u32>(gx) + i;
+                const f32 z =
+                  std::clamp(l0 * tri.z[0] + l1 * tri.z[1] + l2 * tri.z[2], 0.f, 1.f);
+                if (state.depth_enable && !depth_passes(state.test, z, depth[pixel])) {
+                  continue;
+                }
+
+                const f32 w = 1.f / (l0 * attr0[0] + l1 * attr1[0] + l2 * attr2[0]);
+                for (u32 k = 1; k <= varying_count; ++k) {
+                  inputs[k - 1] = (l0 * attr0[k] + l1 * attr1[k] + l2 * attr2[k]) * w;
+                }
+                color4 out;
+                ++shaded;
+                if (!shade(inputs, out)) {
+                  continue;
+                }
+                if (state.depth_enable && state.depth_write) {
+                  depth[pixel] = z;
+                }
+                color[pixel] = blend_color(state.blend, out, color[pixel]);
+              }
+            }
+          }
+        }
+      }
+    }
+    fragments.fetch_add(shaded, std::memory_order_relaxed);
+  };
+  parallel_for(tile_count, 1, raster_stage);
+
+  u32 culled = 0;
+  for (u32 c = 0; c < chunk_count; ++c) {
+    culled += scratch.chunks[c].culled;
+  }
+  return {triangle_count, culled, fragments.load(std::memory_order_relaxed)};
+}
+
+} // namespace shogle
@@ -0,0 +1,97 @@
+#include <shogle/render/sw/texture.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace shogle {
+
+namespace {
+
+i32 wrap_coord(i32 coord, u32 size, sw_texture::sampler_wrap wrap) noexcept {
+  const i32 isize = static_cast<i32>(size);
+  if (wrap == sw_texture::WRAP_CLAMP) {
+    return std::clamp(coord, 0, isize - 1);
+  }
+  const i32 rem = coord % isize;
+  return rem < 0 ? rem + isize : rem;
+}
+
+color4 lerp_color(const color4& a, const color4& b, f32 t) noexcept {
+  return {a.r + (b.r - a.r) * t, a.g + (b.g - a.g) * t, a.b + (b.b - a.b) * t,
+          a.a + (b.a - a.a) * t};
+}
+
+} // namespace
+
+sw_texture::sw_texture(extent2d extent, span<const u8> texels) :
+    _texels(size_t{extent.width} * extent.height), _extent(extent) {
+  SHOGLE_ASSERT(extent.width && extent.height, "Invalid texture extent");
+  if (!texels.empty()) {
+    SHOGLE_ASSERT(texels.size() == _texels.size() * sizeof(u32), "Texel data size mismatch");
+    std::memcpy(_texels.data(), texels.data(), texels.size());
+  }
+}
+
+color4 sw_texture::fetch(u32 x, u32 y) const {
+  SHOGLE_ASSERT(x < _extent.width && y < _extent.height, "Texel out of range");
+  return sw_unpack_color(_texels[size_t{y} * _extent.width + x]);
+}
+
+color4 sw_texture::sample(const vec2& uv, const sampler& samp) const {
+  const f32 u = uv.x * static_cast<f32>(_extent.width);
+  const f32 v = uv.y * static_cast<f32>(_extent.height);
+  if (samp.filter == FILTER_NEAREST) {
+    const i32 x = wrap_coord(static_cast<i32>(std::floor(u)), _extent.width, samp.wrap);
+    const i32 y = wrap_coord(static_cast<i32>(std::floor(v)), _extent.height, samp.wrap);
+    return fetch(static_cast<u32>(x), static_cast<u32>(y));
+  }
+
+  // Texel centers sit at half coordinates
+  const f32 fu = u - .5f;
+  const f32 fv = v - .5f;
+  const f32 x0f = std::floor(fu);
+  const f32 y0f = std::floor(fv);
+  const f32 tx = fu - x0f;
+  const f32 ty = fv - y0f;
+  const i32 x0 = static_cast<i32>(x0f);
+  const i32 y0 = static_cast<i32>(y0f);
+  const u32 xs[] = {static_cast<u32>(wrap_coord(x0, _extent.width, samp.wrap)),
+                    static_cast<u32>(wrap_coord(x0 + 1, _extent.width, samp.wrap))};
+  const u32 ys[] = {static_cast<u32>(wrap_coord(y0, _extent.height, samp.wrap)),
+                    static_cast<u32>(wrap_coord(y0 + 1, _extent.height, samp.wrap))};
+  const color4 top = lerp_color(fetch(xs[0], ys[0]), fetch(xs[1], ys[0]), tx);
+  const color4 bottom = lerp_color(fetch(xs[0], ys[1]), fetch(xs[1], ys[1]), tx);
+  return lerp_color(top, bottom, ty);
+}
+
+sw_framebuffer::sw_framebuffer(extent2d extent) :
+    _color(size_t{extent.width} * extent.height),
+    _depth(size_t{extent.width} * extent.height, 1.f), _extent(extent) {
+  SHOGLE_ASSERT(extent.width && extent.height, "Invalid framebuffer extent");
+}
+
+void sw_framebuffer::clear(const color4& color, f32 depth) {
+  clear_color(color);
+  clear_depth(depth);
+}
+
+void sw_framebuffer::clear_color(const color4& color) {
+  std::fill(_color.begin(), _color.end(), sw_pack_color(color));
+}
+
+void sw_framebuffer::clear_depth(f32 depth) {
+  std::fill(_depth.begin(), _depth.end(), depth);
+}
+
+void sw_framebuffer::read_pixels(span<u8> out) const {
+  SHOGLE_ASSERT(out.size() >= _color.size() * sizeof(u32), "Pixel buffer too small");
+  std::memcpy(out.data(), _color.data(), _color.size() * sizeof(u32));
+}
+
+color4 sw_framebuffer::pixel(u32 x, u32 y) const {
+  SHOGLE_ASSERT(x < _extent.width && y < _extent.height, "Pixel out of range");
+  return sw_unpack_color(_color[size_t{y} * _extent.width + x]);
+}
+
+} // namespace shogle
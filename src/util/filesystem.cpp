@@ -21,7 +21,7 @@ expected<unique_array<u8>, std::error_code> read_entire_file(const char* path) {
   return {in_place, std::move(buffer)};
 }
 
-expected<std::string, std::error_code> read_enrire_file_str(const char* path) {
+expected<std::string, std::error_code> read_entire_file_str(const char* path) {
   stdfs::path in(path);
   std::error_code ec;
   const size_t len = static_cast<size_t>(stdfs::file_size(in, ec));
@@ -188,6 +188,7 @@ void scratch_arena::clear() noexcept {
     header->used = 0u;
     header = header->prev;
   }
+  header->used = 0u;
   _data = static_cast<void*>(header);
   _used = 0u;
 }
@@ -0,0 +1,278 @@
+#include <shogle/util/tlsf.hpp>
+
+#include <bit>
+
+namespace shogle::mem {
+
+namespace {
+
+constexpr u64 align_up(u64 value, u64 alignment) noexcept {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+constexpr u32 msb(u64 value) noexcept {
+  return 63u - static_cast<u32>(std::countl_zero(value));
+}
+
+} // namespace
+
+tlsf_allocator::tlsf_allocator(u64 capacity) : _capacity(capacity) {
+  SHOGLE_ASSERT(capacity, "TLSF allocator with no capacity");
+  reset();
+}
+
+auto tlsf_allocator::_map_insert(u64 size) noexcept -> bin_index {
+  if (size < SMALL_BLOCK_SIZE) {
+    return {0, static_cast<u32>(size)};
+  }
+  const u32 bit = msb(size);
+  return {bit - SL_COUNT_LOG2 + 1, static_cast<u32>(size >> (bit - SL_COUNT_LOG2)) - SL_COUNT};
+}
+
+auto tlsf_allocator::_map_search(u64 size) noexcept -> bin_index {
+  // Round up to the next bin, so that any block found there is big enough
+  if (size >= SMALL_BLOCK_SIZE) {
+    const u64 round = (u64{1} << (msb(size) - SL_COUNT_LOG2)) - 1;
+    size = size > std::numeric_limits<u64>::max() - round ? size : size + round;
+  }
+  return _map_insert(size);
+}
+
+auto tlsf_allocator::_new_node(u64 offset, u64 size) -> handle {
+  const block_node node{offset, size, 1, NULL_HANDLE, NULL_HANDLE, NULL_HANDLE, NULL_HANDLE, false};
+  if (!_spare_nodes.empty()) {
+    const handle idx = _spare_nodes.back();
+    _spare_nodes.pop_back();
+    _nodes[idx] = node;
+    return idx;
+  }
+  _nodes.emplace_back(node);
+  return static_cast<handle>(_nodes.size() - 1);
+}
+
+void tlsf_allocator::_release_node(handle node) noexcept {
+  _spare_nodes.emplace_back(node);
+}
+
+void tlsf_allocator::_insert_free(handle node) noexcept {
+  auto& block = _nodes[node];
+  const auto [fl, sl] = _map_insert(block.size);
+  const handle head = _free_heads[fl][sl];
+  block.prev_free = NULL_HANDLE;
+  block.next_free = head;
+  if (head != NULL_HANDLE) {
+    _nodes[head].prev_free = node;
+  }
+  _free_heads[fl][sl] = node;
+  _sl_bitmap[fl] |= 1u << sl;
+  _fl_bitmap |= u64{1} << fl;
+}
+
+void tlsf_allocator::_remove_free(handle node) noexcept {
+  auto& block = _nodes[node];
+  const auto [fl, sl] = _map_insert(block.size);
+  if (block.prev_free != NULL_HANDLE) {
+    _nodes[block.prev_free].next_free = block.next_free;
+  } else {
+    _free_heads[fl][sl] = block.next_free;
+  }
+  if (block.next_free != NULL_HANDLE) {
+    _nodes[block.next_free].prev_free = block.prev_free;
+  }
+  block.prev_free = NULL_HANDLE;
+  block.next_free = NULL_HANDLE;
+  if (_free_heads[fl][sl] == NULL_HANDLE) {
+    _sl_bitmap[fl] &= ~(1u << sl);
+    if (!_sl_bitmap[fl]) {
+      _fl_bitmap &= ~(u64{1} << fl);
+    }
+  }
+}
+
+auto tlsf_allocator::_find_free(u64 size) const noexcept -> handle {
+  auto [fl, sl] = _map_search(size);
+  if (fl >= FL_COUNT) {
+    return NULL_HANDLE;
+  }
+  u32 sl_map = _sl_bitmap[fl] & (~0u << sl);
+  if (!sl_map) {
+    const u64 fl_map = fl + 1 < FL_COUNT ? _fl_bitmap & (~u64{0} << (fl + 1)) : 0;
+    if (!fl_map) {
+      return NULL_HANDLE;
+    }
+    fl = static_cast<u32>(std::countr_zero(fl_map));
+    sl_map = _sl_bitmap[fl];
+  }
+  sl = static_cast<u32>(std::countr_zero(sl_map));
+  return _free_heads[fl][sl];
+}
+
+void tlsf_allocator::_split(handle node, u64 size) {
+  const u64 offset = _nodes[node].offset + size;
+  const u64 rest = _nodes[node].size - size;
+  const handle tail = _new_node(offset, rest); // May reallocate _nodes
+  auto& block = _nodes[node];
+  auto& tail_block = _nodes[tail];
+  tail_block.prev_phys = node;
+  tail_block.next_phys = block.next_phys;
+  if (block.next_phys != NULL_HANDLE) {
+    _nodes[block.next_phys].prev_phys = tail;
+  }
+  block.next_phys = tail;
+  block.size = size;
+}
+
+auto tlsf_allocator::allocate(u64 size, u64 alignment) -> optional<allocation> {
+  SHOGLE_ASSERT(size, "TLSF allocation with no size");
+  SHOGLE_ASSERT(alignment, "TLSF allocation with zero alignment");
+  handle node = _find_free(size + alignment - 1);
+  if (node == NULL_HANDLE) {
+    return nullopt;
+  }
+  _remove_free(node);
+
+  // Alignment padding goes back to the free lists as its own block
+  const u64 padding = align_up(_nodes[node].offset, alignment) - _nodes[node].offset;
+  if (padding) {
+    _split(node, padding);
+    const handle aligned = _nodes[node].next_phys;
+    _insert_free(node);
+    node = aligned;
+  }
+  if (_nodes[node].size > size) {
+    _split(node, size);
+    _insert_free(_nodes[node].next_phys);
+  }
+
+  auto& block = _nodes[node];
+  block.used = true;
+  block.alignment = alignment;
+  _used += size;
+  ++_alloc_count;
+  return allocation{block.offset, size, node};
+}
+
+void tlsf_allocator::deallocate(handle node) noexcept {
+  SHOGLE_ASSERT(node < _nodes.size() && _nodes[node].used, "Invalid TLSF handle");
+  _nodes[node].used = false;
+  _used -= _nodes[node].size;
+  --_alloc_count;
+
+  const handle prev = _nodes[node].prev_phys;
+  if (prev != NULL_HANDLE && !_nodes[prev].used) {
+    _remove_free(prev);
+    _nodes[prev].size += _nodes[node].size;
+    _nodes[prev].next_phys = _nodes[node].next_phys;
+    if (_nodes[node].next_phys != NULL_HANDLE) {
+      _nodes[_nodes[node].next_phys].prev_phys = prev;
+    }
+    _release_node(node);
+    node = prev;
+  }
+  const handle next = _nodes[node].next_phys;
+  if (next != NULL_HANDLE && !_nodes[next].used) {
+    _remove_free(next);
+    _nodes[node].size += _nodes[next].size;
+    _nodes[node].next_phys = _nodes[next].next_phys;
+    if (_nodes[next].next_phys != NULL_HANDLE) {
+      _nodes[_nodes[next].next_phys].prev_phys = node;
+    }
+    _release_node(next);
+  }
+  _insert_free(node);
+}
+
+auto tlsf_allocator::compact() -> std::vector<block_move> {
+  std::vector<handle> live;
+  live.reserve(_alloc_count);
+  for (handle it = _phys_head; it != NULL_HANDLE;) {
+    const handle next = _nodes[it].next_phys;
+    if (_nodes[it].used) {
+      live.emplace_back(it);
+    } else {
+      _release_node(it);
+    }
+    it = next;
+  }
+  for (auto& heads : _free_heads) {
+    heads.fill(NULL_HANDLE);
+  }
+  _sl_bitmap.fill(0);
+  _fl_bitmap = 0;
+
+  std::vector<block_move> moves;
+  handle tail = NULL_HANDLE;
+  const auto link = [&](handle node) {
+    _nodes[node].prev_phys = tail;
+    _nodes[node].next_phys = NULL_HANDLE;
+    if (tail != NULL_HANDLE) {
+      _nodes[tail].next_phys = node;
+    } else {
+      _phys_head = node;
+    }
+    tail = node;
+  };
+  const auto add_free = [&](u64 offset, u64 size) {
+    const handle node = _new_node(offset, size);
+    link(node);
+    _insert_free(node);
+  };
+
+  // Blocks only move backwards, an aligned offset can't get past the one it already had
+  u64 cursor = 0;
+  for (const handle node : live) {
+    const u64 dst = align_up(cursor, _nodes[node].alignment);
+    if (dst > cursor) {
+      add_free(cursor, dst - cursor);
+    }
+    if (dst != _nodes[node].offset) {
+      moves.emplace_back(node, _nodes[node].offset, dst, _nodes[node].size);
+      _nodes[node].offset = dst;
+    }
+    link(node);
+    cursor = dst + _nodes[node].size;
+  }
+  if (cursor < _capacity) {
+    add_free(cursor, _capacity - cursor);
+  }
+  return moves;
+}
+
+void tlsf_allocator::reset() {
+  _nodes.clear();
+  _spare_nodes.clear();
+  for (auto& heads : _free_heads) {
+    heads.fill(NULL_HANDLE);
+  }
+  _sl_bitmap.fill(0);
+  _fl_bitmap = 0;
+  _used = 0;
+  _alloc_count = 0;
+  _phys_head = _new_node(0, _capacity);
+  _insert_free(_phys_head);
+}
+
+u64 tlsf_allocator::offset(handle node) const {
+  SHOGLE_ASSERT(node < _nodes.size() && _nodes[node].used, "Invalid TLSF handle");
+  return _nodes[node].offset;
+}
+
+u64 tlsf_allocator::size(handle node) const {
+  SHOGLE_ASSERT(node < _nodes.size() && _nodes[node].used, "Invalid TLSF handle");
+  return _nodes[node].size;
+}
+
+u64 tlsf_allocator::largest_free_block() const noexcept {
+  if (!_fl_bitmap) {
+    return 0;
+  }
+  const u32 fl = msb(_fl_bitmap);
+  const u32 sl = msb(_sl_bitmap[fl]);
+  u64 largest = 0;
+  for (handle it = _free_heads[fl][sl]; it != NULL_HANDLE; it = _nodes[it].next_free) {
+    largest = std::max(largest, _nodes[it].size);
+  }
+  return largest;
+}
+
+} // namespace shogle::mem
@@ -0,0 +1,136 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "./mock_scene.hpp"
+
+#include <vector>
+
+using namespace shogle;
+using namespace shogle::test;
+
+namespace {
+
+// Meshes of 24 vertices and 36 indices packed in shared buffers
+struct batch_scene : mock_scene {
+  batch_scene(gl_context& gl) :
+      mock_scene(gl, 1024), ebo(gl, gl_buffer::TYPE_INDEX, 4096 * sizeof(u32)),
+      draw_data(gl, gl_buffer::TYPE_SHADER, 64 * 16),
+      indirect(gl, gl_buffer::TYPE_INDIRECT, 64 * sizeof(gl_indirect_command)) {}
+
+  gl_draw_command make_draw(const gl_graphics_pipeline& pipeline, u32 mesh) {
+    builder.reset();
+    return builder.set_pipeline(pipeline)
+      .set_vertex_layout(layout)
+      .add_vertex_buffer(vbo)
+      .set_index_buffer(ebo, gl_draw_command::INDEX_FORMAT_U32, mesh * 36)
+      .set_vertex_offset(mesh * 24)
+      .set_draw_count(36)
+      .build();
+  }
+
+  void destroy(gl_context& gl) {
+    gl_buffer::deallocate(gl, indirect);
+    gl_buffer::deallocate(gl, draw_data);
+    gl_buffer::deallocate(gl, ebo);
+    mock_scene::destroy(gl);
+  }
+
+  gl_buffer ebo;
+  gl_buffer draw_data;
+  gl_buffer indirect;
+};
+
+} // namespace
+
+TEST_CASE("Batch builder groups compatible draws", "[gl_batch]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  batch_scene scene{gl};
+
+  gl_batch_builder batch;
+  batch.set_draw_data(scene.draw_data, 2, 16, 64);
+  for (u32 i = 0; i < 6; ++i) {
+    REQUIRE(batch.add_draw(scene.make_draw(i % 2 ? scene.pipeline_b : scene.pipeline_a, i)));
+  }
+
+  // Non indexed draws and push uniforms can't go through the indirect path
+  scene.builder.reset();
+  REQUIRE_FALSE(batch.add_draw(scene.builder.set_pipeline(scene.pipeline_a)
+                                 .set_vertex_layout(scene.layout)
+                                 .add_vertex_buffer(scene.vbo)
+                                 .set_draw_count(3)
+                                 .build()));
+  scene.builder.reset();
+  REQUIRE_FALSE(batch.add_draw(scene.builder.set_pipeline(scene.pipeline_a)
+                                 .set_vertex_layout(scene.layout)
+                                 .add_vertex_buffer(scene.vbo)
+                                 .set_index_buffer(scene.ebo, gl_draw_command::INDEX_FORMAT_U32)
+                                 .set_draw_count(3)
+                                 .add_uniform(vec4{1.f}, 0)
+                                 .build()));
+
+  const auto built = batch.build();
+  REQUIRE(batch.draw_count() == 6);
+  REQUIRE(batch.group_count() == 2);
+  REQUIRE(built.groups.size() == 2);
+  REQUIRE(built.groups[0].first_command == 0);
+  REQUIRE(built.groups[0].command_count == 3);
+  // 16 byte stride with 64 byte alignment, group ranges start every 4 commands
+  REQUIRE(built.groups[1].first_command == 4);
+  REQUIRE(built.groups[1].command_count == 3);
+  REQUIRE(built.commands.size() == 7);
+
+  for (u32 i = 0; i < 6; ++i) {
+    const auto& cmd = built.commands[batch.draw_slot(i)];
+    REQUIRE(cmd.count == 36);
+    REQUIRE(cmd.instance_count == 1);
+    REQUIRE(cmd.first_index == i * 36);
+    REQUIRE(cmd.base_vertex == static_cast<i32>(i * 24));
+  }
+  REQUIRE(built.commands[3].count == 0);
+
+  scene.destroy(gl);
+  gl.destroy();
+}
+
+TEST_CASE("Batches are issued with one multi draw per group", "[gl_batch]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  batch_scene scene{gl};
+  const gl_clear_opts clear{color4{0.f, 0.f, 0.f, 1.f}, nullopt, gl_clear_opts::CLEAR_COLOR, {}};
+
+  gl_batch_builder batch;
+  batch.set_draw_data(scene.draw_data, 2, 16, 64);
+  for (u32 i = 0; i < 40; ++i) {
+    batch.add_draw(scene.make_draw(i < 30 ? scene.pipeline_a : scene.pipeline_b, i));
+  }
+  const auto built = batch.build();
+
+  mock.reset_stats();
+  gl.start_frame(clear);
+  gl.submit_batch(built, scene.indirect);
+  gl.end_frame();
+
+  REQUIRE(mock.stats().draw_calls == 2);
+  REQUIRE(mock.call_count("glMultiDrawElementsIndirect") == 2);
+  REQUIRE(mock.call_count("glDrawElementsBaseVertex") == 0);
+
+  std::vector<std::pair<u64, u64>> multi_draws;
+  auto check_calls = [&](std::string_view func, span<const u64> args) {
+    if (func == "glMultiDrawElementsIndirect") {
+      multi_draws.emplace_back(args[2], args[3]);
+    }
+  };
+  mock.decode_trace(check_calls);
+  REQUIRE(multi_draws.size() == 2);
+  REQUIRE(multi_draws[0] == std::pair<u64, u64>{0, 30});
+  REQUIRE(multi_draws[1] ==
+          std::pair<u64, u64>{built.groups[1].first_command * sizeof(gl_indirect_command), 10});
+
+#ifndef SHOGLE_GL_DISABLE_FRAME_STATS
+  REQUIRE(gl.frame_stats().draw_calls == 2);
+  REQUIRE(gl.frame_stats().indices == 40 * 36);
+#endif
+
+  scene.destroy(gl);
+  gl.destroy();
+}
@@ -0,0 +1,278 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <shogle/render/gl/mock.hpp>
+#include <shogle/render/opengl.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace shogle;
+
+namespace {
+
+// Reference decoders, BC7 only handles the mode 6 blocks the encoder emits
+void decode_bc1(const u8* block, u8* out, bool always_four) {
+  const u16 c0 = static_cast<u16>(block[0] | block[1] << 8);
+  const u16 c1 = static_cast<u16>(block[2] | block[3] << 8);
+  const auto unpack = [](u16 c) {
+    const i32 r = c >> 11, g = (c >> 5) & 0x3F, b = c & 0x1F;
+    return std::array<i32, 3>{(r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2)};
+  };
+  const auto p0 = unpack(c0);
+  const auto p1 = unpack(c1);
+  const bool four = always_four || c0 > c1;
+  i32 palette[4][4];
+  for (u32 c = 0; c < 3; ++c) {
+    palette[0][c] = p0[c];
+    palette[1][c] = p1[c];
+    palette[2][c] = four ? (2 * p0[c] + p1[c]) / 3 : (p0[c] + p1[c]) / 2;
+    palette[3][c] = four ? (p0[c] + 2 * p1[c]) / 3 : 0;
+  }
+  palette[0][3] = palette[1][3] = palette[2][3] = 255;
+  palette[3][3] = four ? 255 : 0;
+  const u32 indices = block[4] | block[5] << 8 | block[6] << 16 | u32(block[7]) << 24;
+  for (u32 i = 0; i < 16; ++i) {
+    const u32 idx = (indices >> (i * 2)) & 3;
+    for (u32 c = 0; c < 4; ++c) {
+      out[i * 4 + c] = static_cast<u8>(palette[idx][c]);
+    }
+  }
+}
+
+void decode_bc4(const u8* block, u8* out, u32 channel) {
+  const i32 r0 = block[0];
+  const i32 r1 = block[1];
+  i32 palette[8]{r0, r1};
+  if (r0 > r1) {
+    for (i32 k = 1; k < 7; ++k) {
+      palette[k + 1] = ((7 - k) * r0 + k * r1 + 3) / 7;
+    }
+  } else {
+    for (i32 k = 1; k < 5; ++k) {
+      palette[k + 1] = ((5 - k) * r0 + k * r1 + 2) / 5;
+    }
+    palette[6] = 0;
+    palette[7] = 255;
+  }
+  u64 bits = 0;
+  for (u32 i = 0; i < 6; ++i) {
+    bits |= u64(block[2 + i]) << (i * 8);
+  }
+  for (u32 i = 0; i < 16; ++i) {
+    out[i * 4 + channel] = static_cast<u8>(palette[(bits >> (i * 3)) & 7]);
+  }
+}
+
+void decode_bc7_mode6(const u8* block, u8* out) {
+  u32 pos = 0;
+  const auto get = [&](u32 bits) {
+    u32 value = 0;
+    for (u32 i = 0; i < bits; ++i, ++pos) {
+      value |= ((block[pos / 8] >> (pos % 8)) & 1u) << i;
+    }
+    return value;
+  };
+  REQUIRE(get(7) == 1u << 6);
+  u32 e[2][4];
+  for (u32 c = 0; c < 4; ++c) {
+    e[0][c] = get(7) << 1;
+    e[1][c] = get(7) << 1;
+  }
+  const u32 p0 = get(1);
+  const u32 p1 = get(1);
+  constexpr u32 weights[]{0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+  for (u32 i = 0; i < 16; ++i) {
+    const u32 w = weights[get(i ? 4 : 3)];
+    for (u32 c = 0; c < 4; ++c) {
+      out[i * 4 + c] =
+        static_cast<u8>(((64 - w) * (e[0][c] | p0) + w * (e[1][c] | p1) + 32) >> 6);
+    }
+  }
+}
+
+std::vector<u8> decode(gl_texture::texture_format format, const std::vector<u8>& blocks, u32 width,
+                       u32 height) {
+  const u32 block_size = gl_texture::compressed_block_size(format);
+  const u32 blocks_x = (width + 3) / 4;
+  std::vector<u8> pixels(width * height * 4, 0);
+  for (u32 by = 0; by < (height + 3) / 4; ++by) {
+    for (u32 bx = 0; bx < blocks_x; ++bx) {
+      const u8* block = blocks.data() + (by * blocks_x + bx) * block_size;
+      u8 texels[64]{};
+      switch (format) {
+        case gl_texture::TEX_FORMAT_BC1_RGB:
+          [[fallthrough]];
+        case gl_texture::TEX_FORMAT_BC1_RGBA: {
+          decode_bc1(block, texels, false);
+        } break;
+        case gl_texture::TEX_FORMAT_BC3_RGBA: {
+          decode_bc4(block, texels, 3);
+          u8 color[64];
+          decode_bc1(block + 8, color, true);
+          for (u32 i = 0; i < 16; ++i) {
+            std::copy_n(color + i * 4, 3, texels + i * 4);
+          }
+        } break;
+        case gl_texture::TEX_FORMAT_BC4_R: {
+          decode_bc4(block, texels, 0);
+        } break;
+        case gl_texture::TEX_FORMAT_BC5_RG: {
+          decode_bc4(block, texels, 0);
+          decode_bc4(block + 8, texels, 1);
+        } break;
+        case gl_texture::TEX_FORMAT_BC7_RGBA: {
+          decode_bc7_mode6(block, texels);
+        } break;
+        default:
+          FAIL("Unexpected format");
+      }
+      for (u32 ty = 0; ty < 4 && by * 4 + ty < height; ++ty) {
+        for (u32 tx = 0; tx < 4 && bx * 4 + tx < width; ++tx) {
+          std::copy_n(texels + (ty * 4 + tx) * 4, 4,
+                      pixels.data() + ((by * 4 + ty) * width + bx * 4 + tx) * 4);
+        }
+      }
+    }
+  }
+  return pixels;
+}
+
+f64 psnr(const std::vector<u8>& a, const std::vector<u8>& b, u32 channels) {
+  f64 sum = 0.0;
+  size_t count = 0;
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (i % 4 < channels) {
+      const f64 diff = f64(a[i]) - f64(b[i]);
+      sum += diff * diff;
+      ++count;
+    }
+  }
+  const f64 mse = sum / f64(count);
+  return mse == 0.0 ? 100.0 : 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+// Smooth gradients with some noise and a hard edged disc, odd extent for partial blocks
+std::vector<u8> test_image(u32 width, u32 height) {
+  std::mt19937 rng{7};
+  std::uniform_int_distribution<i32> noise{-6, 6};
+  std::vector<u8> pixels(width * height * 4);
+  for (u32 y = 0; y < height; ++y) {
+    for (u32 x = 0; x < width; ++x) {
+      const f32 dx = f32(x) - f32(width) / 2.f;
+      const f32 dy = f32(y) - f32(height) / 2.f;
+      const bool disc = dx * dx + dy * dy < f32(width * width) / 16.f;
+      u8* texel = pixels.data() + (y * width + x) * 4;
+      texel[0] = static_cast<u8>(std::clamp<i32>(x * 255 / width + noise(rng), 0, 255));
+      texel[1] = static_cast<u8>(std::clamp<i32>(y * 255 / height + noise(rng), 0, 255));
+      texel[2] = disc ? 220 : 40;
+      texel[3] = static_cast<u8>(disc ? 255 : (x + y) * 255 / (width + height));
+    }
+  }
+  return pixels;
+}
+
+} // namespace
+
+TEST_CASE("BCn encoder quality stays above its PSNR floor", "[gl_bcn_encoder]") {
+  constexpr u32 width = 70;
+  constexpr u32 height = 45;
+  const auto pixels = test_image(width, height);
+  const gl_texture::image_data image{pixels.data(), {width, height, 1},
+                                     gl_texture::PIXEL_FORMAT_RGBA, gl_texture::PIXEL_TYPE_U8,
+                                     gl_texture::ALIGN_4BYTES};
+
+  struct expectation {
+    gl_texture::texture_format format;
+    u32 channels;
+    f64 min_psnr;
+  };
+  constexpr expectation cases[] = {
+    {gl_texture::TEX_FORMAT_BC1_RGB, 3, 34.0}, {gl_texture::TEX_FORMAT_BC3_RGBA, 4, 35.0},
+    {gl_texture::TEX_FORMAT_BC4_R, 1, 45.0},   {gl_texture::TEX_FORMAT_BC5_RG, 2, 45.0},
+    {gl_texture::TEX_FORMAT_BC7_RGBA, 4, 36.0},
+  };
+  for (const auto& test : cases) {
+    auto blocks = gl_bcn_encoder::encode(image, {test.format, 1});
+    REQUIRE(blocks.has_value());
+    REQUIRE(blocks->size() == gl_texture::compressed_image_size(image.extent, test.format));
+    const auto decoded = decode(test.format, *blocks, width, height);
+    const f64 quality = psnr(pixels, decoded, test.channels);
+    INFO("format " << std::hex << test.format << " psnr " << quality);
+    REQUIRE(quality >= test.min_psnr);
+
+    // Threading only splits rows of blocks, the output can't change
+    auto threaded = gl_bcn_encoder::encode(image, {test.format, 4});
+    REQUIRE(threaded.has_value());
+    REQUIRE(*threaded == *blocks);
+  }
+
+  // Punch-through alpha keeps transparent texels transparent
+  auto bc1a = gl_bcn_encoder::encode(image, {gl_texture::TEX_FORMAT_BC1_RGBA, 0});
+  REQUIRE(bc1a.has_value());
+  const auto decoded = decode(gl_texture::TEX_FORMAT_BC1_RGBA, *bc1a, width, height);
+  for (size_t i = 3; i < pixels.size(); i += 4) {
+    REQUIRE((pixels[i] < 128) == (decoded[i] == 0));
+  }
+
+  REQUIRE_FALSE(gl_bcn_encoder::encode(image, {gl_texture::TEX_FORMAT_ETC2_RGB8, 1}));
+  REQUIRE_FALSE(gl_bcn_encoder::encode(image, {gl_texture::TEX_FORMAT_RGBA8, 1}));
+}
+
+TEST_CASE("Compressed textures upload encoded blocks", "[gl_bcn_encoder]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  gl_texture tex{gl, gl_texture::TEX_FORMAT_BC7_RGBA, extent2d{32, 32}, 1, 1};
+  REQUIRE(gl_texture::is_compressed(tex.format()));
+
+  std::vector<u8> pixels(32 * 32 * 4, 0x40);
+  auto blocks = gl_bcn_encoder::encode({pixels.data(), {32, 32, 1}, gl_texture::PIXEL_FORMAT_RGBA,
+                                        gl_texture::PIXEL_TYPE_U8, gl_texture::ALIGN_4BYTES},
+                                       {gl_texture::TEX_FORMAT_BC7_RGBA, 2});
+  REQUIRE(blocks.has_value());
+  REQUIRE(blocks->size() == 64 * 16);
+
+  mock.reset_stats();
+  REQUIRE(tex.upload_compressed(gl, {blocks->data(), blocks->size(), {32, 32, 1}}).has_value());
+  REQUIRE(mock.call_count("glCompressedTextureSubImage2D") == 1);
+  REQUIRE(mock.call_count("glTextureSubImage2D") == 0);
+
+  auto short_upload = tex.upload_compressed(gl, {blocks->data(), 16, {32, 32, 1}});
+  REQUIRE(short_upload.error().code() == 0x0501); // GL_INVALID_VALUE
+
+  gl_texture plain{gl, gl_texture::TEX_FORMAT_RGBA8, extent2d{32, 32}, 1, 1};
+  auto wrong = plain.upload_compressed(gl, {blocks->data(), blocks->size(), {32, 32, 1}});
+  REQUIRE(wrong.error().code() == 0x0502); // GL_INVALID_OPERATION
+
+  gl_texture::deallocate(gl, plain);
+  gl_texture::deallocate(gl, tex);
+  gl.destroy();
+}
+
+TEST_CASE("BCn encoder throughput", "[gl_bcn_encoder][!benchmark]") {
+  constexpr u32 extent = 512;
+  const auto pixels = test_image(extent, extent);
+  const gl_texture::image_data image{pixels.data(), {extent, extent, 1},
+                                     gl_texture::PIXEL_FORMAT_RGBA, gl_texture::PIXEL_TYPE_U8,
+                                     gl_texture::ALIGN_4BYTES};
+  std::vector<u8> storage(extent * extent);
+  const span<u8> blocks{storage.data(), storage.size()};
+
+  // 0.25 MPix per run, divide by the reported mean for MPix/s
+  BENCHMARK("BC1 single thread") {
+    return gl_bcn_encoder::encode(image, blocks, {gl_texture::TEX_FORMAT_BC1_RGB, 1}).has_value();
+  };
+  BENCHMARK("BC3 single thread") {
+    return gl_bcn_encoder::encode(image, blocks, {gl_texture::TEX_FORMAT_BC3_RGBA, 1}).has_value();
+  };
+  BENCHMARK("BC5 single thread") {
+    return gl_bcn_encoder::encode(image, blocks, {gl_texture::TEX_FORMAT_BC5_RG, 1}).has_value();
+  };
+  BENCHMARK("BC7 single thread") {
+    return gl_bcn_encoder::encode(image, blocks, {gl_texture::TEX_FORMAT_BC7_RGBA, 1}).has_value();
+  };
+  BENCHMARK("BC7 all threads") {
+    return gl_bcn_encoder::encode(image, blocks, {gl_texture::TEX_FORMAT_BC7_RGBA, 0}).has_value();
+  };
+}
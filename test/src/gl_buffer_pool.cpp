@@ -0,0 +1,122 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <shogle/render/gl/mock.hpp>
+#include <shogle/render/opengl.hpp>
+
+#include <vector>
+
+using namespace shogle;
+
+TEST_CASE("Buffer pools share buffer objects between meshes", "[gl_buffer_pool]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  gl_buffer_pool pool{gl, gl_buffer::TYPE_VERTEX, 4096};
+
+  // 12 byte vertices, offsets stay multiples of the stride for base vertex draws
+  std::vector<gl_buffer_pool::allocation> meshes;
+  for (u32 i = 0; i < 64; ++i) {
+    auto alloc = pool.allocate(gl, 12 * 4, 12);
+    REQUIRE(alloc.has_value());
+    REQUIRE(pool.range(*alloc).offset % 12 == 0);
+    meshes.emplace_back(*alloc);
+  }
+  REQUIRE(pool.block_count() == 1);
+  REQUIRE(mock.live_objects() == 1);
+
+  // Overflowing the block grows the pool instead of failing
+  auto big = pool.allocate(gl, 3000);
+  REQUIRE(big.has_value());
+  REQUIRE(big->block == 1);
+  REQUIRE(pool.block_count() == 2);
+  REQUIRE_FALSE(pool.allocate(gl, 8192).has_value());
+
+  pool.deallocate(*big);
+  gl_buffer_pool::destroy(gl, pool);
+  REQUIRE(mock.live_objects() == 0);
+  gl.destroy();
+}
+
+TEST_CASE("Buffer pool compaction keeps range contents", "[gl_buffer_pool]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  gl_buffer_pool pool{gl, gl_buffer::TYPE_VERTEX, 1024};
+
+  std::vector<gl_buffer_pool::allocation> allocs;
+  for (u32 i = 0; i < 8; ++i) {
+    auto alloc = pool.allocate(gl, 96, 16);
+    REQUIRE(alloc.has_value());
+    const std::vector<u8> data(96, static_cast<u8>(i + 1));
+    REQUIRE(pool.upload(gl, *alloc, data.data(), data.size()).has_value());
+    allocs.emplace_back(*alloc);
+  }
+  for (u32 i = 0; i < 8; i += 2) {
+    pool.deallocate(allocs[i]);
+  }
+
+  mock.reset_stats();
+  const auto copied = pool.compact(gl);
+  REQUIRE(copied.has_value());
+  REQUIRE(*copied == 4 * 96);
+  REQUIRE(mock.call_count("glCopyNamedBufferSubData") == 4);
+  REQUIRE(mock.call_count("glCopyBufferSubData") == 0);
+  // Every range moves by at least its size, no scratch buffer needed
+  REQUIRE(mock.call_count("glCreateBuffers") == 0);
+  REQUIRE(mock.live_objects() == 1);
+
+  for (u32 i = 1; i < 8; i += 2) {
+    const auto range = pool.range(allocs[i]);
+    REQUIRE(range.offset == (i / 2) * 96);
+    std::vector<u8> data(96);
+    REQUIRE(const_cast<gl_buffer&>(pool.block(0))
+              .read_data(gl, data.data(), data.size(), range.offset)
+              .has_value());
+    REQUIRE(data.front() == i + 1);
+    REQUIRE(data.back() == i + 1);
+  }
+
+  // Already packed, nothing left to move
+  REQUIRE(*pool.compact(gl) == 0);
+
+  gl_buffer_pool::destroy(gl, pool);
+  gl.destroy();
+}
+
+TEST_CASE("Overlapping compaction moves go through a scratch buffer", "[gl_buffer_pool]") {
+  gl_mock_provider mock{{800, 600}, {4, 3}};
+  gl_context gl{mock};
+  gl_buffer_pool pool{gl, gl_buffer::TYPE_VERTEX, 1024};
+
+  auto head = pool.allocate(gl, 32);
+  auto tail = pool.allocate(gl, 256);
+  REQUIRE(head.has_value());
+  REQUIRE(tail.has_value());
+  const std::vector<u8> data(256, 7);
+  REQUIRE(pool.upload(gl, *tail, data.data(), data.size()).has_value());
+  pool.deallocate(*head);
+
+  mock.reset_stats();
+  REQUIRE(*pool.compact(gl) == 256);
+  REQUIRE(mock.call_count("glCopyNamedBufferSubData") == 0);
+  REQUIRE(mock.call_count("glCopyBufferSubData") == 2);
+
+  // Sized to the move, not to the whole block
+  u64 scratch_size = 0;
+  auto find_storage = [&](std::string_view func, span<const u64> args) {
+    if (func == "glBufferStorage" || func == "glBufferData") {
+      scratch_size = args[1];
+    }
+  };
+  mock.decode_trace(find_storage);
+  REQUIRE(scratch_size == 256);
+  REQUIRE(mock.live_objects() == 1);
+
+  std::vector<u8> readback(256);
+  REQUIRE(const_cast<gl_buffer&>(pool.block(0))
+            .read_data(gl, readback.data(), readback.size(), pool.range(*tail).offset)
+            .has_value());
+  REQUIRE(pool.range(*tail).offset == 0);
+  REQUIRE(readback == data);
+
+  gl_buffer_pool::destroy(gl, pool);
+  gl.destroy();
+}
@@ -0,0 +1,98 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "./mock_scene.hpp"
+
+#include <vector>
+
+using namespace shogle;
+using namespace shogle::test;
+
+namespace {
+
+void edit_resources(gl_context& gl) {
+  gl_buffer vbo{gl, gl_buffer::TYPE_VERTEX, 16};
+  const u8 data[16]{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+  u8 readback[16]{};
+  REQUIRE(vbo.upload_data(gl, data, sizeof(data), 0).has_value());
+  REQUIRE(vbo.read_data(gl, readback, sizeof(readback), 0).has_value());
+  REQUIRE(std::equal(std::begin(data), std::end(data), std::begin(readback)));
+
+  gl_texture tex{gl, gl_texture::TEX_FORMAT_RGBA8, extent2d{4, 4}, 1, 1};
+  const std::vector<u8> pixels(4 * 4 * 4, 0xFF);
+  REQUIRE(tex.upload_image(gl, {pixels.data(), {4, 4, 1}, gl_texture::PIXEL_FORMAT_RGBA,
+                                gl_texture::PIXEL_TYPE_U8, gl_texture::ALIGN_4BYTES})
+            .has_value());
+  tex.set_sampler(gl, gl_texture::SAMPLER_NEAREST);
+
+  gl_texture::deallocate(gl, tex);
+  gl_buffer::deallocate(gl, vbo);
+}
+
+} // namespace
+
+TEST_CASE("Resource edits skip binds with direct state access", "[gl_dsa]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  mock.reset_stats();
+  edit_resources(gl);
+  REQUIRE(mock.call_count("glCreateBuffers") == 1);
+  REQUIRE(mock.call_count("glCreateTextures") == 1);
+  REQUIRE(mock.call_count("glNamedBufferSubData") == 1);
+  REQUIRE(mock.call_count("glTextureSubImage2D") == 1);
+  REQUIRE(mock.call_count("glBindBuffer") == 0);
+  REQUIRE(mock.call_count("glBindTexture") == 0);
+  gl.destroy();
+}
+
+TEST_CASE("Resource edits bind before GL 4.5", "[gl_dsa]") {
+  gl_mock_provider mock{{800, 600}, {4, 3}};
+  gl_context gl{mock};
+  mock.reset_stats();
+  edit_resources(gl);
+  REQUIRE(mock.call_count("glNamedBufferSubData") == 0);
+  REQUIRE(mock.call_count("glTextureSubImage2D") == 0);
+  REQUIRE(mock.call_count("glGenBuffers") == 1);
+  REQUIRE(mock.call_count("glBufferSubData") == 1);
+  REQUIRE(mock.call_count("glTexSubImage2D") == 1);
+  REQUIRE(mock.call_count("glBindBuffer") > 0);
+  gl.destroy();
+}
+
+TEST_CASE("Uploads between draws keep the cached bindings", "[gl_dsa]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  mock_scene scene{gl};
+  gl_texture tex{gl, gl_texture::TEX_FORMAT_RGBA8, extent2d{4, 4}, 1, 1};
+
+  const auto cmd = scene.builder.set_pipeline(scene.pipeline_a)
+                     .set_vertex_layout(scene.layout)
+                     .add_vertex_buffer(scene.vbo)
+                     .add_texture(tex, 0)
+                     .set_draw_count(3)
+                     .build();
+  const gl_clear_opts clear{color4{0.f, 0.f, 0.f, 1.f}, nullopt, gl_clear_opts::CLEAR_COLOR, {}};
+  const vec3 vertices[3]{};
+  const std::vector<u8> pixels(4 * 4 * 4, 0x80);
+
+  mock.reset_stats();
+  gl.start_frame(clear);
+  gl.submit_command(cmd);
+  const u64 buffer_binds = mock.call_count("glBindBuffer");
+  const u64 texture_binds = mock.call_count("glBindTexture");
+  REQUIRE(scene.vbo.upload_data(gl, vertices, sizeof(vertices), 0).has_value());
+  REQUIRE(tex.upload_image(gl, {pixels.data(), {4, 4, 1}, gl_texture::PIXEL_FORMAT_RGBA,
+                                gl_texture::PIXEL_TYPE_U8, gl_texture::ALIGN_4BYTES})
+            .has_value());
+  gl.submit_command(cmd);
+  gl.end_frame();
+
+  // Nothing got unbound behind the cache, so the second draw rebinds nothing
+  REQUIRE(mock.stats().draw_calls == 2);
+  REQUIRE(mock.call_count("glBindBuffer") == buffer_binds);
+  REQUIRE(mock.call_count("glBindTexture") == texture_binds);
+  REQUIRE(mock.stats().redundant_state_changes == 0);
+
+  gl_texture::deallocate(gl, tex);
+  scene.destroy(gl);
+  gl.destroy();
+}
@@ -0,0 +1,182 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "./mock_scene.hpp"
+
+#include <cmath>
+#include <string>
+
+using namespace shogle;
+using namespace shogle::test;
+
+namespace {
+
+const gl_clear_opts clear{color4{0.f, 0.f, 0.f, 1.f}, nullopt, gl_clear_opts::CLEAR_COLOR, {}};
+
+// Every draw takes DRAW_TIME_NS on the mock GPU clock
+struct draw_fixture : mock_scene {
+  using mock_scene::mock_scene;
+
+  void draw(gl_context& gl, u32 count) {
+    const auto cmd = make_draw(pipeline_a);
+    for (u32 i = 0; i < count; ++i) {
+      gl.submit_command(cmd);
+    }
+  }
+};
+
+bool draw_ms(f64 ms, u32 count) {
+  return std::abs(ms - static_cast<f64>(count * gl_mock_provider::DRAW_TIME_NS) * 1e-6) < 1e-9;
+}
+
+} // namespace
+
+TEST_CASE("Profiler zones measure the GPU time between their timestamps", "[gl_gpu_profiler]") {
+  constexpr u32 FRAMES = 10;
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  const u32 base_objects = mock.live_objects();
+  draw_fixture fixture{gl};
+  gl_gpu_profiler profiler{gl};
+  gl.set_profiler(profiler);
+
+  for (u32 i = 0; i < FRAMES; ++i) {
+    gl.start_frame(clear);
+    {
+      gl_gpu_profiler::scope shadow{gl, profiler, "shadow"};
+      fixture.draw(gl, 2);
+    }
+    {
+      gl_gpu_profiler::scope main{gl, profiler, "main"};
+      fixture.draw(gl, 2);
+      gl_gpu_profiler::scope ui{gl, profiler, "ui"};
+      fixture.draw(gl, 1 + i % 2);
+    }
+    gl.end_frame();
+  }
+  // Nothing keeps the mock GPU behind, every frame is read back when the next one starts
+  REQUIRE(profiler.resolved_frames() == FRAMES - 1);
+  profiler.flush(gl);
+  REQUIRE(profiler.resolved_frames() == FRAMES);
+  REQUIRE(profiler.dropped_frames() == 0);
+
+  const auto zones = profiler.zones();
+  REQUIRE(zones.size() == 4);
+  REQUIRE(zones[gl_gpu_profiler::FRAME_ZONE].name == "frame");
+  REQUIRE(zones[1].name == "shadow");
+  REQUIRE(zones[1].samples == FRAMES);
+  REQUIRE(draw_ms(zones[1].avg_ms, 2));
+  REQUIRE(zones[3].name == "ui");
+  REQUIRE(zones[3].depth == 2);
+  REQUIRE(draw_ms(zones[3].min_ms, 1));
+  REQUIRE(draw_ms(zones[3].max_ms, 2));
+  REQUIRE(draw_ms(zones[2].max_ms, 4));
+  REQUIRE(draw_ms(zones[0].max_ms, 6));
+
+  gl_gpu_profiler::destroy(gl, profiler);
+  REQUIRE(gl.profiler().empty());
+  fixture.destroy(gl);
+  REQUIRE(mock.live_objects() == base_objects);
+  gl.destroy();
+}
+
+TEST_CASE("Profiler results are read back once the GPU catches up", "[gl_gpu_profiler]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  gl_gpu_profiler profiler{gl, {.max_zones = 4, .frame_latency = 3, .trace_frames = 0}};
+  gl.set_profiler(profiler);
+
+  // Every query stays unavailable for two polls
+  mock.set_query_latency(2);
+  gl.scope_frame(clear, [] {});
+  gl.scope_frame(clear, [] {});
+  REQUIRE(profiler.pending_frames() == 2);
+  gl.scope_frame(clear, [] {});
+  REQUIRE(profiler.resolved_frames() == 0);
+  REQUIRE(mock.call_count("glGetQueryObjectui64v") == 0);
+
+  // The third poll of the first frame sees it available, the second one is polled afterwards
+  gl.scope_frame(clear, [] {});
+  REQUIRE(profiler.resolved_frames() == 1);
+  REQUIRE(profiler.dropped_frames() == 0);
+  REQUIRE(mock.call_count("glGetQueryObjectui64v") == 2);
+
+  // A GPU further behind than the ring drops frames instead of stalling
+  mock.set_query_latency(100);
+  for (u32 i = 0; i < 6; ++i) {
+    gl.scope_frame(clear, [] {});
+  }
+  REQUIRE(profiler.dropped_frames() > 0);
+  REQUIRE(profiler.pending_frames() == 3);
+
+  gl_gpu_profiler::destroy(gl, profiler);
+  gl.destroy();
+}
+
+TEST_CASE("Profiler traces dump as Chrome trace events", "[gl_gpu_profiler]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  draw_fixture fixture{gl};
+  gl_gpu_profiler profiler{gl, {.max_zones = 2, .frame_latency = 2, .trace_frames = 2}};
+  gl.set_profiler(profiler);
+
+  for (u32 i = 0; i < 3; ++i) {
+    gl.scope_frame(clear, [&] {
+      gl_gpu_profiler::scope a{gl, profiler, "\"quoted\""};
+      fixture.draw(gl, 1);
+      gl_gpu_profiler::scope b{gl, profiler, "b"};
+      gl_gpu_profiler::scope c{gl, profiler, "dropped"};
+    });
+  }
+  profiler.flush(gl);
+  REQUIRE(profiler.overflowed_zones() == 3);
+  // Only the last two frames are kept, three events each
+  REQUIRE(profiler.trace().size() == 6);
+  REQUIRE(profiler.trace().front().frame == 1);
+
+  const auto json = profiler.chrome_trace();
+  REQUIRE(json.starts_with(R"({"displayTimeUnit":"ms","traceEvents":[{"name":"frame")"));
+  REQUIRE(json.find(R"("name":"\"quoted\"")") != std::string::npos);
+  REQUIRE(json.find(R"("dur":1.000)") != std::string::npos);
+  REQUIRE(json.find("dropped") == std::string::npos);
+  REQUIRE(json.ends_with("]}"));
+
+  gl_gpu_profiler::destroy(gl, profiler);
+  fixture.destroy(gl);
+  gl.destroy();
+}
+
+TEST_CASE("Render graph passes get their own profiler zones", "[gl_gpu_profiler]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  draw_fixture fixture{gl};
+  gl_gpu_profiler profiler{gl};
+  gl.set_profiler(profiler);
+
+  gl_render_graph graph;
+  const auto color = graph.create_texture("color", {gl_texture::TEX_FORMAT_RGBA8, {64, 64}});
+  const auto output = graph.create_texture("output", {gl_texture::TEX_FORMAT_RGBA8, {64, 64}});
+  const auto scene = graph.add_pass("scene", [&](gl_context& gl, const auto&) {
+    fixture.draw(gl, 3);
+  });
+  const auto post = graph.add_pass("post", [&](gl_context& gl, const auto&) {
+    fixture.draw(gl, 1);
+  });
+  graph.write(scene, color).read(post, color).write(post, output);
+  graph.set_output(output);
+  REQUIRE(graph.compile().has_value());
+
+  gl.scope_frame(clear, [&] { REQUIRE(graph.execute(gl).has_value()); });
+  profiler.flush(gl);
+  const auto zones = profiler.zones();
+  REQUIRE(zones.size() == 3);
+  REQUIRE(zones[1].name == "scene");
+  REQUIRE(draw_ms(zones[1].last_ms, 3));
+  REQUIRE(zones[2].name == "post");
+  REQUIRE(zones[2].depth == 1);
+  REQUIRE(draw_ms(zones[2].last_ms, 1));
+
+  gl_render_graph::destroy(gl, graph);
+  gl_gpu_profiler::destroy(gl, profiler);
+  fixture.destroy(gl);
+  gl.destroy();
+}
@@ -0,0 +1,161 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <shogle/render/gl/mock.hpp>
+#include <shogle/render/opengl.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+using namespace shogle;
+
+namespace {
+
+constexpr std::string_view vert_src = "#version 460 core\nvoid main() { gl_Position = vec4(0.0); }\n";
+constexpr std::string_view frag_src =
+  "#version 460 core\nout vec4 color;\nvoid main() { color = vec4(1.0); }\n";
+
+std::filesystem::path make_watch_dir(std::string_view name) {
+  auto dir = std::filesystem::temp_directory_path() / "shogle_test" / name;
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  return dir;
+}
+
+void write_file(const std::filesystem::path& path, std::string_view contents) {
+  std::ofstream out{path, std::ios::binary | std::ios::trunc};
+  out.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+}
+
+// Editors save by writing a temporary file and renaming it over the original
+void replace_file(const std::filesystem::path& path, std::string_view contents) {
+  auto tmp = path;
+  tmp += ".tmp";
+  write_file(tmp, contents);
+  std::filesystem::rename(tmp, path);
+}
+
+std::vector<gl_hot_reloader::reload_event> wait_events(gl_context& gl, gl_hot_reloader& reloader) {
+  for (u32 i = 0; i < 200; ++i) {
+    const auto events = reloader.update(gl);
+    if (!events.empty()) {
+      return {events.begin(), events.end()};
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  return {};
+}
+
+gl_graphics_pipeline make_pipeline(gl_context& gl) {
+  gl_shader vert{gl, vert_src, gl_shader::STAGE_VERTEX};
+  gl_shader frag{gl, frag_src, gl_shader::STAGE_FRAGMENT};
+  gl_graphics_pipeline pipeline{gl, gl_shader_builder{}.add_shader(vert).add_shader(frag).build()};
+  gl_shader::destroy(gl, vert);
+  gl_shader::destroy(gl, frag);
+  return pipeline;
+}
+
+} // namespace
+
+TEST_CASE("Changed shaders swap the pipeline program", "[gl_hot_reload]") {
+  if (!gl_hot_reloader::is_supported()) {
+    return;
+  }
+  const auto dir = make_watch_dir("hot_reload_pipeline");
+  write_file(dir / "mesh.vert", vert_src);
+  write_file(dir / "mesh.frag", frag_src);
+
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  auto args = gl_hot_reloader::create_args::make_default();
+  args.debounce_ms = 0;
+  gl_hot_reloader reloader{gl, args};
+
+  auto pipeline = make_pipeline(gl);
+  pipeline.set_poly_width(3.f);
+  const auto old_program = pipeline.program();
+  u32 reloads = 0;
+  const auto vert_path = (dir / "mesh.vert").string();
+  const auto frag_path = (dir / "mesh.frag").string();
+  auto id = reloader.watch_pipeline(pipeline, {.vertex = vert_path, .fragment = frag_path},
+                                    [&](gl_context&, gl_graphics_pipeline& reloaded) {
+                                      REQUIRE(&reloaded == &pipeline);
+                                      ++reloads;
+                                    });
+  REQUIRE(id.has_value());
+
+  // Idle updates never touch the driver
+  mock.reset_stats();
+  REQUIRE(reloader.update(gl).empty());
+  REQUIRE(mock.stats().calls == 0);
+
+  replace_file(dir / "mesh.frag", frag_src);
+  auto events = wait_events(gl, reloader);
+  REQUIRE(events.size() == 1);
+  REQUIRE(events[0].id == *id);
+  REQUIRE(events[0].success);
+  REQUIRE(reloads == 1);
+  REQUIRE(pipeline.program() != old_program);
+  REQUIRE(pipeline.poly_width() == 3.f);
+
+  // Broken shaders keep the last good program around
+  const auto good_program = pipeline.program();
+  write_file(dir / "mesh.vert", "#version 460 core\n#error broken\n");
+  events = wait_events(gl, reloader);
+  REQUIRE(events.size() == 1);
+  REQUIRE_FALSE(events[0].success);
+  REQUIRE(reloads == 1);
+  REQUIRE(pipeline.program() == good_program);
+
+  gl_graphics_pipeline::destroy(gl, pipeline);
+  gl_hot_reloader::destroy(gl, reloader);
+  REQUIRE(reloader.invalidated());
+  REQUIRE(mock.live_objects() == 0);
+  gl.destroy();
+}
+
+TEST_CASE("Change bursts reload once after the debounce", "[gl_hot_reload]") {
+  if (!gl_hot_reloader::is_supported()) {
+    return;
+  }
+  const auto dir = make_watch_dir("hot_reload_texture");
+  write_file(dir / "albedo.raw", "v0");
+
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  auto args = gl_hot_reloader::create_args::make_default();
+  args.debounce_ms = 50;
+  gl_hot_reloader reloader{gl, args};
+  gl_texture tex{gl, gl_texture::TEX_FORMAT_RGBA8, extent2d{2, 2}, 1, 1};
+
+  std::vector<std::string> loads;
+  auto id = reloader.watch_texture(tex, (dir / "albedo.raw").string(),
+                                   [&](gl_context&, gl_texture& texture, span<const u8> file) {
+                                     REQUIRE(&texture == &tex);
+                                     loads.emplace_back(reinterpret_cast<const char*>(file.data()),
+                                                        file.size());
+                                     return gl_expect<void>{};
+                                   });
+  REQUIRE(id.has_value());
+  REQUIRE(reloader.watch_count() == 1);
+
+  for (u32 i = 1; i <= 3; ++i) {
+    write_file(dir / "albedo.raw", "v" + std::to_string(i));
+    REQUIRE(reloader.update(gl).empty());
+  }
+  const auto events = wait_events(gl, reloader);
+  REQUIRE(events.size() == 1);
+  REQUIRE(events[0].kind == gl_hot_reloader::EVENT_TEXTURE);
+  REQUIRE(loads == std::vector<std::string>{"v3"});
+
+  reloader.unwatch(*id);
+  REQUIRE(reloader.watch_count() == 0);
+  write_file(dir / "albedo.raw", "v4");
+  std::this_thread::sleep_for(std::chrono::milliseconds(60));
+  REQUIRE(reloader.update(gl).empty());
+  REQUIRE(loads.size() == 1);
+
+  gl_texture::deallocate(gl, tex);
+  gl_hot_reloader::destroy(gl, reloader);
+  gl.destroy();
+}
@@ -0,0 +1,117 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <shogle/render/gl/mock.hpp>
+#include <shogle/render/opengl.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace shogle;
+
+namespace {
+
+std::vector<f32> random_texels(size_t count, u32 seed) {
+  std::mt19937 rng{seed};
+  std::uniform_real_distribution<f32> dist{0.f, 1.f};
+  std::vector<f32> texels(count);
+  for (auto& texel : texels) {
+    texel = dist(rng);
+  }
+  return texels;
+}
+
+} // namespace
+
+TEST_CASE("Vectorized 2x2 reduce matches the scalar reference", "[gl_mipmap]") {
+  // Odd destination widths leave a tail for the scalar loop
+  constexpr extent2d extents[] = {{2, 2}, {38, 6}, {64, 4}, {130, 2}};
+  for (u32 channels = 1; channels <= 4; ++channels) {
+    for (const auto& [width, height] : extents) {
+      const auto src = random_texels(size_t(width) * height * channels, width + channels);
+      std::vector<f32> simd(src.size() / 4);
+      std::vector<f32> scalar(src.size() / 4);
+      gl_mip_chain::reduce_2x2(src.data(), simd.data(), width, height, channels);
+      gl_mip_chain::reduce_2x2_scalar(src.data(), scalar.data(), width, height, channels);
+      REQUIRE(simd == scalar);
+    }
+  }
+}
+
+TEST_CASE("sRGB mip chains average in linear space", "[gl_mipmap]") {
+  const u8 pixels[] = {0, 0, 0, 0, 255, 255, 255, 255, 255, 255, 255, 255, 0, 0, 0, 0};
+  const gl_texture::image_data base{pixels, {2, 2, 1}, gl_texture::PIXEL_FORMAT_RGBA,
+                                    gl_texture::PIXEL_TYPE_U8, gl_texture::ALIGN_4BYTES};
+
+  gl_mip_chain srgb{base, gl_mip_chain::generate_args::make_default(gl_mip_chain::FILTER_BOX,
+                                                                    true)};
+  REQUIRE(srgb.level_count() == 1);
+  const auto* texel = static_cast<const u8*>(srgb.level(1).data);
+  REQUIRE(texel[0] == 188);
+  REQUIRE(texel[2] == 188);
+  REQUIRE(texel[3] == 128); // Alpha stays linear
+
+  gl_mip_chain linear{base};
+  REQUIRE(static_cast<const u8*>(linear.level(1).data)[0] == 128);
+
+  // Odd extents go through the separable filter, which must keep flat images flat
+  const std::vector<f32> flat(5 * 3 * 3, .5f);
+  const gl_texture::image_data odd{flat.data(), {5, 3, 1}, gl_texture::PIXEL_FORMAT_RGB,
+                                   gl_texture::PIXEL_TYPE_F32, gl_texture::ALIGN_4BYTES};
+  for (auto filter : {gl_mip_chain::FILTER_BOX, gl_mip_chain::FILTER_KAISER}) {
+    gl_mip_chain chain{odd, gl_mip_chain::generate_args::make_default(filter, false)};
+    REQUIRE(chain.level_count() == 2);
+    REQUIRE(chain.level(1).extent.width == 2);
+    REQUIRE(chain.level(1).extent.height == 1);
+    REQUIRE(chain.level(2).extent.width == 1);
+    for (u32 level = 1; level <= chain.level_count(); ++level) {
+      const auto image = chain.level(level);
+      const auto* data = static_cast<const f32*>(image.data);
+      for (u32 i = 0; i < image.extent.width * image.extent.height * 3; ++i) {
+        REQUIRE(std::abs(data[i] - .5f) < 1e-5f);
+      }
+    }
+  }
+
+  const u16 depth[4]{};
+  REQUIRE_FALSE(gl_mip_chain::generate({depth, {2, 2, 1}, gl_texture::PIXEL_FORMAT_DEPTH,
+                                        gl_texture::PIXEL_TYPE_U16, gl_texture::ALIGN_4BYTES})
+                  .has_value());
+}
+
+TEST_CASE("Mip chains upload every level the texture has", "[gl_mipmap]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  gl_texture tex{gl, gl_texture::TEX_FORMAT_RGBA8, extent2d{64, 64}, 1, 4};
+
+  const std::vector<u8> pixels(64 * 64 * 4, 0x80);
+  const gl_texture::image_data base{pixels.data(), {64, 64, 1}, gl_texture::PIXEL_FORMAT_RGBA,
+                                    gl_texture::PIXEL_TYPE_U8, gl_texture::ALIGN_4BYTES};
+  gl_mip_chain chain{base};
+  REQUIRE(chain.level_count() == 6);
+  REQUIRE(chain.level(6).extent.width == 1);
+
+  mock.reset_stats();
+  REQUIRE(chain.upload(gl, tex).has_value());
+  REQUIRE(mock.call_count("glTextureSubImage2D") == 3);
+  REQUIRE(mock.call_count("glGenerateTextureMipmap") == 0);
+
+  gl_texture::deallocate(gl, tex);
+  gl.destroy();
+}
+
+TEST_CASE("2x2 reduce throughput", "[gl_mipmap][!benchmark]") {
+  constexpr u32 extent = 1024;
+  const auto src = random_texels(size_t(extent) * extent * 4, 42);
+  std::vector<f32> dst(src.size() / 4);
+
+  BENCHMARK("scalar") {
+    gl_mip_chain::reduce_2x2_scalar(src.data(), dst.data(), extent, extent, 4);
+    return dst.front();
+  };
+  BENCHMARK("simd") {
+    gl_mip_chain::reduce_2x2(src.data(), dst.data(), extent, extent, 4);
+    return dst.front();
+  };
+}
@@ -0,0 +1,184 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "./mock_scene.hpp"
+
+using namespace shogle;
+using namespace shogle::test;
+
+TEST_CASE("Context creation on a mock provider", "[gl_mock]") {
+  gl_mock_provider mock;
+  auto gl = gl_context::create(mock);
+  REQUIRE(gl.has_value());
+  REQUIRE(gl->version().major == 4);
+  REQUIRE(gl->version().minor == 6);
+  REQUIRE(mock.call_count("glGetString") > 0);
+  gl->destroy();
+}
+
+TEST_CASE("Object lifetime is tracked by the mock", "[gl_mock]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  const u32 base_objects = mock.live_objects();
+  {
+    mock_scene scene{gl};
+    REQUIRE(mock.live_objects() > base_objects);
+    scene.destroy(gl);
+  }
+  REQUIRE(mock.live_objects() == base_objects);
+  gl.destroy();
+}
+
+TEST_CASE("Repeated draws skip redundant state changes", "[gl_mock]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  mock_scene scene{gl};
+  const auto cmd = scene.make_draw(scene.pipeline_a);
+  const gl_clear_opts clear{color4{0.f, 0.f, 0.f, 1.f}, nullopt, gl_clear_opts::CLEAR_COLOR, {}};
+
+  gl.start_frame(clear);
+  gl.submit_command(cmd);
+  gl.end_frame();
+
+  mock.reset_stats();
+  gl.start_frame(clear);
+  gl.submit_command(cmd);
+  gl.submit_command(cmd);
+  gl.end_frame();
+
+  const auto stats = mock.stats();
+  REQUIRE(stats.draw_calls == 2);
+  REQUIRE(stats.redundant_state_changes == 0);
+  REQUIRE(mock.call_count("glUseProgram") == 0);
+  REQUIRE(mock.call_count("glBindVertexArray") == 0);
+
+  scene.destroy(gl);
+  gl.destroy();
+}
+
+TEST_CASE("Deferred submission groups draws by pipeline", "[gl_mock]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  mock_scene scene{gl};
+  const auto cmd_a = scene.make_draw(scene.pipeline_a);
+  const auto cmd_b = scene.make_draw(scene.pipeline_b);
+  const gl_clear_opts clear{color4{0.f, 0.f, 0.f, 1.f}, nullopt, gl_clear_opts::CLEAR_COLOR, {}};
+
+  gl.set_submit_mode(gl_context::SUBMIT_DEFERRED);
+  mock.reset_stats();
+  gl.start_frame(clear);
+  for (u32 i = 0; i < 8; ++i) {
+    gl.submit_command(i % 2 ? cmd_b : cmd_a);
+  }
+  gl.end_frame();
+
+  REQUIRE(mock.stats().draw_calls == 8);
+  REQUIRE(mock.call_count("glUseProgram") == 2);
+
+  u32 traced_draws = 0;
+  auto count_draws = [&](std::string_view func, span<const u64>) {
+    traced_draws += func == "glDrawArrays";
+  };
+  mock.decode_trace(count_draws);
+  REQUIRE(traced_draws == 8);
+
+  scene.destroy(gl);
+  gl.destroy();
+}
+
+TEST_CASE("Per submit error policy checks once per command", "[gl_mock]") {
+  gl_mock_provider mock;
+  gl_context gl{mock, gl_context::ERROR_POLICY_PER_SUBMIT};
+  REQUIRE(gl.error_policy() == gl_context::ERROR_POLICY_PER_SUBMIT);
+  mock_scene scene{gl};
+  const auto cmd = scene.make_draw(scene.pipeline_a);
+  const gl_clear_opts clear{color4{0.f, 0.f, 0.f, 1.f}, nullopt, gl_clear_opts::CLEAR_COLOR, {}};
+
+  mock.reset_stats();
+  gl.start_frame(clear);
+  gl.submit_command(cmd);
+  gl.submit_command(cmd);
+  gl.end_frame();
+  REQUIRE(mock.stats().draw_calls == 2);
+  REQUIRE(mock.call_count("glGetError") == 4);
+
+  // Calls returning their error keep checking
+  const u8 data[4]{};
+  mock.push_error(0x0505); // GL_OUT_OF_MEMORY
+  REQUIRE_FALSE(scene.vbo.upload_data(gl, data, sizeof(data), 0).has_value());
+
+  scene.destroy(gl);
+  gl.destroy();
+}
+
+TEST_CASE("Debug callback error policy never polls for errors", "[gl_mock]") {
+  gl_mock_provider mock;
+  gl_context gl{mock, gl_context::ERROR_POLICY_DEBUG_CALLBACK};
+  REQUIRE(mock.call_count("glEnable") == 2);
+  mock_scene scene{gl};
+  const auto cmd = scene.make_draw(scene.pipeline_a);
+  const gl_clear_opts clear{color4{0.f, 0.f, 0.f, 1.f}, nullopt, gl_clear_opts::CLEAR_COLOR, {}};
+
+  gl.start_frame(clear);
+  gl.submit_command(cmd);
+  gl.end_frame();
+
+  const u8 data[4]{};
+  REQUIRE(scene.vbo.upload_data(gl, data, sizeof(data), 0).has_value());
+
+  // Failing calls still hand their error back, taken from the callback
+  mock.push_error(0x0505); // GL_OUT_OF_MEMORY
+  const auto failed = scene.vbo.upload_data(gl, data, sizeof(data), 0);
+  REQUIRE_FALSE(failed.has_value());
+  REQUIRE(failed.error().code() == 0x0505);
+  REQUIRE(scene.vbo.upload_data(gl, data, sizeof(data), 0).has_value());
+  REQUIRE(mock.call_count("glGetError") == 0);
+
+  scene.destroy(gl);
+  gl.destroy();
+}
+
+TEST_CASE("Frame stats count the work of the last frame", "[gl_mock]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  mock_scene scene{gl};
+  const gl_clear_opts clear{color4{0.f, 0.f, 0.f, 1.f}, nullopt, gl_clear_opts::CLEAR_COLOR, {}};
+
+  const vec3 vertices[3]{};
+  REQUIRE(scene.vbo.upload_data(gl, vertices, sizeof(vertices), 0).has_value());
+  scene.builder.reset();
+  const auto cmd = scene.builder.set_pipeline(scene.pipeline_a)
+                     .set_vertex_layout(scene.layout)
+                     .add_vertex_buffer(scene.vbo)
+                     .set_draw_count(3)
+                     .set_instances(4)
+                     .add_uniform(vec4{1.f}, 0)
+                     .add_uniform(mat4{1.f}, 1)
+                     .build();
+
+  gl.start_frame(clear);
+  gl.submit_command(cmd);
+  gl.submit_command(cmd);
+  gl.end_frame();
+
+#ifndef SHOGLE_GL_DISABLE_FRAME_STATS
+  const auto& stats = gl.frame_stats();
+  REQUIRE(stats.draw_calls == 2);
+  REQUIRE(stats.instances == 8);
+  REQUIRE(stats.vertices == 24);
+  REQUIRE(stats.indices == 0);
+  REQUIRE(stats.program_binds == 1);
+  REQUIRE(stats.vao_binds == 1);
+  REQUIRE(stats.uniform_uploads[static_cast<u32>(attribute_type::vec4)] == 2);
+  REQUIRE(stats.uniform_uploads[static_cast<u32>(attribute_type::mat4)] == 2);
+  REQUIRE(stats.buffer_upload_bytes == sizeof(vertices));
+#endif
+
+  // Counters restart every frame
+  gl.start_frame(clear);
+  gl.end_frame();
+  REQUIRE(gl.frame_stats().draw_calls == 0);
+  REQUIRE(gl.frame_stats().buffer_upload_bytes == 0);
+
+  scene.destroy(gl);
+  gl.destroy();
+}
@@ -0,0 +1,168 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <shogle/render/gl/mock.hpp>
+#include <shogle/render/opengl.hpp>
+
+#include <vector>
+
+using namespace shogle;
+
+namespace {
+
+// Mock driver that renders to one of its own framebuffers instead of the window
+struct redirected_mock {
+  void* gl_get_proc(const char* name) noexcept { return mock.gl_get_proc(name); }
+
+  extent2d surface_extent() const noexcept { return mock.surface_extent(); }
+
+  gldefs::GLhandle default_framebuffer() const noexcept { return fbo; }
+
+  gl_mock_provider mock;
+  gldefs::GLhandle fbo = 0;
+};
+
+static_assert(gl_offscreen_provider_type<redirected_mock>);
+
+gl_clear_opts make_clear(color4 color) {
+  return {color, nullopt, gl_clear_opts::CLEAR_COLOR, {}};
+}
+
+bool pixels_are(span<const u8> pixels, u8 r, u8 g, u8 b, u8 a) {
+  for (size_t i = 0; i < pixels.size(); i += gl_offscreen_provider::PIXEL_SIZE) {
+    if (pixels[i] != r || pixels[i + 1] != g || pixels[i + 2] != b || pixels[i + 3] != a) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+TEST_CASE("Providers without a framebuffer hook render to framebuffer zero", "[gl_offscreen]") {
+  gl_mock_provider mock;
+  const gl_surface_provider prov{mock};
+  REQUIRE(prov.default_framebuffer() == 0);
+
+  redirected_mock redirected;
+  redirected.fbo = 42;
+  const gl_surface_provider redirected_prov{redirected};
+  REQUIRE(redirected_prov.default_framebuffer() == 42);
+}
+
+TEST_CASE("The context clears and draws to the provider framebuffer", "[gl_offscreen]") {
+  redirected_mock prov;
+  gl_context gl{prov};
+  gl_texture color{gl, gl_texture::TEX_FORMAT_RGBA8, extent2d{800, 600}, 1, 1};
+  using attachment = gl_framebuffer::texture_attachment;
+  const attachment attachments[] = {{color, 0, 0}};
+  gl_framebuffer target{gl, {800, 600}, span<const attachment>{attachments}};
+  prov.fbo = target.id();
+
+  prov.mock.reset_stats();
+  gl.start_frame(make_clear(color4{1.f, 0.f, 0.f, 1.f}));
+  gl.end_frame();
+
+  u32 default_binds = 0;
+  u32 target_binds = 0;
+  auto count_binds = [&](std::string_view func, span<const u64> args) {
+    if (func != "glBindFramebuffer") {
+      return;
+    }
+    default_binds += args[1] == 0;
+    target_binds += args[1] == target.id();
+  };
+  prov.mock.decode_trace(count_binds);
+  REQUIRE(target_binds > 0);
+  REQUIRE(default_binds == 0);
+
+  gl_framebuffer::destroy(gl, target);
+  gl_texture::deallocate(gl, color);
+  gl.destroy();
+}
+
+TEST_CASE("Offscreen frames read back the clear color", "[gl_offscreen]") {
+  auto prov = gl_offscreen_provider::create({{64, 32}, {3, 3}, gl_offscreen_provider::BACKEND_AUTO,
+                                             false});
+  if (!prov) {
+    SKIP("No headless OpenGL driver: " << prov.error());
+  }
+  REQUIRE(prov->default_framebuffer() != 0);
+  REQUIRE(prov->frame_size() == 64 * 32 * gl_offscreen_provider::PIXEL_SIZE);
+  gl_context gl{*prov};
+
+  std::vector<u8> storage(prov->frame_size());
+  span<u8> pixels{storage.data(), storage.size()};
+  gl.start_frame(make_clear(color4{1.f, 0.f, 1.f, 1.f}));
+  gl.end_frame();
+  REQUIRE(prov->read_pixels(pixels).has_value());
+  REQUIRE(pixels_are(pixels, 255, 0, 255, 255));
+
+  // Too small for the frame
+  REQUIRE_FALSE(prov->read_pixels(pixels.first(pixels.size() / 2)).has_value());
+
+  REQUIRE(prov->set_surface_extent({16, 16}).has_value());
+  REQUIRE(prov->surface_extent().width == 16);
+  pixels = pixels.first(prov->frame_size());
+  gl.start_frame(make_clear(color4{0.f, 1.f, 0.f, 1.f}));
+  gl.end_frame();
+  REQUIRE(prov->read_pixels(pixels).has_value());
+  REQUIRE(pixels_are(pixels, 0, 255, 0, 255));
+  gl.destroy();
+}
+
+TEST_CASE("Asynchronous readbacks resolve in request order", "[gl_offscreen]") {
+  auto prov = gl_offscreen_provider::create({{32, 32}, {3, 3}, gl_offscreen_provider::BACKEND_AUTO,
+                                             false});
+  if (!prov) {
+    SKIP("No headless OpenGL driver: " << prov.error());
+  }
+  gl_context gl{*prov};
+  std::vector<u8> storage(prov->frame_size());
+  span<u8> pixels{storage.data(), storage.size()};
+  REQUIRE_FALSE(prov->resolve_readback(pixels).has_value());
+
+  gl.start_frame(make_clear(color4{1.f, 0.f, 0.f, 1.f}));
+  gl.end_frame();
+  REQUIRE(prov->request_readback().has_value());
+  gl.start_frame(make_clear(color4{0.f, 0.f, 1.f, 1.f}));
+  gl.end_frame();
+  REQUIRE(prov->request_readback().has_value());
+  REQUIRE(prov->pending_readbacks() == gl_offscreen_provider::READBACK_SLOTS);
+  REQUIRE_FALSE(prov->request_readback().has_value());
+
+  REQUIRE(prov->resolve_readback(pixels).has_value());
+  REQUIRE(pixels_are(pixels, 255, 0, 0, 255));
+  REQUIRE(prov->resolve_readback(pixels).has_value());
+  REQUIRE(pixels_are(pixels, 0, 0, 255, 255));
+  REQUIRE(prov->pending_readbacks() == 0);
+  gl.destroy();
+}
+
+TEST_CASE("Offscreen readback benchmark", "[gl_offscreen][!benchmark]") {
+  auto prov = gl_offscreen_provider::create({{1280, 720}, {3, 3},
+                                             gl_offscreen_provider::BACKEND_AUTO, false});
+  if (!prov) {
+    SKIP("No headless OpenGL driver: " << prov.error());
+  }
+  gl_context gl{*prov};
+  std::vector<u8> storage(prov->frame_size());
+  span<u8> pixels{storage.data(), storage.size()};
+  const auto clear = make_clear(color4{.2f, .3f, .4f, 1.f});
+
+  BENCHMARK("720p frame, synchronous read") {
+    gl.start_frame(clear);
+    gl.end_frame();
+    return prov->read_pixels(pixels).has_value();
+  };
+
+  // One frame of latency, the copy of the previous frame overlaps with the current one
+  REQUIRE(prov->request_readback().has_value());
+  BENCHMARK("720p frame, pixel buffer readback") {
+    gl.start_frame(clear);
+    gl.end_frame();
+    const bool requested = prov->request_readback().has_value();
+    return requested && prov->resolve_readback(pixels).has_value();
+  };
+  gl.destroy();
+}
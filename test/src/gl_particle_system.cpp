@@ -0,0 +1,189 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "./mock_scene.hpp"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace shogle;
+using namespace shogle::test;
+
+namespace {
+
+const gl_clear_opts clear{color4{0.f, 0.f, 0.f, 1.f}, nullopt, gl_clear_opts::CLEAR_COLOR, {}};
+
+using particle_arrays = gl_particle_system::particle_arrays;
+
+// Owns the storage behind a particle_arrays view
+struct host_particles {
+  host_particles(u32 count, u32 seed) : data(8 * size_t{count}) {
+    std::mt19937 rng{seed};
+    std::uniform_real_distribution<f32> dist{-10.f, 10.f};
+    for (auto& value : data) {
+      value = dist(rng);
+    }
+    for (u32 i = 0; i < 3; ++i) {
+      view.pos[i] = data.data() + i * size_t{count};
+      view.vel[i] = data.data() + (i + 3) * size_t{count};
+    }
+    view.age = data.data() + 6 * size_t{count};
+    view.life = data.data() + 7 * size_t{count};
+  }
+
+  std::vector<f32> data;
+  particle_arrays view;
+};
+
+gl_particle_system::emitter_desc fountain(f32 rate, f32 life) {
+  return {
+    .position = {0.f, 0.f, 0.f},
+    .position_spread = {1.f, 0.f, 1.f},
+    .velocity = {0.f, 10.f, 0.f},
+    .velocity_spread = {1.f, 1.f, 1.f},
+    .min_life = life,
+    .max_life = life,
+    .rate = rate,
+  };
+}
+
+} // namespace
+
+TEST_CASE("Vectorized particle integration matches the scalar one", "[gl_particle_system]") {
+  // Odd count, the scalar tail has to pick up the rest
+  constexpr u32 COUNT = 1003;
+  host_particles simd{COUNT, 7};
+  host_particles scalar{COUNT, 7};
+  const gl_particle_system::step_args args{{0.f, -9.8f, 1.f}, .5f, 1.f / 60.f};
+
+  for (u32 step = 0; step < 10; ++step) {
+    gl_particle_system::integrate(simd.view, COUNT, args);
+    gl_particle_system::integrate_scalar(scalar.view, COUNT, args);
+  }
+  for (size_t i = 0; i < simd.data.size(); ++i) {
+    REQUIRE(std::abs(simd.data[i] - scalar.data[i]) < 1e-4f);
+  }
+}
+
+TEST_CASE("CPU particles spawn, age and die", "[gl_particle_system]") {
+  // No compute shaders before 4.3, the system falls back to the CPU
+  gl_mock_provider mock{{800, 600}, {4, 2}};
+  gl_context gl{mock};
+  const u32 base_objects = mock.live_objects();
+  mock_program program{gl};
+  gl_particle_system particles{gl, {.capacity = 1024,
+                                    .gravity = {0.f, -10.f, 0.f},
+                                    .drag = 0.f,
+                                    .path = gl_particle_system::SIM_PATH_GPU,
+                                    .particle_binding = 3,
+                                    .frame_regions = 2,
+                                    .seed = 1}};
+  REQUIRE(particles.path() == gl_particle_system::SIM_PATH_CPU);
+  const auto emitter = particles.add_emitter(fountain(100.f, .45f));
+  REQUIRE(emitter.has_value());
+
+  // Ten spawns per step, each batch lives for five steps
+  for (u32 i = 0; i < 4; ++i) {
+    REQUIRE(particles.update(gl, .1f).has_value());
+  }
+  REQUIRE(particles.size() == 40);
+  for (u32 i = 0; i < 6; ++i) {
+    REQUIRE(particles.update(gl, .1f).has_value());
+  }
+  REQUIRE(particles.size() == 50);
+  particles.burst(*emitter, 5);
+  REQUIRE(particles.update(gl, .1f).has_value());
+  REQUIRE(particles.size() == 55);
+
+  const auto& cpu = particles.cpu_particles();
+  for (u32 i = 0; i < particles.size(); ++i) {
+    REQUIRE(cpu.age[i] < cpu.life[i]);
+    // Spawn box plus sideways drift over half a second
+    REQUIRE(std::abs(cpu.pos[0][i]) <= 1.5f);
+    REQUIRE(cpu.vel[1][i] <= 11.f);
+  }
+
+  mock.reset_stats();
+  REQUIRE(particles.begin_frame(gl).has_value());
+  gl.start_frame(clear);
+  REQUIRE(particles.draw(gl, program.pipeline).has_value());
+  gl.end_frame();
+  particles.end_frame(gl);
+  REQUIRE(mock.stats().draw_calls == 1);
+#ifndef SHOGLE_GL_DISABLE_FRAME_STATS
+  REQUIRE(gl.frame_stats().instances == 55);
+#endif
+  REQUIRE(mock.call_count("glDispatchCompute") == 0);
+
+  // Spawns past the capacity are dropped
+  particles.emitter(*emitter).rate = 1e6f;
+  REQUIRE(particles.update(gl, .1f).has_value());
+  REQUIRE(particles.size() == particles.capacity());
+
+  gl_particle_system::destroy(gl, particles);
+  program.destroy(gl);
+  REQUIRE(mock.live_objects() == base_objects);
+  gl.destroy();
+}
+
+TEST_CASE("GPU particles ping-pong between two buffers", "[gl_particle_system]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  const u32 base_objects = mock.live_objects();
+  mock_program program{gl};
+  gl_particle_system particles{gl};
+  REQUIRE(particles.path() == gl_particle_system::SIM_PATH_GPU);
+  REQUIRE(particles.add_emitter(fountain(1000.f, 2.f)).has_value());
+  REQUIRE(particles.add_emitter(fountain(50.f, 1.f)).has_value());
+
+  REQUIRE(particles.begin_frame(gl).has_value());
+  const auto first = particles.particle_buffer().id();
+  REQUIRE(particles.update(gl, 1.f / 60.f).has_value());
+  const auto second = particles.particle_buffer().id();
+  REQUIRE(first != second);
+  REQUIRE(particles.update(gl, 1.f / 60.f).has_value());
+  REQUIRE(particles.particle_buffer().id() == first);
+  REQUIRE(mock.call_count("glDispatchCompute") == 2);
+  REQUIRE(mock.call_count("glMemoryBarrier") == 2);
+
+  // Every slot gets drawn, the vertex shader skips the dead ones
+  mock.reset_stats();
+  gl.start_frame(clear);
+  REQUIRE(particles.draw(gl, program.pipeline).has_value());
+  gl.end_frame();
+  REQUIRE(mock.stats().draw_calls == 1);
+#ifndef SHOGLE_GL_DISABLE_FRAME_STATS
+  REQUIRE(gl.frame_stats().instances == gl_particle_system::DEFAULT_CAPACITY);
+#endif
+
+  // Parameters for a bounded number of updates fit in a frame
+  for (u32 i = 2; i < gl_particle_system::MAX_UPDATES_PER_FRAME; ++i) {
+    REQUIRE(particles.update(gl, 1.f / 60.f).has_value());
+  }
+  REQUIRE(!particles.update(gl, 1.f / 60.f).has_value());
+  particles.end_frame(gl);
+  REQUIRE(particles.begin_frame(gl).has_value());
+  REQUIRE(particles.update(gl, 1.f / 60.f).has_value());
+  particles.end_frame(gl);
+
+  gl_particle_system::destroy(gl, particles);
+  program.destroy(gl);
+  REQUIRE(mock.live_objects() == base_objects);
+  gl.destroy();
+}
+
+TEST_CASE("CPU particle integration throughput", "[gl_particle_system][!benchmark]") {
+  constexpr u32 COUNT = 200000;
+  host_particles particles{COUNT, 42};
+  const gl_particle_system::step_args args{{0.f, -9.8f, 0.f}, .1f, 1.f / 60.f};
+
+  BENCHMARK("integrate_scalar") {
+    gl_particle_system::integrate_scalar(particles.view, COUNT, args);
+    return particles.view.pos[0][COUNT - 1];
+  };
+  BENCHMARK("integrate") {
+    gl_particle_system::integrate(particles.view, COUNT, args);
+    return particles.view.pos[0][COUNT - 1];
+  };
+}
@@ -0,0 +1,104 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <shogle/render/gl/mock.hpp>
+#include <shogle/render/opengl.hpp>
+
+#include <cstdio>
+#include <filesystem>
+
+using namespace shogle;
+
+namespace {
+
+constexpr gl_pipeline_sources test_sources{
+  .vertex = "#version 460 core\nvoid main() { gl_Position = vec4(0.0); }\n",
+  .fragment = "#version 460 core\nout vec4 color;\nvoid main() { color = vec4(1.0); }\n",
+};
+
+std::filesystem::path make_cache_dir(std::string_view name) {
+  auto dir = std::filesystem::temp_directory_path() / "shogle_test" / name;
+  std::filesystem::remove_all(dir);
+  return dir;
+}
+
+} // namespace
+
+TEST_CASE("Cached pipelines skip shader compilation", "[gl_pipeline_cache]") {
+  const auto dir = make_cache_dir("pipeline_cache_hit");
+  {
+    gl_mock_provider mock;
+    gl_context gl{mock};
+    gl_pipeline_cache cache{gl, dir.string()};
+    auto pipeline = cache.create_pipeline(gl, test_sources);
+    REQUIRE(pipeline.has_value());
+    REQUIRE(cache.stats().misses == 1);
+    REQUIRE(std::filesystem::exists(cache.entry_path(gl_pipeline_cache::hash_sources(test_sources))));
+    gl_graphics_pipeline::destroy(gl, *pipeline);
+    REQUIRE(mock.live_objects() == 0);
+    gl.destroy();
+  }
+
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  gl_pipeline_cache cache{gl, dir.string()};
+  mock.reset_stats();
+  auto pipeline = cache.create_pipeline(gl, test_sources);
+  REQUIRE(pipeline.has_value());
+  REQUIRE(cache.stats().hits == 1);
+  REQUIRE(mock.call_count("glCompileShader") == 0);
+  REQUIRE(mock.call_count("glProgramBinary") == 1);
+  gl_graphics_pipeline::destroy(gl, *pipeline);
+  gl.destroy();
+}
+
+TEST_CASE("Corrupted cache entries fall back to compilation", "[gl_pipeline_cache]") {
+  const auto dir = make_cache_dir("pipeline_cache_corrupt");
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  gl_pipeline_cache cache{gl, dir.string()};
+  auto first = cache.create_pipeline(gl, test_sources);
+  REQUIRE(first.has_value());
+  gl_graphics_pipeline::destroy(gl, *first);
+
+  const auto path = cache.entry_path(gl_pipeline_cache::hash_sources(test_sources));
+  {
+    std::FILE* file = std::fopen(path.c_str(), "r+b");
+    REQUIRE(file);
+    std::fseek(file, -1, SEEK_END);
+    std::fputc(0xFF, file);
+    std::fclose(file);
+  }
+
+  mock.reset_stats();
+  auto second = cache.create_pipeline(gl, test_sources);
+  REQUIRE(second.has_value());
+  REQUIRE(cache.stats().rejected == 1);
+  REQUIRE(cache.stats().misses == 2);
+  REQUIRE(mock.call_count("glCompileShader") == 2);
+  REQUIRE(std::filesystem::exists(path));
+  gl_graphics_pipeline::destroy(gl, *second);
+  REQUIRE(mock.live_objects() == 0);
+  gl.destroy();
+}
+
+TEST_CASE("Driver changes invalidate cache entries", "[gl_pipeline_cache]") {
+  const auto dir = make_cache_dir("pipeline_cache_driver");
+  gl_mock_provider mock_46;
+  gl_context gl_46{mock_46};
+  gl_pipeline_cache cache_46{gl_46, dir.string()};
+  auto first = cache_46.create_pipeline(gl_46, test_sources);
+  REQUIRE(first.has_value());
+  gl_graphics_pipeline::destroy(gl_46, *first);
+  gl_46.destroy();
+
+  gl_mock_provider mock_45{{800, 600}, {4, 5}};
+  gl_context gl_45{mock_45};
+  gl_pipeline_cache cache_45{gl_45, dir.string()};
+  REQUIRE(cache_45.driver_hash() != cache_46.driver_hash());
+  auto second = cache_45.create_pipeline(gl_45, test_sources);
+  REQUIRE(second.has_value());
+  REQUIRE(cache_45.stats().hits == 0);
+  REQUIRE(cache_45.stats().misses == 1);
+  gl_graphics_pipeline::destroy(gl_45, *second);
+  gl_45.destroy();
+}
@@ -0,0 +1,116 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <shogle/render/gl/mock.hpp>
+#include <shogle/render/opengl.hpp>
+
+#include <vector>
+
+using namespace shogle;
+
+namespace {
+
+constexpr gl_pipeline_sources test_sources{
+  .vertex = "#version 460 core\nvoid main() { gl_Position = vec4(0.0); }\n",
+  .fragment = "#version 460 core\nout vec4 color;\nvoid main() { color = vec4(1.0); }\n",
+};
+
+constexpr gl_pipeline_sources broken_sources{
+  .vertex = "#version 460 core\nvoid main() { gl_Position = vec4(0.0); }\n",
+  .fragment = "#version 460 core\n#error broken\n",
+};
+
+} // namespace
+
+TEST_CASE("Parallel compilation submits everything before querying status",
+          "[gl_pipeline_compiler]") {
+  gl_mock_provider mock;
+  mock.set_compile_latency(2);
+  gl_context gl{mock};
+  gl_pipeline_compiler compiler{gl};
+  REQUIRE(compiler.parallel());
+
+  mock.reset_stats();
+  std::vector<gl_pipeline_compiler::ticket> tickets;
+  for (u32 i = 0; i < 8; ++i) {
+    tickets.emplace_back(compiler.submit(gl, test_sources));
+  }
+  REQUIRE(mock.call_count("glCompileShader") == 16);
+  REQUIRE(mock.call_count("glLinkProgram") == 8);
+  REQUIRE(mock.call_count("glGetShaderiv") == 0);
+  REQUIRE(mock.call_count("glGetProgramiv") == 0);
+
+  // The driver is still busy for the first two polls
+  REQUIRE(compiler.poll(gl) == 0);
+  REQUIRE(compiler.poll(gl) == 0);
+  REQUIRE_FALSE(compiler.is_ready(tickets[0]));
+  REQUIRE(compiler.poll(gl) == 8);
+  REQUIRE(compiler.pending_count() == 0);
+
+  for (const auto ticket : tickets) {
+    REQUIRE(compiler.is_ready(ticket));
+    auto pipeline = compiler.take(ticket);
+    REQUIRE(pipeline.has_value());
+    REQUIRE(pipeline->stages() ==
+            (gl_shader::STAGE_VERTEX_BIT | gl_shader::STAGE_FRAGMENT_BIT));
+    gl_graphics_pipeline::destroy(gl, *pipeline);
+  }
+  // Shaders are gone once the program links
+  REQUIRE(mock.live_objects() == 0);
+
+  gl_pipeline_compiler::destroy(gl, compiler);
+  REQUIRE(compiler.invalidated());
+  gl.destroy();
+}
+
+TEST_CASE("Compilation errors come back through the ticket", "[gl_pipeline_compiler]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  gl_pipeline_compiler compiler{gl};
+
+  const auto good = compiler.submit(gl, test_sources);
+  const auto bad = compiler.submit(gl, broken_sources);
+  compiler.finish(gl);
+
+  auto pipeline = compiler.take(good);
+  REQUIRE(pipeline.has_value());
+  auto failed = compiler.take(bad);
+  REQUIRE_FALSE(failed.has_value());
+  REQUIRE(std::string_view{failed.error().what()}.find("#error") != std::string_view::npos);
+  gl_graphics_pipeline::destroy(gl, *pipeline);
+  REQUIRE(mock.live_objects() == 0);
+
+  // Tickets get reused after being taken
+  REQUIRE(compiler.submit(gl, test_sources) < 2);
+  gl_pipeline_compiler::destroy(gl, compiler);
+  REQUIRE(mock.live_objects() == 0);
+  gl.destroy();
+}
+
+TEST_CASE("Without the extension pipelines compile within the budget",
+          "[gl_pipeline_compiler]") {
+  gl_mock_provider mock;
+  mock.disable_extension("GL_KHR_parallel_shader_compile");
+  gl_context gl{mock};
+  gl_pipeline_compiler compiler{gl, 2};
+  REQUIRE_FALSE(compiler.parallel());
+
+  mock.reset_stats();
+  std::vector<gl_pipeline_compiler::ticket> tickets;
+  for (u32 i = 0; i < 5; ++i) {
+    tickets.emplace_back(compiler.submit(gl, test_sources));
+  }
+  REQUIRE(mock.call_count("glCompileShader") == 0);
+
+  REQUIRE(compiler.poll(gl) == 2);
+  REQUIRE(compiler.is_ready(tickets[1]));
+  REQUIRE_FALSE(compiler.is_ready(tickets[2]));
+  REQUIRE(compiler.poll(gl) == 2);
+  REQUIRE(compiler.poll(gl) == 1);
+  REQUIRE(compiler.poll(gl) == 0);
+  REQUIRE(mock.call_count("glGetProgramiv") == 5); // Link status only
+
+  // Untaken pipelines get released with the compiler
+  gl_pipeline_compiler::destroy(gl, compiler);
+  REQUIRE(mock.live_objects() == 0);
+  gl.destroy();
+}
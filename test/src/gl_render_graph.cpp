@@ -0,0 +1,182 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <shogle/render/gl/mock.hpp>
+#include <shogle/render/opengl.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace shogle;
+
+namespace {
+
+constexpr extent2d FULL{1280, 720};
+constexpr extent2d HALF{640, 360};
+constexpr u32 BLUR_PASSES = 8;
+
+using graph_t = gl_render_graph;
+
+// Scene, bright pass, ping-pong blur and composite, the usual bloom chain
+struct bloom_chain {
+  bloom_chain(std::vector<std::string>* log = nullptr) {
+    const auto record = [log](std::string name) -> graph_t::pass_callback {
+      return [log, name](gl_context&, const graph_t::pass_context&) {
+        if (log) {
+          log->push_back(name);
+        }
+      };
+    };
+    hdr = graph.create_texture("hdr", {gl_texture::TEX_FORMAT_RGBA16F, FULL});
+    depth = graph.create_texture("depth", {gl_texture::TEX_FORMAT_D24_S8, FULL});
+    ldr = graph.create_texture("ldr", {gl_texture::TEX_FORMAT_RGBA8, FULL});
+    graph.set_output(ldr);
+
+    // Declared first, ordering has to come from the dependencies
+    composite = graph.add_pass("composite", record("composite"));
+    scene = graph.add_pass("scene", record("scene"));
+    graph.write(scene, hdr).write(scene, depth, graph_t::ACCESS_DEPTH);
+
+    auto source = graph.create_texture("bright", {gl_texture::TEX_FORMAT_RGBA16F, HALF});
+    const auto bright = graph.add_pass("bright", record("bright"));
+    graph.read(bright, hdr).write(bright, source);
+    for (u32 i = 0; i < BLUR_PASSES; ++i) {
+      const auto target = graph.create_texture("blur", {gl_texture::TEX_FORMAT_RGBA16F, HALF});
+      const auto blur = graph.add_pass("blur", record("blur"));
+      graph.read(blur, source).write(blur, target);
+      source = target;
+    }
+    graph.read(composite, hdr).read(composite, source).write(composite, ldr);
+
+    debug = graph.add_pass("debug", record("debug"));
+    const auto overdraw = graph.create_texture("overdraw", {gl_texture::TEX_FORMAT_R32U, FULL});
+    graph.read(debug, hdr).write(debug, overdraw);
+  }
+
+  graph_t graph;
+  graph_t::resource_id hdr, depth, ldr;
+  graph_t::pass_id scene, composite, debug;
+};
+
+} // namespace
+
+TEST_CASE("Render graphs cull unused passes and order the rest", "[gl_render_graph]") {
+  bloom_chain chain;
+  REQUIRE(chain.graph.compile().has_value());
+
+  const auto schedule = chain.graph.schedule();
+  REQUIRE(schedule.size() == BLUR_PASSES + 3);
+  REQUIRE(schedule.front().pass == chain.scene);
+  REQUIRE(schedule.back().pass == chain.composite);
+  REQUIRE(chain.graph.culled(chain.debug));
+  REQUIRE(!chain.graph.culled(chain.scene));
+
+  graph_t cyclic;
+  const auto a = cyclic.create_texture("a", {gl_texture::TEX_FORMAT_RGBA8, FULL});
+  const auto b = cyclic.create_texture("b", {gl_texture::TEX_FORMAT_RGBA8, FULL});
+  const auto first = cyclic.add_pass("first", {});
+  const auto second = cyclic.add_pass("second", {});
+  cyclic.read(first, b).write(first, a).read(second, a).write(second, b);
+  cyclic.set_output(a);
+  REQUIRE(!cyclic.compile());
+  REQUIRE(cyclic.schedule().empty());
+}
+
+TEST_CASE("Transient textures with matching descriptions share storage", "[gl_render_graph]") {
+  bloom_chain chain;
+  REQUIRE(chain.graph.compile().has_value());
+
+  // hdr, depth, ldr and two half resolution textures for the whole blur chain
+  REQUIRE(chain.graph.transient_count() == BLUR_PASSES + 4);
+  REQUIRE(chain.graph.physical_count() == 5);
+  REQUIRE(chain.graph.physical_index(chain.hdr) != chain.graph.physical_index(chain.ldr));
+
+  // Depth is dead after the scene, hdr is still read by the composite
+  const auto& scene = chain.graph.schedule().front();
+  REQUIRE(scene.invalidate_depth);
+  REQUIRE(scene.invalidate_colors == 0);
+  REQUIRE(chain.graph.schedule().back().invalidate_colors == 0);
+}
+
+TEST_CASE("Image stores get a memory barrier before the next access", "[gl_render_graph]") {
+  graph_t graph;
+  const auto lut = graph.create_texture("lut", {gl_texture::TEX_FORMAT_RGBA16F, {32, 32}});
+  const auto out = graph.create_texture("out", {gl_texture::TEX_FORMAT_RGBA8, FULL});
+  const auto bake = graph.add_pass("bake", {});
+  const auto apply = graph.add_pass("apply", {});
+  const auto again = graph.add_pass("again", {});
+  graph.write(bake, lut, graph_t::ACCESS_IMAGE_WRITE);
+  graph.read(apply, lut).write(apply, out);
+  graph.read(again, lut).write(again, out);
+  graph.set_output(out);
+  REQUIRE(graph.compile().has_value());
+
+  const auto schedule = graph.schedule();
+  REQUIRE(schedule.size() == 3);
+  REQUIRE(schedule[0].barriers == graph_t::BARRIER_NONE);
+  REQUIRE(schedule[1].barriers == graph_t::BARRIER_TEXTURE_FETCH);
+  REQUIRE(schedule[2].barriers == graph_t::BARRIER_NONE);
+}
+
+TEST_CASE("Executing a render graph reuses its pooled textures", "[gl_render_graph]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  const u32 base_objects = mock.live_objects();
+  std::vector<std::string> log;
+  bloom_chain chain{&log};
+  REQUIRE(chain.graph.compile().has_value());
+
+  mock.reset_stats();
+  REQUIRE(chain.graph.execute(gl).has_value());
+  REQUIRE(mock.call_count("glCreateTextures") == chain.graph.physical_count());
+  REQUIRE(mock.call_count("glCreateFramebuffers") == BLUR_PASSES + 3);
+  REQUIRE(mock.call_count("glInvalidateNamedFramebufferData") == 1);
+  REQUIRE(log.size() == BLUR_PASSES + 3);
+  REQUIRE(log.front() == "scene");
+  REQUIRE(log.back() == "composite");
+
+  // Nothing gets allocated again, recompiling the same frame keeps the textures
+  mock.reset_stats();
+  REQUIRE(chain.graph.execute(gl).has_value());
+  REQUIRE(chain.graph.compile().has_value());
+  REQUIRE(chain.graph.execute(gl).has_value());
+  REQUIRE(mock.call_count("glCreateTextures") == 0);
+  REQUIRE(chain.graph.texture(chain.ldr).format() == gl_texture::TEX_FORMAT_RGBA8);
+
+  gl_render_graph::destroy(gl, chain.graph);
+  REQUIRE(chain.graph.invalidated());
+  REQUIRE(mock.live_objects() == base_objects);
+  gl.destroy();
+}
+
+TEST_CASE("Passes with several color writes draw to every attachment", "[gl_render_graph]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  graph_t graph;
+  const auto albedo = graph.create_texture("albedo", {gl_texture::TEX_FORMAT_RGBA8, FULL});
+  const auto normal = graph.create_texture("normal", {gl_texture::TEX_FORMAT_RGBA16F, FULL});
+  const auto out = graph.create_texture("out", {gl_texture::TEX_FORMAT_RGBA8, FULL});
+  const auto gbuffer = graph.add_pass("gbuffer", {});
+  const auto lighting = graph.add_pass("lighting", {});
+  graph.write(gbuffer, albedo).write(gbuffer, normal);
+  graph.read(lighting, albedo).read(lighting, normal).write(lighting, out);
+  graph.set_output(out);
+  REQUIRE(graph.compile().has_value());
+
+  mock.reset_stats();
+  REQUIRE(graph.execute(gl).has_value());
+  u32 draw_buffer_calls = 0;
+  u64 draw_buffer_count = 0;
+  auto find_draw_buffers = [&](std::string_view func, span<const u64> args) {
+    if (func == "glNamedFramebufferDrawBuffers") {
+      ++draw_buffer_calls;
+      draw_buffer_count = args[1];
+    }
+  };
+  mock.decode_trace(find_draw_buffers);
+  // The single attachment lighting pass keeps the default draw buffer
+  REQUIRE(draw_buffer_calls == 1);
+  REQUIRE(draw_buffer_count == 2);
+
+  gl_render_graph::destroy(gl, graph);
+  gl.destroy();
+}
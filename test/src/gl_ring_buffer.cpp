@@ -0,0 +1,104 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <shogle/render/gl/mock.hpp>
+#include <shogle/render/opengl.hpp>
+
+using namespace shogle;
+
+TEST_CASE("Ring buffer bump allocation", "[gl_ring_buffer]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  gl_ring_buffer ring{gl, gl_buffer::TYPE_UNIFORM, 1024, 3};
+  REQUIRE(ring.alignment() == 256);
+  REQUIRE(ring.buffer().size() == 3 * 1024);
+
+  REQUIRE(ring.begin_frame(gl).has_value());
+  REQUIRE(ring.current_region() == 0);
+
+  const u32 value = 0xCAFE;
+  const auto first = ring.push(value);
+  const auto second = ring.push(value);
+  REQUIRE(first.has_value());
+  REQUIRE(second.has_value());
+  REQUIRE(first->offset == 0);
+  REQUIRE(second->offset == 256);
+  REQUIRE(*static_cast<const u32*>(second->ptr) == value);
+
+  // Only 1024 bytes per region
+  REQUIRE(ring.allocate(256).has_value());
+  REQUIRE(ring.allocate(256).has_value());
+  REQUIRE_FALSE(ring.allocate(1).has_value());
+  ring.end_frame(gl);
+
+  REQUIRE(ring.begin_frame(gl).has_value());
+  REQUIRE(ring.current_region() == 1);
+  const auto next = ring.allocate(16);
+  REQUIRE(next.has_value());
+  REQUIRE(next->offset == 1024);
+  ring.end_frame(gl);
+
+  gl_ring_buffer::destroy(gl, ring);
+  gl.destroy();
+}
+
+TEST_CASE("Ring buffer offsets honor strides that aren't powers of two", "[gl_ring_buffer]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  gl_ring_buffer ring{gl, gl_buffer::TYPE_VERTEX, 1024, 2};
+  REQUIRE(ring.alignment() == 16);
+
+  REQUIRE(ring.begin_frame(gl).has_value());
+  ring.end_frame(gl);
+  REQUIRE(ring.begin_frame(gl).has_value());
+  REQUIRE(ring.current_region() == 1);
+  REQUIRE(ring.allocate(4).has_value());
+
+  // 12 byte vertices, offsets have to land on a vertex boundary of the whole buffer
+  const auto verts = ring.allocate(12 * 4, 12);
+  REQUIRE(verts.has_value());
+  REQUIRE(verts->offset == 1056);
+  REQUIRE(verts->offset % 12 == 0);
+  REQUIRE(verts->offset % 16 == 0);
+  ring.end_frame(gl);
+
+  gl_ring_buffer::destroy(gl, ring);
+  gl.destroy();
+}
+
+TEST_CASE("Ring buffer waits on fences before reusing a region", "[gl_ring_buffer]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  const u32 base_objects = mock.live_objects();
+  gl_ring_buffer ring{gl, gl_buffer::TYPE_VERTEX, 512, 2};
+
+  mock.set_fence_latency(1);
+  for (u32 i = 0; i < 2; ++i) {
+    REQUIRE(ring.begin_frame(gl).has_value());
+    REQUIRE(ring.allocate(64).has_value());
+    ring.end_frame(gl);
+  }
+  REQUIRE(ring.stall_count() == 0);
+
+  // Region 0 is still held by the GPU
+  REQUIRE(ring.begin_frame(gl).has_value());
+  REQUIRE(ring.stall_count() == 1);
+  REQUIRE(ring.current_region() == 0);
+  ring.end_frame(gl);
+
+  // Regions fenced before the change keep the old latency
+  mock.set_fence_latency(0);
+  for (u32 i = 0; i < 2; ++i) {
+    REQUIRE(ring.begin_frame(gl).has_value());
+    ring.end_frame(gl);
+  }
+  REQUIRE(ring.stall_count() == 3);
+  for (u32 i = 0; i < 2; ++i) {
+    REQUIRE(ring.begin_frame(gl).has_value());
+    ring.end_frame(gl);
+  }
+  REQUIRE(ring.stall_count() == 3);
+
+  gl_ring_buffer::destroy(gl, ring);
+  REQUIRE(mock.live_objects() == base_objects);
+  gl.destroy();
+}
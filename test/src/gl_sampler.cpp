@@ -0,0 +1,93 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "./mock_scene.hpp"
+
+using namespace shogle;
+using namespace shogle::test;
+
+TEST_CASE("Sampler cache deduplicates descriptions", "[gl_sampler]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  const u32 base_objects = mock.live_objects();
+  gl_sampler_cache cache;
+
+  auto linear = gl_sampler_desc::make_default();
+  linear.max_anisotropy = 64.f;
+  auto nearest = linear;
+  nearest.min_filter = gl_texture::SAMPLER_NEAREST;
+  nearest.mag_filter = gl_texture::SAMPLER_NEAREST;
+
+  auto a = cache.get(gl, linear);
+  auto b = cache.get(gl, nearest);
+  auto c = cache.get(gl, linear);
+  REQUIRE(a.has_value());
+  REQUIRE(b.has_value());
+  REQUIRE(c.has_value());
+  REQUIRE(&a->get() == &c->get());
+  REQUIRE(a->get().id() != b->get().id());
+  REQUIRE(cache.size() == 2);
+
+  // Equal descriptions hash the same, even with a signed zero
+  auto negative_bias = linear;
+  negative_bias.lod_bias = -0.f;
+  auto d = cache.get(gl, negative_bias);
+  REQUIRE(d.has_value());
+  REQUIRE(&a->get() == &d->get());
+  REQUIRE(cache.size() == 2);
+  REQUIRE(mock.call_count("glGenSamplers") == 2);
+  REQUIRE(mock.live_objects() == base_objects + 2);
+
+  gl_sampler_cache::destroy(gl, cache);
+  REQUIRE(cache.size() == 0);
+  REQUIRE(cache.invalidated());
+  REQUIRE(mock.live_objects() == base_objects);
+  gl.destroy();
+}
+
+TEST_CASE("Draws bind samplers without touching texture parameters", "[gl_sampler]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  mock_scene scene{gl};
+  gl_texture tex{gl, gl_texture::TEX_FORMAT_RGBA8, extent2d{4, 4}, 1, 1};
+  gl_sampler_cache cache;
+
+  auto clamp = gl_sampler_desc::make_default();
+  clamp.wrap_s = clamp.wrap_t = gl_texture::WRAP_CLAMP_TO_EDGE;
+  const gl_sampler& repeat_sampler = cache.get(gl, gl_sampler_desc::make_default()).value();
+  const gl_sampler& clamp_sampler = cache.get(gl, clamp).value();
+
+  const auto make_draw = [&](gl_command_builder& builder, const gl_sampler& sampler) {
+    return builder.set_pipeline(scene.pipeline_a)
+      .set_vertex_layout(scene.layout)
+      .add_vertex_buffer(scene.vbo)
+      .add_texture(tex, 0, sampler)
+      .set_draw_count(3)
+      .build();
+  };
+  gl_command_builder repeat_builder, clamp_builder;
+  const auto repeat_draw = make_draw(repeat_builder, repeat_sampler);
+  const auto clamp_draw = make_draw(clamp_builder, clamp_sampler);
+  const gl_clear_opts clear{color4{0.f, 0.f, 0.f, 1.f}, nullopt, gl_clear_opts::CLEAR_COLOR, {}};
+
+  mock.reset_stats();
+  gl.start_frame(clear);
+  gl.submit_command(repeat_draw);
+  gl.submit_command(repeat_draw);
+  gl.submit_command(clamp_draw);
+  gl.end_frame();
+
+  // The same image sampled two ways: one texture bind, one sampler bind per switch
+  REQUIRE(mock.call_count("glBindTexture") == 1);
+  REQUIRE(mock.call_count("glBindSampler") == 2);
+  REQUIRE(mock.call_count("glTexParameteri") == 0);
+  REQUIRE(mock.stats().redundant_state_changes == 0);
+#ifndef SHOGLE_GL_DISABLE_FRAME_STATS
+  REQUIRE(gl.frame_stats().texture_binds == 1);
+  REQUIRE(gl.frame_stats().sampler_binds == 2);
+#endif
+
+  gl_sampler_cache::destroy(gl, cache);
+  gl_texture::deallocate(gl, tex);
+  scene.destroy(gl);
+  gl.destroy();
+}
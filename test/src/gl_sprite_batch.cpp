@@ -0,0 +1,160 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "./mock_scene.hpp"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace shogle;
+using namespace shogle::test;
+
+namespace {
+
+using sprite_quad = gl_sprite_batch::sprite_quad;
+using sprite_vertex = gl_sprite_batch::sprite_vertex;
+
+std::vector<sprite_quad> random_quads(size_t count, u32 seed) {
+  std::mt19937 rng{seed};
+  std::uniform_real_distribution<f32> pos{-500.f, 500.f};
+  std::uniform_real_distribution<f32> size{1.f, 64.f};
+  std::uniform_real_distribution<f32> rot{0.f, 6.28f};
+  std::vector<sprite_quad> quads(count);
+  for (auto& quad : quads) {
+    quad.transform.pos = {pos(rng), pos(rng)};
+    quad.transform.scale = {size(rng), size(rng)};
+    quad.transform.rot = rot(rng);
+    quad.uvs = {0.f, 0.f, 1.f, 1.f};
+    quad.color = {1.f, 1.f, 1.f, 1.f};
+  }
+  return quads;
+}
+
+} // namespace
+
+TEST_CASE("Sprites with the same layer, pipeline and texture share a draw", "[gl_sprite_batch]") {
+  constexpr u32 SPRITE_COUNT = 1000;
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  const u32 base_objects = mock.live_objects();
+  mock_program program{gl};
+  gl_texture atlas{gl, gl_texture::TEX_FORMAT_RGBA8, extent2d{64, 64}, 1, 1};
+  gl_texture font{gl, gl_texture::TEX_FORMAT_RGBA8, extent2d{32, 32}, 1, 1};
+  gl_sprite_batch batch{gl, {.max_sprites = 2048, .texture_unit = 0, .frame_regions = 2}};
+
+  REQUIRE(batch.begin_frame(gl).has_value());
+  batch.set_pipeline(program.pipeline);
+  math::transform2d<f32> transform;
+  for (u32 i = 0; i < SPRITE_COUNT; ++i) {
+    // Interleaved textures, the batch has to regroup them
+    REQUIRE(batch.draw(i % 2 ? atlas : font, {0, 0, 16, 16}, transform));
+  }
+  REQUIRE(batch.draw(atlas, {0, 0, 64, 64}, transform, {1.f, 1.f, 1.f, 1.f}, 1));
+  REQUIRE(batch.size() == SPRITE_COUNT + 1);
+
+  const gl_clear_opts clear{color4{0.f, 0.f, 0.f, 1.f}, nullopt, gl_clear_opts::CLEAR_COLOR, {}};
+  mock.reset_stats();
+  gl.start_frame(clear);
+  REQUIRE(batch.flush(gl).has_value());
+  gl.end_frame();
+  batch.end_frame(gl);
+
+  REQUIRE(batch.draw_count() == 3);
+  REQUIRE(mock.stats().draw_calls == 3);
+  REQUIRE(batch.size() == 0);
+  REQUIRE(batch.capacity() == 2048 - SPRITE_COUNT - 1);
+
+  gl_sprite_batch::destroy(gl, batch);
+  gl_texture::deallocate(gl, font);
+  gl_texture::deallocate(gl, atlas);
+  program.destroy(gl);
+  REQUIRE(mock.live_objects() == base_objects);
+  gl.destroy();
+}
+
+TEST_CASE("Expanded quads match the transform matrix", "[gl_sprite_batch]") {
+  sprite_quad quad;
+  quad.transform.pos = {120.f, -40.f};
+  quad.transform.scale = {32.f, 16.f};
+  quad.transform.pivot = {4.f, -2.f};
+  quad.transform.offset = {0.25f, 0.1f};
+  quad.transform.rot = 0.7f;
+  quad.uvs = {0.25f, 0.5f, 0.75f, 1.f};
+  quad.color = {1.f, 0.f, 0.f, 1.f};
+
+  sprite_vertex out[gl_sprite_batch::VERTICES_PER_SPRITE];
+  gl_sprite_batch::expand_quads(span<const sprite_quad>{&quad, 1}, out);
+
+  const auto model = quad.transform.matrix();
+  const f32 corners[][2] = {{-.5f, -.5f}, {.5f, -.5f}, {.5f, .5f}, {-.5f, .5f}};
+  for (u32 i = 0; i < gl_sprite_batch::VERTICES_PER_SPRITE; ++i) {
+    const vec4 expected = model * vec4{corners[i][0], corners[i][1], 0.f, 1.f};
+    REQUIRE(std::abs(out[i].pos.x - expected.x) < 1e-3f);
+    REQUIRE(std::abs(out[i].pos.y - expected.y) < 1e-3f);
+    REQUIRE(out[i].color.r == 1.f);
+  }
+  // Bottom left samples the bottom of the source rectangle
+  REQUIRE(out[0].uvs.x == 0.25f);
+  REQUIRE(out[0].uvs.y == 1.f);
+  REQUIRE(out[2].uvs.x == 0.75f);
+  REQUIRE(out[2].uvs.y == 0.5f);
+}
+
+TEST_CASE("Sprite batches reject sprites once the frame is full", "[gl_sprite_batch]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  mock_program program{gl};
+  gl_texture tex{gl, gl_texture::TEX_FORMAT_RGBA8, extent2d{16, 16}, 1, 1};
+  gl_sprite_batch batch{gl, {.max_sprites = 8, .texture_unit = 0, .frame_regions = 2}};
+  REQUIRE(!gl_sprite_batch::create(gl, {.max_sprites = 0, .texture_unit = 0, .frame_regions = 2}));
+
+  const math::transform2d<f32> transform;
+  REQUIRE(batch.begin_frame(gl).has_value());
+  batch.set_pipeline(program.pipeline);
+  for (u32 i = 0; i < 5; ++i) {
+    REQUIRE(batch.draw(tex, {0, 0, 16, 16}, transform));
+  }
+  REQUIRE(batch.flush(gl).has_value());
+
+  // Flushed sprites still count against the frame
+  for (u32 i = 0; i < 3; ++i) {
+    REQUIRE(batch.draw(tex, {0, 0, 16, 16}, transform));
+  }
+  REQUIRE(!batch.draw(tex, {0, 0, 16, 16}, transform));
+  REQUIRE(batch.flush(gl).has_value());
+  batch.end_frame(gl);
+
+  REQUIRE(batch.begin_frame(gl).has_value());
+  REQUIRE(batch.capacity() == 8);
+  REQUIRE(batch.draw(tex, {0, 0, 16, 16}, transform));
+
+  gl_sprite_batch::destroy(gl, batch);
+  gl_texture::deallocate(gl, tex);
+  program.destroy(gl);
+  gl.destroy();
+}
+
+TEST_CASE("Sprite expansion throughput", "[gl_sprite_batch][!benchmark]") {
+  constexpr size_t SPRITE_COUNT = 100000;
+  const auto quads = random_quads(SPRITE_COUNT, 42);
+  std::vector<sprite_vertex> vertices(SPRITE_COUNT * gl_sprite_batch::VERTICES_PER_SPRITE);
+
+  BENCHMARK("matrix per sprite") {
+    const f32 corners[][2] = {{-.5f, -.5f}, {.5f, -.5f}, {.5f, .5f}, {-.5f, .5f}};
+    for (size_t i = 0; i < SPRITE_COUNT; ++i) {
+      const auto model = quads[i].transform.matrix();
+      for (u32 j = 0; j < gl_sprite_batch::VERTICES_PER_SPRITE; ++j) {
+        const vec4 pos = model * vec4{corners[j][0], corners[j][1], 0.f, 1.f};
+        auto& vert = vertices[i * gl_sprite_batch::VERTICES_PER_SPRITE + j];
+        vert.pos = {pos.x, pos.y};
+        vert.color = quads[i].color;
+      }
+    }
+    return vertices.back().pos.x;
+  };
+  BENCHMARK("expand_quads") {
+    gl_sprite_batch::expand_quads({quads.data(), quads.size()}, vertices.data());
+    return vertices.back().pos.x;
+  };
+}
@@ -0,0 +1,150 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "./mock_scene.hpp"
+
+#include <vector>
+
+using namespace shogle;
+using namespace shogle::test;
+
+namespace {
+
+gl_texture::image_data make_image(const std::vector<u8>& pixels, u32 extent) {
+  return {pixels.data(), {extent, extent, 1}, gl_texture::PIXEL_FORMAT_RGBA,
+          gl_texture::PIXEL_TYPE_U8, gl_texture::ALIGN_4BYTES};
+}
+
+} // namespace
+
+TEST_CASE("Bindless materials share a single draw", "[gl_texture_residency]") {
+  constexpr u32 MATERIAL_COUNT = 100;
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  const u32 base_objects = mock.live_objects();
+  mock_scene scene{gl};
+
+  gl_texture_residency residency{gl, {.max_materials = MATERIAL_COUNT,
+                                      .page_layers = 0,
+                                      .levels = 1,
+                                      .allow_bindless = true}};
+  REQUIRE(residency.mode() == gl_texture_residency::MODE_BINDLESS);
+
+  const std::vector<u8> pixels(4 * 4 * 4, 0xFF);
+  for (u32 i = 0; i < MATERIAL_COUNT; ++i) {
+    auto mat = residency.add_image(gl, gl_texture::TEX_FORMAT_RGBA8, make_image(pixels, 4));
+    REQUIRE(mat.has_value());
+    REQUIRE(*mat == i);
+    REQUIRE(residency.entry(*mat).handle != 0);
+  }
+  REQUIRE(!residency.add_image(gl, gl_texture::TEX_FORMAT_RGBA8, make_image(pixels, 4)));
+  REQUIRE(mock.call_count("glMakeTextureHandleResidentARB") == MATERIAL_COUNT);
+
+  mock.reset_stats();
+  REQUIRE(residency.flush(gl).has_value());
+  REQUIRE(residency.flush(gl).has_value());
+  REQUIRE(mock.call_count("glNamedBufferSubData") == 1);
+
+  auto& builder = scene.builder;
+  builder.set_pipeline(scene.pipeline_a)
+    .set_vertex_layout(scene.layout)
+    .add_vertex_buffer(scene.vbo);
+  residency.add_bindings(builder, 0);
+  const auto cmd = builder.set_draw_count(3).set_instances(MATERIAL_COUNT).build();
+  const gl_clear_opts clear{color4{0.f, 0.f, 0.f, 1.f}, nullopt, gl_clear_opts::CLEAR_COLOR, {}};
+  mock.reset_stats();
+  gl.start_frame(clear);
+  gl.submit_command(cmd);
+  gl.end_frame();
+
+  // Every material reachable from one draw, no texture units involved
+  REQUIRE(mock.stats().draw_calls == 1);
+  REQUIRE(mock.call_count("glBindTexture") == 0);
+  REQUIRE(mock.call_count("glBindBufferRange") == 1);
+
+  residency.remove(gl, 42);
+  REQUIRE(residency.size() == MATERIAL_COUNT - 1);
+  auto reused = residency.add_image(gl, gl_texture::TEX_FORMAT_RGBA8, make_image(pixels, 4));
+  REQUIRE(reused.has_value());
+  REQUIRE(*reused == 42);
+
+  gl_texture_residency::destroy(gl, residency);
+  REQUIRE(mock.call_count("glMakeTextureHandleNonResidentARB") == MATERIAL_COUNT + 1);
+  scene.destroy(gl);
+  REQUIRE(mock.live_objects() == base_objects);
+  gl.destroy();
+}
+
+TEST_CASE("Texture array materials pack by format and extent", "[gl_texture_residency]") {
+  gl_mock_provider mock;
+  mock.disable_extension("GL_ARB_bindless_texture");
+  gl_context gl{mock};
+  const u32 base_objects = mock.live_objects();
+  gl_texture_residency residency{gl, {.max_materials = 16,
+                                      .page_layers = 2,
+                                      .levels = 1,
+                                      .allow_bindless = true}};
+  REQUIRE(residency.mode() == gl_texture_residency::MODE_TEXTURE_ARRAY);
+  gl_texture loose{gl, gl_texture::TEX_FORMAT_RGBA8, extent2d{4, 4}, 1, 1};
+  REQUIRE(!residency.add_texture(gl, loose));
+  gl_texture::deallocate(gl, loose);
+
+  const std::vector<u8> small(4 * 4 * 4, 0xFF);
+  const std::vector<u8> large(8 * 8 * 4, 0x80);
+  const auto add = [&](const std::vector<u8>& pixels, u32 extent) {
+    return residency.add_image(gl, gl_texture::TEX_FORMAT_RGBA8, make_image(pixels, extent))
+      .value();
+  };
+  const u32 a = add(small, 4);
+  const u32 b = add(large, 8);
+  const u32 c = add(small, 4);
+  const u32 d = add(small, 4);
+
+  // Same format and extent share a page until it runs out of layers
+  REQUIRE(residency.page_count() == 3);
+  REQUIRE(residency.entry(a).page == residency.entry(c).page);
+  REQUIRE(residency.entry(a).layer == 0);
+  REQUIRE(residency.entry(c).layer == 1);
+  REQUIRE(residency.entry(b).page != residency.entry(a).page);
+  REQUIRE(residency.entry(d).page != residency.entry(a).page);
+  REQUIRE(residency.page_texture(0).type() == gl_texture::TEX_TYPE_2D_ARRAY);
+
+  // Freed layers get reused by the next image that fits
+  residency.remove(gl, c);
+  const u32 e = add(small, 4);
+  REQUIRE(residency.entry(e).page == residency.entry(a).page);
+  REQUIRE(residency.entry(e).layer == 1);
+  REQUIRE(residency.page_count() == 3);
+
+  gl_command_builder builder;
+  residency.add_bindings(builder, 0, 2);
+  REQUIRE(mock.call_count("glMakeTextureHandleResidentARB") == 0);
+
+  gl_texture_residency::destroy(gl, residency);
+  REQUIRE(mock.live_objects() == base_objects);
+  gl.destroy();
+}
+
+TEST_CASE("Flushing regenerates mipmaps once per changed page", "[gl_texture_residency]") {
+  gl_mock_provider mock;
+  mock.disable_extension("GL_ARB_bindless_texture");
+  gl_context gl{mock};
+  gl_texture_residency residency{gl, {.max_materials = 8,
+                                      .page_layers = 8,
+                                      .levels = 3,
+                                      .allow_bindless = true}};
+  const std::vector<u8> pixels(4 * 4 * 4, 0xFF);
+  for (u32 i = 0; i < 5; ++i) {
+    REQUIRE(residency.add_image(gl, gl_texture::TEX_FORMAT_RGBA8, make_image(pixels, 4)));
+  }
+  REQUIRE(residency.page_count() == 1);
+  REQUIRE(mock.call_count("glTextureSubImage3D") == 5);
+  REQUIRE(mock.call_count("glGenerateTextureMipmap") == 0);
+
+  REQUIRE(residency.flush(gl).has_value());
+  REQUIRE(mock.call_count("glGenerateTextureMipmap") == 1);
+  REQUIRE(residency.flush(gl).has_value());
+  REQUIRE(mock.call_count("glGenerateTextureMipmap") == 1);
+
+  gl_texture_residency::destroy(gl, residency);
+  gl.destroy();
+}
@@ -0,0 +1,122 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <shogle/render/gl/mock.hpp>
+#include <shogle/render/opengl.hpp>
+
+#include <vector>
+
+using namespace shogle;
+
+TEST_CASE("Texture uploads are sourced from the staging buffer", "[gl_texture_stream]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  gl_texture tex{gl, gl_texture::TEX_FORMAT_RGBA8, extent2d{16, 16}, 1, 1};
+  gl_texture_streamer streamer{gl, {.staging_size = 1536,
+                                    .staging_regions = 2,
+                                    .readback_size = 0,
+                                    .readback_slots = 0}};
+
+  std::vector<u8> pixels(16 * 16 * 4, 0xAB);
+  const gl_texture::image_data image{pixels.data(), {16, 16, 1}, gl_texture::PIXEL_FORMAT_RGBA,
+                                     gl_texture::PIXEL_TYPE_U8, gl_texture::ALIGN_4BYTES};
+
+  mock.reset_stats();
+  REQUIRE(streamer.upload_image(gl, tex, image).has_value());
+  REQUIRE(streamer.staged_uploads() == 1);
+
+  // The texture copy gets an offset into the unpack buffer, not the client pointer
+  u64 pixels_arg = ~0ull;
+  bool unpack_bound = false;
+  auto check_calls = [&](std::string_view func, span<const u64> args) {
+    if (func == "glBindBuffer" && args[0] == 0x88EC) {
+      unpack_bound = args[1] != 0;
+    } else if (func == "glTextureSubImage2D") {
+      REQUIRE(unpack_bound);
+      pixels_arg = args[8];
+    }
+  };
+  mock.decode_trace(check_calls);
+  REQUIRE(pixels_arg < streamer.staging().buffer().size());
+  REQUIRE_FALSE(unpack_bound);
+
+  // A second image doesn't fit in the region, so it goes through the synchronous path
+  REQUIRE(streamer.upload_image(gl, tex, image).has_value());
+  REQUIRE(streamer.sync_uploads() == 1);
+  streamer.poll(gl);
+  REQUIRE(streamer.upload_image(gl, tex, image).has_value());
+  REQUIRE(streamer.staged_uploads() == 2);
+
+  gl_texture_streamer::destroy(gl, streamer);
+  gl_texture::deallocate(gl, tex);
+  gl.destroy();
+}
+
+TEST_CASE("Polling never waits for the GPU to release a staging region", "[gl_texture_stream]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  gl_texture tex{gl, gl_texture::TEX_FORMAT_RGBA8, extent2d{16, 16}, 1, 1};
+  gl_texture_streamer streamer{gl, {.staging_size = 1536,
+                                    .staging_regions = 2,
+                                    .readback_size = 0,
+                                    .readback_slots = 0}};
+
+  std::vector<u8> pixels(16 * 16 * 4, 0xAB);
+  const gl_texture::image_data image{pixels.data(), {16, 16, 1}, gl_texture::PIXEL_FORMAT_RGBA,
+                                     gl_texture::PIXEL_TYPE_U8, gl_texture::ALIGN_4BYTES};
+
+  mock.set_fence_latency(4);
+  REQUIRE(streamer.upload_image(gl, tex, image).has_value());
+  streamer.poll(gl);
+  REQUIRE(streamer.upload_image(gl, tex, image).has_value());
+  REQUIRE(streamer.staged_uploads() == 2);
+
+  // The first region is still in use, the upload copies from client memory instead
+  streamer.poll(gl);
+  REQUIRE(streamer.staging().stall_count() == 1);
+  REQUIRE(streamer.upload_image(gl, tex, image).has_value());
+  REQUIRE(streamer.sync_uploads() == 1);
+
+  gl_texture_streamer::destroy(gl, streamer);
+  gl_texture::deallocate(gl, tex);
+  gl.destroy();
+}
+
+TEST_CASE("Readbacks become available once their fence signals", "[gl_texture_stream]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  gl_texture_streamer streamer{gl, {.staging_size = 256,
+                                    .staging_regions = 2,
+                                    .readback_size = 64 * 64 * 4,
+                                    .readback_slots = 2}};
+
+  mock.set_fence_latency(1);
+  const auto area = rectangle_pos<u32>{0, 0, 64, 64};
+  auto first = streamer.read_pixels(gl, GL_DEFAULT_BINDING, area, gl_texture::PIXEL_FORMAT_RGBA,
+                                    gl_texture::PIXEL_TYPE_U8);
+  auto second = streamer.read_pixels(gl, GL_DEFAULT_BINDING, area, gl_texture::PIXEL_FORMAT_RGBA,
+                                     gl_texture::PIXEL_TYPE_U8);
+  REQUIRE(first.has_value());
+  REQUIRE(second.has_value());
+  REQUIRE_FALSE(streamer
+                  .read_pixels(gl, GL_DEFAULT_BINDING, area, gl_texture::PIXEL_FORMAT_RGBA,
+                               gl_texture::PIXEL_TYPE_U8)
+                  .has_value());
+
+  REQUIRE_FALSE(streamer.readback_data(*first).has_value());
+  streamer.poll(gl);
+  REQUIRE_FALSE(streamer.readback_data(*first).has_value());
+  streamer.poll(gl);
+  const auto data = streamer.readback_data(*first);
+  REQUIRE(data.has_value());
+  REQUIRE(data->size() == 64 * 64 * 4);
+
+  streamer.release(gl, *first);
+  streamer.release(gl, *second);
+  REQUIRE(streamer
+            .read_pixels(gl, GL_DEFAULT_BINDING, area, gl_texture::PIXEL_FORMAT_RGBA,
+                         gl_texture::PIXEL_TYPE_U8)
+            .has_value());
+
+  gl_texture_streamer::destroy(gl, streamer);
+  gl.destroy();
+}
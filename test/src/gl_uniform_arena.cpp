@@ -0,0 +1,128 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "./mock_scene.hpp"
+
+#include <cstring>
+#include <vector>
+
+using namespace shogle;
+using namespace shogle::test;
+
+namespace {
+
+constexpr std::string_view vert_src = R"glsl(#version 460 core
+layout(location = 0) in vec3 att_pos;
+layout(std140, binding = 1) uniform Transform {
+  mat4 model;
+  mat3 normal;
+  vec3 tint;
+  float alpha;
+  vec4 lights[2];
+};
+void main() { gl_Position = model * vec4(att_pos, 1.0); }
+)glsl";
+
+} // namespace
+
+TEST_CASE("Uniform block reflection reports driver offsets", "[gl_uniform_arena]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  mock_scene scene{gl, 1024, vert_src};
+
+  REQUIRE(scene.pipeline_a.uniform_block_count(gl) == 1);
+  REQUIRE_FALSE(scene.pipeline_a.uniform_block_index(gl, "Missing").has_value());
+  const auto layout = gl_uniform_block_layout::reflect(gl, scene.pipeline_a, "Transform");
+  REQUIRE(layout.has_value());
+  REQUIRE(layout->binding() == 1);
+  REQUIRE(layout->data_size() == 160);
+
+  const auto members = layout->members();
+  REQUIRE(members.size() == 5);
+  REQUIRE(members[0].name == "model");
+  REQUIRE(members[1].offset == 64);
+  REQUIRE(members[1].matrix_stride == 16);
+  REQUIRE(members[2].offset == 112);
+  REQUIRE(members[3].offset == 124);
+  REQUIRE(members[4].offset == 128);
+  REQUIRE(members[4].array_stride == 16);
+  REQUIRE(members[4].size == 2);
+
+  // mat3 columns get padded to vec4 in std140
+  std::vector<u8> block(layout->data_size(), 0);
+  const u32 normal = *layout->member_index("normal");
+  const mat3 normal_mat{1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f, 8.f, 9.f};
+  layout->write(block.data(), {normal, normal_mat});
+  f32 column[4];
+  std::memcpy(column, block.data() + 64 + 16, sizeof(column));
+  REQUIRE(column[0] == 4.f);
+  REQUIRE(column[2] == 6.f);
+  REQUIRE(column[3] == 0.f);
+
+  const u32 lights = *layout->member_index("lights");
+  layout->write(block.data(), {lights, vec4{3.f}}, 1);
+  std::memcpy(column, block.data() + 128 + 16, sizeof(column));
+  REQUIRE(column[3] == 3.f);
+
+  scene.destroy(gl);
+  gl.destroy();
+}
+
+TEST_CASE("Draws source their uniforms from the arena", "[gl_uniform_arena]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  mock_scene scene{gl, 1024, vert_src};
+  gl_uniform_arena arena{gl, 4096};
+  const auto layout = *gl_uniform_block_layout::reflect(gl, scene.pipeline_a, "Transform");
+  const u32 model = *layout.member_index("model");
+  const u32 alpha = *layout.member_index("alpha");
+  const gl_clear_opts clear{color4{0.f, 0.f, 0.f, 1.f}, nullopt, gl_clear_opts::CLEAR_COLOR, {}};
+
+  gl_command_builder builder;
+  const auto draw = [&](f32 alpha_value) {
+    const gl_draw_command::push_uniform uniforms[] = {{model, mat4{1.f}}, {alpha, alpha_value}};
+    const auto binding = arena.push(layout, uniforms);
+    REQUIRE(binding.has_value());
+    builder.reset();
+    gl.submit_command(builder.set_pipeline(scene.pipeline_a)
+                        .set_vertex_layout(scene.layout)
+                        .add_vertex_buffer(scene.vbo)
+                        .add_shader_binding(*binding)
+                        .set_draw_count(3)
+                        .build());
+  };
+
+  REQUIRE(arena.begin_frame(gl).has_value());
+  mock.reset_stats();
+  gl.start_frame(clear);
+  for (u32 i = 0; i < 8; ++i) {
+    draw(1.f);
+  }
+  gl.end_frame();
+  arena.end_frame(gl);
+
+  // Identical blocks share a range, so the binding only changes once
+  REQUIRE(mock.call_count("glUniformMatrix4fv") == 0);
+  REQUIRE(mock.call_count("glUniform1f") == 0);
+  REQUIRE(mock.call_count("glBindBufferRange") == 1);
+  REQUIRE(arena.stats().pushes == 8);
+  REQUIRE(arena.stats().reused == 7);
+  REQUIRE(arena.stats().bytes == layout.data_size());
+
+  REQUIRE(arena.begin_frame(gl).has_value());
+  arena.reset_stats();
+  mock.reset_stats();
+  gl.start_frame(clear);
+  for (u32 i = 0; i < 8; ++i) {
+    draw(static_cast<f32>(i));
+  }
+  gl.end_frame();
+  arena.end_frame(gl);
+
+  REQUIRE(mock.call_count("glBindBufferRange") == 8);
+  REQUIRE(arena.stats().reused == 0);
+  REQUIRE(arena.ring().region_used() >= 8 * layout.data_size());
+
+  gl_uniform_arena::destroy(gl, arena);
+  scene.destroy(gl);
+  gl.destroy();
+}
@@ -0,0 +1,152 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "./mock_scene.hpp"
+
+#include <array>
+#include <vector>
+
+using namespace shogle;
+using namespace shogle::test;
+
+namespace {
+
+constexpr u32 ATTRIB_COUNT = gl_vertex_layout::MAX_ATTRIBUTE_BINDINGS;
+constexpr u32 VERTEX_COUNT = 3;
+
+// One vec4 buffer per location, the widest SOA layout a vertex layout takes
+constexpr auto attribs = [] {
+  std::array<vertex_attribute, ATTRIB_COUNT> out{};
+  for (u32 i = 0; i < ATTRIB_COUNT; ++i) {
+    out[i] = {i, attribute_type::vec4, 0};
+  }
+  return out;
+}();
+
+struct soa_scene {
+  soa_scene(gl_context& gl_) :
+      gl(gl_), program(gl), layout(gl, 0, span<const vertex_attribute>{attribs}) {
+    for (u32 i = 0; i < ATTRIB_COUNT; ++i) {
+      buffers.emplace_back(gl, gl_buffer::TYPE_VERTEX, 2 * VERTEX_COUNT * sizeof(vec4));
+    }
+  }
+
+  ~soa_scene() {
+    gl_buffer::deallocate_n(gl, buffers.data(), buffers.size());
+    gl_vertex_layout::destroy(gl, layout);
+    program.destroy(gl);
+  }
+
+  gl_draw_command make_draw(gl_command_builder& builder, size_t last_offset = 0) {
+    builder.set_pipeline(program.pipeline).set_vertex_layout(layout).set_draw_count(VERTEX_COUNT);
+    for (u32 i = 0; i < ATTRIB_COUNT; ++i) {
+      builder.add_vertex_buffer(buffers[i], i, i == ATTRIB_COUNT - 1 ? last_offset : 0);
+    }
+    return builder.build();
+  }
+
+  gl_context& gl;
+  mock_program program;
+  gl_vertex_layout layout;
+  std::vector<gl_buffer> buffers;
+};
+
+const gl_clear_opts clear{color4{0.f, 0.f, 0.f, 1.f}, nullopt, gl_clear_opts::CLEAR_COLOR, {}};
+
+} // namespace
+
+TEST_CASE("Vertex formats are described once per layout", "[gl_vertex_format]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  mock.reset_stats();
+  {
+    soa_scene scene{gl};
+    REQUIRE(mock.call_count("glVertexArrayAttribFormat") == ATTRIB_COUNT);
+    REQUIRE(mock.call_count("glVertexArrayAttribBinding") == ATTRIB_COUNT);
+
+    gl_command_builder builder;
+    const auto cmd = scene.make_draw(builder);
+    mock.reset_stats();
+    gl.start_frame(clear);
+    for (u32 i = 0; i < 4; ++i) {
+      gl.submit_command(cmd);
+    }
+    gl.end_frame();
+
+    // Sixteen sources in a single call for the first draw, nothing for the rest
+    REQUIRE(mock.stats().draw_calls == 4);
+    REQUIRE(mock.call_count("glVertexArrayVertexBuffers") == 1);
+    REQUIRE(mock.call_count("glVertexAttribPointer") == 0);
+    REQUIRE(mock.call_count("glEnableVertexAttribArray") == 0);
+    REQUIRE(mock.call_count("glBindVertexArray") == 1);
+  }
+  gl.destroy();
+}
+
+TEST_CASE("Changing a vertex buffer offset rebinds the vertex buffers once", "[gl_vertex_format]") {
+  gl_mock_provider mock;
+  gl_context gl{mock};
+  {
+    soa_scene scene{gl};
+    gl_command_builder first_builder, second_builder;
+    const auto first = scene.make_draw(first_builder);
+    const auto second = scene.make_draw(second_builder, VERTEX_COUNT * sizeof(vec4));
+
+    mock.reset_stats();
+    gl.start_frame(clear);
+    gl.submit_command(first);
+    gl.submit_command(second);
+    gl.submit_command(second);
+    gl.end_frame();
+
+    REQUIRE(mock.call_count("glVertexArrayVertexBuffers") == 2);
+    REQUIRE(mock.call_count("glVertexAttribPointer") == 0);
+  }
+  gl.destroy();
+}
+
+TEST_CASE("Vertex formats are bound on the VAO before GL 4.5", "[gl_vertex_format]") {
+  gl_mock_provider mock{{800, 600}, {4, 3}};
+  gl_context gl{mock};
+  mock.reset_stats();
+  {
+    soa_scene scene{gl};
+    REQUIRE(mock.call_count("glVertexAttribFormat") == ATTRIB_COUNT);
+    REQUIRE(mock.call_count("glVertexAttribBinding") == ATTRIB_COUNT);
+    REQUIRE(mock.call_count("glVertexArrayAttribFormat") == 0);
+
+    gl_command_builder builder;
+    const auto cmd = scene.make_draw(builder);
+    mock.reset_stats();
+    gl.start_frame(clear);
+    gl.submit_command(cmd);
+    gl.submit_command(cmd);
+    gl.end_frame();
+
+    REQUIRE(mock.call_count("glVertexArrayVertexBuffers") == 0);
+    REQUIRE(mock.call_count("glBindVertexBuffer") == ATTRIB_COUNT);
+    REQUIRE(mock.call_count("glVertexAttribPointer") == 0);
+    REQUIRE(mock.stats().redundant_state_changes == 0);
+  }
+  gl.destroy();
+}
+
+TEST_CASE("Vertex attribute pointers are used before GL 4.3", "[gl_vertex_format]") {
+  gl_mock_provider mock{{800, 600}, {4, 2}};
+  gl_context gl{mock};
+  {
+    soa_scene scene{gl};
+    gl_command_builder builder;
+    const auto cmd = scene.make_draw(builder);
+
+    mock.reset_stats();
+    gl.start_frame(clear);
+    gl.submit_command(cmd);
+    gl.submit_command(cmd);
+    gl.end_frame();
+
+    REQUIRE(mock.call_count("glBindVertexBuffer") == 0);
+    REQUIRE(mock.call_count("glVertexAttribPointer") == ATTRIB_COUNT);
+    REQUIRE(mock.stats().redundant_state_changes == 0);
+  }
+  gl.destroy();
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <shogle/render/gl/mock.hpp>
+#include <shogle/render/opengl.hpp>
+
+namespace shogle::test {
+
+// The mock compiles anything, tests that only need a program to bind share these
+inline constexpr std::string_view stub_vert_src = "#version 460 core\nvoid main() {}";
+inline constexpr std::string_view stub_frag_src = "#version 460 core\nvoid main() {}";
+
+// Stub shaders linked into a single graphics pipeline
+struct mock_program {
+  mock_program(gl_context& gl, std::string_view vert_src = stub_vert_src) :
+      vert(gl, vert_src, gl_shader::STAGE_VERTEX),
+      frag(gl, stub_frag_src, gl_shader::STAGE_FRAGMENT),
+      pipeline(gl, gl_shader_builder{}.add_shader(vert).add_shader(frag).build()) {}
+
+  void destroy(gl_context& gl) {
+    gl_graphics_pipeline::destroy(gl, pipeline);
+    gl_shader::destroy(gl, frag);
+    gl_shader::destroy(gl, vert);
+  }
+
+  gl_shader vert;
+  gl_shader frag;
+  gl_graphics_pipeline pipeline;
+};
+
+// Two pipelines sharing the stub shaders, a vec3 vertex layout and a vertex buffer
+struct mock_scene {
+  static constexpr vertex_attribute attribs[] = {{0, attribute_type::vec3, 0}};
+
+  mock_scene(gl_context& gl, u32 vertex_count = 3, std::string_view vert_src = stub_vert_src) :
+      vert(gl, vert_src, gl_shader::STAGE_VERTEX),
+      frag(gl, stub_frag_src, gl_shader::STAGE_FRAGMENT),
+      pipeline_a(gl, gl_shader_builder{}.add_shader(vert).add_shader(frag).build()),
+      pipeline_b(gl, gl_shader_builder{}.add_shader(vert).add_shader(frag).build()),
+      layout(gl, sizeof(vec3), span<const vertex_attribute>{attribs}),
+      vbo(gl, gl_buffer::TYPE_VERTEX, vertex_count * sizeof(vec3)) {}
+
+  // Non indexed triangle with `pipeline`
+  gl_draw_command make_draw(const gl_graphics_pipeline& pipeline) {
+    builder.reset();
+    return builder.set_pipeline(pipeline)
+      .set_vertex_layout(layout)
+      .add_vertex_buffer(vbo)
+      .set_draw_count(3)
+      .build();
+  }
+
+  void destroy(gl_context& gl) {
+    gl_buffer::deallocate(gl, vbo);
+    gl_vertex_layout::destroy(gl, layout);
+    gl_graphics_pipeline::destroy(gl, pipeline_b);
+    gl_graphics_pipeline::destroy(gl, pipeline_a);
+    gl_shader::destroy(gl, frag);
+    gl_shader::destroy(gl, vert);
+  }
+
+  gl_shader vert;
+  gl_shader frag;
+  gl_graphics_pipeline pipeline_a;
+  gl_graphics_pipeline pipeline_b;
+  gl_vertex_layout layout;
+  gl_buffer vbo;
+  gl_command_builder builder;
+};
+
+} // namespace shogle::test
@@ -0,0 +1,233 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <shogle/render/software.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace shogle;
+
+namespace {
+
+struct quad_vertex {
+  vec3 pos;
+  vec2 uv;
+
+  static constexpr u32 attribute_count = 2;
+
+  static constexpr std::array<vertex_attribute, attribute_count> attributes() {
+    return {{
+      {0, attribute_type::vec3, offsetof(quad_vertex, pos)},
+      {1, attribute_type::vec2, offsetof(quad_vertex, uv)},
+    }};
+  }
+};
+
+struct uv_varyings {
+  vec2 uv;
+};
+
+struct color_varyings {
+  color4 color;
+};
+
+// Two triangles sharing a diagonal, counter clockwise in NDC
+std::vector<quad_vertex> make_quad(f32 x0, f32 y0, f32 x1, f32 y1, f32 z) {
+  return {
+    {{x0, y0, z}, {0.f, 1.f}},
+    {{x1, y0, z}, {1.f, 1.f}},
+    {{x1, y1, z}, {1.f, 0.f}},
+    {{x0, y1, z}, {0.f, 0.f}},
+  };
+}
+
+constexpr u32 quad_indices[] = {0, 1, 2, 0, 2, 3};
+
+const auto pass_uv = [](const quad_vertex& vert, uv_varyings& out) -> vec4 {
+  out.uv = vert.uv;
+  return {vert.pos.x, vert.pos.y, vert.pos.z, 1.f};
+};
+
+bool same_color(const color4& a, const color4& b) {
+  constexpr f32 tol = 1.5f / 255.f;
+  return std::abs(a.r - b.r) <= tol && std::abs(a.g - b.g) <= tol &&
+         std::abs(a.b - b.b) <= tol && std::abs(a.a - b.a) <= tol;
+}
+
+} // namespace
+
+TEST_CASE("Shared edges shade every pixel exactly once", "[sw_rasterizer]") {
+  // Odd sized target so tiles and 4 pixel groups get clipped on the borders
+  sw_context sw{{4, 16}};
+  sw_framebuffer fb{{67, 45}};
+  fb.clear({0.f, 0.f, 0.f, 0.f});
+  const auto quad = make_quad(-1.f, -1.f, 1.f, 1.f, 0.f);
+
+  // Additive blending would leave 2 in any pixel rasterized twice
+  auto state = sw_draw_state::make_default(false);
+  state.blend = sw_draw_state::BLEND_ADDITIVE;
+  const auto stats = sw.draw<uv_varyings>(
+    fb, state, span<const quad_vertex>{quad.data(), quad.size()}, quad_indices, pass_uv,
+    [](const uv_varyings&) -> color4 { return {1.f / 255.f, 0.f, 0.f, 0.f}; });
+  REQUIRE(stats.triangles == 2);
+  REQUIRE(stats.culled == 0);
+  REQUIRE(stats.fragments == 67 * 45);
+  for (const u32 texel : fb.color()) {
+    REQUIRE(texel == 1u);
+  }
+
+  // Same for a fan of thin triangles around an off center point
+  fb.clear({0.f, 0.f, 0.f, 0.f});
+  std::vector<quad_vertex> fan;
+  fan.push_back({{.13f, -.21f, 0.f}, {0.f, 0.f}});
+  constexpr u32 SEGMENTS = 37;
+  for (u32 i = 0; i <= SEGMENTS; ++i) {
+    const f32 angle = 6.2831853f * static_cast<f32>(i) / SEGMENTS;
+    fan.push_back({{.9f * std::cos(angle), .9f * std::sin(angle), 0.f}, {0.f, 0.f}});
+  }
+  std::vector<u32> fan_indices;
+  for (u32 i = 1; i <= SEGMENTS; ++i) {
+    fan_indices.insert(fan_indices.end(), {0, i, i + 1});
+  }
+  sw.draw<uv_varyings>(fb, state, span<const quad_vertex>{fan.data(), fan.size()},
+                       span<const u32>{fan_indices.data(), fan_indices.size()}, pass_uv,
+                       [](const uv_varyings&) -> color4 { return {1.f / 255.f, 0.f, 0.f, 0.f}; });
+  for (const u32 texel : fb.color()) {
+    REQUIRE(texel <= 1u);
+  }
+}
+
+TEST_CASE("Depth testing keeps the nearest fragment", "[sw_rasterizer]") {
+  sw_context sw{{2, sw_context::DEFAULT_TILE_SIZE}};
+  sw_framebuffer fb{{32, 32}};
+  fb.clear({0.f, 0.f, 0.f, 1.f});
+  const auto near = make_quad(-1.f, -1.f, 0.f, 1.f, -.5f);
+  const auto far = make_quad(-1.f, -1.f, 1.f, 1.f, .5f);
+  const auto state = sw_draw_state::make_default(true);
+  const auto solid = [](const color4& color) {
+    return [color](const uv_varyings&) { return color; };
+  };
+
+  // Near first, the far quad only lands on the right half
+  sw.draw<uv_varyings>(fb, state, span<const quad_vertex>{near.data(), near.size()},
+                       quad_indices, pass_uv, solid({1.f, 0.f, 0.f, 1.f}));
+  const auto stats =
+    sw.draw<uv_varyings>(fb, state, span<const quad_vertex>{far.data(), far.size()},
+                         quad_indices, pass_uv, solid({0.f, 0.f, 1.f, 1.f}));
+  REQUIRE(stats.fragments == 16 * 32);
+  REQUIRE(same_color(fb.pixel(3, 10), {1.f, 0.f, 0.f, 1.f}));
+  REQUIRE(same_color(fb.pixel(28, 10), {0.f, 0.f, 1.f, 1.f}));
+  REQUIRE(std::abs(fb.depth()[10 * 32 + 3] - .25f) < 1e-5f);
+  REQUIRE(std::abs(fb.depth()[10 * 32 + 28] - .75f) < 1e-5f);
+
+  // Back facing quads go away with culling
+  auto culled = state;
+  culled.cull = sw_draw_state::CULL_BACK;
+  const u32 flipped[] = {0, 2, 1, 0, 3, 2};
+  const auto flipped_stats =
+    sw.draw<uv_varyings>(fb, culled, span<const quad_vertex>{far.data(), far.size()}, flipped,
+                         pass_uv, solid({0.f, 1.f, 0.f, 1.f}));
+  REQUIRE(flipped_stats.culled == 2);
+  REQUIRE(flipped_stats.fragments == 0);
+}
+
+TEST_CASE("Alpha blending and discarded fragments", "[sw_rasterizer]") {
+  sw_context sw{{3, 8}};
+  sw_framebuffer fb{{16, 16}};
+  fb.clear({0.f, 0.f, 1.f, 1.f});
+  const auto quad = make_quad(-1.f, -1.f, 1.f, 1.f, 0.f);
+  auto state = sw_draw_state::make_default(false);
+  state.blend = sw_draw_state::BLEND_ALPHA;
+
+  // Discards the top half of the target, v grows downwards
+  const auto stats = sw.draw<uv_varyings>(
+    fb, state, span<const quad_vertex>{quad.data(), quad.size()}, quad_indices, pass_uv,
+    [](const uv_varyings& in, color4& out) {
+      out = {1.f, 0.f, 0.f, .25f};
+      return in.uv.y >= .5f;
+    });
+  REQUIRE(stats.fragments == 16 * 16);
+  REQUIRE(same_color(fb.pixel(5, 2), {0.f, 0.f, 1.f, 1.f}));
+  REQUIRE(same_color(fb.pixel(5, 13), {.25f, 0.f, .75f, 1.f}));
+
+  // Vertex colors come out interpolated
+  const color4 corners[] = {
+    {1.f, 0.f, 0.f, 1.f}, {0.f, 1.f, 0.f, 1.f}, {0.f, 0.f, 1.f, 1.f}, {1.f, 1.f, 1.f, 1.f}};
+  state.blend = sw_draw_state::BLEND_NONE;
+  sw.draw<color_varyings>(
+    fb, state, span<const quad_vertex>{quad.data(), quad.size()}, quad_indices,
+    [&](const quad_vertex& vert, color_varyings& out) -> vec4 {
+      const u32 corner = static_cast<u32>(&vert - quad.data());
+      out.color = corners[corner];
+      return {vert.pos.x, vert.pos.y, vert.pos.z, 1.f};
+    },
+    [](const color_varyings& in) { return in.color; });
+  const color4 center = fb.pixel(7, 8);
+  REQUIRE(std::abs(center.r - .5f) < .1f);
+  REQUIRE(std::abs(center.b - .5f) < .1f);
+  REQUIRE(fb.pixel(0, 15).r > .9f);
+}
+
+TEST_CASE("Textures sample with nearest and bilinear filtering", "[sw_rasterizer]") {
+  // 2x2 checker, white on the top left
+  const u32 texels[] = {0xFFFFFFFF, 0xFF000000, 0xFF000000, 0xFFFFFFFF};
+  sw_texture tex{{2, 2}, span<const u8>{reinterpret_cast<const u8*>(texels), sizeof(texels)}};
+  const sw_texture::sampler nearest{sw_texture::FILTER_NEAREST, sw_texture::WRAP_REPEAT};
+  const sw_texture::sampler linear{sw_texture::FILTER_LINEAR, sw_texture::WRAP_CLAMP};
+
+  REQUIRE(same_color(tex.sample({.1f, .1f}, nearest), {1.f, 1.f, 1.f, 1.f}));
+  REQUIRE(same_color(tex.sample({.9f, .1f}, nearest), {0.f, 0.f, 0.f, 1.f}));
+  REQUIRE(same_color(tex.sample({1.1f, -.9f}, nearest), {1.f, 1.f, 1.f, 1.f}));
+  REQUIRE(same_color(tex.sample({.5f, .5f}, linear), {.5f, .5f, .5f, 1.f}));
+  REQUIRE(same_color(tex.sample({0.f, 0.f}, linear), {1.f, 1.f, 1.f, 1.f}));
+  REQUIRE(same_color(tex.sample({.5f, .25f}, linear), {.5f, .5f, .5f, 1.f}));
+
+  // Stretched over a 4x4 target each texel covers a 2x2 block
+  sw_context sw{{1, 4}};
+  sw_framebuffer fb{{4, 4}};
+  const auto quad = make_quad(-1.f, -1.f, 1.f, 1.f, 0.f);
+  sw.draw<uv_varyings>(fb, sw_draw_state::make_default(false),
+                       span<const quad_vertex>{quad.data(), quad.size()}, quad_indices, pass_uv,
+                       [&](const uv_varyings& in) { return tex.sample(in.uv, nearest); });
+  std::vector<u8> pixels(4 * 4 * 4);
+  fb.read_pixels({pixels.data(), pixels.size()});
+  REQUIRE(pixels[0] == 0xFF);
+  REQUIRE(pixels[(1 * 4 + 1) * 4] == 0xFF);
+  REQUIRE(pixels[(1 * 4 + 2) * 4] == 0x00);
+  REQUIRE(pixels[(3 * 4 + 3) * 4] == 0xFF);
+}
+
+TEST_CASE("Software rasterizer scaling across threads", "[sw_rasterizer][!benchmark]") {
+  constexpr u32 TRIANGLES = 20000;
+  std::mt19937 rng{9};
+  std::uniform_real_distribution<f32> pos{-1.f, 1.f};
+  std::uniform_real_distribution<f32> size{.02f, .15f};
+  std::vector<quad_vertex> verts;
+  verts.reserve(3 * TRIANGLES);
+  for (u32 i = 0; i < TRIANGLES; ++i) {
+    const f32 x = pos(rng), y = pos(rng), z = pos(rng) * .9f, s = size(rng);
+    verts.push_back({{x, y, z}, {0.f, 0.f}});
+    verts.push_back({{x + s, y, z}, {1.f, 0.f}});
+    verts.push_back({{x, y + s, z}, {0.f, 1.f}});
+  }
+  const u32 texels[] = {0xFFFFFFFF, 0xFF0000FF, 0xFF00FF00, 0xFFFF0000};
+  sw_texture tex{{2, 2}, span<const u8>{reinterpret_cast<const u8*>(texels), sizeof(texels)}};
+  sw_framebuffer fb{{1280, 720}};
+  const auto shade = [&](const uv_varyings& in) { return tex.sample(in.uv); };
+
+  const u32 hardware = std::max(std::thread::hardware_concurrency(), 1u);
+  for (const u32 threads : {1u, 2u, 4u, hardware}) {
+    sw_context sw{{threads, sw_context::DEFAULT_TILE_SIZE}};
+    BENCHMARK("draw " + std::to_string(threads) + " threads") {
+      fb.clear({0.f, 0.f, 0.f, 1.f});
+      return sw.draw<uv_varyings>(fb, sw_draw_state::make_default(true),
+                                  span<const quad_vertex>{verts.data(), verts.size()}, {},
+                                  pass_uv, shade);
+    };
+  }
+}
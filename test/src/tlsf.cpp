@@ -0,0 +1,136 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <shogle/util/tlsf.hpp>
+
+#include <random>
+#include <vector>
+
+using namespace shogle;
+
+namespace {
+
+// Blocks must tile the whole range, with no two free blocks next to each other
+void check_blocks(const mem::tlsf_allocator& tlsf) {
+  u64 cursor = 0;
+  u64 used = 0;
+  bool prev_free = false;
+  tlsf.for_each_block([&](u64 offset, u64 size, bool is_used) {
+    REQUIRE(offset == cursor);
+    REQUIRE(size > 0);
+    REQUIRE((is_used || !prev_free));
+    prev_free = !is_used;
+    cursor += size;
+    used += is_used ? size : 0;
+  });
+  REQUIRE(cursor == tlsf.capacity());
+  REQUIRE(used == tlsf.used_size());
+}
+
+} // namespace
+
+TEST_CASE("TLSF allocations are aligned and coalesce on release", "[tlsf]") {
+  mem::tlsf_allocator tlsf{4096};
+  auto a = tlsf.allocate(100, 1);
+  auto b = tlsf.allocate(36, 12);
+  auto c = tlsf.allocate(256, 256);
+  REQUIRE(a.has_value());
+  REQUIRE(b.has_value());
+  REQUIRE(c.has_value());
+  REQUIRE(b->offset % 12 == 0);
+  REQUIRE(c->offset % 256 == 0);
+  REQUIRE(tlsf.allocation_count() == 3);
+  check_blocks(tlsf);
+
+  REQUIRE_FALSE(tlsf.allocate(8192).has_value());
+
+  tlsf.deallocate(b->node);
+  tlsf.deallocate(a->node);
+  tlsf.deallocate(c->node);
+  check_blocks(tlsf);
+  REQUIRE(tlsf.used_size() == 0);
+  REQUIRE(tlsf.largest_free_block() == 4096);
+  REQUIRE(tlsf.allocate(4096).has_value());
+}
+
+TEST_CASE("TLSF survives random allocation patterns", "[tlsf]") {
+  constexpr u64 capacity = 1 << 20;
+  mem::tlsf_allocator tlsf{capacity};
+  std::mt19937 rng{1234};
+  std::uniform_int_distribution<u64> size_dist{1, 4096};
+  std::uniform_int_distribution<u32> align_dist{0, 4};
+  constexpr u64 alignments[] = {1, 4, 12, 16, 256};
+
+  std::vector<std::pair<mem::tlsf_allocator::allocation, u64>> live;
+  for (u32 i = 0; i < 4000; ++i) {
+    if (live.empty() || rng() % 3 != 0) {
+      const u64 align = alignments[align_dist(rng)];
+      if (auto alloc = tlsf.allocate(size_dist(rng), align)) {
+        REQUIRE(alloc->offset % align == 0);
+        REQUIRE(alloc->offset + alloc->size <= capacity);
+        live.emplace_back(*alloc, align);
+      }
+    } else {
+      const size_t idx = rng() % live.size();
+      tlsf.deallocate(live[idx].first.node);
+      live[idx] = live.back();
+      live.pop_back();
+    }
+    if (i % 500 == 0) {
+      check_blocks(tlsf);
+    }
+  }
+  check_blocks(tlsf);
+  REQUIRE(tlsf.allocation_count() == live.size());
+
+  // Compaction leaves a single free block at the end, minus alignment padding
+  const u64 used = tlsf.used_size();
+  const auto moves = tlsf.compact();
+  check_blocks(tlsf);
+  REQUIRE(tlsf.used_size() == used);
+  for (const auto& move : moves) {
+    REQUIRE(move.dst_offset < move.src_offset);
+    REQUIRE(tlsf.offset(move.node) == move.dst_offset);
+  }
+  for (const auto& [alloc, align] : live) {
+    REQUIRE(tlsf.offset(alloc.node) % align == 0);
+    tlsf.deallocate(alloc.node);
+  }
+  check_blocks(tlsf);
+  REQUIRE(tlsf.largest_free_block() == capacity);
+}
+
+TEST_CASE("TLSF allocation benchmark", "[tlsf][!benchmark]") {
+  constexpr u64 capacity = 1 << 24;
+  constexpr size_t slot_count = 256;
+  std::mt19937 rng{7};
+  std::uniform_int_distribution<u64> size_dist{16, 4096};
+  std::vector<u64> sizes(4096);
+  for (auto& size : sizes) {
+    size = size_dist(rng);
+  }
+
+  mem::tlsf_allocator tlsf{capacity};
+  BENCHMARK("allocate and free") {
+    auto alloc = tlsf.allocate(sizes.front(), 16);
+    tlsf.deallocate(alloc->node);
+    return tlsf.used_size();
+  };
+
+  // Free and refill a fixed set of live slots, fragmenting the free lists
+  std::vector<mem::tlsf_allocator::allocation> live;
+  live.reserve(slot_count);
+  for (size_t i = 0; i < slot_count; ++i) {
+    live.push_back(*tlsf.allocate(sizes[i], 16));
+  }
+  size_t next = 0;
+  BENCHMARK("random churn") {
+    for (size_t i = 0; i < slot_count; ++i) {
+      const size_t slot = (next * 31 + i * 17) % slot_count;
+      tlsf.deallocate(live[slot].node);
+      live[slot] = *tlsf.allocate(sizes[next++ % sizes.size()], 16);
+    }
+    return tlsf.used_size();
+  };
+  tlsf.reset();
+}